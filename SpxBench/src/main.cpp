@@ -0,0 +1,246 @@
+#include "asset_path.h"
+#include "globalVar.h"
+#include "jobs.h"
+#include "log.h"
+#include "mesh.h"
+#include "mesh_file.h"
+#include "mesh_simplify.h"
+#include "obj_loader.h"
+#include "scene_text.h"
+#include "texture_compress.h"
+#include "stb/stb_image.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// SpxBench: runs the engine's throughput benchmarks and checks their results, so a
+// regression in an encoder, loader or file format fails the run (exit code 1).
+//
+//   SpxBench [textures] [obj] [mesh] [lods] [scene]     (none = all)
+//            [--image <file>]... [--obj <file>] [--mesh <source>] [--scene <file>]
+//
+// Without input files every check uses the engine textures or a synthetic input.
+// Run it from the engine folder so the asset paths resolve.
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct Options {
+        std::vector<std::string> checks;
+        std::vector<std::string> images;
+        std::string obj;
+        std::string mesh;
+        std::string scene;
+    };
+
+    int s_failures = 0;
+
+    void Check(bool ok, const std::string& what) {
+        std::printf("  %-4s %s\n", ok ? "ok" : "FAIL", what.c_str());
+        if (!ok) ++s_failures;
+    }
+
+    bool Wanted(const Options& options, const char* check) {
+        if (options.checks.empty()) return true;
+        for (const std::string& c : options.checks) {
+            if (c == check) return true;
+        }
+        return false;
+    }
+
+    // Lowest PSNR (dB) each format may reach on the test images; the fast and high
+    // quality encoders both have to clear it. About 2 dB under the worst engine texture
+    // (stone.jpg, noisy: BC1 28.2, BC3 29.4, BC7 38.0 dB with the fast encoders)
+    double PsnrFloor(TextureCompress::Format format) {
+        switch (format) {
+        case TextureCompress::Format::BC1: return 26.0;
+        case TextureCompress::Format::BC3: return 27.0;
+        case TextureCompress::Format::BC7: return 36.0;
+        default: return 0.0;
+        }
+    }
+
+    // Smooth gradients, hard edges and an alpha ramp: the cases block encoders get wrong
+    std::vector<unsigned char> MakeTestImage(int w, int h) {
+        std::vector<unsigned char> rgba(static_cast<size_t>(w) * h * 4);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                unsigned char* p = &rgba[(static_cast<size_t>(y) * w + x) * 4];
+                const bool checker = ((x / 16) + (y / 16)) & 1;
+                p[0] = static_cast<unsigned char>(x * 255 / (w - 1));
+                p[1] = static_cast<unsigned char>(y * 255 / (h - 1));
+                p[2] = checker ? 200 : 40;
+                p[3] = static_cast<unsigned char>((x + y) * 255 / (w + h - 2));
+            }
+        }
+        return rgba;
+    }
+
+    void BenchTextures(const Options& options) {
+        std::printf("textures: block encoder quality and throughput\n");
+        struct Image {
+            std::string name;
+            int w = 0;
+            int h = 0;
+            std::vector<unsigned char> rgba;
+        };
+        std::vector<Image> images;
+        images.push_back({ "synthetic 512x512", 512, 512, MakeTestImage(512, 512) });
+        std::vector<std::string> paths = options.images;
+        if (paths.empty()) paths = { CUBE_TEXTURE, PLANE_TEXTURE, FLOOR_TEXTURE };
+        for (const std::string& path : paths) {
+            std::vector<unsigned char> bytes;
+            if (!ReadAssetFile(path, bytes)) {
+                // the default textures are optional, a file asked for is not
+                if (!options.images.empty()) Check(false, "read " + path);
+                continue;
+            }
+            Image image;
+            int n = 0;
+            unsigned char* data = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &image.w, &image.h, &n, 4);
+            if (!data) {
+                Check(false, "decode " + path);
+                continue;
+            }
+            image.name = path;
+            image.rgba.assign(data, data + static_cast<size_t>(image.w) * image.h * 4);
+            stbi_image_free(data);
+            images.push_back(std::move(image));
+        }
+
+        const TextureCompress::Format formats[] = { TextureCompress::Format::BC1, TextureCompress::Format::BC3, TextureCompress::Format::BC7 };
+        const TextureCompress::Quality qualities[] = { TextureCompress::Quality::Fast, TextureCompress::Quality::High };
+        for (const Image& image : images) {
+            for (TextureCompress::Format format : formats) {
+                double fastPsnr = 0.0;
+                for (TextureCompress::Quality quality : qualities) {
+                    const TextureCompress::EncodeReport r = TextureCompress::MeasureEncode(image.rgba.data(), image.w, image.h, format, quality);
+                    char line[256];
+                    std::snprintf(line, sizeof(line), "%s %s %s: %.2f dB (floor %.0f), %.1f MPix/s", image.name.c_str(),
+                        TextureCompress::FormatName(format), quality == TextureCompress::Quality::High ? "high" : "fast",
+                        r.psnr, PsnrFloor(format), r.mpixelsPerSec);
+                    Check(r.bytes == TextureCompress::CompressedSize(format, image.w, image.h) && r.psnr >= PsnrFloor(format), line);
+                    // high quality fits and refines the endpoints further, over a whole image it must not lose
+                    if (quality == TextureCompress::Quality::Fast) fastPsnr = r.psnr;
+                    else Check(r.psnr >= fastPsnr - 0.01, image.name + " " + TextureCompress::FormatName(format) + ": high >= fast");
+                }
+            }
+        }
+    }
+
+    void BenchObj(const Options& options) {
+        std::printf("obj: import throughput\n");
+        const ObjLoader::BenchmarkReport r = ObjLoader::BenchmarkParse(options.obj);
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s: %zu triangles, %.1f MB/s, %.2f Mtris/s",
+            options.obj.empty() ? "synthetic grid" : options.obj.c_str(), r.triangles, r.mbPerSec, r.mTrianglesPerSec);
+        Check(r.triangles > 0, line);
+    }
+
+    // A grid OBJ in the temp folder, for the cook round trip when no mesh is given
+    std::string WriteGridObj(int quads) {
+        const std::string path = (fs::temp_directory_path() / "spxbench_grid.obj").string();
+        std::ofstream out(path, std::ios::trunc);
+        for (int z = 0; z <= quads; ++z) {
+            for (int x = 0; x <= quads; ++x) out << "v " << x << " " << std::sin(x * 0.1f + z * 0.2f) << " " << z << "\n";
+        }
+        for (int z = 0; z <= quads; ++z) {
+            for (int x = 0; x <= quads; ++x) out << "vt " << float(x) / quads << " " << float(z) / quads << "\n";
+        }
+        out << "vn 0 1 0\n";
+        for (int z = 0; z < quads; ++z) {
+            for (int x = 0; x < quads; ++x) {
+                const int a = z * (quads + 1) + x + 1, b = a + quads + 1;
+                out << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << b + 1 << "/" << b + 1 << "/1 " << a + 1 << "/" << a + 1 << "/1\n";
+            }
+        }
+        return out ? path : std::string();
+    }
+
+    void BenchMesh(const Options& options) {
+        std::printf("mesh: cooked .spxmesh load vs source import\n");
+        const std::string source = options.mesh.empty() ? WriteGridObj(256) : options.mesh;
+        if (source.empty()) {
+            Check(false, "write the synthetic grid");
+            return;
+        }
+        const MeshFile::BenchmarkReport r = MeshFile::BenchmarkLoad(source);
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s: source %.2f ms, cooked %.2f ms (%.1fx)", source.c_str(),
+            r.sourceSeconds * 1000.0, r.cookedSeconds * 1000.0, r.speedup);
+        Check(r.cookedBytes > 0 && r.speedup > 0.0, line);
+
+        // LOD 0 of the cooked file must draw exactly the triangles the importer made
+        MeshData imported, cooked;
+        const bool loaded = MeshFile::ImportSource(source, imported) && MeshFile::Read(MeshFile::CookedPath(source), cooked);
+        size_t lod0 = cooked.TriangleCount();
+        if (loaded && !cooked.lods.empty()) {
+            lod0 = 0;
+            for (uint32_t i = 0; i < cooked.lods[0].submeshCount; ++i) lod0 += cooked.submeshes[cooked.lods[0].submeshOffset + i].indexCount / 3;
+        }
+        Check(loaded && imported.TriangleCount() > 0 && lod0 == imported.TriangleCount(),
+            "cooked LOD 0 has the " + std::to_string(imported.TriangleCount()) + " imported triangles");
+    }
+
+    void BenchLods(const Options& options) {
+        std::printf("lods: simplification and LOD choice by distance\n");
+        const MeshSimplify::BenchmarkReport r = MeshSimplify::Benchmark(options.mesh);
+        bool shrinking = !r.lodTriangles.empty() && r.lodTriangles[0] == r.triangles;
+        for (size_t i = 1; i < r.lodTriangles.size(); ++i) shrinking &= r.lodTriangles[i] < r.lodTriangles[i - 1];
+        char line[256];
+        std::snprintf(line, sizeof(line), "%zu triangles -> %zu LODs in %.0f ms", r.triangles, r.lodTriangles.size(), r.seconds * 1000.0);
+        Check(shrinking && r.lodTriangles.size() > 1, line);
+        // walking away, the selector may only ever pick coarser LODs
+        bool coarser = !r.samples.empty();
+        for (size_t i = 1; i < r.samples.size(); ++i) coarser &= r.samples[i].lod >= r.samples[i - 1].lod;
+        Check(coarser && r.samples.back().lod > 0, "LOD never gets finer with distance and drops at range");
+    }
+
+    void BenchScene(const Options& options) {
+        std::printf("scene: .spx text save/load\n");
+        const SceneText::BenchmarkReport r = SceneText::Benchmark(options.scene);
+        char line[256];
+        std::snprintf(line, sizeof(line), "%zu entities: save %.0f MB/s, load %.0f MB/s, round trip %s",
+            r.entities, r.saveMBps, r.loadMBps, r.roundTrip ? "exact" : "MISMATCH");
+        Check(r.entities > 0 && r.roundTrip, line);
+    }
+
+    void PrintUsage() {
+        std::printf("usage:\n");
+        std::printf("  SpxBench [textures] [obj] [mesh] [lods] [scene]   (none = all)\n");
+        std::printf("      --image <file>   texture to encode (repeatable, default: the engine textures)\n");
+        std::printf("      --obj <file>     OBJ to import (default: synthetic 1M triangle grid)\n");
+        std::printf("      --mesh <source>  model to cook and simplify (default: synthetic)\n");
+        std::printf("      --scene <file>   .spx or .spxscene to round trip (default: synthetic 100k entities)\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--image") == 0 && hasValue) options.images.push_back(argv[++i]);
+        else if (std::strcmp(argv[i], "--obj") == 0 && hasValue) options.obj = argv[++i];
+        else if (std::strcmp(argv[i], "--mesh") == 0 && hasValue) options.mesh = argv[++i];
+        else if (std::strcmp(argv[i], "--scene") == 0 && hasValue) options.scene = argv[++i];
+        else if (argv[i][0] != '-') options.checks.push_back(argv[i]);
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (Wanted(options, "textures")) BenchTextures(options);
+    if (Wanted(options, "obj")) BenchObj(options);
+    if (Wanted(options, "mesh")) BenchMesh(options);
+    if (Wanted(options, "lods")) BenchLods(options);
+    if (Wanted(options, "scene")) BenchScene(options);
+
+    Jobs::Shutdown();
+    std::printf("%s (%d failed)\n", s_failures == 0 ? "all checks passed" : "FAILED", s_failures);
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include "log.h"
+#include "pak_file.h"
+#include "mesh_file.h"
+#include "jobs.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// SpxPak: builds and inspects .spxpak asset packs.
+//
+//   SpxPak pack <out.spxpak> <root> <file or folder under root>... [--store] [--cook-meshes]
+//   SpxPak list <pack.spxpak>
+//   SpxPak verify <pack.spxpak>
+//
+// e.g. from the engine folder: SpxPak pack game.spxpak . assets Shaders --cook-meshes
+
+namespace fs = std::filesystem;
+
+namespace {
+    void PrintUsage() {
+        std::printf("usage:\n");
+        std::printf("  SpxPak pack <out.spxpak> <root> <inputs...> [--store] [--cook-meshes]\n");
+        std::printf("      --store        keep every entry uncompressed\n");
+        std::printf("      --cook-meshes  cook .obj/.gltf/.glb to .spxmesh and pack those too\n");
+        std::printf("  SpxPak list <pack.spxpak>\n");
+        std::printf("  SpxPak verify <pack.spxpak>\n");
+    }
+
+    bool IsMeshSource(const std::string& name) {
+        std::string ext = fs::path(name).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext == ".obj" || ext == ".gltf" || ext == ".glb";
+    }
+
+    // Cook every mesh source next to its source file and add the cooked file to the inputs,
+    // along with the textures next to it (the images a .glb embeds are written there by the cook)
+    bool CookMeshes(std::vector<PakFile::Input>& inputs) {
+        std::vector<PakFile::Input> cooked;
+        for (const PakFile::Input& input : inputs) {
+            if (!IsMeshSource(input.name)) continue;
+            std::string cookedPath = MeshFile::CookedPath(input.sourcePath);
+            if (!MeshFile::IsUpToDate(input.sourcePath, cookedPath) && !MeshFile::Cook(input.sourcePath, cookedPath)) {
+                std::printf("failed to cook %s\n", input.sourcePath.c_str());
+                return false;
+            }
+            cooked.push_back({ MeshFile::CookedPath(input.name), cookedPath });
+
+            CookedMesh mesh;
+            if (!mesh.Open(cookedPath, false)) return false;
+            fs::path nameDir = fs::path(MeshFile::CookedPath(input.name)).parent_path();
+            fs::path cookedDir = fs::path(cookedPath).parent_path();
+            for (const MeshMaterial& m : mesh.Materials()) {
+                for (const std::string* texture : { &m.diffuseTexture, &m.normalTexture }) {
+                    if (texture->empty() || !fs::is_regular_file(*texture)) continue;
+                    std::string rel = fs::path(*texture).lexically_relative(cookedDir).generic_string();
+                    if (rel.empty() || rel.rfind("..", 0) == 0) continue; // outside the model's folder
+                    cooked.push_back({ (nameDir / rel).generic_string(), *texture });
+                }
+            }
+        }
+        // a folder input may already hold the cooked files
+        for (PakFile::Input& c : cooked) {
+            std::string name = PakFile::NormalizeName(c.name);
+            bool present = std::any_of(inputs.begin(), inputs.end(),
+                [&](const PakFile::Input& i) { return PakFile::NormalizeName(i.name) == name; });
+            if (!present) inputs.push_back(std::move(c));
+        }
+        return true;
+    }
+
+    int Pack(int argc, char** argv) {
+        std::string out, root;
+        std::vector<std::string> dirs;
+        PakFile::WriteOptions options;
+        bool cookMeshes = false;
+        for (int i = 2; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--store") == 0) options.compress = false;
+            else if (std::strcmp(argv[i], "--cook-meshes") == 0) cookMeshes = true;
+            else if (out.empty()) out = argv[i];
+            else if (root.empty()) root = argv[i];
+            else dirs.push_back(argv[i]);
+        }
+        if (out.empty() || root.empty() || dirs.empty()) {
+            PrintUsage();
+            return 1;
+        }
+
+        std::vector<PakFile::Input> inputs;
+        for (const std::string& dir : dirs) {
+            if (!PakFile::Collect(root, dir, inputs)) return 1;
+        }
+        // never pack the output into itself
+        std::error_code ec;
+        inputs.erase(std::remove_if(inputs.begin(), inputs.end(),
+            [&](const PakFile::Input& i) { return fs::equivalent(i.sourcePath, out, ec); }), inputs.end());
+        if (cookMeshes && !CookMeshes(inputs)) return 1;
+
+        PakFile::WriteReport report;
+        if (!PakFile::Write(out, inputs, options, &report)) {
+            std::printf("failed to write %s\n", out.c_str());
+            return 1;
+        }
+        std::printf("%s: %zu files (%zu compressed), %llu -> %llu bytes in %.2f s\n", out.c_str(),
+            report.files, report.compressed, (unsigned long long)report.bytesIn, (unsigned long long)report.bytesOut, report.seconds);
+        return 0;
+    }
+
+    int List(const std::string& path) {
+        PakArchive pak;
+        if (!pak.Open(path)) return 1;
+        std::vector<const PakFile::Entry*> entries;
+        for (size_t i = 0; i < pak.EntryCount(); ++i) entries.push_back(&pak.Entries()[i]);
+        std::sort(entries.begin(), entries.end(),
+            [&](const PakFile::Entry* a, const PakFile::Entry* b) { return pak.Name(*a) < pak.Name(*b); });
+        for (const PakFile::Entry* e : entries) {
+            std::string_view name = pak.Name(*e);
+            std::printf("%12llu %12llu %-4s %.*s\n", (unsigned long long)e->size, (unsigned long long)e->storedSize,
+                e->compression == uint32_t(PakFile::Compression::Lz4) ? "lz4" : "-", (int)name.size(), name.data());
+        }
+        std::printf("%zu entries\n", pak.EntryCount());
+        return 0;
+    }
+
+    int Verify(const std::string& path) {
+        PakArchive pak;
+        if (!pak.Open(path)) return 1;
+        bool ok = pak.Verify();
+        std::printf("%s: %s\n", path.c_str(), ok ? "ok" : "CORRUPT");
+        return ok ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        PrintUsage();
+        return 1;
+    }
+    std::string command = argv[1];
+    int result = 1;
+    if (command == "pack") result = Pack(argc, argv);
+    else if (command == "list") result = List(argv[2]);
+    else if (command == "verify") result = Verify(argv[2]);
+    else PrintUsage();
+
+    Jobs::Shutdown();
+    return result;
+}
@@ -12,10 +12,23 @@ uniform sampler2D myTexture;
 uniform int u_selected;            // 1 = selected, 0 = not
 uniform vec3 u_highlightColor;     // highlight color (rgb)
 
+// material uniforms (imported models): 0 = texture only, 1 = texture * u_baseColor, 2 = u_baseColor only
+uniform int u_materialMode;
+uniform vec4 u_baseColor;
+
+#ifdef ALPHA_TEST
+uniform float u_alphaCutoff = 0.5; // cutout materials: texels below this are discarded
+#endif
+
 void main()
 {
     // Use texture coordinates produced by the vertex shader
     vec4 base = texture(myTexture, vTexCoord);
+    if (u_materialMode == 1) base *= u_baseColor;
+    else if (u_materialMode == 2) base = u_baseColor;
+#ifdef ALPHA_TEST
+    if (base.a < u_alphaCutoff) discard;
+#endif
 
     if (u_selected == 1) {
         // Blend highlight color into base color. Adjust factor to taste.
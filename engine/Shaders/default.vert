@@ -6,15 +6,35 @@ layout(location = 2) in vec2 aTexCoord;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform int u_flipV;               // 1 = uv origin top-left (glTF), 0 = bottom-left
+// Packed vertex formats (vertex_quantize.h): aPos is snorm relative to the mesh bounds,
+// aNormal.xy is an octahedral normal. 0 = plain float vertices.
+uniform int u_vertexFormat;
+uniform vec3 u_posCenter;
+uniform vec3 u_posExtent;
 
 out vec2 vTexCoord;
 out vec3 vNormal;
 
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
 void main()
 {
-    vTexCoord = aTexCoord;
-    vNormal = mat3(transpose(inverse(model))) * aNormal;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+    if (u_vertexFormat != 0) {
+        position = u_posCenter + aPos * u_posExtent;
+        normal = OctDecode(aNormal.xy);
+    }
+    vTexCoord = (u_flipV == 1) ? vec2(aTexCoord.x, 1.0 - aTexCoord.y) : aTexCoord;
+    vNormal = mat3(transpose(inverse(model))) * normal;
+    gl_Position = projection * view * model * vec4(position, 1.0);
 }
 
 
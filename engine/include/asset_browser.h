@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+
+// Editor panel for browsing the mounted asset folders with image thumbnails.
+// Thumbnails are made on the Jobs workers (decode + SIMD box downscale), kept in a disk
+// cache keyed by path, size and modification time, and packed into one atlas texture
+// so the whole grid draws from a single GL texture. Only the rows on screen are laid out
+// and only visible thumbnails are requested, so folders with thousands of files scroll
+// smoothly; atlas cells of thumbnails scrolled away are reused least recently used first.
+// Main (GL) thread only.
+class AssetBrowser {
+public:
+    static constexpr int kThumbSize = 64;   // thumbnails fit in kThumbSize x kThumbSize
+    static constexpr int kAtlasSize = 1024; // 16 x 16 cells
+
+    enum class ThumbState {
+        Pending,   // queued or being made
+        Ready,
+        Failed,    // not an image we can decode
+    };
+
+    explicit AssetBrowser(const std::string& cacheDir);
+    ~AssetBrowser();
+    AssetBrowser(const AssetBrowser&) = delete;
+    AssetBrowser& operator=(const AssetBrowser&) = delete;
+
+    // Draw the panel. Returns the virtual path of a file double-clicked this frame, "" otherwise.
+    std::string Draw();
+    // Start queued thumbnail jobs and upload finished ones; once per frame
+    void Update();
+
+    // Thumbnail of any image path (virtual or on disk), requesting it if needed.
+    // When Ready, texture + uv (u0, v0, u1, v1) locate it in the atlas.
+    ThumbState Thumbnail(const std::string& path, GLuint& texture, float uv[4]);
+
+    static bool IsImageFile(const std::string& path);
+    // .obj, .gltf, .glb or a cooked .spxmesh
+    static bool IsModelFile(const std::string& path);
+
+private:
+    struct Item {
+        std::string name;        // file or folder name
+        std::string path;        // virtual path (mount point + path in the mount)
+        bool folder = false;
+        bool image = false;
+    };
+    struct Thumb {
+        ThumbState state = ThumbState::Pending;
+        bool started = false;    // job submitted
+        int cell = -1;           // atlas cell once Ready
+        int width = 0;           // thumbnail size inside the cell
+        int height = 0;
+        uint64_t lastUsed = 0;   // frame of the last Thumbnail call
+    };
+    struct Results;              // shared with the workers
+
+    void Scan();
+    void Navigate(const std::string& folder);
+    void StartJob(const std::string& path);
+    int AllocCell();
+
+    std::string m_cacheDir;
+    std::shared_ptr<Results> m_results;
+
+    // Folder being shown: m_folder is relative to the mount's root ("" or ending in '/')
+    int m_mount = 0;
+    std::string m_mountRoot;
+    std::string m_mountPoint;
+    std::vector<std::string> m_mountNames; // for the mount picker, filled by Scan
+    std::string m_folder;
+    std::vector<Item> m_items;
+    bool m_scanned = false;
+    char m_filter[64] = {};
+
+    // Thumbnails by path, the queue of requested ones and the atlas
+    std::unordered_map<std::string, Thumb> m_thumbs;
+    std::deque<std::string> m_queue;
+    int m_inFlight = 0;
+    GLuint m_atlas = 0;
+    std::vector<int> m_freeCells;
+    std::vector<std::string> m_cellOwner; // path in each cell, "" = free
+    uint64_t m_frame = 0;
+};
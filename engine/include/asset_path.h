@@ -1,4 +1,24 @@
 #pragma once
 #include <string>
+#include <vector>
 
-std::string GetAssetPath(const std::string& relativePath);
\ No newline at end of file
+class MappedFile;
+class PakArchive;
+
+// String front end of the Vfs (vfs.h). Paths are virtual ("shaders/default.vert") and
+// resolve the same way loose or packed; new code can keep a Vfs::AssetId instead.
+
+// Loose file behind a virtual path, or the virtual path itself when the asset is packed
+// or missing. Only needed for code that has to see the real file (file watchers, tools).
+std::string GetAssetPath(const std::string& relativePath);
+
+// Shipping builds mount one .spxpak before anything loads, so the development assets
+// folder is never mounted and nothing is probed on disk.
+bool MountAssetPack(const std::string& pakPath);
+void UnmountAssetPack();
+const PakArchive* GetAssetPack();
+
+// Whole asset file, see Vfs::Read
+bool ReadAssetFile(const std::string& path, std::vector<unsigned char>& out);
+// Map an asset, see Vfs::Open
+bool OpenAssetFile(const std::string& path, MappedFile& file);
@@ -10,8 +10,13 @@
 #include "../src/Input/EditorInput.h" // Editor input handling
 // Forward-declare to avoid pulling shader header into every consumer
 class Shader;
+class AssetBrowser;
+class SceneSaver;
 
 #include "entity.h" // Engine will own the Entity and the entity vector
+#include "mesh.h"
+#include "terrain.h"
+#include "world_partition.h"
 #include <glm/gtc/matrix_inverse.hpp> // optional, glm::inverse already available via gtc/matrix_transform if included
 
 
@@ -20,6 +25,27 @@ struct EngineConfig {
     bool enableImGui = false;
     bool enableDocking = true;
     float clearColor[4] = { 0.12f, 0.15f, 0.18f, 1.0f };
+    // Texture cook step: block-compress textures on load (None = plain RGBA8)
+    TextureCompress::Format textureFormat = TextureCompress::Format::Auto;
+    TextureCompress::Quality textureQuality = TextureCompress::Quality::Fast; // High = slower load, better quality
+    size_t textureBudgetMB = 512; // GPU texture memory budget, 0 = unlimited
+    // Mesh cook step: vertex layout of cooked meshes (Float8 = full precision floats)
+    VertexFormat meshVertexFormat = VertexFormat::Packed16;
+    int meshLodCount = 4;          // LOD levels generated per cooked mesh (1 = none)
+    float lodPixelError = 1.0f;    // screen-space error allowed when picking a LOD
+    std::string assetPack;         // .spxpak to serve assets from (empty = loose files)
+    bool hotReload = true;         // watch the loose asset folders, reload changed textures/shaders
+    std::string programCacheDir = "cache/programs"; // linked shader binaries (empty = always compile)
+    std::string thumbnailCacheDir = "cache/thumbnails"; // asset browser thumbnails (empty = not cached)
+    std::string fontCacheDir = "cache/fonts"; // baked ImGui font atlas (empty = rasterize every launch)
+    std::string textureCacheDir = "cache/textures"; // block-compressed mip chains (empty = encode on every load)
+    int autosaveSeconds = 120;     // background autosave interval (0 = off)
+    std::string autosaveDir = "autosave"; // <scene name>.autosave.spxscene, LZ4 packed
+    float farPlane = 1000.0f;      // camera far clip distance, covers the streaming radius
+    float originRebaseDistance = 1024.0f; // shift the world back to the origin when the camera gets this far (0 = never), keep it a power of two
+    std::string worldPath;         // .spxworld streamed around the camera (empty = none)
+    WorldPartition::Settings world; // cell size for exports, streaming radii and budgets
+    Terrain::Settings terrain;     // chunked heightmap terrain (terrain.heightmap empty = none)
 };
 const ImVec4 COLOR_LIGHTBLUE(0.43f, 0.7f, 0.89f, 1.0f);
 
@@ -47,9 +73,32 @@ public:
     void AddPlane(const glm::vec3& pos = glm::vec3(0.0f));
 	// Add a floor to the scene at the given position (default center)
 	void AddFloor(const glm::vec3& pos = glm::vec3(0.0f));
+    // Add a model (.obj, .gltf, .glb or .spxmesh); it is cooked and uploaded in the background
+    void AddMesh(const std::string& path, const glm::vec3& pos = glm::vec3(0.0f));
+
+    // Scenes (.spxscene, see scene_file.h, or .spx text). New and Load replace the current entities.
+    // SaveScene only queues the save: the entities are snapshotted at the end of the frame
+    // and written on a worker, see UpdateSaves.
+    void NewScene();
+    bool LoadScene(const std::string& path);
+    bool SaveScene(const std::string& path);
+    const std::string& GetScenePath() const { return m_scenePath; }
+
+    // Streamed worlds (see world_partition.h). Export splits the scene's own entities into
+    // cells of world.cellSize; Open streams a world in around the camera next to them.
+    bool OpenWorld(const std::string& manifestPath);
+    void CloseWorld();
+    bool ExportWorld(const std::string& manifestPath);
 
     // Access camera
     Camera& GetCamera() { return m_camera; }
+    // Heightmap terrain, see terrain.h
+    Terrain& GetTerrain() { return m_terrain; }
+
+    // Floating origin: entity and camera positions are floats relative to this world
+    // position, which moves in whole steps when the camera strays (see UpdateOrigin).
+    const glm::dvec3& GetOrigin() const { return m_origin; }
+    glm::dvec3 WorldPosition(const GameObj& obj) const { return m_origin + glm::dvec3(obj.position); }
 
 
 private:
@@ -58,6 +107,7 @@ private:
     std::unique_ptr<SpxWindow> window;
     GLFWwindow* glfwwindow = nullptr;
     std::unique_ptr<EditorInput> m_input;
+    std::unique_ptr<AssetBrowser> m_assetBrowser; // editor panel, only with ImGui
 
     // Engine-owned entity state
     std::unique_ptr<Entity> m_entity;
@@ -66,8 +116,34 @@ private:
     int m_planeObjIdx; // 0 plane object index
     int m_cubeObjIdx;  // 0 cube object index
 	int m_floorObjIdx; //0 floor object index
+    int m_meshObjIdx = 0; // model object index
 
     int m_selectedEntityIndex = -1; // -1 = none selected
+    std::string m_scenePath;        // file of the open scene, "" = never saved
+    std::unique_ptr<SceneSaver> m_sceneSaver;
+    std::string m_pendingSavePath;  // save requested this frame, started at the frame boundary
+    std::chrono::steady_clock::time_point m_lastAutosave;
+
+    WorldPartition m_world;
+    Terrain m_terrain;
+    glm::dvec3 m_origin = glm::dvec3(0.0);
+
+    // After the frame: rebase when the camera is originRebaseDistance away from the origin
+    void UpdateOrigin();
+    // Move the origin by shift, in one batched pass over every transform and the camera
+    void ShiftOrigin(const glm::vec3& shift);
+
+    // Copy the entity store into scene columns (cleared first), streamed entities excluded
+    void SnapshotScene(SceneFile::Columns& scene) const;
+    // Create the entity of one scene row and append it, nullptr for unknown types.
+    // id -1 keeps the id stored in the scene, streamed cells pass a fresh one.
+    GameObj* SpawnEntity(const SceneFile::Columns& scene, size_t row, int id = -1);
+    // Remove streamed entities (ids as handed out by UpdateWorld), all of them when ids is null
+    void RemoveStreamedEntities(const std::vector<int>* ids);
+    // After the frame: stream world cells in and out around the camera
+    void UpdateWorld();
+    // End of frame: report finished saves, start a queued save or a due autosave
+    void UpdateSaves();
 
     // Engine-owned shader for plane rendering
     std::unique_ptr<Shader> m_planeShader;
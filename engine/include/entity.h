@@ -9,12 +9,16 @@
 #include "../include/log.h"
 #include "../include/globalVar.h"
 #include "../include/textures.h"
+#include "../include/lod_selector.h"
+#include "../include/mesh_cache.h"
 
 // Forward-declare Shader to avoid including its header here
 class Shader;
+class Camera;
 
 struct GameObj { // Any game object not player-related 
-    virtual ~GameObj() = default; // make polymorphic for safe dynamic_cast
+    // make polymorphic for safe dynamic_cast; drops this object's texture reference
+    virtual ~GameObj() { if (texHandle != INVALID_TEXTURE) TextureManager::Release(texHandle); }
 
     GameObj()
         : entId(-1),
@@ -32,10 +36,13 @@ struct GameObj { // Any game object not player-related
         isDangerous(false),
         isCollidable(true),
         isVisible(true),
-        tex_ID(0),
-        texPath("")
+        isStreamed(false),
+        texHandle(INVALID_TEXTURE)
     {
     }
+    // a copy would release texHandle twice
+    GameObj(const GameObj&) = delete;
+    GameObj& operator=(const GameObj&) = delete;
 
     int entId;          // individual entity ID
     int entTypeID;      // type of entity ie; plane, cube, npc, pickup etc
@@ -54,9 +61,11 @@ struct GameObj { // Any game object not player-related
     bool isDangerous;
     bool isCollidable;      // Collision detection on or off, off for things like grass or small decor
     bool isVisible;         // Render or not
+    bool isStreamed;        // spawned by world streaming: removed with its cell, not saved with the scene
 
-    unsigned int tex_ID;
-	std::string texPath; // path to the texture file, used for loading and debugging, not used at runtime after texture is loaded
+    // Texture reference owned by this object. The GL id and path live in TextureManager:
+    // TextureManager::GetGLId(texHandle) / TextureManager::GetPath(texHandle)
+    TextureHandle texHandle;
 };
 
 class Entity // Give this more thought !!
@@ -84,9 +93,38 @@ public:
     void RenderFloor(Shader* shader, const glm::mat4& view, const glm::mat4& projection,
         std::vector<std::unique_ptr<GameObj>>& entVector, int& currentIndex, int& FloorObjIdx, int& selectedEntityId);
 
-    bool SetTextureForGameObj(GameObj* obj, const std::string& path);
+    // Create an imported model (.obj, .gltf, .glb or a cooked .spxmesh). It is cooked and
+    // uploaded in the background (see MeshCache) and draws once it is ready.
+    void CreateMesh(std::vector<std::unique_ptr<GameObj>>& entVector, int& currentIndex,
+        int& MeshObjIdx, const std::string& path, const glm::vec3& position = glm::vec3(0.0f));
+
+    // Draw the models, each at the coarsest LOD its size on screen allows (LodSelector)
+    void RenderMesh(Shader* shader, const glm::mat4& view, const glm::mat4& projection,
+        const std::vector<std::unique_ptr<GameObj>>& entVector, int selectedEntityId);
+
+    // What the last RenderMesh drew
+    struct MeshDrawStats {
+        int drawn = 0;
+        int reduced = 0;        // drawn at a LOD above 0
+        size_t triangles = 0;
+    };
+    const MeshDrawStats& GetMeshDrawStats() const { return m_meshStats; }
+
+    // Swap the object's texture ("" clears it). With async the image is decoded on the
+    // workers and the object draws untextured until it is uploaded; a bad file is then only
+    // reported in the log instead of through the return value.
+    bool SetTextureForGameObj(GameObj* obj, const std::string& path, bool async = false);
+
+    // Camera + viewport height used to estimate on-screen texture size for mip streaming.
+    // Set before the Render* calls each frame; nullptr turns the requests off.
+    void SetViewInfo(const Camera* camera, float viewportHeight);
 
 private:
+    void RequestTextureMip(const GameObj* obj) const;
+
+    const Camera* m_viewCamera = nullptr;
+    float m_viewportHeight = 0.0f;
+    MeshDrawStats m_meshStats;
 
     
     
@@ -335,3 +373,20 @@ public:
 private:
 
 };
+
+// Imported model. The buffers and material textures are shared through MeshCache by
+// every instance of the same file; the LOD choice is per instance.
+class MeshModel : public GameObj {
+public:
+    MeshModel(int idx, const std::string& name, int Meshobjidx, const std::string& path)
+        : meshPath(path), mesh(MeshCache::Acquire(path)) {
+        entId = idx;
+        entName = name;
+        entObjectIndex = Meshobjidx;
+        entTypeID = OBJ_MESH; // from globalVar.h = 13
+    }
+
+    std::string meshPath;                    // source file, saved with the scene
+    std::shared_ptr<const LoadedMesh> mesh;  // nullptr for an empty path
+    LodSelector lod;                         // keeps this instance's hysteresis state
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+
+// Native open/save file dialogs. OpenAsync/SaveAsync show them on their own thread so
+// the editor keeps rendering (and stays usable) while the user browses; the main thread
+// picks up the choice with TakeResult. One dialog at a time. Windows only for now,
+// elsewhere the dialog reports a cancel.
+namespace FileDialog {
+
+    enum class Filter {
+        Images,
+        Scenes,
+        Worlds,
+        Models,
+        All,
+    };
+
+    // Blocks until the dialog closes, "" when cancelled
+    std::string Open(Filter filter);
+    // Asks before overwriting; adds the filter's extension when the user typed none
+    std::string Save(Filter filter);
+
+    // requestId tells the caller what the dialog was for (e.g. the entity id).
+    // False when a dialog is already showing.
+    bool OpenAsync(Filter filter, int requestId);
+    bool SaveAsync(Filter filter, int requestId);
+    bool IsOpen();
+    // True once per closed async dialog; path is "" when it was cancelled
+    bool TakeResult(int& requestId, std::string& path);
+
+    // Call on shutdown; a dialog still showing is left to close with the process
+    void Shutdown();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Watches folders (recursively) on a background thread: inotify on Linux,
+// ReadDirectoryChangesW on Windows. Editors save in several steps (truncate, write,
+// rename), so a file is only reported once it has been quiet for the debounce time.
+// The owner collects the changes on its own thread with TakeChanges.
+class FileWatcher {
+public:
+    struct Change {
+        size_t root = 0;         // index into the roots given to Start
+        std::string path;        // relative to that root, '/' separators
+    };
+
+    FileWatcher() = default;
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool Start(const std::vector<std::string>& roots, int debounceMs = 200);
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+
+    // Files that settled since the last call, each reported once
+    std::vector<Change> TakeChanges();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Run();
+    // Called by the platform loop for every raw event
+    void Touch(size_t root, std::string path);
+    // Move files quiet for the debounce time to m_ready
+    void Settle();
+
+    std::vector<std::string> m_roots;
+    std::chrono::milliseconds m_debounce{ 200 };
+    std::thread m_thread;
+    std::atomic<bool> m_stop{ false };
+
+    std::map<std::pair<size_t, std::string>, Clock::time_point> m_pending; // watcher thread only
+    std::mutex m_mutex;                                                    // guards m_ready
+    std::vector<Change> m_ready;
+};
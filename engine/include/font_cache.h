@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct ImFontAtlas;
+
+// Disk cache of baked ImGui font atlases: the Alpha8 pixels, the glyph tables and the
+// atlas UVs (white pixel, baked lines, mouse cursors). Rasterizing the fonts with
+// stb_truetype is most of the ImGui startup cost; a warm start restores the atlas
+// instead. Entries are keyed by the font file bytes, sizes, glyph ranges and every config
+// field that changes the bake, so an edited font or size is simply a miss. A damaged or
+// mismatching entry is deleted and the caller builds the atlas as usual.
+namespace FontCache {
+
+    constexpr uint32_t kVersion = 1;
+    constexpr const char* kExtension = ".spxfont";
+
+    // Folder for the entries (created on the first store), empty = cache off.
+    // Set it before any thread calls Load or Store.
+    void SetDirectory(const std::string& directory);
+    const std::string& Directory();
+
+    // Key of an atlas whose fonts were added (AddFont*) but not built yet
+    uint64_t Key(const ImFontAtlas* atlas);
+
+    // Restore a baked atlas into an atlas with the same fonts added and not built yet.
+    // On success the atlas is ready (IsBuilt) without rasterizing anything.
+    bool Load(ImFontAtlas* atlas, uint64_t key);
+    // Store a built atlas. Colored atlases (no Alpha8 pixels) are not cached.
+    bool Store(const ImFontAtlas* atlas, uint64_t key);
+}
@@ -1,7 +1,13 @@
 #pragma once
 
+// Virtual asset paths (see vfs.h), the same for loose files and packs
 constexpr const char* TEXTURE_PATH = "assets/textures/";
 constexpr const char* SHADER_PATH = "Shaders/";
+constexpr const char* CUBE_TEXTURE = "assets/textures/crate.jpg";
+constexpr const char* PLANE_TEXTURE = "assets/textures/github.jpg";
+constexpr const char* FLOOR_TEXTURE = "assets/textures/stone.jpg";
+constexpr const char* DEFAULT_VERT_SHADER = "Shaders/default.vert";
+constexpr const char* DEFAULT_FRAG_SHADER = "Shaders/default.frag";
 
 
 extern const int MAIN_GRID;
@@ -18,5 +24,6 @@ extern const int OBJ_PYRAMID;
 extern const int OBJ_TRIANGEL;
 
 extern const int OBJ_FLOOR;
+extern const int OBJ_MESH;
 
 //extern bool ShouldAddPlane;
@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "mapped_file.h"
+#include "mesh.h"
+
+
+// glTF 2.0 scene description as read from the JSON. Indices refer to the arrays
+// in GltfModel, -1 = not present.
+struct GltfBufferView {
+    int buffer = -1;
+    size_t byteOffset = 0;
+    size_t byteLength = 0;
+    size_t byteStride = 0;   // 0 = tightly packed
+};
+
+struct GltfAccessor {
+    int bufferView = -1;
+    size_t byteOffset = 0;
+    GLenum componentType = GL_FLOAT; // glTF uses the GL enums directly
+    bool normalized = false;
+    size_t count = 0;
+    int components = 1;              // SCALAR 1, VEC2 2, VEC3 3, VEC4 4, MAT4 16
+    bool hasBounds = false;
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+struct GltfPrimitive {
+    int position = -1;   // accessors
+    int normal = -1;
+    int texcoord = -1;
+    int indices = -1;
+    int material = -1;
+    GLenum mode = GL_TRIANGLES;
+};
+
+struct GltfMesh {
+    std::string name;
+    std::vector<GltfPrimitive> primitives;
+};
+
+struct GltfMaterial {
+    std::string name;
+    glm::vec4 baseColor = glm::vec4(1.0f);
+    float metallic = 1.0f;
+    float roughness = 1.0f;
+    int baseColorTexture = -1; // textures
+    int normalTexture = -1;
+    bool doubleSided = false;
+    bool alphaBlend = false;
+    float alphaCutoff = 0.0f;  // alphaMode MASK, 0 = opaque
+};
+
+struct GltfImage {
+    std::string path;      // resolved file path for external images
+    int bufferView = -1;   // embedded image (GLB / data uri)
+    std::string mimeType;
+};
+
+struct GltfTexture {
+    int image = -1;
+};
+
+struct GltfNode {
+    std::string name;
+    int parent = -1;
+    std::vector<int> children;
+    int mesh = -1;
+    glm::mat4 local = glm::mat4(1.0f);
+    glm::mat4 world = glm::mat4(1.0f); // computed at load
+    bool inScene = false;              // reachable from the default scene
+};
+
+// Zero-copy glTF / GLB reader. The .glb (or the .gltf + its .bin files) stay memory
+// mapped while the model is alive and accessors are read straight from the mapping.
+// The JSON is read with the single-pass JsonDocument tokenizer. No GL calls, so it is
+// safe on a worker thread.
+// glTF is not drawn directly: MeshFile::ImportSource flattens it with ToMeshData, the
+// cooker writes a .spxmesh and the game loads that through MeshCache like any other model.
+class GltfModel {
+public:
+    GltfModel() = default;
+    GltfModel(const GltfModel&) = delete;
+    GltfModel& operator=(const GltfModel&) = delete;
+
+    // Parse the file and map its buffers
+    bool Load(const std::string& path);
+
+    // Flatten all mesh instances into one MeshData with world transforms applied,
+    // uvs flipped to the engine convention and one submesh per primitive. Used by the
+    // mesh cooker and the optimisers.
+    bool ToMeshData(MeshData& mesh) const;
+
+    // Raw bytes of a bufferView inside the mapped file(s), nullptr if out of range
+    const uint8_t* BufferViewData(int view) const;
+
+    const std::string& Path() const { return m_path; }
+    const std::vector<GltfNode>& Nodes() const { return m_nodes; }
+    const std::vector<int>& SceneRoots() const { return m_sceneRoots; }
+    const std::vector<GltfMesh>& Meshes() const { return m_meshes; }
+    const std::vector<GltfMaterial>& Materials() const { return m_materials; }
+    const std::vector<GltfTexture>& Textures() const { return m_textures; }
+    const std::vector<GltfImage>& Images() const { return m_images; }
+    const std::vector<GltfAccessor>& Accessors() const { return m_accessors; }
+    const std::vector<GltfBufferView>& BufferViews() const { return m_bufferViews; }
+
+private:
+    struct Buffer {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    bool ParseJson(const char* json, size_t size, const uint8_t* glbBin, size_t glbBinSize);
+    bool ReadAccessor(int accessor, int wantComponents, std::vector<float>& out) const;
+    bool ReadIndices(int accessor, std::vector<uint32_t>& out) const;
+
+    std::string m_path;
+    std::string m_baseDir;
+    MappedFile m_file;                      // the .glb or .gltf
+    std::vector<MappedFile> m_binFiles;     // external .bin buffers
+    std::vector<std::vector<uint8_t>> m_decoded; // base64 data: uri buffers (the only copies)
+    std::vector<Buffer> m_buffers;
+
+    std::vector<GltfBufferView> m_bufferViews;
+    std::vector<GltfAccessor> m_accessors;
+    std::vector<GltfMesh> m_meshes;
+    std::vector<GltfMaterial> m_materials;
+    std::vector<GltfTexture> m_textures;
+    std::vector<GltfImage> m_images;
+    std::vector<GltfNode> m_nodes;
+    std::vector<int> m_sceneRoots;
+};
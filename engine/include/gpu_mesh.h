@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "mesh.h"
+
+class Shader;
+
+// Vertex + index buffer pair with its VAO, the GPU side of a MeshData / cooked mesh.
+// Attribute locations match the engine shaders (0 position, 1 normal, 2 uv).
+// Main thread only, like all GL objects.
+class GpuMesh {
+public:
+    GpuMesh() = default;
+    ~GpuMesh();
+    GpuMesh(const GpuMesh&) = delete;
+    GpuMesh& operator=(const GpuMesh&) = delete;
+
+    // Upload raw buffers that are already in GPU layout (e.g. straight from a mapped file)
+    bool Upload(VertexFormat format, const void* vertices, size_t vertexCount,
+        const void* indices, size_t indexCount, GLenum indexType);
+    // Upload a CPU mesh (32-bit indices) including its submeshes/LODs, packing the
+    // vertices first when a quantized format is asked for
+    bool Upload(const MeshData& mesh, VertexFormat format = VertexFormat::Float8);
+
+    void SetSubmeshes(std::vector<MeshSubmesh> submeshes, std::vector<MeshLod> lods);
+    // Bounds the packed positions are relative to (set by the MeshData / cooked upload)
+    void SetBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    // u_vertexFormat / u_posCenter / u_posExtent for default.vert. Call before Draw with
+    // the shader bound; Float8 meshes set u_vertexFormat back to 0.
+    void ApplyDecodeUniforms(const Shader& shader) const;
+
+    // Draw every submesh of a LOD (clamped to the available levels)
+    void Draw(int lod = 0) const;
+    void DrawSubmesh(const MeshSubmesh& submesh) const;
+    void Release();
+
+    bool IsValid() const { return m_vao != 0; }
+    GLuint Vao() const { return m_vao; }
+    VertexFormat Format() const { return m_format; }
+    size_t VertexCount() const { return m_vertexCount; }
+    size_t IndexCount() const { return m_indexCount; }
+    size_t GpuBytes() const { return m_gpuBytes; }
+    int LodCount() const { return m_lods.empty() ? 1 : static_cast<int>(m_lods.size()); }
+    const std::vector<MeshSubmesh>& Submeshes() const { return m_submeshes; }
+    const std::vector<MeshLod>& Lods() const { return m_lods; }
+    const glm::vec3& BoundsMin() const { return m_boundsMin; }
+    const glm::vec3& BoundsMax() const { return m_boundsMax; }
+
+    // Bytes per vertex of a format
+    static size_t VertexStride(VertexFormat format);
+
+private:
+    GLuint m_vao = 0;
+    GLuint m_vbo = 0;
+    GLuint m_ebo = 0;
+    GLenum m_indexType = GL_UNSIGNED_INT;
+    VertexFormat m_format = VertexFormat::Float8;
+    size_t m_vertexCount = 0;
+    size_t m_indexCount = 0;
+    size_t m_gpuBytes = 0;
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsMax = glm::vec3(0.0f);
+    std::vector<MeshSubmesh> m_submeshes;
+    std::vector<MeshLod> m_lods;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Non-cryptographic hashes used for file checksums, asset ids and cache keys.
+// Stable across runs and platforms (they end up in files on disk), so never change
+// the constants without bumping the version of every format that stores them.
+namespace Hash {
+
+    // FNV-1a, fine for short strings (paths, names)
+    constexpr uint64_t Fnv1a64(std::string_view text, uint64_t seed = 0xCBF29CE484222325ull) {
+        uint64_t h = seed;
+        for (char c : text) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001B3ull;
+        }
+        return h;
+    }
+
+    inline uint64_t Mix64(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // Fast hash for large blobs: four independent multiply-rotate lanes over 32 byte
+    // blocks (several GB/s), then the tail a byte at a time. Used for file checksums.
+    inline uint64_t Bytes64(const void* data, size_t size, uint64_t seed = 0) {
+        constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+        constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+        auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+        auto round = [&](uint64_t acc, uint64_t lane) { return rotl(acc + lane * kPrime2, 31) * kPrime1; };
+
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        const unsigned char* end = p + size;
+        uint64_t v[4] = { seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1 };
+        while (end - p >= 32) {
+            for (int i = 0; i < 4; ++i) {
+                uint64_t lane;
+                std::memcpy(&lane, p + i * 8, 8);
+                v[i] = round(v[i], lane);
+            }
+            p += 32;
+        }
+        uint64_t h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18) + static_cast<uint64_t>(size);
+        while (p < end) {
+            h = rotl(h ^ (*p++ * kPrime1), 11) * kPrime2;
+        }
+        return Mix64(h);
+    }
+}
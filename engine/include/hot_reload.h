@@ -0,0 +1,15 @@
+#pragma once
+
+// Editor hot reload. A FileWatcher thread watches the loose asset folders (the Vfs folder
+// mounts) and Update, on the main thread, swaps changed textures and shader programs in
+// place: TextureHandles held by GameObj and Shader pointers stay valid, and a shader
+// that no longer compiles keeps its old program. Nothing to watch when only packs are mounted.
+namespace HotReload {
+
+    bool Start(int debounceMs = 200);
+    void Stop();
+    bool IsRunning();
+
+    // Once per frame on the GL thread. Returns the number of assets reloaded.
+    int Update();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Small worker-thread pool shared by the engine for CPU-side work
+// (texture cooking, model imports, etc). GL calls must stay on the main thread.
+namespace Jobs {
+    // Start the workers. workerCount 0 = one per hardware thread minus the main thread.
+    // Called lazily by Submit/ParallelFor if the engine has not started it yet, also after
+    // a Shutdown. Does nothing while the workers run.
+    void Init(unsigned workerCount = 0);
+    // Finish the queued tasks and join the workers
+    void Shutdown();
+
+    unsigned WorkerCount();
+
+    // Queue a fire-and-forget task to run on a worker thread
+    void Submit(std::function<void()> task);
+
+    // Split [0, count) into batches of batchSize and run fn(begin, end) on the workers.
+    // The calling thread helps out and the call blocks until every batch is done,
+    // so it is safe to call from inside another job.
+    void ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& fn);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Single-pass JSON tokenizer (jsmn style) used by the glTF loader.
+// Parse() walks the text once and records a flat token array that points back into
+// the caller's buffer: no strings or numbers are copied, the only allocation is the
+// token vector. The buffer must outlive the document.
+//
+// Containers list their direct children right after themselves. For an object the
+// children alternate key, value. Token::next is the index after the whole subtree,
+// which makes skipping a value O(1):
+//     for (int k = doc.FirstChild(obj); k != doc.End(obj); k = doc.Next(k + 1)) { key = k, value = k + 1 }
+struct JsonToken {
+    enum Type : uint8_t { Invalid = 0, Object, Array, String, Primitive };
+    Type type = Invalid;
+    uint32_t start = 0;    // byte range in the text (strings exclude the quotes)
+    uint32_t end = 0;
+    uint32_t size = 0;     // direct children (object: 2 per member)
+    uint32_t next = 0;     // first token after this subtree
+};
+
+class JsonDocument {
+public:
+    bool Parse(const char* text, size_t size);
+    const std::string& Error() const { return m_error; }
+
+    int Root() const { return m_tokens.empty() ? -1 : 0; }
+    size_t TokenCount() const { return m_tokens.size(); }
+    const JsonToken& Token(int index) const { return m_tokens[static_cast<size_t>(index)]; }
+    JsonToken::Type Type(int index) const { return index < 0 ? JsonToken::Invalid : m_tokens[static_cast<size_t>(index)].type; }
+
+    // Child iteration: FirstChild .. End, stepping with Next
+    int FirstChild(int index) const { return index + 1; }
+    int Next(int index) const { return static_cast<int>(m_tokens[static_cast<size_t>(index)].next); }
+    int End(int index) const { return Next(index); }
+    // Array element count / object member count
+    int Count(int index) const;
+
+    // Value of key in an object, -1 if missing (or index is not an object)
+    int Find(int object, std::string_view key) const;
+    // i-th array element, -1 if out of range (linear in i, iterate for whole arrays)
+    int At(int array, int i) const;
+
+    // Raw text of a token (strings without quotes and with escapes left in place)
+    std::string_view Raw(int index) const;
+    bool Equals(int index, std::string_view text) const;
+    // String value with escapes resolved (allocates, use for names/uris only)
+    std::string String(int index) const;
+
+    double Number(int index, double fallback = 0.0) const;
+    int64_t Int(int index, int64_t fallback = 0) const;
+    bool Bool(int index, bool fallback = false) const;
+
+    // Shorthands for object members with a default
+    double NumberOf(int object, std::string_view key, double fallback = 0.0) const { return Number(Find(object, key), fallback); }
+    int64_t IntOf(int object, std::string_view key, int64_t fallback = 0) const { return Int(Find(object, key), fallback); }
+    bool BoolOf(int object, std::string_view key, bool fallback = false) const { return Bool(Find(object, key), fallback); }
+    std::string StringOf(int object, std::string_view key) const { int v = Find(object, key); return v < 0 ? std::string() : String(v); }
+
+private:
+    const char* m_text = nullptr;
+    std::vector<JsonToken> m_tokens;
+    std::string m_error;
+};
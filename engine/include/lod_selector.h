@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+
+#include "mesh.h"
+
+// Runtime LOD choice for one drawn mesh instance. A level's error (model units) is
+// scaled to pixels with the projected size and the coarsest level under the pixel
+// threshold wins. Coarsening needs the error to drop below threshold * (1 - hysteresis),
+// so an object sitting at a switch distance does not flicker between two levels.
+class LodSelector {
+public:
+    struct Settings {
+        float pixelError = 1.0f;   // allowed screen-space error in pixels
+        float hysteresis = 0.3f;   // width of the no-switch band, fraction of pixelError
+    };
+
+    // radius: bounding radius in model units, projectedRadius: the same radius in pixels
+    // (Camera::ProjectedSize). Returns the level to draw.
+    int Select(const std::vector<MeshLod>& lods, float radius, float projectedRadius);
+    int Current() const { return m_current; }
+    void Reset() { m_current = 0; }
+
+    // Screen-space error of a level in pixels
+    static float PixelError(const MeshLod& lod, float radius, float projectedRadius);
+
+    static void SetSettings(const Settings& settings);
+    static const Settings& GetSettings();
+
+private:
+    int m_current = 0;
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// LZ4 block format (no frame header): greedy single-pass compressor and a bounds
+// checked decompressor. Used for pack entries, where decode speed matters more than
+// ratio. The caller stores the decompressed size next to the block.
+namespace Lz4 {
+
+    // Worst case compressed size of `size` input bytes
+    size_t CompressBound(size_t size);
+
+    // Returns the compressed size, 0 if it does not fit in `capacity`
+    size_t Compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+
+    // Decodes exactly dstSize bytes. False on malformed or truncated input.
+    bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only memory mapped file (CreateFileMapping on Windows, mmap elsewhere).
+// The view stays valid until Close() or the object is destroyed.
+// It can also stand in for a file that lives elsewhere: a view into memory owned by
+// someone else (a stored pack entry) or an owned buffer (a decompressed one).
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const std::string& path);
+    // Not owned: owner, when given, is held until Close() so the memory can't go away
+    // under the view; without one the memory must outlive this object
+    bool OpenView(const void* data, size_t size, std::shared_ptr<const void> owner = nullptr);
+    bool OpenBuffer(std::vector<uint8_t>&& buffer);
+    void Close();
+
+    bool IsOpen() const { return m_open; }
+    const char* Data() const { return static_cast<const char*>(m_data); }
+    size_t Size() const { return m_size; }
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;  // empty files are open but have no view (m_data == nullptr)
+    bool m_mapped = false; // m_data is our own OS mapping
+    std::vector<uint8_t> m_buffer;
+    std::shared_ptr<const void> m_owner;  // backing memory of a view
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
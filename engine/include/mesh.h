@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// CPU-side mesh produced by the model importers. Vertices use the same interleaved
+// 8-float layout as the built-in models: position (3), normal (3), uv (2).
+constexpr int MESH_VERTEX_FLOATS = 8;
+
+// Vertex layouts a GPU vertex buffer can be in (stored in cooked .spxmesh files)
+enum class VertexFormat : uint32_t {
+    Float8 = 0,   // float pos3 normal3 uv2, 32 bytes
+    // Quantized layouts (see vertex_quantize.h), decoded in the vertex shader.
+    // Positions are snorm16 relative to the mesh bounds, normals octahedral.
+    Packed16 = 1, // snorm16 pos3 + pad, snorm16 oct normal2, half uv2, 16 bytes
+    Packed12 = 2, // snorm16 pos3, snorm8 oct normal2, half uv2, 12 bytes
+};
+
+struct MeshMaterial {
+    std::string name;
+    glm::vec3 ambient = glm::vec3(0.0f);
+    glm::vec3 diffuse = glm::vec3(0.8f);
+    glm::vec3 specular = glm::vec3(0.0f);
+    float shininess = 0.0f;
+    float opacity = 1.0f;
+    float alphaCutoff = 0.0f;    // > 0 = cutout, texels with less alpha are discarded
+    std::string diffuseTexture;  // full path or MeshImage name, empty if none
+    std::string normalTexture;
+};
+
+// Range of the index buffer drawn with one material
+struct MeshSubmesh {
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    int materialIndex = -1;      // into MeshData::materials, -1 = default material
+};
+
+// One level of detail: a run of submeshes (and so of the index buffer) sharing the
+// vertex buffer with the other levels. LOD 0 is the full mesh.
+struct MeshLod {
+    uint32_t submeshOffset = 0;  // into MeshData::submeshes
+    uint32_t submeshCount = 0;
+    float error = 0.0f;          // geometric error in model units (0 for LOD 0)
+};
+
+// Image stored inside the source model (GLB chunk / data uri). Materials refer to it
+// by name; MeshFile::Write saves it as a file next to the cooked mesh.
+struct MeshImage {
+    std::string name;          // "<source>#image<N>"
+    std::string extension;     // ".png", ".jpg"
+    std::vector<uint8_t> bytes;
+};
+
+struct MeshData {
+    std::vector<float> vertices;     // MESH_VERTEX_FLOATS per vertex
+    std::vector<uint32_t> indices;   // triangle list
+    std::vector<MeshSubmesh> submeshes;
+    std::vector<MeshMaterial> materials;
+    std::vector<MeshLod> lods;       // empty = single level made of all submeshes
+    std::vector<MeshImage> images;   // embedded textures
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    size_t VertexCount() const { return vertices.size() / MESH_VERTEX_FLOATS; }
+    size_t TriangleCount() const { return indices.size() / 3; }
+
+    void Clear() {
+        vertices.clear();
+        indices.clear();
+        submeshes.clear();
+        materials.clear();
+        lods.clear();
+        images.clear();
+        boundsMin = boundsMax = glm::vec3(0.0f);
+    }
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gpu_mesh.h"
+#include "mesh.h"
+#include "textures.h"
+
+// A model as the renderer draws it: the cooked vertex/index buffers with their LOD chain,
+// plus a texture reference per material. Shared by every MeshModel using the same file.
+struct LoadedMesh {
+    GpuMesh gpu;
+    std::vector<MeshMaterial> materials;
+    std::vector<TextureHandle> textures;   // diffuse texture per material, INVALID_TEXTURE = none
+    glm::vec3 center = glm::vec3(0.0f);    // bounding sphere in model space (LOD and mip choice)
+    float radius = 0.0f;
+    bool failed = false;                   // import, cook or upload failed, see the log
+
+    LoadedMesh() = default;
+    ~LoadedMesh();
+    LoadedMesh(const LoadedMesh&) = delete;
+    LoadedMesh& operator=(const LoadedMesh&) = delete;
+
+    bool IsReady() const { return gpu.IsValid(); }
+};
+
+// Models for the MeshModel entities, shared by path (.obj, .gltf, .glb or .spxmesh).
+// Acquire returns right away; a worker cooks the source to .spxmesh when the cooked file
+// is missing or stale (MeshFile::IsUpToDate) and maps it, then Update uploads it straight
+// from the mapping. Until then the mesh is not ready and draws nothing.
+// Main thread only; the mesh is freed with its last reference.
+namespace MeshCache {
+
+    std::shared_ptr<const LoadedMesh> Acquire(const std::string& path);
+
+    // Upload finished loads (a few per frame). Call once per frame.
+    void Update();
+    // Drop loads that finished but were never uploaded. Call after Jobs::Shutdown,
+    // before the asset pack is unmounted.
+    void Shutdown();
+
+    struct Stats {
+        int meshes = 0;        // alive, loaded or not
+        int loading = 0;       // cooking / mapping on the workers
+        size_t gpuBytes = 0;
+    };
+    Stats GetStats();
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "mesh.h"
+
+class GpuMesh;
+
+// Cooked mesh format (.spxmesh). Written once by the cook step, then loaded with a
+// single file map: vertex and index blobs are stored in GPU layout so they go to
+// glBufferData straight from the mapping.
+//
+// Layout (little endian, every section 16 byte aligned):
+//   Header | vertices | indices | submeshes | lods | materials | string blob
+// The checksum covers everything after the header. Readers reject other versions,
+// the caller then re-cooks from the source file.
+namespace MeshFile {
+
+    constexpr char kMagic[8] = { 'S', 'P', 'X', 'M', 'E', 'S', 'H', '\0' };
+    constexpr uint32_t kVersion = 3;   // 3: material alpha cutoff
+    constexpr const char* kExtension = ".spxmesh";
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;     // sizeof(Header), lets newer readers skip fields
+        uint32_t vertexFormat;   // VertexFormat of the vertex blob
+        uint32_t cookFormat;     // VertexFormat the cook asked for (packing can fall back to Float8)
+        uint32_t vertexStride;
+        uint32_t vertexCount;
+        uint32_t indexType;      // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+        uint32_t indexCount;
+        uint32_t submeshCount;
+        uint32_t lodCount;
+        uint32_t materialCount;
+        uint32_t cookLodCount;   // LOD levels the cook asked for (simplification can stop earlier)
+        float boundsMin[3];
+        float boundsMax[3];
+        uint64_t vertexOffset;   // byte offsets from the start of the file
+        uint64_t indexOffset;
+        uint64_t submeshOffset;
+        uint64_t lodOffset;
+        uint64_t materialOffset;
+        uint64_t stringOffset;
+        uint64_t stringBytes;
+        uint64_t payloadBytes;   // file size - headerSize
+        uint64_t checksum;       // Hash::Bytes64 of the payload
+    };
+    static_assert(sizeof(Header) == 152, "MeshFile::Header layout changed, bump kVersion");
+
+    struct SubmeshRecord {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        int32_t materialIndex;
+        uint32_t reserved;
+    };
+
+    struct LodRecord {
+        uint32_t submeshOffset;
+        uint32_t submeshCount;
+        float error;
+        uint32_t reserved;
+    };
+
+    // Strings are (offset, length) into the string blob. Texture paths are relative
+    // to the folder of the .spxmesh file.
+    struct MaterialRecord {
+        float ambient[3];
+        float diffuse[3];
+        float specular[3];
+        float shininess;
+        float opacity;
+        uint32_t name[2];
+        uint32_t diffuseTexture[2];
+        uint32_t normalTexture[2];
+        float alphaCutoff;       // 0 = opaque
+    };
+
+    // "assets/objModels/crate.obj" -> "assets/objModels/crate.spxmesh"
+    std::string CookedPath(const std::string& sourcePath);
+    // True if the cooked file exists, is newer than the source and has the current version
+    // and vertex format
+    bool IsUpToDate(const std::string& sourcePath, const std::string& cookedPath);
+
+    // Vertex layout the cook step writes (Float8 = no quantization). Packed positions are
+    // relative to the bounds in the header, default.vert decodes them.
+    void SetCookFormat(VertexFormat format);
+    VertexFormat CookFormat();
+    // LOD levels the cook step generates with MeshSimplify (1 = LOD 0 only)
+    void SetCookLodCount(int lodCount);
+    int CookLodCount();
+
+    // Import a source model by extension (.obj, .gltf, .glb)
+    bool ImportSource(const std::string& sourcePath, MeshData& mesh);
+
+    // Write mesh as .spxmesh (via a temp file + rename so readers never see half a file).
+    // Packed formats fall back to Float8 when the uvs do not survive half precision.
+    // Embedded images (mesh.images) are written next to it as <name>.image<N>.<ext>.
+    bool Write(const std::string& path, const MeshData& mesh, VertexFormat format = VertexFormat::Float8);
+    // Import the source and write the cooked file
+    bool Cook(const std::string& sourcePath, const std::string& cookedPath);
+    // Full CPU copy of a cooked file (tools, optimisers), packed vertices are decoded
+    bool Read(const std::string& path, MeshData& mesh);
+
+    // Source vs cooked load times for one model, logged. Cooks first if needed.
+    // Upload to the GPU is included when a GL context is current.
+    struct BenchmarkReport {
+        double sourceSeconds = 0.0;  // import from the source format
+        double cookedSeconds = 0.0;  // map + validate + checksum
+        double uploadSeconds = 0.0;  // glBufferData from the mapping (0 without GL)
+        size_t sourceBytes = 0;
+        size_t cookedBytes = 0;
+        double speedup = 0.0;
+    };
+    BenchmarkReport BenchmarkLoad(const std::string& sourcePath, int iterations = 3);
+}
+
+// A mapped .spxmesh. The accessors point into the mapping, so they stay valid
+// until Close() or destruction.
+class CookedMesh {
+public:
+    bool Open(const std::string& path, bool verifyChecksum = true);
+    void Close();
+
+    bool IsOpen() const { return m_header != nullptr; }
+    const MeshFile::Header& Header() const { return *m_header; }
+    const void* Vertices() const;
+    const void* Indices() const;
+
+    std::vector<MeshSubmesh> Submeshes() const;
+    std::vector<MeshLod> Lods() const;
+    std::vector<MeshMaterial> Materials() const;
+
+    // Single glBufferData per buffer straight from the mapping
+    bool Upload(GpuMesh& gpu) const;
+
+private:
+    std::string String(const uint32_t ref[2]) const;
+
+    MappedFile m_file;
+    std::string m_dir;
+    const MeshFile::Header* m_header = nullptr;
+};
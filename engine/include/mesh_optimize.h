@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mesh.h"
+
+// Import-time index/vertex reordering. None of these change the geometry: every
+// triangle keeps its vertices and winding, only the order of triangles and vertices
+// changes, so the GPU transforms fewer vertices and reads the vertex buffer linearly.
+namespace MeshOptimize {
+
+    // Post-transform cache efficiency of an index range, simulated with a FIFO cache
+    struct CacheStats {
+        float acmr = 0.0f;   // average cache miss ratio: transformed vertices per triangle (0.5 - 3)
+        float atvr = 0.0f;   // average transform to vertex ratio: transformed / unique vertices (1 = ideal)
+    };
+    CacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = 16);
+
+    // Forsyth's linear-speed vertex cache optimisation (LRU score model, 32 entries)
+    void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+    // Tipsify-style overdraw pass, run after OptimizeVertexCache: the triangle list is cut
+    // into clusters at cache restarts, then clusters facing away from the mesh centre are
+    // drawn first so they occlude the rest. threshold bounds the ACMR loss (1.05 = 5%).
+    void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount,
+        size_t vertexStrideFloats, float threshold = 1.05f);
+
+    // Renumber vertices in first-use order and reorder the vertex buffer to match,
+    // dropping unreferenced vertices. Returns the new vertex count.
+    size_t OptimizeVertexFetch(MeshData& mesh);
+
+    struct Report {
+        CacheStats before;
+        CacheStats after;
+        size_t triangles = 0;
+        size_t verticesBefore = 0;
+        size_t verticesAfter = 0;
+        double seconds = 0.0;
+    };
+    // Full pipeline on a mesh: cache + overdraw per submesh, then vertex fetch.
+    // Logs ACMR/ATVR before and after with `name` as the label.
+    Report Optimize(MeshData& mesh, const std::string& name = std::string());
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+
+// Import-time LOD generation. Edges are collapsed onto existing vertices in order of
+// quadric error (Garland & Heckbert), so every level reuses the LOD 0 vertex buffer and
+// only adds an index range. UV/normal seams and open borders can only slide along
+// themselves, and a normal/uv difference term keeps collapses off attribute edges.
+namespace MeshSimplify {
+
+    // Simplify a triangle list to about targetIndexCount indices, stopping early when the
+    // next collapse would move the surface more than targetError (model units).
+    // destination needs room for indexCount indices. Returns the new index count;
+    // resultError receives the largest error introduced.
+    size_t Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+        const float* vertices, size_t vertexCount, size_t vertexStrideFloats,
+        size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+    struct LodSettings {
+        int lodCount = 6;              // levels including LOD 0, 1 = no LODs
+        float reduction = 0.5f;        // triangles kept from one level to the next
+        size_t minTriangles = 64;      // no level below this
+        float maxError = 0.05f;        // total error limit relative to the bounding radius
+    };
+
+    // Append LOD 1..n to mesh.indices/submeshes/lods, LOD 0 being the current submeshes.
+    // Each level is built from the previous one, submeshes in parallel. Meshes that
+    // already have LODs are left alone.
+    bool GenerateLods(MeshData& mesh, const LodSettings& settings = LodSettings(), const std::string& name = std::string());
+    // Several meshes, in parallel across meshes
+    void GenerateLods(const std::vector<MeshData*>& meshes, const LodSettings& settings = LodSettings());
+
+    // Triangles drawn vs camera distance with the runtime LodSelector, logged as a table.
+    // Distances go from the bounding radius out to `farRadii` radii.
+    struct DistanceSample {
+        float distance = 0.0f;
+        int lod = 0;
+        size_t triangles = 0;
+        float pixelError = 0.0f;
+    };
+    std::vector<DistanceSample> BenchmarkDistance(const MeshData& mesh, float fovYDegrees = 45.0f,
+        float viewportHeight = 1080.0f, float farRadii = 200.0f, int steps = 12);
+
+    // Simplification time for a model (empty path = synthetic ~1M triangle sphere),
+    // followed by the distance table
+    struct BenchmarkReport {
+        double seconds = 0.0;
+        size_t triangles = 0;
+        std::vector<size_t> lodTriangles;
+        std::vector<DistanceSample> samples;
+    };
+    BenchmarkReport Benchmark(const std::string& path = std::string(), const LodSettings& settings = LodSettings());
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "mesh.h"
+
+// Wavefront OBJ/MTL importer.
+// The file is memory mapped and cut into line-aligned chunks that are parsed in parallel
+// on the Jobs workers; indices are then resolved, vertices deduplicated by their
+// (position, uv, normal) triple and triangles grouped into one submesh per material.
+// Polygons are fan-triangulated; missing normals are generated (smooth, per position).
+namespace ObjLoader {
+
+    struct ImportStats {
+        size_t bytes = 0;
+        size_t triangles = 0;
+        size_t vertices = 0;      // after deduplication
+        size_t corners = 0;       // face corners before deduplication
+        double parseSeconds = 0.0;   // parallel chunk parse
+        double resolveSeconds = 0.0; // index resolve, material sort, dedup, vertex build
+        double totalSeconds = 0.0;   // including map + MTL
+    };
+
+    // Import path into mesh. Returns false (and logs) if the file can't be read
+    // or has no faces. Relative mtllib / texture paths resolve against the OBJ folder.
+    bool Load(const std::string& path, MeshData& mesh, ImportStats* stats = nullptr);
+
+    // Same, from text already in memory (baseDir is used for mtllib lookups)
+    bool LoadFromMemory(const char* data, size_t size, const std::string& baseDir,
+        MeshData& mesh, ImportStats* stats = nullptr);
+
+    // Parse a .mtl file and append its materials
+    bool LoadMaterials(const std::string& path, std::vector<MeshMaterial>& materials);
+
+    // Parse-throughput benchmark: imports path `iterations` times and logs the best run.
+    // With an empty path a synthetic ~1M triangle grid (about 60 MB of OBJ text) is
+    // generated in memory instead, so the numbers are comparable between machines.
+    struct BenchmarkReport {
+        size_t bytes = 0;
+        size_t triangles = 0;
+        double bestSeconds = 0.0;
+        double mbPerSec = 0.0;
+        double mTrianglesPerSec = 0.0;
+    };
+    BenchmarkReport BenchmarkParse(const std::string& path = std::string(), int iterations = 5);
+}
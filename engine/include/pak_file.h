@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Asset pack (.spxpak): every shipped asset in one memory mapped file.
+//
+// Layout (little endian):
+//   Header | entries (sorted by name hash) | name strings | data
+// Lookups are a binary search on the hash of the normalized name (lower case, '/'
+// separators), so "Shaders\default.vert" and "shaders/default.vert" are the same entry.
+// Entry data starts 16 byte aligned. Stored entries are used straight from the mapping
+// (a .spxmesh inside a pack uploads without a copy); Lz4 entries decode into a buffer.
+namespace PakFile {
+
+    constexpr char kMagic[8] = { 'S', 'P', 'X', 'P', 'A', 'K', '\0', '\0' };
+    constexpr uint32_t kVersion = 1;
+    constexpr const char* kExtension = ".spxpak";
+    constexpr size_t kAlignment = 16;
+
+    enum class Compression : uint32_t {
+        None = 0,
+        Lz4 = 1,
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t entryCount;
+        uint32_t reserved;
+        uint64_t entryOffset;
+        uint64_t stringOffset;
+        uint64_t stringBytes;
+        uint64_t fileSize;
+        uint64_t indexChecksum;  // Hash::Bytes64 of the entries + strings
+    };
+    static_assert(sizeof(Header) == 64, "PakFile::Header layout changed, bump kVersion");
+
+    struct Entry {
+        uint64_t hash;           // HashName of the entry name
+        uint64_t offset;         // from the start of the file
+        uint64_t storedSize;     // bytes in the pack
+        uint64_t size;           // bytes after decompression
+        uint64_t checksum;       // Hash::Bytes64 of the uncompressed bytes
+        uint32_t nameOffset;     // into the string section
+        uint32_t nameLength;
+        uint32_t compression;    // Compression
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Entry) == 56, "PakFile::Entry layout changed, bump kVersion");
+
+    // Lower case, '/' separators, no leading "./" or "/"
+    std::string NormalizeName(std::string_view name);
+    // Hash of the normalized name, computed without building it (no allocation)
+    uint64_t HashName(std::string_view name);
+    // Building blocks for allocation-free compares: the normalized name is
+    // NormalizeChar of every char from NameStart on
+    inline char NormalizeChar(char c) {
+        if (c == '\\') return '/';
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    size_t NameStart(std::string_view name);
+
+    struct Input {
+        std::string name;        // name inside the pack, e.g. "assets/textures/crate.jpg"
+        std::string sourcePath;  // file to read
+    };
+
+    // Every file under root/dir, named relative to root
+    bool Collect(const std::string& root, const std::string& dir, std::vector<Input>& inputs);
+
+    struct WriteOptions {
+        bool compress = true;
+        float minSaving = 0.1f;                 // keep Lz4 only when it saves this much
+        std::vector<std::string> storeExtensions = { ".spxmesh", ".png", ".jpg", ".jpeg" }; // mapped or already compressed
+    };
+    struct WriteReport {
+        size_t files = 0;
+        size_t compressed = 0;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+        double seconds = 0.0;
+    };
+    // Read and compress the inputs (in parallel) and write the pack via temp file + rename
+    bool Write(const std::string& path, const std::vector<Input>& inputs,
+        const WriteOptions& options = WriteOptions(), WriteReport* report = nullptr);
+}
+
+// A mapped .spxpak. Reads are const and safe from any thread.
+class PakArchive {
+public:
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return m_header != nullptr; }
+
+    const PakFile::Entry* Find(std::string_view name) const;
+    const PakFile::Entry* FindHash(uint64_t nameHash) const;
+    bool Contains(std::string_view name) const { return Find(name) != nullptr; }
+
+    // Zero-copy bytes of a stored entry, nullptr for compressed ones
+    const uint8_t* View(const PakFile::Entry& entry) const;
+    // Uncompressed bytes of any entry
+    bool Read(const PakFile::Entry& entry, std::vector<uint8_t>& out) const;
+    bool Read(std::string_view name, std::vector<uint8_t>& out) const;
+
+    std::string_view Name(const PakFile::Entry& entry) const;
+    size_t EntryCount() const { return m_header ? m_header->entryCount : 0; }
+    const PakFile::Entry* Entries() const { return m_entries; }
+    const std::string& Path() const { return m_path; }
+
+    // Decode every entry and check its checksum (slow, for tools)
+    bool Verify() const;
+
+private:
+    MappedFile m_file;
+    std::string m_path;
+    const PakFile::Header* m_header = nullptr;
+    const PakFile::Entry* m_entries = nullptr;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <glad/glad.h>
+
+// Disk cache of linked GL programs (glGetProgramBinary / glProgramBinary), so a warm
+// start skips compiling and linking. Entries are keyed by a hash of the shader sources
+// and of the GL vendor/renderer/version strings: an edited shader or a driver update
+// is simply a miss. Every entry is checked (header, driver, size, checksum, link status)
+// before use; a rejected entry is deleted and the caller compiles from source.
+namespace ProgramCache {
+
+    constexpr uint32_t kVersion = 1;
+    constexpr const char* kExtension = ".spxprog";
+
+    // Folder for the entries (created on the first store), empty = cache off
+    void SetDirectory(const std::string& directory);
+    const std::string& Directory();
+    // Off when no folder is set or the driver offers no binary formats. Needs a GL context.
+    bool IsEnabled();
+
+    // Needs a GL context (the driver strings are part of the key)
+    uint64_t Key(std::string_view vertexSource, std::string_view fragmentSource);
+
+    // A linked program from the cache, 0 on a miss or a rejected entry
+    GLuint Load(uint64_t key);
+    // Store a linked program. Link it with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    bool Store(uint64_t key, GLuint program);
+
+    struct Stats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t rejected = 0;   // present but unusable (driver changed, corrupt, link failed)
+        uint32_t stores = 0;
+        double loadMs = 0.0;     // time spent in Load, hits and misses
+    };
+    Stats GetStats();
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mapped_file.h"
+
+// Binary scene format (.spxscene). The entity store is written column by column: one
+// typed block per field (ids, types, positions, flags, ...), entity i being row i of
+// every block. Names, texture and model paths are interned into one string table and the
+// entities store indices into it, so a thousand crates share one path.
+// Loading is a single file map; every column is then either used in place (SceneView)
+// or bulk copied into vectors (Read), no per-entity parsing.
+//
+// Layout (little endian, every block 16 byte aligned):
+//   Header | block records | blocks...
+// The checksum covers everything after the header. Readers skip block ids they don't
+// know, so columns can be added without breaking older scenes.
+// A file may also be stored LZ4 compressed (autosaves are): PackedHeader followed by one
+// LZ4 block of the whole file above. Readers unpack it into memory and go on as usual.
+namespace SceneFile {
+
+    constexpr char kMagic[8] = { 'S', 'P', 'X', 'S', 'C', 'N', 'E', '\0' };
+    constexpr uint32_t kVersion = 1;
+    constexpr const char* kExtension = ".spxscene";
+    constexpr uint32_t kNoString = 0xFFFFFFFFu;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;     // sizeof(Header), lets newer readers skip fields
+        uint64_t entityCount;
+        uint32_t blockCount;
+        uint32_t stringCount;
+        uint64_t payloadBytes;   // file size - headerSize
+        uint64_t checksum;       // Hash::Bytes64 of the payload
+    };
+    static_assert(sizeof(Header) == 48, "SceneFile::Header layout changed, bump kVersion");
+
+    constexpr char kPackedMagic[8] = { 'S', 'P', 'X', 'S', 'C', 'N', 'Z', '\0' };
+
+    struct PackedHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;     // sizeof(PackedHeader)
+        uint64_t rawSize;        // size of the unpacked .spxscene
+        uint64_t storedSize;     // LZ4 bytes after this header
+        uint64_t checksum;       // Hash::Bytes64 of the LZ4 bytes
+    };
+    static_assert(sizeof(PackedHeader) == 40, "SceneFile::PackedHeader layout changed, bump kVersion");
+
+    constexpr uint32_t BlockId(const char (&tag)[5]) {
+        return uint32_t(uint8_t(tag[0])) | uint32_t(uint8_t(tag[1])) << 8 | uint32_t(uint8_t(tag[2])) << 16 | uint32_t(uint8_t(tag[3])) << 24;
+    }
+    // Entity columns (entityCount rows)
+    constexpr uint32_t kBlockIds = BlockId("EIDS");        // int32 entity id
+    constexpr uint32_t kBlockTypes = BlockId("TYPE");      // int32 entTypeID (OBJ_CUBE, ...)
+    constexpr uint32_t kBlockObjIndex = BlockId("OIDX");   // int32 index within its type
+    constexpr uint32_t kBlockPositions = BlockId("POS3");  // float3
+    constexpr uint32_t kBlockRotations = BlockId("ROT3");  // float3, radians
+    constexpr uint32_t kBlockScales = BlockId("SCL3");     // float3
+    constexpr uint32_t kBlockFlags = BlockId("FLAG");      // uint8 EntityFlags
+    constexpr uint32_t kBlockPoints = BlockId("PNTS");     // int32 entPoints
+    constexpr uint32_t kBlockHealth = BlockId("HPPT");     // int32 HealthPackPoints
+    constexpr uint32_t kBlockNames = BlockId("NAME");      // uint32 string index
+    constexpr uint32_t kBlockTextures = BlockId("TEXR");   // uint32 string index, kNoString = none
+    constexpr uint32_t kBlockMeshes = BlockId("MESH");     // uint32 string index of the model (OBJ_MESH), kNoString = none
+    // String table (stringCount strings)
+    constexpr uint32_t kBlockStringOffsets = BlockId("STRO"); // uint32, stringCount + 1 offsets
+    constexpr uint32_t kBlockStringData = BlockId("STRD");    // chars, not terminated
+
+    struct BlockRecord {
+        uint32_t id;
+        uint32_t elementSize;    // bytes per row, checked against the reader's type
+        uint64_t offset;         // from the start of the file
+        uint64_t count;          // rows
+    };
+    static_assert(sizeof(BlockRecord) == 24, "SceneFile::BlockRecord layout changed, bump kVersion");
+
+    enum EntityFlags : uint8_t {
+        FlagActive = 1 << 0,
+        FlagHealthPack = 1 << 1,
+        FlagDangerous = 1 << 2,
+        FlagCollidable = 1 << 3,
+        FlagVisible = 1 << 4,
+    };
+    // A new GameObj's flags, used when a scene leaves them out
+    constexpr uint8_t kDefaultFlags = FlagActive | FlagCollidable | FlagVisible;
+
+    // Lets the string lookup take string_views without building a std::string
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    // A scene as columns: the in-memory form of the file, filled from the entity store
+    // by the engine. Every entity column has Size() rows.
+    struct Columns {
+        std::vector<int32_t> ids;
+        std::vector<int32_t> types;
+        std::vector<int32_t> objectIndices;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> rotations;
+        std::vector<glm::vec3> scales;
+        std::vector<uint8_t> flags;
+        std::vector<int32_t> points;
+        std::vector<int32_t> healthPoints;
+        std::vector<uint32_t> names;
+        std::vector<uint32_t> textures;
+        std::vector<uint32_t> meshes;
+        std::vector<std::string> strings;
+        std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> lookup; // strings -> index, for Intern
+
+        size_t Size() const { return ids.size(); }
+        void Clear();
+        void Reserve(size_t count);
+        // Append a row with the defaults of a new GameObj, returns its index
+        size_t AddEntity(int32_t id);
+        // Index of s in strings, added on first use
+        uint32_t Intern(std::string_view s);
+        const std::string& String(uint32_t index) const;
+    };
+
+    // Build the whole file in memory, LZ4 packed when compress is set
+    bool Encode(const Columns& scene, std::vector<char>& file, bool compress = false);
+    // Write via a temp file + rename so readers never see half a file
+    bool Write(const std::string& path, const Columns& scene, bool compress = false);
+    // Map, validate, then bulk copy every column
+    bool Read(const std::string& path, Columns& scene);
+}
+
+// A mapped .spxscene. The column pointers point into the mapping, so they stay valid
+// until Close() or destruction; static data can be used from here without a copy.
+// Packed files are unpacked into a buffer the view owns instead.
+class SceneView {
+public:
+    bool Open(const std::string& path, bool verifyChecksum = true);
+    void Close();
+
+    bool IsOpen() const { return m_header != nullptr; }
+    size_t EntityCount() const { return m_header ? static_cast<size_t>(m_header->entityCount) : 0; }
+    size_t StringCount() const { return m_header ? m_header->stringCount : 0; }
+    std::string_view String(uint32_t index) const;
+
+    // Column with EntityCount() rows, nullptr when the file has no such block
+    template <typename T>
+    const T* Column(uint32_t id) const { return static_cast<const T*>(Find(id, sizeof(T))); }
+
+private:
+    const void* Find(uint32_t id, size_t elementSize) const;
+
+    MappedFile m_file;
+    const SceneFile::Header* m_header = nullptr;
+    const SceneFile::BlockRecord* m_blocks = nullptr;
+    const uint32_t* m_stringOffsets = nullptr;
+    const char* m_stringData = nullptr;
+};
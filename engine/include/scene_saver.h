@@ -0,0 +1,62 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "scene_file.h"
+
+// Saves scenes off the main thread. The editor gathers its entities into Snapshot() at a
+// frame boundary (a bulk copy into columns reused from the last save, the only main
+// thread cost), then Start() hands them to a worker that serializes, compresses and
+// writes the file via a temp file + rename. The frame never waits on the disk.
+// One save runs at a time: the snapshot belongs to the worker until Poll() has
+// reported the save as finished. Busy/Snapshot/Start/Poll are main thread only.
+class SceneSaver {
+public:
+    struct Result {
+        std::string path;
+        bool ok = false;
+        bool autosave = false;
+        bool unchanged = false;      // autosave skipped, same bytes as the last one
+        size_t bytes = 0;
+        double snapshotSeconds = 0.0; // main thread, as passed to Start
+        double saveSeconds = 0.0;     // worker: encode + compress + write
+    };
+
+    SceneSaver() = default;
+    ~SceneSaver();
+
+    SceneSaver(const SceneSaver&) = delete;
+    SceneSaver& operator=(const SceneSaver&) = delete;
+
+    bool Busy() const { return m_busy; }
+    // Columns to gather the scene into, only while !Busy()
+    SceneFile::Columns& Snapshot() { return m_snapshot; }
+    // Save the snapshot to path: .spx as text, anything else as binary .spxscene.
+    // Autosaves are LZ4 packed and skipped when nothing changed since the last one.
+    void Start(const std::string& path, bool autosave, double snapshotSeconds = 0.0);
+    // True once per finished save
+    bool Poll(Result& result);
+    // Block until the running save (if any) is on disk
+    void Wait();
+
+private:
+    void Save();   // worker
+
+    SceneFile::Columns m_snapshot;
+    std::vector<char> m_bytes;     // encoded binary file, reused
+    std::string m_text;            // encoded text file, reused
+    std::string m_path;
+    bool m_autosave = false;
+    double m_snapshotSeconds = 0.0;
+    uint64_t m_lastAutosaveHash = 0;
+    std::string m_lastAutosavePath;
+
+    bool m_busy = false;           // main thread: Start until Poll
+    std::mutex m_mutex;
+    std::condition_variable m_doneCv;
+    bool m_done = false;           // worker finished, guarded by m_mutex
+    Result m_result;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "scene_file.h"
+
+// Text scene format (.spx): the same columns as a .spxscene, written one block per entity
+// so scenes and prefabs can be read, hand edited and diffed in version control.
+//
+//   # comment
+//   spx scene 1
+//   entity 7
+//       type cube                  cube | plane | floor | ... or the raw entTypeID
+//       name "Crate \"big\""       \\ \" \n \r \t and \xHH escapes
+//       index 2
+//       position 1.5 0 -3
+//       rotation 0 0.7853982 0     radians
+//       scale 1 1 1
+//       flags active collidable visible
+//       points 0
+//       health 0
+//       texture "assets/textures/crate.jpg"
+//       mesh "assets/objModels/crate.obj"   model of a mesh entity
+//   end
+//
+// Every field line is optional and falls back to the defaults of a new GameObj. Floats
+// are written in their shortest exact form, so save -> load gives back the same bits.
+// The parser makes one pass over the mapped file: keys and values are views into the
+// buffer, numbers are parsed in place and names go straight into the string table,
+// nothing is allocated per line.
+namespace SceneText {
+
+    constexpr int kVersion = 1;
+    constexpr const char* kExtension = ".spx";
+
+    // True for paths with the .spx extension (any case)
+    bool IsTextPath(const std::string& path);
+
+    // Append the scene as text
+    void Serialize(const SceneFile::Columns& scene, std::string& out);
+    // Parse text into scene (cleared first). name is only used in error messages.
+    bool Parse(const char* text, size_t size, SceneFile::Columns& scene, const std::string& name = "scene");
+
+    // Write via a temp file + rename so readers never see half a file
+    bool Write(const std::string& path, const SceneFile::Columns& scene);
+    // Map and parse
+    bool Read(const std::string& path, SceneFile::Columns& scene);
+
+    // Save/load throughput in memory, best of `iterations`, plus a check that the parsed
+    // scene matches the original entity for entity. path may be a .spx or .spxscene file;
+    // empty = a synthetic 100k entity scene.
+    struct BenchmarkReport {
+        size_t bytes = 0;
+        size_t entities = 0;
+        double saveSeconds = 0.0;
+        double loadSeconds = 0.0;
+        double saveMBps = 0.0;
+        double loadMBps = 0.0;
+        bool roundTrip = false;
+    };
+    BenchmarkReport Benchmark(const std::string& path = std::string(), int iterations = 5);
+}
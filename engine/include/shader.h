@@ -1,16 +1,57 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include "vfs.h"
 
+// A vertex + fragment program with keyword permutations. Every keyword given to the
+// constructor can be switched on per variant and becomes "#define KEYWORD" in both stages
+// (right after #version). The base variant (no keywords) is built in the constructor and is
+// what ID() returns; other variants compile on first use or ahead of time with Precompile.
+// Where the driver has GL_KHR_parallel_shader_compile they compile on driver threads and
+// Poll only picks up finished ones, so a frame never waits on the compiler. Until a variant
+// is ready the base program stands in for it.
 class Shader {
 public:
+    // Bit i = the i-th keyword given to the constructor
+    using Permutation = uint32_t;
+    static constexpr size_t kMaxKeywords = 32;
+
     // Construct and build the shader from file paths
-    Shader(const std::string& vertexPath, const std::string& fragmentPath);
+    Shader(const std::string& vertexPath, const std::string& fragmentPath, std::vector<std::string> keywords = {});
     ~Shader();
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
 
-    // Use / bind the shader program
+    // Use / bind the shader program (the base variant)
     void Use() const;
+    // Bind a variant (starting its compile if needed); the uniform setters write to it
+    void Use(Permutation variant);
+
+    // Bit of a keyword, 0 when the shader has no such keyword
+    Permutation Keyword(std::string_view name) const;
+    // Start compiling variants without waiting for them
+    void Precompile(const std::vector<Permutation>& variants);
+    bool IsReady(Permutation variant) const;
+    // Program of a variant, starting its compile if needed; the base program until it is ready
+    GLuint Program(Permutation variant);
+    // Pick up finished compiles. With parallel compile this never blocks; without it
+    // one variant is finished per call so the stalls are spread over frames.
+    void Poll();
+    // Poll every live shader, once per frame
+    static void PollAll();
+    // GL_KHR/ARB_parallel_shader_compile, checked once (needs a GL context)
+    static bool ParallelCompileSupported();
+
+    // Rebuild from the source files and swap the program in place; on a compile or link
+    // error the old program stays. Uniforms must be set again afterwards (they are per frame).
+    bool Reload();
+    bool UsesFile(Vfs::AssetId asset) const;
+    // Reload every live shader built from this file, returns how many were swapped
+    static int ReloadFile(Vfs::AssetId asset);
 
     // convenience uniform setters
     void SetUniformVec3(const char* name, float x, float y, float z) const;
@@ -39,10 +80,45 @@ public:
     GLuint ID() const { return programID; }
 
 private:
+    struct Variant {
+        Permutation keywords = 0;
+        GLuint program = 0;      // linked, in use
+        GLuint pending = 0;      // being compiled / linked, replaces program when done
+        GLuint vertShader = 0;
+        GLuint fragShader = 0;
+        uint64_t cacheKey = 0;   // ProgramCache key of the pending build, 0 = cache off
+        bool failed = false;     // last build failed, not retried until the sources change
+    };
+
     // private member can only be accessed by member functions and not outside the class
-    GLuint programID;
-    // Helper functions for shader compilation and file reading
-    bool CompileShader(const char* source, GLenum shaderType, GLuint& outShader) const;
+    GLuint programID;            // program of the base variant
+    mutable GLuint m_activeProgram = 0; // bound by Use, target of the uniform setters
+    std::string m_vertexPath;
+    std::string m_fragmentPath;
+    std::vector<std::string> m_keywords;
+    std::string m_vertexSource;  // as read, without the keyword defines
+    std::string m_fragmentSource;
+    std::vector<Variant> m_variants; // [0] is the base variant
+
+    Variant* FindVariant(Permutation variant);
+    const Variant* FindVariant(Permutation variant) const;
+    // Read both source files, false (and nothing changed) when one is missing or empty
+    bool ReadSources(std::string& vertexSource, std::string& fragmentSource) const;
+    // Sources with the keyword defines injected after #version
+    std::string Preprocess(const std::string& source, Permutation variant) const;
+    std::string VariantName(Permutation variant) const;
+    // Issue compile + link without waiting (or take the program from the cache), from the
+    // stored sources or from ones not committed yet (Reload)
+    void StartBuild(Variant& variant);
+    void StartBuild(Variant& variant, const std::string& vertexSource, const std::string& fragmentSource);
+    // Query the results of a started build (blocks if the driver isn't done yet)
+    bool FinishBuild(Variant& variant);
+    bool IsBuildDone(const Variant& variant) const;
+    void DiscardBuild(Variant& variant);
+    // Make a linked program the variant's program, deleting the old one
+    void Adopt(Variant& variant, GLuint program);
+    // Compile status of a shader object, logs the info log on failure
+    bool CheckCompile(GLuint shader, const char* stage) const;
     // Read shader source code from file
     std::string ReadFile(const std::string& path) const;
 };
@@ -0,0 +1,37 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Startup timings: Engine::Initialize marks the end of each phase and records the
+// startup tasks (with the thread they ran on), End logs them as a report with the total,
+// FirstFrame adds the time to the first presented frame. Main thread only.
+namespace StartupProfiler {
+
+    struct Phase {
+        std::string name;
+        double ms = 0.0;         // since the previous mark
+    };
+
+    struct Task {
+        std::string name;
+        bool worker = false;     // ran on a Jobs worker
+        double startMs = 0.0;    // since Begin
+        double endMs = 0.0;
+    };
+
+    void Begin();
+    // End of a phase, timed from the previous mark (or Begin)
+    void Mark(const std::string& phase);
+    // A task that ran between two points in time (possibly on another thread)
+    void AddTask(const std::string& name, bool worker, std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end);
+    // Log the report once; later calls do nothing
+    void End();
+    // Call after the first SwapBuffers; logs the time to first frame once
+    void FirstFrame();
+
+    const std::vector<Phase>& Phases();
+    const std::vector<Task>& Tasks();
+    double TotalMs();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runs a set of tasks in dependency order: Worker tasks go to the Jobs pool as soon as
+// their dependencies are done, Main tasks run on the thread that called Run (GL, GLFW and
+// ImGui need it), so CPU work overlaps with the main-thread work. Used for engine startup.
+// A task returning false fails the graph; tasks depending on it are skipped.
+class TaskGraph {
+public:
+    using TaskId = int;
+    enum class Thread {
+        Main,
+        Worker,
+    };
+
+    struct Timing {
+        std::string name;
+        Thread thread = Thread::Main;
+        bool ran = false;        // false = skipped after a failed dependency
+        bool ok = false;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    // Dependencies must have been added before
+    TaskId Add(std::string name, Thread thread, std::vector<TaskId> dependsOn, std::function<bool()> task);
+
+    // Blocks until every task ran or was skipped. Main tasks run in the order they were
+    // added whenever their dependencies allow. False when a task failed.
+    bool Run();
+
+    const std::vector<Timing>& Timings() const { return m_timings; }
+
+private:
+    struct Task {
+        Thread thread = Thread::Main;
+        std::vector<TaskId> dependsOn;
+        std::function<bool()> fn;
+    };
+    std::vector<Task> m_tasks;
+    std::vector<Timing> m_timings;
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "textures.h"
+
+class Shader;
+
+// Heightmap terrain drawn with geomipmapping. The heightmap (16-bit grey PNG, or a raw
+// little endian .r16 of width*width samples) is cut into square chunks of chunkQuads
+// quads per side. Every chunk keeps its full resolution vertices; a LOD only changes
+// which of them the indices use (LOD l takes every 2^l-th row and column), so all chunks
+// share one index buffer holding every LOD.
+//
+// A chunk next to a coarser neighbour would leave T-junctions (cracks) along the shared
+// edge, so each LOD also has a variant per combination of coarser sides (16) in which the
+// odd vertices on those sides are folded onto their even neighbour. Neighbouring chunks
+// are kept at most one LOD apart, which is all the stitching has to cover.
+//
+// Chunks within loadRadius of the camera get their vertices built on the workers (a raw
+// heightmap is mapped, so only the rows those chunks touch are ever paged in) and are
+// uploaded a few per frame; chunks beyond unloadRadius free their buffers. Draw only
+// submits chunks inside the view frustum. Resident chunks, and with the LODs the triangle
+// count, are bounded by the radii, not by the size of the heightmap.
+class Terrain {
+public:
+    struct Settings {
+        std::string heightmap;         // asset path, empty = no terrain
+        std::string texture = "assets/textures/stone.jpg";
+        glm::dvec3 origin = glm::dvec3(0.0); // world position of the first sample (-X/-Z corner)
+        float sampleSpacing = 1.0f;    // metres between samples
+        float heightScale = 256.0f;    // metres at sample value 65535
+        float textureTiling = 8.0f;    // metres per texture repeat
+        int chunkQuads = 32;           // quads per chunk side, a power of two from 2 to 128
+        float lodDistance = 96.0f;     // full detail up to here, each doubling of the distance drops a LOD
+        float loadRadius = 768.0f;     // chunks closer than this to the camera are built
+        float unloadRadius = 896.0f;   // chunks further than this are freed, > loadRadius
+        int maxBuildsInFlight = 8;     // chunks being built on the workers at once
+        int uploadsPerFrame = 4;       // built chunks uploaded per frame
+    };
+
+    struct Stats {
+        int chunks = 0;                // chunks in the heightmap
+        int resident = 0;              // uploaded
+        int building = 0;              // on the workers or waiting for upload
+        int drawn = 0;                 // last Draw, after frustum culling
+        size_t triangles = 0;          // last Draw
+        size_t gpuBytes = 0;           // resident vertex buffers + the shared index buffer
+    };
+
+    Terrain() = default;
+    ~Terrain();
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+
+    // Start loading the heightmap (a PNG is decoded on a worker). Main thread, GL context current.
+    bool Open(const Settings& settings);
+    void Close();
+    bool IsOpen() const { return m_open; }
+    bool IsReady() const { return m_heightmap != nullptr; }
+
+    // Pick the LODs around the camera (world space, see Engine::GetOrigin), start chunk
+    // builds, upload finished ones within the budget and free far chunks
+    void Update(const glm::dvec3& camera);
+    // Draw the visible chunks with the default shader. origin is the floating origin the
+    // view matrix is relative to.
+    void Draw(Shader& shader, const glm::mat4& view, const glm::mat4& projection, const glm::dvec3& origin);
+
+    // Height of the terrain under a world position (bilinear), false outside or while loading
+    bool HeightAt(double x, double z, float& height) const;
+
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    struct Heightmap;
+    struct Inbox;
+    struct Chunk {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        bool building = true;          // false once uploaded
+        std::vector<float> vertices;   // built, waiting for upload
+        float minY = 0.0f;             // height range relative to the terrain origin
+        float maxY = 0.0f;
+    };
+    struct IndexRange {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    int Key(int x, int z) const { return z * m_chunksX + x; }
+    float ChunkSize() const { return m_settings.chunkQuads * m_settings.sampleSpacing; }
+    // Distance from p (terrain space) to the chunk's box, the height range unknown until built
+    double DistanceToChunk(const glm::dvec3& p, int x, int z) const;
+    void SetHeightmap(std::shared_ptr<const Heightmap> heightmap);
+    void BuildIndices();
+    void StartBuilds(const glm::dvec3& local);
+    void FreeChunk(Chunk& chunk);
+
+    Settings m_settings;
+    bool m_open = false;
+    std::shared_ptr<const Heightmap> m_heightmap;
+    std::shared_ptr<Inbox> m_inbox;
+    int m_chunksX = 0;
+    int m_chunksZ = 0;
+    int m_lodCount = 0;
+    int m_inFlight = 0;
+    std::unordered_map<int, Chunk> m_chunks;
+    std::deque<int> m_uploads;         // built chunks in arrival order (nearest first)
+
+    // LOD of each chunk around the camera, 0xFF = not wanted; rebuilt by Update, read by Draw
+    int m_windowX = 0;
+    int m_windowZ = 0;
+    int m_windowW = 0;
+    int m_windowH = 0;
+    std::vector<uint8_t> m_lods;
+
+    GLuint m_ebo = 0;                  // every LOD x stitch variant, 16-bit indices
+    std::vector<IndexRange> m_ranges;  // [lod * 16 + coarser side mask]
+    size_t m_indexBytes = 0;
+    TextureHandle m_texture = INVALID_TEXTURE;
+    Stats m_stats;
+};
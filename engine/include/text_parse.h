@@ -0,0 +1,120 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+// Small non-allocating helpers for the text file parsers (OBJ/MTL, scene files).
+// Every function takes the current position and the end of the buffer, never reads
+// past end and returns the position after what it consumed.
+namespace TextParse {
+
+    inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+    inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+    // Skip spaces and tabs (not newlines)
+    inline const char* SkipSpaces(const char* p, const char* end) {
+        while (p < end && IsSpace(*p)) ++p;
+        return p;
+    }
+
+    // Position after the next '\n' (or end)
+    inline const char* NextLine(const char* p, const char* end) {
+        const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        return nl ? static_cast<const char*>(nl) + 1 : end;
+    }
+
+    // End of the current line, '\r' excluded
+    inline const char* LineEnd(const char* p, const char* end) {
+        const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        const char* e = nl ? static_cast<const char*>(nl) : end;
+        while (e > p && (e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')) --e;
+        return e;
+    }
+
+    // True if [p, end) starts with the keyword followed by a space or the end of the line
+    inline bool StartsWithWord(const char* p, const char* end, const char* word) {
+        size_t n = std::strlen(word);
+        if (static_cast<size_t>(end - p) < n || std::memcmp(p, word, n) != 0) return false;
+        return p + n == end || IsSpace(p[n]) || p[n] == '\n';
+    }
+
+    // Signed decimal integer. Returns p unchanged when there is no number.
+    inline const char* ParseInt(const char* p, const char* end, int32_t& out) {
+        const char* start = p;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+        if (p >= end || !IsDigit(*p)) return start;
+        int64_t value = 0;
+        while (p < end && IsDigit(*p)) {
+            if (value < (int64_t(1) << 32)) value = value * 10 + (*p - '0');
+            ++p;
+        }
+        out = static_cast<int32_t>(negative ? -value : value);
+        return p;
+    }
+
+    // Decimal float with optional fraction and exponent ("-1.25e-3"). About 10x faster
+    // than strtof: up to 19 significant digits are gathered into an integer and scaled
+    // once with a power-of-ten table. Results can differ from strtof in the last bit,
+    // fine for geometry. Returns p unchanged when there is no number.
+    inline const char* ParseFloat(const char* p, const char* end, float& out) {
+        static const double kPow10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        const char* start = p;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool any = false;
+        while (p < end && IsDigit(*p)) {
+            if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) ++digits; }
+            else ++exponent; // digits we can't keep still scale the value
+            ++p;
+            any = true;
+        }
+        if (p < end && *p == '.') {
+            ++p;
+            while (p < end && IsDigit(*p)) {
+                if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) ++digits; --exponent; }
+                ++p;
+                any = true;
+            }
+        }
+        if (!any) return start;
+
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            int32_t e = 0;
+            const char* q = ParseInt(p + 1, end, e);
+            if (q != p + 1) { exponent += e; p = q; }
+        }
+
+        double value = static_cast<double>(mantissa);
+        if (mantissa != 0) {
+            if (exponent < 0) {
+                int e = -exponent;
+                while (e > 22) { value /= 1e22; e -= 22; }
+                value /= kPow10[e];
+            }
+            else {
+                int e = exponent;
+                while (e > 22) { value *= 1e22; e -= 22; }
+                value *= kPow10[e];
+            }
+        }
+        out = static_cast<float>(negative ? -value : value);
+        return p;
+    }
+
+    // Correctly rounded float (std::from_chars), for formats that must read back the exact
+    // value they wrote. Slower than ParseFloat but still well ahead of strtof, no locale.
+    // No leading '+'. Returns p unchanged when there is no number.
+    inline const char* ParseFloatExact(const char* p, const char* end, float& out) {
+        std::from_chars_result result = std::from_chars(p, end, out);
+        return result.ec == std::errc() ? result.ptr : p;
+    }
+}
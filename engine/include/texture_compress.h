@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+// S3TC enums are an extension so glad (core profile) does not define them
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// CPU block-compression encoder used by the TextureManager cook step.
+// Input is always tightly packed RGBA8 (what stbi_load(..., 4) gives us).
+namespace TextureCompress {
+
+    enum class Format {
+        None = 0, // upload as plain GL_RGBA8
+        BC1,      // DXT1, 0.5 byte/texel, opaque (1-bit alpha not used)
+        BC3,      // DXT5, 1 byte/texel, BC1 colour + separate alpha block
+        BC7,      // BPTC, 1 byte/texel, best quality (mode 6 only)
+        Auto      // BC1 for opaque images, BC3 when the image has any alpha
+    };
+
+    enum class Quality {
+        Fast, // bounding-box endpoints + projected indices
+        High  // principal-axis endpoints, least-squares refine, exhaustive index search
+    };
+
+    // Bytes for one 4x4 block (8 or 16)
+    size_t BlockBytes(Format format);
+    // Bytes for a whole w x h level (partial blocks are padded up)
+    size_t CompressedSize(Format format, int w, int h);
+    // GL internal format to pass to glCompressedTexImage2D (0 for None/Auto)
+    GLenum GLInternalFormat(Format format);
+    const char* FormatName(Format format);
+
+    // Resolves Auto to BC1 or BC3 by scanning the alpha channel
+    Format ResolveFormat(Format format, const unsigned char* rgba, int w, int h);
+
+    // Encode a w x h RGBA8 image. Block rows are spread over the Jobs workers.
+    bool Encode(const unsigned char* rgba, int w, int h, Format format, Quality quality,
+        std::vector<unsigned char>& out);
+
+    // Decode back to RGBA8, used to measure encoder quality
+    bool Decode(const unsigned char* blocks, int w, int h, Format format,
+        std::vector<unsigned char>& outRgba);
+
+    // Encode + decode an image and report quality/throughput, e.g. when tuning the
+    // quality switch:  auto r = TextureCompress::MeasureEncode(px, w, h, BC7, High);
+    struct EncodeReport {
+        double psnr = 0.0;          // dB over RGBA, higher is better (inf when lossless)
+        double seconds = 0.0;       // wall time of Encode()
+        double mpixelsPerSec = 0.0; // encode throughput
+        size_t bytes = 0;           // compressed size
+    };
+    EncodeReport MeasureEncode(const unsigned char* rgba, int w, int h, Format format, Quality quality);
+}
@@ -1,13 +1,118 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
 
 #include <glad/glad.h>
+#include "texture_compress.h"
+#include "vfs.h"
 
-// Simple texture cache: load a texture once, keep GLuint handle for reuse.
-// Note: this returns an OpenGL texture id; textures are kept until program exit.
-// If you need explicit unloads, add an Unload or Clear API.
+// Compact texture handle: low 20 bits = slot in the TextureManager table,
+// high 12 bits = slot generation so stale handles are detected after an unload.
+using TextureHandle = uint32_t;
+constexpr TextureHandle INVALID_TEXTURE = 0;
+
+// Texture cache: paths are interned once, after that everything goes through handles.
+// Handle lookups are a direct index into a dense table (no string hashing, no locking).
+// Like every GL call, the TextureManager must only be used from the main (GL) thread.
 namespace TextureManager {
+
+    struct TextureInfo {
+        GLuint glId = 0;
+        int refCount = 0;
+        int width = 0;
+        int height = 0;
+        size_t bytes = 0;        // GPU memory estimate including the mip chain
+        uint32_t pathId = 0;     // Vfs asset id of the path, see GetPath
+        uint32_t generation = 0; // bumped each time the slot is reused
+
+        // Residency (driven by screen size and the memory budget, see Update)
+        GLenum internalFormat = 0;  // GL_RGBA8 or the compressed format
+        int levels = 0;             // mip levels currently on the GPU
+        int mipBias = 0;            // GL_TEXTURE_BASE_LEVEL, finer mips are not resident (0 = full resolution)
+        bool resident = false;      // false once evicted; Touch/Bind reload it in the background
+        uint64_t lastUsedFrame = 0; // frame of the last Touch/Bind, drives the LRU
+
+        // Mip streaming
+        int requestedMip = 0;       // finest mip asked for by RequestMip this frame
+        uint64_t requestFrame = 0;  // frame requestedMip belongs to
+        int coarseFrames = 0;       // consecutive frames a coarser mip was enough
+        bool streaming = false;     // finer mips are being built on a worker
+        uint32_t loadGeneration = 0; // bumped when the image is evicted or rebuilt, streams started before no longer fit
+
+        // Background loads (AcquireAsync)
+        bool loading = false;       // decode still running on a worker, nothing to draw yet
+        bool loadFailed = false;    // the decode failed; Touch won't retry until a hot reload fixes the file
+    };
+
+    struct TextureStats {
+        size_t residentBytes = 0;
+        size_t budgetBytes = 0;  // 0 = unlimited
+        int textureCount = 0;    // live handles
+        int residentCount = 0;   // textures with GPU memory
+        int reducedCount = 0;    // resident but with top mips dropped
+        uint64_t evictions = 0;  // totals since startup
+        uint64_t mipDrops = 0;
+        uint64_t reloads = 0;
+        uint64_t streamIns = 0;  // finished mip streams uploaded
+        int loadingCount = 0;    // AcquireAsync loads and evicted reloads still on the workers
+        int loadBatch = 0;       // loads started since the last time none were running (progress bars)
+    };
+
+    // Load (or reuse) the texture at path and take a reference. INVALID_TEXTURE on failure.
+    TextureHandle Acquire(const std::string& path);
+    TextureHandle Acquire(Vfs::AssetId asset);
+    // Same for an encoded image (PNG/JPG/...) already in memory, e.g. embedded in a GLB.
+    // name is the cache key ("model.glb#image0"); the bytes are copied so the texture
+    // can be rebuilt after an eviction.
+    TextureHandle AcquireFromMemory(const std::string& name, const unsigned char* data, size_t size);
+    // Non-blocking Acquire: the handle is valid right away, the file is read, decoded and
+    // cooked on the Jobs workers and Update uploads it. Until then Touch/Bind give 0.
+    // A failed load is only logged (the handle stays, see TextureInfo::loadFailed).
+    TextureHandle AcquireAsync(const std::string& path);
+    bool IsLoading(TextureHandle handle);
+    // Extra reference / drop a reference (texture is deleted when the count hits 0)
+    void AddRef(TextureHandle handle);
+    bool Release(TextureHandle handle);
+
+    // O(1) queries by handle. Invalid or stale handles give 0 / nullptr / "".
+    GLuint GetGLId(TextureHandle handle);
+    const TextureInfo* GetInfo(TextureHandle handle);
+    const std::string& GetPath(TextureHandle handle);
+
+    // Live handle for a path without loading it (INVALID_TEXTURE if not loaded)
+    TextureHandle Find(const std::string& path);
+
+    // Hot reload: decode the file again on a worker and swap the GL texture under the
+    // existing handle in Update; the old texture draws until then. A failed decode (file
+    // half written, bad image) keeps the current texture. Textures that are not loaded,
+    // evicted or built from memory are left alone. True if a reload was started.
+    bool Reload(Vfs::AssetId asset);
+
+    // Mark the texture as used this frame and return its GL id. If the budget evicted it
+    // the reload is queued on the workers and 0 is returned until Update uploads it.
+    // Bind does the same and binds it to a texture unit.
+    GLuint Touch(TextureHandle handle);
+    GLuint Bind(TextureHandle handle, GLuint unit = 0);
+
+    // Screen-size mip streaming: before drawing, tell the manager how big the texture is
+    // on screen (in pixels, along its longest side) or which mip level is enough.
+    // The finest request of the frame wins. Update() then streams finer levels in on the
+    // Jobs workers, or raises GL_TEXTURE_BASE_LEVEL and frees the finer levels once a
+    // coarser mip has been enough for a while.
+    void RequestScreenSize(TextureHandle handle, float screenPixels);
+    void RequestMip(TextureHandle handle, int mip);
+
+    // Call BeginFrame at the top of each frame and Update after the frame has been drawn.
+    // Update uploads finished mip streams, applies the screen-size requests and then the
+    // memory budget: while over budget the least recently used textures first lose their
+    // top mip, then get evicted completely.
+    void BeginFrame();
+    void Update();
+    void SetBudget(size_t bytes); // 0 = unlimited
+    TextureStats GetStats();
+
+    // Older path / GL id based API, kept for existing callers
     // Load texture from disk (path). Returns 0 on failure, otherwise GL texture id.
     GLuint Load(const std::string& path);
 
@@ -18,6 +123,14 @@ namespace TextureManager {
     bool Unload(GLuint texID);
     void UnloadAll();
 
-}
-
+    // Cook step: when format is not None, Acquire() builds the mip chain on the CPU,
+    // block-compresses every level on the Jobs workers and uploads with glCompressedTexImage2D.
+    // The manager starts at Format::None (plain GL_RGBA8); the engine sets
+    // EngineConfig::textureFormat, Auto by default.
+    void SetCookSettings(TextureCompress::Format format, TextureCompress::Quality quality);
+    // Folder for cooked (compressed) chains, so a texture is only encoded once per version
+    // of its file, not on every launch or reload. Empty = encode every time. Set it
+    // before the first load, the workers read it.
+    void SetCacheDirectory(const std::string& directory);
 
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+// Conversion between the Float8 vertex layout and the packed layouts in VertexFormat.
+// Packed vertices are decoded by the vertex shader (default.vert, u_vertexFormat):
+//   position = u_posCenter + snorm(pos) * u_posExtent
+//   normal   = OctDecode(snorm(normal.xy))
+//   uv       = half2, read as float by the vertex fetch
+// The centre/extent come from the mesh bounds, which the cooked file already stores.
+namespace VertexQuantize {
+
+    uint16_t FloatToHalf(float value);   // round to nearest even, overflow -> inf
+    float HalfToFloat(uint16_t value);
+
+    // Octahedral normal mapping, unit vector <-> [-1, 1]^2
+    glm::vec2 OctEncode(const glm::vec3& normal);
+    glm::vec3 OctDecode(const glm::vec2& encoded);
+
+    // Shader decode parameters for a bounding box
+    struct DecodeParams {
+        glm::vec3 center = glm::vec3(0.0f);
+        glm::vec3 extent = glm::vec3(1.0f);
+    };
+    DecodeParams BoundsParams(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    bool IsPacked(VertexFormat format);
+    const char* FormatName(VertexFormat format);
+
+    // Float8 vertices -> format (GpuMesh::VertexStride(format) bytes per vertex).
+    // The bounds must contain every position.
+    bool Encode(VertexFormat format, const float* vertices, size_t vertexCount,
+        const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<uint8_t>& out);
+    // format -> Float8 (tools and MeshFile::Read, the renderer never decodes on the CPU)
+    bool Decode(VertexFormat format, const void* vertices, size_t vertexCount,
+        const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<float>& out);
+
+    // Round trip error of a mesh in a format, logged with the memory saving
+    struct ErrorReport {
+        float maxPositionError = 0.0f;   // model units
+        float maxNormalDegrees = 0.0f;
+        float maxUvError = 0.0f;
+        size_t floatBytes = 0;
+        size_t packedBytes = 0;
+    };
+    ErrorReport Measure(VertexFormat format, const MeshData& mesh, const char* name = nullptr);
+
+    // Largest uv error a packed format may add before the cook keeps Float8 (half floats
+    // lose precision on uvs that tile far outside 0..1)
+    constexpr float kMaxUvError = 1.0f / 2048.0f;
+}
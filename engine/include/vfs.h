@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MappedFile;
+class PakArchive;
+
+// Virtual file system for assets. Assets are named by virtual paths such as
+// "shaders/default.vert" or "assets/textures/crate.jpg", resolved through mount points,
+// newest mount first:
+//   Directory - loose files under a folder (development)
+//   Pack      - a .spxpak archive (shipping)
+//   Memory    - byte buffers registered at runtime (generated or embedded assets)
+// The same virtual path, and so the same AssetId, works whether the asset is loose or packed.
+//
+// Paths are interned once into a dense AssetId (case-insensitive, '\' == '/'). Find and the
+// resolve of an already resolved id don't allocate: the location (pack entry, memory
+// buffer or loose file path), or that there is none, is cached per id until the mounts
+// change or Invalidate is called. The hot reload watcher invalidates on changes in the
+// mounted folders; code writing a file it reads back later invalidates that id.
+// With nothing mounted, the development assets root (the folder holding "assets") is
+// mounted as a directory on first use. Paths no mount has (absolute paths from a file
+// dialog, cooked files next to a source model) are read from disk as given.
+// All functions are thread safe. A mount can be removed while other threads still read
+// from it: reads in flight and views handed out by Open keep its pack or buffers alive.
+namespace Vfs {
+
+    using AssetId = uint32_t;
+    constexpr AssetId kInvalidAsset = 0;
+
+    using MountId = int;
+    constexpr MountId kInvalidMount = -1;
+
+    enum class MountKind : uint8_t {
+        Directory,
+        Pack,
+        Memory,
+    };
+
+    // mountPoint is a virtual prefix ("" = everything, "assets/" = only paths under assets/),
+    // stripped before the lookup in the mounted folder / pack / memory files
+    MountId MountDirectory(const std::string& directory, std::string_view mountPoint = {});
+    MountId MountPack(const std::string& pakPath, std::string_view mountPoint = {});
+    MountId MountMemory(std::string_view mountPoint = {});
+    // path is relative to the memory mount's mount point. Views handed out by Open keep
+    // the bytes alive, also past Unmount.
+    bool AddMemoryFile(MountId mount, std::string_view path, std::vector<uint8_t> bytes);
+    bool Unmount(MountId mount);
+    void UnmountAll();
+    // Archive behind a pack mount, nullptr for other mounts. Valid until the mount goes away.
+    const PakArchive* GetPack(MountId mount);
+    // Folder mounts (mounting the default one if nothing is mounted yet), for file watchers
+    struct DirectoryMount {
+        MountId mount = kInvalidMount;
+        std::string root;
+        std::string mountPoint;
+    };
+    std::vector<DirectoryMount> DirectoryMounts();
+
+    // Intern a path; the first spelling is kept as the name
+    AssetId Intern(std::string_view path);
+    // Id of a path interned before, kInvalidAsset otherwise. Never allocates.
+    AssetId Find(std::string_view path);
+    const std::string& Name(AssetId id);
+
+    struct Location {
+        bool found = false;
+        MountId mount = kInvalidMount;   // kInvalidMount = plain disk path outside the mounts
+        MountKind kind = MountKind::Directory;
+    };
+    Location Resolve(AssetId id);
+    bool Exists(AssetId id);
+    // Loose file behind the asset, empty when it is packed, in memory or missing
+    std::string DiskPath(AssetId id);
+
+    // Whole file
+    bool Read(AssetId id, std::vector<uint8_t>& out);
+    // Pack entries stored uncompressed and memory files are views (no copy), compressed
+    // pack entries decode into the MappedFile's buffer, loose files are mapped
+    bool Open(AssetId id, MappedFile& file);
+
+    // Forget cached locations, e.g. after files were added to a mounted folder
+    void Invalidate();
+    // Forget one asset's cached location, e.g. after writing its file
+    void Invalidate(AssetId id);
+
+    struct Stats {
+        size_t assets = 0;
+        size_t mounts = 0;
+        uint64_t resolves = 0;
+        uint64_t cacheHits = 0;
+    };
+    Stats GetStats();
+}
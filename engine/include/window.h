@@ -2,6 +2,7 @@
 #include <glad/glad.h> // for GLuint & GL calls used by framebuffer helpers
 #include <functional>
 #include <string>
+#include <vector>
 #include <imgui\ImGuiAF.h>
 #include <imgui\imgui.h>
 #include <imgui\imgui_internal.h>
@@ -38,9 +39,16 @@ public:
     SpxWindow& operator=(const SpxWindow&) = delete;
 
     void SetIcon(GLFWwindow* window); // set window icon from image file
+    void SetIcon(GLFWwindow* window, const std::vector<unsigned char>& rgba, int width, int height); // already decoded
+    // Decode the icon image to RGBA8. No GL or GLFW calls, safe on a worker thread.
+    static bool DecodeIcon(std::vector<unsigned char>& rgba, int& width, int& height);
 
     // #### ImGui integration requires access to the GLFWwindow* ####
-    void SetUpImGui(GLFWwindow* window);
+    // fonts: atlas from BuildFontAtlas (the ImGui context takes ownership), nullptr = load the fonts here
+    void SetUpImGui(GLFWwindow* window, ImFontAtlas* fonts = nullptr);
+    // Read and rasterize the editor fonts into a new atlas (or restore it from the FontCache),
+    // nullptr on failure. CPU only, so it can run on a worker while the GL context is created.
+    static ImFontAtlas* BuildFontAtlas();
     void NewImguiFrame(GLFWwindow* window);
 
     // Docking control
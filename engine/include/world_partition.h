@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "scene_file.h"
+
+// Streams a large world in square grid cells on the XZ plane. A world is a manifest
+// (.spxworld, text: cell size and the list of non-empty cells) plus one .spxscene per cell
+// in the <manifest name>_cells folder next to it, holding the entities whose position
+// falls inside that cell.
+//
+// Each frame Update() gets the camera position: cells within loadRadius are read and
+// decoded on the workers (nearest first, a few at a time), cells beyond unloadRadius are
+// dropped; the gap between the two radii keeps a cell on the border from flickering.
+// Decoded cells are turned into entities by the caller under a per-frame time budget
+// (Spawn), since creating the models uploads their GL buffers. The entities of dropped
+// cells are handed back by TakeUnloaded. Resident cells, loads in flight and the work
+// per frame are bounded by the settings, not by the size of the world.
+class WorldPartition {
+public:
+    static constexpr int kVersion = 1;
+    static constexpr const char* kExtension = ".spxworld";
+
+    struct Settings {
+        float cellSize = 64.0f;        // used by Export; Open takes it from the manifest
+        float loadRadius = 160.0f;     // cells closer than this to the camera are loaded
+        float unloadRadius = 224.0f;   // cells further than this are dropped, > loadRadius
+        int maxLoadsInFlight = 4;      // cells being read/decoded at once
+        double spawnBudgetMs = 2.0;    // main thread time per frame for creating entities
+    };
+
+    struct Stats {
+        size_t cells = 0;              // non-empty cells in the world
+        size_t resident = 0;           // loaded and fully spawned
+        size_t pending = 0;            // loading or waiting to spawn
+        size_t entities = 0;           // spawned entities of resident/pending cells
+    };
+
+    WorldPartition() = default;
+    WorldPartition(const WorldPartition&) = delete;
+    WorldPartition& operator=(const WorldPartition&) = delete;
+
+    // Split scene into cells by position and write the manifest and one file per cell
+    static bool Export(const SceneFile::Columns& scene, const std::string& manifestPath, float cellSize);
+
+    bool Open(const std::string& manifestPath, const Settings& settings);
+    // Forget every cell; the caller removes the entities (TakeUnloaded does not report them)
+    void Close();
+    bool IsOpen() const { return m_cellSize > 0.0f; }
+    const std::string& Path() const { return m_manifestPath; }
+
+    // Collect finished loads, start loads around the camera (world space, see
+    // Engine::GetOrigin), drop far cells
+    void Update(const glm::dvec3& camera);
+    // Create entities of decoded cells until the time budget runs out. spawn makes the
+    // entity for one row and returns its id (-1 = skipped).
+    void Spawn(const std::function<int(const SceneFile::Columns&, size_t)>& spawn);
+    // Ids of the entities of cells dropped since the last call
+    std::vector<int> TakeUnloaded();
+
+    Stats GetStats() const;
+
+private:
+    enum class CellState { Loading, Ready, Resident };
+    struct Cell {
+        CellState state = CellState::Loading;
+        std::unique_ptr<SceneFile::Columns> columns;  // decoded rows while Ready
+        size_t spawned = 0;                           // rows handled so far
+        std::vector<int> entityIds;
+    };
+    // Loads finished on the workers. Shared with the jobs, so a Close() while loads are
+    // running just lets their results fall on the floor.
+    struct Inbox;
+
+    static uint64_t Key(int32_t x, int32_t z) { return uint64_t(uint32_t(x)) << 32 | uint32_t(z); }
+    std::string CellPath(int32_t x, int32_t z) const;
+    double DistanceToCell(const glm::dvec3& p, int32_t x, int32_t z) const;
+
+    Settings m_settings;
+    float m_cellSize = 0.0f;
+    std::string m_manifestPath;
+    std::string m_cellDir;
+    glm::dvec3 m_camera = glm::dvec3(0.0);
+    std::unordered_set<uint64_t> m_available;      // non-empty cells from the manifest
+    std::unordered_map<uint64_t, Cell> m_cells;    // loading, ready or resident
+    std::shared_ptr<Inbox> m_inbox;
+    int m_inFlight = 0;
+    std::vector<int> m_unloaded;
+};
@@ -1,7 +1,7 @@
 #include "Camera.h"
 
 Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch)
-    : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM) {
+    : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), NearPlane(0.1f), FarPlane(100.0f) {
     Position = position;
     WorldUp = up;
     Yaw = yaw;
@@ -14,7 +14,13 @@ glm::mat4 Camera::GetViewMatrix() const {
 }
 
 glm::mat4 Camera::GetProjectionMatrix(float aspectRatio) const {
-    return glm::perspective(glm::radians(Zoom), aspectRatio, 0.1f, 100.0f);
+    return glm::perspective(glm::radians(Zoom), aspectRatio, NearPlane, FarPlane);
+}
+
+float Camera::ProjectedSize(const glm::vec3& center, float radius, float viewportHeight) const {
+    float dist = glm::length(center - Position);
+    if (dist <= radius) return viewportHeight * 16.0f; // inside it, wants full resolution
+    return radius / (dist * glm::tan(glm::radians(Zoom) * 0.5f)) * viewportHeight * 0.5f;
 }
 
 void Camera::ProcessKeyboard(Camera_Movement direction, float deltaTime) {
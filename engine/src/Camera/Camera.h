@@ -32,6 +32,8 @@ public:
     float MovementSpeed;
     float MouseSensitivity;
     float Zoom;
+    float NearPlane;
+    float FarPlane;
 
     Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f),
         glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f),
@@ -39,6 +41,8 @@ public:
 
     glm::mat4 GetViewMatrix() const;
     glm::mat4 GetProjectionMatrix(float aspectRatio) const;
+    // Approximate on-screen radius in pixels of a sphere (used to pick texture mips)
+    float ProjectedSize(const glm::vec3& center, float radius, float viewportHeight) const;
 
     void ProcessKeyboard(Camera_Movement direction, float deltaTime);
     void ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true);
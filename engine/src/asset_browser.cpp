@@ -0,0 +1,528 @@
+#include "../include/asset_browser.h"
+#include "../include/asset_path.h"
+#include "../include/hash.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include "../include/vfs.h"
+#include "stb/stb_image.h"
+#include "imgui/imgui.h"
+#include "imgui/ImGuiAF.h"
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+
+// SSE2 is baseline on x64 (MSVC defines _M_X64, gcc/clang define __SSE2__)
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define SPX_AB_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char kMagic[8] = { 'S', 'P', 'X', 'T', 'H', 'M', 'B', '\0' };
+    constexpr uint32_t kCacheVersion = 1;
+    constexpr int kCellsPerRow = AssetBrowser::kAtlasSize / AssetBrowser::kThumbSize;
+    constexpr int kCellCount = kCellsPerRow * kCellsPerRow;
+    constexpr int kMaxInFlight = 8;          // thumbnail jobs on the workers at once
+    constexpr int kMaxUploadsPerFrame = 8;   // atlas uploads per frame
+    constexpr uint64_t kStaleFrames = 2;     // queued requests not asked for since are dropped
+
+    struct ThumbHeader {
+        char magic[8];
+        uint32_t version;
+        uint16_t width;
+        uint16_t height;
+    };
+    static_assert(sizeof(ThumbHeader) == 16, "thumbnail cache header layout changed, bump kCacheVersion");
+
+    struct ThumbPixels {
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> pixels; // RGBA8, top row first
+    };
+
+    // Sum `count` RGBA8 pixels into four 32-bit channel totals
+#ifdef SPX_AB_SSE2
+    inline __m128i SumPixels(const unsigned char* p, int count, __m128i acc) {
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 4));
+            // pixels 0+2 and 1+3 in 16-bit lanes (max 510), then widened into the totals
+            __m128i pairs = _mm_add_epi16(_mm_unpacklo_epi8(px, zero), _mm_unpackhi_epi8(px, zero));
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(pairs, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(pairs, zero));
+        }
+        for (; i < count; ++i) {
+            int32_t one;
+            std::memcpy(&one, p + i * 4, 4);
+            __m128i px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(one), zero);
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(px, zero));
+        }
+        return acc;
+    }
+#endif
+
+    // Box filter resize of an RGBA8 image: each output pixel is the average of the source
+    // pixels it covers (at least one, so small images are scaled up nearest-neighbour)
+    void ResizeBox(const unsigned char* src, int sw, int sh, unsigned char* dst, int dw, int dh) {
+        for (int y = 0; y < dh; ++y) {
+            const int y0 = static_cast<int>(static_cast<int64_t>(y) * sh / dh);
+            const int y1 = std::max(y0 + 1, static_cast<int>(static_cast<int64_t>(y + 1) * sh / dh));
+            for (int x = 0; x < dw; ++x) {
+                const int x0 = static_cast<int>(static_cast<int64_t>(x) * sw / dw);
+                const int x1 = std::max(x0 + 1, static_cast<int>(static_cast<int64_t>(x + 1) * sw / dw));
+                uint32_t sum[4] = { 0, 0, 0, 0 };
+#ifdef SPX_AB_SSE2
+                __m128i acc = _mm_setzero_si128();
+                for (int r = y0; r < y1; ++r) {
+                    acc = SumPixels(src + (static_cast<size_t>(r) * sw + x0) * 4, x1 - x0, acc);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(sum), acc);
+#else
+                for (int r = y0; r < y1; ++r) {
+                    const unsigned char* p = src + (static_cast<size_t>(r) * sw + x0) * 4;
+                    for (int i = 0; i < (x1 - x0) * 4; ++i) sum[i & 3] += p[i];
+                }
+#endif
+                const uint32_t count = static_cast<uint32_t>((x1 - x0) * (y1 - y0));
+                unsigned char* out = dst + (static_cast<size_t>(y) * dw + x) * 4;
+                for (int c = 0; c < 4; ++c) out[c] = static_cast<unsigned char>((sum[c] + count / 2) / count);
+            }
+        }
+    }
+
+    // Cache key from the loose file's path, size and write time; 0 when the asset isn't a loose file
+    uint64_t FileKey(const std::string& path) {
+        const std::string disk = Vfs::DiskPath(Vfs::Intern(path));
+        if (disk.empty()) return 0;
+        std::error_code ec;
+        const auto size = fs::file_size(disk, ec);
+        if (ec) return 0;
+        const auto time = fs::last_write_time(disk, ec);
+        if (ec) return 0;
+        uint64_t h = Hash::Fnv1a64(disk);
+        h = Hash::Mix64(h ^ static_cast<uint64_t>(size));
+        h = Hash::Mix64(h ^ static_cast<uint64_t>(time.time_since_epoch().count()));
+        return Hash::Mix64(h ^ kCacheVersion);
+    }
+
+    std::string CachePath(const std::string& cacheDir, uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.thumb", static_cast<unsigned long long>(key));
+        return (fs::path(cacheDir) / name).string();
+    }
+
+    bool ReadCached(const std::string& cacheDir, uint64_t key, ThumbPixels& thumb) {
+        if (cacheDir.empty()) return false;
+        std::ifstream in(CachePath(cacheDir, key), std::ios::binary);
+        ThumbHeader header;
+        if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kCacheVersion
+            || header.width == 0 || header.height == 0
+            || header.width > AssetBrowser::kThumbSize || header.height > AssetBrowser::kThumbSize) {
+            return false;
+        }
+        thumb.width = header.width;
+        thumb.height = header.height;
+        thumb.pixels.resize(static_cast<size_t>(thumb.width) * thumb.height * 4);
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(thumb.pixels.data()), static_cast<std::streamsize>(thumb.pixels.size())));
+    }
+
+    void WriteCached(const std::string& cacheDir, uint64_t key, const ThumbPixels& thumb) {
+        if (cacheDir.empty()) return;
+        std::error_code ec;
+        fs::create_directories(cacheDir, ec);
+        ThumbHeader header = {};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kCacheVersion;
+        header.width = static_cast<uint16_t>(thumb.width);
+        header.height = static_cast<uint16_t>(thumb.height);
+        // temp file + rename: another editor instance may be reading the same cache
+        const std::string path = CachePath(cacheDir, key);
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.write(reinterpret_cast<const char*>(&header), sizeof(header))
+                || !out.write(reinterpret_cast<const char*>(thumb.pixels.data()), static_cast<std::streamsize>(thumb.pixels.size()))) {
+                return;
+            }
+        }
+        fs::rename(tmp, path, ec);
+        if (ec) fs::remove(tmp, ec);
+    }
+
+    // Worker side: disk cache, else read + decode + downscale (and fill the cache)
+    bool MakeThumbnail(const std::string& path, const std::string& cacheDir, ThumbPixels& thumb) {
+        uint64_t key = FileKey(path);
+        if (key && ReadCached(cacheDir, key, thumb)) return true;
+
+        std::vector<unsigned char> bytes;
+        if (!ReadAssetFile(path, bytes) || bytes.empty()) return false;
+        if (!key) {
+            // packed or in-memory asset: key on the bytes, still saves the decode
+            key = Hash::Mix64(Hash::Bytes64(bytes.data(), bytes.size()) ^ Hash::Fnv1a64(path) ^ kCacheVersion);
+            if (ReadCached(cacheDir, key, thumb)) return true;
+        }
+
+        // workers that loaded textures have flipping on (thread-local); thumbnails stay top row first
+        stbi_set_flip_vertically_on_load_thread(0);
+        int w = 0, h = 0, n = 0;
+        unsigned char* data = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &w, &h, &n, 4);
+        if (!data) return false;
+
+        const int longest = std::max(w, h);
+        thumb.width = std::max(1, (w * AssetBrowser::kThumbSize + longest / 2) / longest);
+        thumb.height = std::max(1, (h * AssetBrowser::kThumbSize + longest / 2) / longest);
+        thumb.pixels.resize(static_cast<size_t>(thumb.width) * thumb.height * 4);
+        ResizeBox(data, w, h, thumb.pixels.data(), thumb.width, thumb.height);
+        stbi_image_free(data);
+
+        WriteCached(cacheDir, key, thumb);
+        return true;
+    }
+
+    bool LessNoCase(const std::string& a, const std::string& b) {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](unsigned char x, unsigned char y) {
+            return std::tolower(x) < std::tolower(y);
+        });
+    }
+
+    bool ContainsNoCase(const std::string& text, const char* needle) {
+        const size_t n = std::strlen(needle);
+        if (n == 0) return true;
+        auto it = std::search(text.begin(), text.end(), needle, needle + n, [](unsigned char x, unsigned char y) {
+            return std::tolower(x) == std::tolower(y);
+        });
+        return it != text.end();
+    }
+
+    // Shorten a label with "..." until it fits the width
+    std::string Ellipsize(const std::string& text, float width) {
+        if (ImGui::CalcTextSize(text.c_str()).x <= width) return text;
+        std::string out = text;
+        while (!out.empty() && ImGui::CalcTextSize((out + "...").c_str()).x > width) out.pop_back();
+        return out + "...";
+    }
+}
+
+// Finished thumbnails, filled by the workers. Shared so jobs still running when the
+// browser is destroyed have somewhere to put their result.
+struct AssetBrowser::Results {
+    struct Done {
+        std::string path;
+        bool ok = false;
+        ThumbPixels thumb;
+    };
+    std::mutex mutex;
+    std::vector<Done> done;
+};
+
+AssetBrowser::AssetBrowser(const std::string& cacheDir)
+    : m_cacheDir(cacheDir), m_results(std::make_shared<Results>())
+{
+}
+
+AssetBrowser::~AssetBrowser() {
+    if (m_atlas) glDeleteTextures(1, &m_atlas);
+}
+
+bool AssetBrowser::IsImageFile(const std::string& path) {
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tga"
+        || ext == ".gif" || ext == ".psd" || ext == ".hdr";
+}
+
+bool AssetBrowser::IsModelFile(const std::string& path) {
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".obj" || ext == ".gltf" || ext == ".glb" || ext == ".spxmesh";
+}
+
+AssetBrowser::ThumbState AssetBrowser::Thumbnail(const std::string& path, GLuint& texture, float uv[4]) {
+    auto [it, inserted] = m_thumbs.try_emplace(path);
+    Thumb& thumb = it->second;
+    thumb.lastUsed = m_frame;
+    if (inserted) m_queue.push_back(path);
+    if (thumb.state == ThumbState::Ready) {
+        // half a texel in from the edges so linear filtering never reads the next cell
+        const float texel = 1.0f / kAtlasSize;
+        const int cx = (thumb.cell % kCellsPerRow) * kThumbSize;
+        const int cy = (thumb.cell / kCellsPerRow) * kThumbSize;
+        texture = m_atlas;
+        uv[0] = (cx + 0.5f) * texel;
+        uv[1] = (cy + 0.5f) * texel;
+        uv[2] = (cx + thumb.width - 0.5f) * texel;
+        uv[3] = (cy + thumb.height - 0.5f) * texel;
+    }
+    return thumb.state;
+}
+
+void AssetBrowser::StartJob(const std::string& path) {
+    ++m_inFlight;
+    std::shared_ptr<Results> results = m_results;
+    std::string cacheDir = m_cacheDir;
+    Jobs::Submit([results, path, cacheDir]() {
+        Results::Done done;
+        done.path = path;
+        done.ok = MakeThumbnail(path, cacheDir, done.thumb);
+        std::lock_guard<std::mutex> lock(results->mutex);
+        results->done.push_back(std::move(done));
+    });
+}
+
+int AssetBrowser::AllocCell() {
+    if (!m_atlas) {
+        glGenTextures(1, &m_atlas);
+        glBindTexture(GL_TEXTURE_2D, m_atlas);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, kAtlasSize, kAtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_cellOwner.assign(kCellCount, std::string());
+        for (int cell = kCellCount - 1; cell >= 0; --cell) m_freeCells.push_back(cell);
+    }
+    if (!m_freeCells.empty()) {
+        int cell = m_freeCells.back();
+        m_freeCells.pop_back();
+        return cell;
+    }
+    // full: take the cell of the least recently shown thumbnail, never one on screen now
+    int victim = -1;
+    uint64_t oldest = m_frame;
+    for (int cell = 0; cell < kCellCount; ++cell) {
+        auto it = m_thumbs.find(m_cellOwner[cell]);
+        if (it != m_thumbs.end() && it->second.lastUsed < oldest) {
+            oldest = it->second.lastUsed;
+            victim = cell;
+        }
+    }
+    if (victim >= 0) {
+        m_thumbs.erase(m_cellOwner[victim]); // asked for again when it scrolls back into view
+        m_cellOwner[victim].clear();
+    }
+    return victim;
+}
+
+void AssetBrowser::Update() {
+    std::vector<Results::Done> done;
+    {
+        std::lock_guard<std::mutex> lock(m_results->mutex);
+        const size_t count = std::min<size_t>(m_results->done.size(), kMaxUploadsPerFrame);
+        for (size_t i = 0; i < count; ++i) done.push_back(std::move(m_results->done[i]));
+        m_results->done.erase(m_results->done.begin(), m_results->done.begin() + count);
+    }
+    for (Results::Done& result : done) {
+        --m_inFlight;
+        auto it = m_thumbs.find(result.path);
+        if (it == m_thumbs.end()) continue;
+        Thumb& thumb = it->second;
+        if (!result.ok) {
+            thumb.state = ThumbState::Failed;
+            continue;
+        }
+        const int cell = AllocCell();
+        if (cell < 0) {
+            // every cell is on screen; try again later (the disk cache makes that cheap)
+            thumb.started = false;
+            m_queue.push_back(result.path);
+            continue;
+        }
+        glBindTexture(GL_TEXTURE_2D, m_atlas);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, (cell % kCellsPerRow) * kThumbSize, (cell / kCellsPerRow) * kThumbSize,
+            result.thumb.width, result.thumb.height, GL_RGBA, GL_UNSIGNED_BYTE, result.thumb.pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        thumb.state = ThumbState::Ready;
+        thumb.cell = cell;
+        thumb.width = result.thumb.width;
+        thumb.height = result.thumb.height;
+        m_cellOwner[cell] = result.path;
+    }
+
+    // newest requests first would starve the old ones; instead the ones scrolled away are dropped
+    while (m_inFlight < kMaxInFlight && !m_queue.empty()) {
+        std::string path = std::move(m_queue.front());
+        m_queue.pop_front();
+        auto it = m_thumbs.find(path);
+        if (it == m_thumbs.end() || it->second.started || it->second.state != ThumbState::Pending) continue;
+        if (m_frame - it->second.lastUsed > kStaleFrames) {
+            m_thumbs.erase(it);
+            continue;
+        }
+        it->second.started = true;
+        StartJob(path);
+    }
+    ++m_frame;
+}
+
+void AssetBrowser::Navigate(const std::string& folder) {
+    m_folder = folder;
+    m_scanned = false;
+}
+
+void AssetBrowser::Scan() {
+    m_scanned = true;
+    m_items.clear();
+    std::vector<Vfs::DirectoryMount> mounts = Vfs::DirectoryMounts();
+    if (mounts.empty()) return;
+    m_mount = std::clamp(m_mount, 0, static_cast<int>(mounts.size()) - 1);
+    m_mountRoot = mounts[m_mount].root;
+    m_mountPoint = mounts[m_mount].mountPoint;
+    m_mountNames.clear();
+    for (const Vfs::DirectoryMount& mount : mounts) {
+        m_mountNames.push_back(mount.mountPoint.empty() ? mount.root : mount.mountPoint + " (" + mount.root + ")");
+    }
+
+    std::error_code ec;
+    for (auto it = fs::directory_iterator(fs::path(m_mountRoot) / m_folder, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        Item item;
+        item.name = it->path().filename().string();
+        if (item.name.empty() || item.name[0] == '.') continue;
+        item.folder = it->is_directory(ec);
+        item.path = m_mountPoint + m_folder + item.name;
+        item.image = !item.folder && IsImageFile(item.name);
+        m_items.push_back(std::move(item));
+    }
+    std::sort(m_items.begin(), m_items.end(), [](const Item& a, const Item& b) {
+        if (a.folder != b.folder) return a.folder;
+        return LessNoCase(a.name, b.name);
+    });
+}
+
+std::string AssetBrowser::Draw() {
+    std::string activated;
+    if (!ImGui::Begin("Asset Browser")) {
+        ImGui::End();
+        return activated;
+    }
+    if (!m_scanned) {
+        if (m_mountRoot.empty()) {
+            // first time: start in the assets folder when the mount has one
+            std::vector<Vfs::DirectoryMount> mounts = Vfs::DirectoryMounts();
+            std::error_code ec;
+            if (!mounts.empty() && fs::is_directory(fs::path(mounts[0].root) / "assets", ec)) m_folder = "assets/";
+        }
+        Scan();
+    }
+
+    // toolbar: mount, up, refresh, location, filter
+    std::string navigate;
+    bool goUp = false;
+    if (m_mountNames.size() > 1) {
+        ImGui::SetNextItemWidth(160.0f);
+        if (ImGui::BeginCombo("##mount", m_mountNames[m_mount].c_str())) {
+            for (int i = 0; i < static_cast<int>(m_mountNames.size()); ++i) {
+                if (ImGui::Selectable(m_mountNames[i].c_str(), i == m_mount) && i != m_mount) {
+                    m_mount = i;
+                    Navigate(std::string());
+                }
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SameLine();
+    }
+    ImGui::BeginDisabled(m_folder.empty());
+    if (ImGui::Button(ICON_FA_LEVEL_UP_ALT)) goUp = true;
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_SYNC)) m_scanned = false;
+    ImGui::SameLine();
+    ImGui::Text("%s%s", m_mountPoint.empty() ? "/" : m_mountPoint.c_str(), m_folder.c_str());
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(std::max(80.0f, ImGui::GetContentRegionAvail().x));
+    ImGui::InputTextWithHint("##filter", "Filter", m_filter, sizeof(m_filter));
+
+    std::vector<int> shown;
+    shown.reserve(m_items.size());
+    for (int i = 0; i < static_cast<int>(m_items.size()); ++i) {
+        if (m_items[i].folder || ContainsNoCase(m_items[i].name, m_filter)) shown.push_back(i);
+    }
+
+    const ImGuiStyle& style = ImGui::GetStyle();
+    const float pad = 6.0f;
+    const ImVec2 cell(kThumbSize + pad * 2.0f, kThumbSize + pad * 2.0f + ImGui::GetTextLineHeight());
+    ImGui::BeginChild("##grid");
+    const int columns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + style.ItemSpacing.x) / (cell.x + style.ItemSpacing.x)));
+    const int rows = (static_cast<int>(shown.size()) + columns - 1) / columns;
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+
+    // only the visible rows are laid out and only their thumbnails are requested
+    ImGuiListClipper clipper;
+    clipper.Begin(rows, cell.y + style.ItemSpacing.y);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            for (int col = 0; col < columns; ++col) {
+                const int index = row * columns + col;
+                if (index >= static_cast<int>(shown.size())) break;
+                const Item& item = m_items[shown[index]];
+                if (col > 0) ImGui::SameLine();
+
+                ImGui::PushID(shown[index]);
+                const ImVec2 pos = ImGui::GetCursorScreenPos();
+                ImGui::InvisibleButton("##item", cell);
+                const bool hovered = ImGui::IsItemHovered();
+                if (hovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+                    if (item.folder) navigate = m_folder + item.name + "/";
+                    else activated = item.path;
+                }
+                if (hovered) {
+                    draw->AddRectFilled(pos, ImVec2(pos.x + cell.x, pos.y + cell.y), ImGui::GetColorU32(ImGuiCol_HeaderHovered), 4.0f);
+                    ImGui::SetTooltip("%s", item.path.c_str());
+                }
+
+                const ImVec2 box(pos.x + pad, pos.y + pad);
+                GLuint texture = 0;
+                float uv[4];
+                ThumbState state = item.image ? Thumbnail(item.path, texture, uv) : ThumbState::Failed;
+                if (state == ThumbState::Ready) {
+                    // keep the aspect ratio, centred in the square
+                    const Thumb& thumb = m_thumbs[item.path];
+                    const float x = box.x + (kThumbSize - thumb.width) * 0.5f;
+                    const float y = box.y + (kThumbSize - thumb.height) * 0.5f;
+                    draw->AddImage((ImTextureID)(intptr_t)texture, ImVec2(x, y), ImVec2(x + thumb.width, y + thumb.height),
+                        ImVec2(uv[0], uv[1]), ImVec2(uv[2], uv[3]));
+                }
+                else {
+                    const char* icon = item.folder ? ICON_FA_FOLDER
+                        : !item.image ? ICON_FA_FILE
+                        : state == ThumbState::Pending ? ICON_FA_FILE_IMAGE : ICON_FA_EXCLAMATION_TRIANGLE;
+                    const float size = ImGui::GetFontSize() * 2.0f;
+                    const ImVec2 textSize = ImGui::GetFont()->CalcTextSizeA(size, FLT_MAX, 0.0f, icon);
+                    draw->AddText(ImGui::GetFont(), size, ImVec2(box.x + (kThumbSize - textSize.x) * 0.5f, box.y + (kThumbSize - textSize.y) * 0.5f),
+                        ImGui::GetColorU32(ImGuiCol_Text), icon);
+                }
+                const std::string label = Ellipsize(item.name, cell.x - 2.0f);
+                const float labelWidth = ImGui::CalcTextSize(label.c_str()).x;
+                draw->AddText(ImVec2(pos.x + (cell.x - labelWidth) * 0.5f, box.y + kThumbSize + pad * 0.5f),
+                    ImGui::GetColorU32(ImGuiCol_Text), label.c_str());
+                ImGui::PopID();
+            }
+        }
+    }
+    ImGui::EndChild();
+    ImGui::End();
+
+    if (goUp) {
+        // drop the last "name/" of the folder
+        std::string parent = m_folder.substr(0, m_folder.size() - 1);
+        size_t slash = parent.find_last_of('/');
+        navigate = (slash == std::string::npos) ? std::string() : parent.substr(0, slash + 1);
+        Navigate(navigate);
+    }
+    else if (!navigate.empty()) {
+        Navigate(navigate);
+    }
+    return activated;
+}
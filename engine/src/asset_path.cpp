@@ -1,51 +1,51 @@
 // assets_path.cpp
 #include "../include/asset_path.h"
-#include <filesystem>
+#include "../include/log.h"
+#include "../include/vfs.h"
 
 #include <string>
 
-namespace fs = std::filesystem;
+// Thin wrappers over the Vfs for code that still passes paths around as strings
+static Vfs::MountId s_assetPack = Vfs::kInvalidMount;
 
-// Try several strategies in order:
-// 1) Look upward from this source file's directory for a directory that contains "assets"
-// 2) Look upward from the executable directory for a directory that contains "assets"
-// 3) Fall back to exe_dir / relativePath
-static fs::path FindAssetsRoot()
+std::string GetAssetPath(const std::string& relativePath)
 {
-    // 1) Start from the directory of this source file (compile-time path)
-    fs::path srcPath = fs::path(__FILE__).parent_path();
-
-    fs::path cur = srcPath;
-    while (true) {
-        if (fs::exists(cur / "assets")) return cur;
-        if (!cur.has_parent_path()) break;
-        cur = cur.parent_path();
-    }
+    // the loose file when there is one, else the virtual path itself (packed or missing)
+    std::string diskPath = Vfs::DiskPath(Vfs::Intern(relativePath));
+    return diskPath.empty() ? relativePath : diskPath;
+}
 
-    // 2) Start from executable directory (runtime)
-    try {
-        fs::path exe = fs::current_path(); // fallback to cwd
+bool MountAssetPack(const std::string& pakPath)
+{
+    UnmountAssetPack();
+    s_assetPack = Vfs::MountPack(pakPath);
+    return s_assetPack != Vfs::kInvalidMount;
+}
 
-        cur = exe;
-        while (true) {
-            if (fs::exists(cur / "assets")) return cur;
-            if (!cur.has_parent_path()) break;
-            cur = cur.parent_path();
-        }
-    }
-    catch (...) {
-        // ignore and fall back
-    }
+void UnmountAssetPack()
+{
+    if (s_assetPack == Vfs::kInvalidMount) return;
+    Vfs::Unmount(s_assetPack);
+    s_assetPack = Vfs::kInvalidMount;
+}
 
-    // 3) as last resort, return the executable/cwd path
-    return fs::current_path();
+const PakArchive* GetAssetPack()
+{
+    return Vfs::GetPack(s_assetPack);
 }
 
-std::string GetAssetPath(const std::string& relativePath)
+bool ReadAssetFile(const std::string& path, std::vector<unsigned char>& out)
+{
+    if (!Vfs::Read(Vfs::Intern(path), out)) {
+        LOG_WARNING("ReadAssetFile: cannot open " << path);
+        return false;
+    }
+    return true;
+}
+
+bool OpenAssetFile(const std::string& path, MappedFile& file)
 {
-    static fs::path assetsRoot = FindAssetsRoot();
-    fs::path p = assetsRoot / relativePath;
-    return p.make_preferred().string();
+    return Vfs::Open(Vfs::Intern(path), file);
 }
 
 //#ifdef _WIN32
@@ -7,6 +7,11 @@
 #include <imgui\imgui_impl_opengl3.h>
 #include <imgui\ImGuiAF.h>
 #include "log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <unordered_set>
 #include <iostream>
 
 #include <glm/glm.hpp>
@@ -16,142 +21,296 @@
 #include "../include/asset_path.h"
 #include "../src/Input/EditorInput.h"
 #include <textures.h>
-
+#include "../include/hot_reload.h"
+#include "../include/jobs.h"
+#include "../include/lod_selector.h"
+#include "../include/mesh_cache.h"
+#include "../include/asset_browser.h"
+#include "../include/file_dialog.h"
+#include "../include/font_cache.h"
+#include "../include/mesh_file.h"
+#include "../include/program_cache.h"
+#include "../include/scene_file.h"
+#include "../include/scene_saver.h"
+#include "../include/scene_text.h"
+#include "../include/startup_profiler.h"
+#include "../include/task_graph.h"
+
+
+// Dialog request ids below 0 are engine requests, the others are entity ids
+static constexpr int kOpenSceneRequest = -2;
+static constexpr int kSaveSceneRequest = -3;
+static constexpr int kOpenWorldRequest = -4;
+static constexpr int kExportWorldRequest = -5;
+static constexpr int kAddModelRequest = -6;
+
+// TRS with Euler angles in radians, the order the inspector edits them in
+static glm::mat4 ComposeModelMatrix(const GameObj& obj) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), obj.position);
+    model = glm::rotate(model, obj.rotation.x, glm::vec3(1, 0, 0));
+    model = glm::rotate(model, obj.rotation.y, glm::vec3(0, 1, 0));
+    model = glm::rotate(model, obj.rotation.z, glm::vec3(0, 0, 1));
+    return glm::scale(model, obj.scale);
+}
 
 Engine::Engine() = default;
 Engine::~Engine() { Shutdown(); }
 
 bool Engine::Initialize(const EngineConfig& config) {
     m_config = config;
+    m_camera.FarPlane = config.farPlane;
+    StartupProfiler::Begin();
 
-    window = std::make_unique<SpxWindow>(config.windowConfig);
-    if (!window || !window->IsValid()) {
-        LOG_DEBUG("Engine: Failed to create window");
-        window.reset();
+    // Shipping builds serve every asset from one pack; mount it before anything loads
+    if (!config.assetPack.empty() && !MountAssetPack(config.assetPack)) {
+        LOG_ERROR("Engine: failed to mount asset pack " << config.assetPack);
         return false;
     }
 
-    void* native = window->GetNativeWindow();
-    if (!native) {
-        LOG_DEBUG("Engine: no native window");
-        return false;
-    }
-    glfwwindow = reinterpret_cast<GLFWwindow*>(native);
-    glfwMakeContextCurrent(glfwwindow);
+    StartupProfiler::Mark("Asset pack");
+
+    // Startup runs as a task graph: CPU-only work (font rasterizing, icon decode) runs on the
+    // workers while the main thread creates the window and GL context. Everything touching
+    // GL, GLFW or ImGui stays on the main thread.
+    Jobs::Init();
+    FontCache::SetDirectory(config.fontCacheDir); // read by the font task on a worker
+    TextureManager::SetCacheDirectory(config.textureCacheDir); // read by texture loads on the workers
+    using Thread = TaskGraph::Thread;
+    TaskGraph startup;
+
+    ImFontAtlas* fonts = nullptr; // owned by the ImGui context once handed over
+    std::vector<unsigned char> icon;
+    int iconWidth = 0, iconHeight = 0;
+
+    const TaskGraph::TaskId rasterizeFonts = startup.Add("Rasterize fonts", Thread::Worker, {}, [&]() {
+        // on failure SetUpImGui loads the fonts itself and logs what is missing
+        if (config.enableImGui) fonts = SpxWindow::BuildFontAtlas();
+        return true;
+    });
+    const TaskGraph::TaskId decodeIcon = startup.Add("Decode icon", Thread::Worker, {}, [&]() {
+        SpxWindow::DecodeIcon(icon, iconWidth, iconHeight); // no icon = the default one
+        return true;
+    });
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        LOG_DEBUG("Failed to initialize GLAD");
-        return false;
-    }
-	// Create EditorInput now that we have a native window for keyboard/mouse input
-    m_input = std::make_unique<EditorInput>(glfwwindow);
-    m_input->SetCamera(&m_camera);
-    LOG_INFO("EditorInput initialized");
-    if (m_input->HasKeyboardAttached()) {
-		LOG_INFO("Keyboard detected, input initialized");
-	}
-	else {
-		LOG_WARNING("No keyboard detected; input may not work");
-	}
-
-
-    // ##################  ImGui initialization could go here  ####################
-    // apply docking preference to window so ImGui is initialized with correct flags
-    window->SetEnableDocking(config.enableDocking);
-
-    if (config.enableImGui) {
-        window->SetUpImGui(glfwwindow);
-        LOG_INFO("ImGui initialized");
-    }
+    const TaskGraph::TaskId createWindow = startup.Add("Window + GL context", Thread::Main, {}, [&]() {
+        window = std::make_unique<SpxWindow>(config.windowConfig);
+        if (!window || !window->IsValid()) {
+            LOG_DEBUG("Engine: Failed to create window");
+            window.reset();
+            return false;
+        }
 
-    // ##################  END ImGui initialization  ####################
+        void* native = window->GetNativeWindow();
+        if (!native) {
+            LOG_DEBUG("Engine: no native window");
+            return false;
+        }
+        glfwwindow = reinterpret_cast<GLFWwindow*>(native);
+        glfwMakeContextCurrent(glfwwindow);
+        return true;
+    });
 
-    int w = window->GetWidth();
-    int h = window->GetHeight();
-    glViewport(0, 0, w, h);
+    const TaskGraph::TaskId glLoader = startup.Add("GL loader", Thread::Main, { createWindow }, [&]() {
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            LOG_DEBUG("Failed to initialize GLAD");
+            return false;
+        }
+        return true;
+    });
 
-    glEnable(GL_DEPTH_TEST);
-    glClearColor(config.clearColor[0], config.clearColor[1], config.clearColor[2], config.clearColor[3]);
+    startup.Add("Input", Thread::Main, { createWindow }, [&]() {
+        // Create EditorInput now that we have a native window for keyboard/mouse input
+        m_input = std::make_unique<EditorInput>(glfwwindow);
+        m_input->SetCamera(&m_camera);
+        LOG_INFO("EditorInput initialized");
+        if (m_input->HasKeyboardAttached()) {
+            LOG_INFO("Keyboard detected, input initialized");
+        }
+        else {
+            LOG_WARNING("No keyboard detected; input may not work");
+        }
+        return true;
+    });
 
-    window->SetResizeCallback([this](int width, int height) {
-        glViewport(0, 0, width, height);
+    startup.Add("Window icon", Thread::Main, { createWindow, decodeIcon }, [&]() {
+        window->SetIcon(glfwwindow, icon, iconWidth, iconHeight);
+        return true;
     });
 
-    // Create the engine-owned Entity and entity vector
-    m_entity = std::make_unique<Entity>();
-    m_entities.clear();
-    m_currentEntityIndex = 0;
-	m_cubeObjIdx = 0;
-    m_planeObjIdx = 0;
-	m_floorObjIdx = 0;
-
-    // Create the plane shader once here (Engine owns it).
-    // Build full paths relative to assets using GetAssetPath.
-    std::string shaderDir = GetAssetPath("shaders/"); // adjust if you use a SHADER_PATH macro
-    std::string vertFile = shaderDir + "default.vert";
-    std::string fragFile = shaderDir + "default.frag";
-
-    // Try to construct shader; the Shader class should log compile/link errors if any.
-    m_planeShader = std::make_unique<Shader>(vertFile, fragFile);
-    if (!m_planeShader) {
-        LOG_WARNING("Failed to create plane shader");
-    }
-    else {
-        LOG_INFO("Plane shader created: %s , %s", vertFile.c_str(), fragFile.c_str());
-    }
+    startup.Add("GL state + callbacks", Thread::Main, { glLoader }, [&]() {
+        int w = window->GetWidth();
+        int h = window->GetHeight();
+        glViewport(0, 0, w, h);
 
-    // Register a render callback with the window so it can call into Engine while the FBO is bound.
-    // The callback computes a simple centered orthographic projection and calls Entity::RenderPlane.
-    
-    window->SetRenderCallback([this]() {
-        int fbw = window->GetFramebufferWidth();
-        int fbh = window->GetFramebufferHeight();
-        if (fbw <= 0 || fbh <= 0) return;
+        glEnable(GL_DEPTH_TEST);
+        glClearColor(config.clearColor[0], config.clearColor[1], config.clearColor[2], config.clearColor[3]);
 
-        float aspect = (fbh > 0) ? static_cast<float>(fbw) / static_cast<float>(fbh) : 1.0f;
+        window->SetResizeCallback([this](int width, int height) {
+            glViewport(0, 0, width, height);
+        });
 
-        glm::mat4 view = m_camera.GetViewMatrix();
-        glm::mat4 projection = m_camera.GetProjectionMatrix(aspect);
+        // Register a render callback with the window so it can call into Engine while the FBO is bound.
+        // The callback computes a simple centered orthographic projection and calls Entity::RenderPlane.
+        window->SetRenderCallback([this]() {
+            int fbw = window->GetFramebufferWidth();
+            int fbh = window->GetFramebufferHeight();
+            if (fbw <= 0 || fbh <= 0) return;
 
-        // compute selected entity id (or -1 if none)
-        int selectedEntityId = -1;
-        if (m_selectedEntityIndex >= 0 && m_selectedEntityIndex < (int)m_entities.size()) {
-            selectedEntityId = m_entities[m_selectedEntityIndex]->entId;
-        }
+            float aspect = (fbh > 0) ? static_cast<float>(fbw) / static_cast<float>(fbh) : 1.0f;
 
-        if (m_entity) {
-            // render cubes and planes (updated signatures with selectedEntityId)
-            m_entity->RenderCube(m_planeShader.get(), view, projection, m_entities, m_currentEntityIndex, m_cubeObjIdx, selectedEntityId);
-            m_entity->RenderPlane(m_planeShader.get(), view, projection, m_entities, m_currentEntityIndex, m_planeObjIdx, selectedEntityId);
-            m_entity->RenderFloor(m_planeShader.get(), view, projection, m_entities, m_currentEntityIndex, m_floorObjIdx, selectedEntityId);
-        }
+            glm::mat4 view = m_camera.GetViewMatrix();
+            glm::mat4 projection = m_camera.GetProjectionMatrix(aspect);
+
+            // compute selected entity id (or -1 if none)
+            int selectedEntityId = -1;
+            if (m_selectedEntityIndex >= 0 && m_selectedEntityIndex < (int)m_entities.size()) {
+                selectedEntityId = m_entities[m_selectedEntityIndex]->entId;
+            }
+
+            if (m_entity) {
+                // lets the render calls work out how big each texture is on screen (mip streaming)
+                m_entity->SetViewInfo(&m_camera, static_cast<float>(fbh));
+                // render cubes and planes (updated signatures with selectedEntityId)
+                m_entity->RenderCube(m_planeShader.get(), view, projection, m_entities, m_currentEntityIndex, m_cubeObjIdx, selectedEntityId);
+                m_entity->RenderPlane(m_planeShader.get(), view, projection, m_entities, m_currentEntityIndex, m_planeObjIdx, selectedEntityId);
+                m_entity->RenderFloor(m_planeShader.get(), view, projection, m_entities, m_currentEntityIndex, m_floorObjIdx, selectedEntityId);
+                m_entity->RenderMesh(m_planeShader.get(), view, projection, m_entities, selectedEntityId);
+            }
+            if (m_planeShader) m_terrain.Draw(*m_planeShader, view, projection, m_origin);
+        });
+
+        // Register action callback (UI -> Engine) so clicking "Add Plane" invokes Engine::AddPlane
+        window->SetActionCallback([this](const std::string& cmd) {
+            if (cmd == "AddCube") {
+                // place at center by default
+                AddCube(glm::vec3(0.0f, 0.0f, 0.0f));
+            }
+            if (cmd == "AddPlane") {
+                // place at center by default
+                AddPlane(glm::vec3(0.0f, 0.0f, 0.0f));
+            }
+            if (cmd == "AddFloor") {
+                // place at center by default
+                AddFloor(glm::vec3(0.0f, 0.0f, 0.0f));
+            }
+            if (cmd == "AddModel") {
+                FileDialog::OpenAsync(FileDialog::Filter::Models, kAddModelRequest);
+            }
+            if (cmd == "NewScene") {
+                NewScene();
+            }
+            if (cmd == "OpenScene") {
+                FileDialog::OpenAsync(FileDialog::Filter::Scenes, kOpenSceneRequest);
+            }
+            // Save goes straight to the open scene's file, Save As (or a scene never saved) asks
+            if (cmd == "SaveScene" && !m_scenePath.empty()) {
+                SaveScene(m_scenePath);
+            }
+            else if (cmd == "SaveScene" || cmd == "SaveSceneAs") {
+                FileDialog::SaveAsync(FileDialog::Filter::Scenes, kSaveSceneRequest);
+            }
+            if (cmd == "OpenWorld") {
+                FileDialog::OpenAsync(FileDialog::Filter::Worlds, kOpenWorldRequest);
+            }
+            if (cmd == "ExportWorld") {
+                FileDialog::SaveAsync(FileDialog::Filter::Worlds, kExportWorldRequest);
+            }
+            if (cmd == "CloseWorld") {
+                CloseWorld();
+            }
+        });
+        return true;
     });
-    
 
-    // Register action callback (UI -> Engine) so clicking "Add Plane" invokes Engine::AddPlane
-    window->SetActionCallback([this](const std::string& cmd) {
-        if (cmd == "AddCube") {
-            // place at center by default
-            AddCube(glm::vec3(0.0f, 0.0f, 0.0f));
+    startup.Add("Settings + hot reload", Thread::Main, {}, [&]() {
+        TextureManager::SetCookSettings(config.textureFormat, config.textureQuality);
+        TextureManager::SetBudget(config.textureBudgetMB * 1024 * 1024);
+        MeshFile::SetCookFormat(config.meshVertexFormat);
+        MeshFile::SetCookLodCount(config.meshLodCount);
+        LodSelector::Settings lodSettings;
+        lodSettings.pixelError = config.lodPixelError;
+        LodSelector::SetSettings(lodSettings);
+        if (config.hotReload) HotReload::Start();
+        return true;
+    });
+
+    startup.Add("Shaders", Thread::Main, { glLoader }, [&]() {
+        // Create the plane shader once here (Engine owns it).
+        // Virtual paths, resolved by the Vfs to the loose files or the mounted pack.
+        std::string vertFile = DEFAULT_VERT_SHADER;
+        std::string fragFile = DEFAULT_FRAG_SHADER;
+
+        // Linked programs are cached on disk, a warm start skips compiling the shaders
+        ProgramCache::SetDirectory(config.programCacheDir);
+        // Try to construct shader; the Shader class should log compile/link errors if any.
+        // Keywords become #defines in the shader variants (see default.frag)
+        m_planeShader = std::make_unique<Shader>(vertFile, fragFile, std::vector<std::string>{ "ALPHA_TEST" });
+        if (!m_planeShader) {
+            LOG_WARNING("Failed to create plane shader");
         }
-        if (cmd == "AddPlane") {
-            // place at center by default
-            AddPlane(glm::vec3(0.0f, 0.0f, 0.0f));
+        else {
+            LOG_INFO("Plane shader created: %s , %s", vertFile.c_str(), fragFile.c_str());
+            // known variants compile in the background while the editor starts up
+            m_planeShader->Precompile({ m_planeShader->Keyword("ALPHA_TEST") });
         }
-        if (cmd == "AddFloor") {
-            // place at center by default
-            AddFloor(glm::vec3(0.0f, 0.0f, 0.0f));
+        return true;
+    });
+
+    // ImGui last among the main tasks, so the fonts have the most time to rasterize
+    startup.Add("ImGui", Thread::Main, { glLoader, rasterizeFonts }, [&]() {
+        // apply docking preference to window so ImGui is initialized with correct flags
+        window->SetEnableDocking(config.enableDocking);
+        if (config.enableImGui) {
+            window->SetUpImGui(glfwwindow, fonts);
+            fonts = nullptr;
+            m_assetBrowser = std::make_unique<AssetBrowser>(config.thumbnailCacheDir);
+            LOG_INFO("ImGui initialized");
         }
-	});
+        return true;
+    });
 
+    startup.Add("Entities", Thread::Main, {}, [&]() {
+        // Create the engine-owned Entity and entity vector
+        m_entity = std::make_unique<Entity>();
+        m_entities.clear();
+        m_currentEntityIndex = 0;
+        m_cubeObjIdx = 0;
+        m_planeObjIdx = 0;
+        m_floorObjIdx = 0;
+        m_meshObjIdx = 0;
+        return true;
+    });
+
+    const bool started = startup.Run();
+    // the atlas is only left over when ImGui setup never ran
+    if (fonts) IM_DELETE(fonts);
+    for (const TaskGraph::Timing& task : startup.Timings()) {
+        if (task.ran) StartupProfiler::AddTask(task.name, task.thread == Thread::Worker, task.start, task.end);
+    }
+    StartupProfiler::Mark("Startup tasks");
+    if (!started) {
+        LOG_ERROR("Engine: startup failed");
+        StartupProfiler::End();
+        return false;
+    }
+
+    m_sceneSaver = std::make_unique<SceneSaver>();
+    if (!config.worldPath.empty()) OpenWorld(config.worldPath);
+    if (!config.terrain.heightmap.empty()) m_terrain.Open(config.terrain);
     m_running = true;
     m_lastTime = std::chrono::steady_clock::now();
+    m_lastAutosave = m_lastTime;
+    StartupProfiler::End();
+    {
+        [[maybe_unused]] const ProgramCache::Stats cache = ProgramCache::GetStats();
+        LOG_INFO("ProgramCache: " << cache.hits << " hits, " << cache.misses << " misses, " << cache.rejected
+            << " rejected, " << cache.stores << " stored (" << cache.loadMs << " ms loading)");
+    }
     LOG_INFO("Engine initialized successfully");
     return true;
 }
 
 void Engine::Run() {
-    window->SetIcon(glfwwindow);
     bool showGui = true; // persistent for the run session
 
     using clock = std::chrono::steady_clock;
@@ -163,6 +322,27 @@ void Engine::Run() {
         m_lastTime = now;
         float dt = delta.count();
 
+        TextureManager::BeginFrame();
+        HotReload::Update();
+        Shader::PollAll();
+
+        // A file picked in the background dialog: load it onto the entity that asked,
+        // if it still exists. The decode runs on the workers (see the import progress below).
+        int dialogRequest = -1;
+        std::string pickedPath;
+        if (FileDialog::TakeResult(dialogRequest, pickedPath) && !pickedPath.empty()) {
+            if (dialogRequest == kOpenSceneRequest) LoadScene(pickedPath);
+            if (dialogRequest == kSaveSceneRequest) SaveScene(pickedPath);
+            if (dialogRequest == kOpenWorldRequest) OpenWorld(pickedPath);
+            if (dialogRequest == kExportWorldRequest) ExportWorld(pickedPath);
+            if (dialogRequest == kAddModelRequest) AddMesh(pickedPath);
+            for (auto& obj : m_entities) {
+                if (!obj || obj->entId != dialogRequest) continue;
+                m_entity->SetTextureForGameObj(obj.get(), pickedPath, true);
+                break;
+            }
+        }
+
         // 2) Start ImGui frame (only if enabled)
         if (m_config.enableImGui) {
             window->NewImguiFrame(glfwwindow);
@@ -187,10 +367,10 @@ void Engine::Run() {
                             selected->entName = std::string(nameBuf);
                         }
                         ImGui::TextColored(COLOR_LIGHTBLUE, ICON_FA_EDIT "  Editor");
-                        // Position
-                        float pos[3] = { selected->position.x, selected->position.y, selected->position.z };
-                        if (ImGui::InputFloat3("Position", pos)) {
-                            selected->position = glm::vec3(pos[0], pos[1], pos[2]);
+                        // Position, edited in world space: the object stores it relative to the floating origin
+                        glm::dvec3 worldPos = WorldPosition(*selected);
+                        if (ImGui::InputScalarN("Position", ImGuiDataType_Double, &worldPos.x, 3, nullptr, nullptr, "%.3f")) {
+                            selected->position = glm::vec3(worldPos - m_origin);
                         }
 
                         // Rotation (Euler degrees for editing)
@@ -210,13 +390,8 @@ void Engine::Run() {
                             selected->scale = glm::vec3(sc[0], sc[1], sc[2]);
                         }
 
-                        // Update modelMatrix using TRS (make sure order is correct for your math)
-                        selected->modelMatrix = glm::translate(glm::mat4(1.0f), selected->position);
-                        // apply rotation (if you use Euler -> convert to quat / rotate)
-                        selected->modelMatrix = glm::rotate(selected->modelMatrix, selected->rotation.x, glm::vec3(1, 0, 0));
-                        selected->modelMatrix = glm::rotate(selected->modelMatrix, selected->rotation.y, glm::vec3(0, 1, 0));
-                        selected->modelMatrix = glm::rotate(selected->modelMatrix, selected->rotation.z, glm::vec3(0, 0, 1));
-                        selected->modelMatrix = glm::scale(selected->modelMatrix, selected->scale);
+                        // Update modelMatrix using TRS
+                        selected->modelMatrix = ComposeModelMatrix(*selected);
 
                         ImGui::SeparatorText("Scene Properties");
                         ImGui::Text("Gameplay Properties");
@@ -237,33 +412,47 @@ void Engine::Run() {
                         ImGui::SeparatorText("Texture");
 
                         // show path or "None"
-                        if (!selected->texPath.empty()) {
-                            ImGui::TextWrapped("Path: %s", selected->texPath.c_str());
+                        const std::string& texPath = TextureManager::GetPath(selected->texHandle);
+                        if (!texPath.empty()) {
+                            ImGui::TextWrapped("Path: %s", texPath.c_str());
                         }
                         else {
                             ImGui::Text("Texture: None");
                         }
 
-                        // Preview (if texture present)
-                        if (selected->tex_ID != 0) {
-                            ImGui::Text("Preview:");
-                            ImGui::Image((void*)(intptr_t)selected->tex_ID, ImVec2(128, 128));
+                        // Preview (if texture present): the thumbnail from the asset browser's atlas,
+                        // the full texture only when no thumbnail can be made (e.g. images inside a GLB)
+                        if (TextureManager::IsLoading(selected->texHandle)) {
+                            ImGui::Text("Loading...");
                         }
-
-                        // Change texture button
-                        if (ImGui::Button("Change Texture")) {
-                            // Blocking Win32 dialog - returns UTF-8 path (your openFileDialog returns std::string)
-                            std::string path;
-                            if (window) {
-                                path = window->openFileDialog();
+                        else if (selected->texHandle != INVALID_TEXTURE) {
+                            GLuint thumbTex = 0;
+                            float uv[4];
+                            AssetBrowser::ThumbState thumb = m_assetBrowser
+                                ? m_assetBrowser->Thumbnail(texPath, thumbTex, uv) : AssetBrowser::ThumbState::Failed;
+                            if (thumb == AssetBrowser::ThumbState::Ready) {
+                                // the uv rect has the thumbnail's aspect ratio
+                                float aspect = (uv[2] - uv[0]) / std::max(uv[3] - uv[1], 1e-6f);
+                                ImVec2 size = (aspect >= 1.0f) ? ImVec2(128.0f, 128.0f / aspect) : ImVec2(128.0f * aspect, 128.0f);
+                                ImGui::Text("Preview:");
+                                ImGui::Image((void*)(intptr_t)thumbTex, size, ImVec2(uv[0], uv[1]), ImVec2(uv[2], uv[3]));
                             }
-
-                            if (!path.empty()) {
-                                if (!m_entity->SetTextureForGameObj(selected, path)) {
-                                    LOG_WARNING("Failed to set texture for entity " << selected->entId);
-                                }
+                            else if (thumb == AssetBrowser::ThumbState::Pending) {
+                                ImGui::Text("Preview: generating...");
                             }
+                            else if (GLuint previewTex = TextureManager::Touch(selected->texHandle)) {
+                                ImGui::Text("Preview:");
+                                ImGui::Image((void*)(intptr_t)previewTex, ImVec2(128, 128));
+                            }
+                        }
+
+                        // Change texture button: the dialog runs on its own thread and the
+                        // choice is picked up at the top of a later frame
+                        ImGui::BeginDisabled(FileDialog::IsOpen());
+                        if (ImGui::Button("Change Texture")) {
+                            FileDialog::OpenAsync(FileDialog::Filter::Images, selected->entId);
                         }
+                        ImGui::EndDisabled();
                         ImGui::SameLine();
                         if (ImGui::Button("Clear Texture")) {
                             // Clear/unload texture
@@ -416,6 +605,72 @@ void Engine::Run() {
             }
 			// ######################## End Main Object Explorer Window ####################
 
+            // ######################## Texture memory stats (for tuning the budget) ####################
+            if (showGui) {
+                ImGui::Begin("Texture Memory");
+                TextureManager::TextureStats stats = TextureManager::GetStats();
+                const float mb = 1.0f / (1024.0f * 1024.0f);
+                ImGui::Text("Resident: %.1f MB", stats.residentBytes * mb);
+                ImGui::Text("Textures: %d (%d resident, %d reduced)", stats.textureCount, stats.residentCount, stats.reducedCount);
+                ImGui::Text("Evictions: %llu  Mip drops: %llu  Reloads: %llu  Stream-ins: %llu",
+                    (unsigned long long)stats.evictions, (unsigned long long)stats.mipDrops,
+                    (unsigned long long)stats.reloads, (unsigned long long)stats.streamIns);
+                int budgetMB = static_cast<int>(m_config.textureBudgetMB);
+                if (ImGui::SliderInt("Budget (MB, 0 = off)", &budgetMB, 0, 4096)) {
+                    m_config.textureBudgetMB = static_cast<size_t>(budgetMB);
+                    TextureManager::SetBudget(m_config.textureBudgetMB * 1024 * 1024);
+                }
+                if (m_entity) {
+                    const MeshCache::Stats models = MeshCache::GetStats();
+                    const Entity::MeshDrawStats& drawn = m_entity->GetMeshDrawStats();
+                    ImGui::Text("Models: %d (%.1f MB), drawn %d (%d at a lower LOD), %zu triangles",
+                        models.meshes, models.gpuBytes * mb, drawn.drawn, drawn.reduced, drawn.triangles);
+                }
+                ImGui::End();
+            }
+
+            // ######################## Asset browser ####################
+            if (showGui && m_assetBrowser) {
+                // double-clicking an image puts it on the selected object, a model adds it to the scene
+                std::string picked = m_assetBrowser->Draw();
+                if (!picked.empty()) {
+                    if (AssetBrowser::IsModelFile(picked)) {
+                        AddMesh(picked);
+                    }
+                    else if (AssetBrowser::IsImageFile(picked) && m_selectedEntityIndex >= 0 && m_selectedEntityIndex < (int)m_entities.size()) {
+                        m_entity->SetTextureForGameObj(m_entities[m_selectedEntityIndex].get(), picked, true);
+                    }
+                    else {
+                        LOG_INFO("Asset browser: select an object, then double-click an image to apply it (" << picked << ")");
+                    }
+                }
+            }
+
+            // ######################## Background work (file dialog, texture imports, saves) ####################
+            {
+                TextureManager::TextureStats loads = TextureManager::GetStats();
+                const bool saving = m_sceneSaver && m_sceneSaver->Busy();
+                const WorldPartition::Stats world = m_world.GetStats();
+                const bool terrainLoading = m_terrain.IsOpen() && !m_terrain.IsReady();
+                const MeshCache::Stats models = MeshCache::GetStats();
+                if (loads.loadingCount > 0 || FileDialog::IsOpen() || saving || world.pending > 0 || terrainLoading || models.loading > 0) {
+                    ImGui::Begin("Background Tasks", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse);
+                    if (FileDialog::IsOpen()) ImGui::Text("Waiting for the file dialog...");
+                    if (saving) ImGui::Text("Saving the scene...");
+                    if (world.pending > 0) ImGui::Text("Streaming world cells: %d loading, %d resident", (int)world.pending, (int)world.resident);
+                    if (terrainLoading) ImGui::Text("Loading the terrain heightmap...");
+                    if (models.loading > 0) ImGui::Text("Importing models (%d)", models.loading);
+                    if (loads.loadingCount > 0) {
+                        const int done = loads.loadBatch - loads.loadingCount;
+                        char overlay[32];
+                        std::snprintf(overlay, sizeof(overlay), "%d / %d", done, loads.loadBatch);
+                        ImGui::Text("Importing textures");
+                        ImGui::ProgressBar(loads.loadBatch > 0 ? static_cast<float>(done) / loads.loadBatch : 0.0f, ImVec2(240.0f, 0.0f), overlay);
+                    }
+                    ImGui::End();
+                }
+            }
+
 
             // Draw the MainSceneWindow which will call the registered render callback while FBO is bound
             window->MainSceneWindow(glfwwindow);
@@ -444,8 +699,20 @@ void Engine::Run() {
             window->RenderImGui(glfwwindow); // this calls ImGui::Render() internally
         }
 
+        // Frame is drawn: upload streamed mips, apply screen-size requests and the budget
+        TextureManager::Update();
+        MeshCache::Update();
+        if (m_assetBrowser) m_assetBrowser->Update();
+        UpdateOrigin();
+        UpdateWorld();
+        m_terrain.Update(m_origin + glm::dvec3(m_camera.Position));
+
         // 6) Present
         window->SwapBuffers();
+        StartupProfiler::FirstFrame();
+
+        // Frame boundary: nothing is editing the entities, snapshot them for a queued save
+        UpdateSaves();
     }
 
     m_running = false;
@@ -471,14 +738,30 @@ void Engine::Shutdown() {
         LOG_INFO("ImGui shutdown successfully");
     }
 
+    // Finish the running save and flush one the last frame queued, before the entities go
+    if (m_sceneSaver) {
+        m_sceneSaver->Wait();
+        UpdateSaves();
+        m_sceneSaver->Wait();
+        UpdateSaves();
+        m_sceneSaver.reset();
+    }
+
     // clean up in reverse order
     m_input.reset();
     m_entity.reset();
     m_entities.clear();
+    m_terrain.Close();
+    HotReload::Stop();
+    FileDialog::Shutdown();
     m_planeShader.reset();
+    m_assetBrowser.reset();
+    Jobs::Shutdown();
+    MeshCache::Shutdown();
     if (window) {
         window.reset();
     }
+    UnmountAssetPack();
 
     m_running = false;
     LOG_INFO("Engine shutdown");
@@ -515,6 +798,254 @@ void Engine::AddFloor(const glm::vec3& pos)
 	m_selectedEntityIndex = static_cast<int>(m_entities.size()) - 1;
 	ImGui::SetWindowFocus("Object Inspector"); // this will need work for terrain
 }
+// add a model; it draws once the worker has cooked it and the main thread uploaded it
+void Engine::AddMesh(const std::string& path, const glm::vec3& pos)
+{
+    if (!m_entity || path.empty()) return;
+    m_entity->CreateMesh(m_entities, m_currentEntityIndex, m_meshObjIdx, path, pos);
+    m_selectedEntityIndex = static_cast<int>(m_entities.size()) - 1;
+    ImGui::SetWindowFocus("Object Inspector");
+}
+
+void Engine::NewScene()
+{
+    m_world.Close();
+    m_entities.clear();
+    m_currentEntityIndex = 0;
+    m_cubeObjIdx = 0;
+    m_planeObjIdx = 0;
+    m_floorObjIdx = 0;
+    m_meshObjIdx = 0;
+    m_selectedEntityIndex = -1;
+    m_scenePath.clear();
+}
+
+bool Engine::SaveScene(const std::string& path)
+{
+    if (!m_sceneSaver || path.empty()) return false;
+    // later requests in the same frame win; a save still running delays this one
+    m_pendingSavePath = path;
+    m_scenePath = path;
+    return true;
+}
+
+GameObj* Engine::SpawnEntity(const SceneFile::Columns& scene, size_t row, int id)
+{
+    if (id < 0) id = scene.ids[row];
+    const int type = scene.types[row];
+    const int objIdx = scene.objectIndices[row];
+    const std::string& name = scene.String(scene.names[row]);
+    // the models build their GL buffers in the constructor
+    std::unique_ptr<GameObj> obj;
+    if (type == OBJ_CUBE) {
+        obj = std::make_unique<CubeModel>(id, name, objIdx);
+        m_cubeObjIdx = std::max(m_cubeObjIdx, objIdx + 1);
+    }
+    else if (type == OBJ_PLANE) {
+        obj = std::make_unique<PlaneModel>(id, name, objIdx);
+        m_planeObjIdx = std::max(m_planeObjIdx, objIdx + 1);
+    }
+    else if (type == OBJ_FLOOR) {
+        obj = std::make_unique<FloorTerrain>(id, name, objIdx);
+        m_floorObjIdx = std::max(m_floorObjIdx, objIdx + 1);
+    }
+    else if (type == OBJ_MESH) {
+        const std::string& path = scene.String(scene.meshes[row]);
+        if (path.empty()) {
+            LOG_WARNING("Engine: scene model " << id << " has no model file, skipped");
+            return nullptr;
+        }
+        obj = std::make_unique<MeshModel>(id, name, objIdx, path);
+        m_meshObjIdx = std::max(m_meshObjIdx, objIdx + 1);
+    }
+    else {
+        LOG_WARNING("Engine: scene entity " << id << " has unknown type " << type << ", skipped");
+        return nullptr;
+    }
+    obj->position = glm::vec3(glm::dvec3(scene.positions[row]) - m_origin);
+    obj->rotation = scene.rotations[row];
+    obj->scale = scene.scales[row];
+    obj->modelMatrix = ComposeModelMatrix(*obj);
+    const uint8_t flags = scene.flags[row];
+    obj->isActive = (flags & SceneFile::FlagActive) != 0;
+    obj->isHealthPack = (flags & SceneFile::FlagHealthPack) != 0;
+    obj->isDangerous = (flags & SceneFile::FlagDangerous) != 0;
+    obj->isCollidable = (flags & SceneFile::FlagCollidable) != 0;
+    obj->isVisible = (flags & SceneFile::FlagVisible) != 0;
+    obj->entPoints = scene.points[row];
+    obj->HealthPackPoints = scene.healthPoints[row];
+    // textures decode on the workers; objects sharing a path share the texture
+    const std::string& texture = scene.String(scene.textures[row]);
+    if (!texture.empty()) m_entity->SetTextureForGameObj(obj.get(), texture, true);
+    m_currentEntityIndex = std::max(m_currentEntityIndex, id + 1);
+    m_entities.push_back(std::move(obj));
+    return m_entities.back().get();
+}
+
+bool Engine::OpenWorld(const std::string& manifestPath)
+{
+    CloseWorld();
+    return m_world.Open(manifestPath, m_config.world);
+}
+
+void Engine::CloseWorld()
+{
+    m_world.Close();
+    RemoveStreamedEntities(nullptr);
+}
+
+bool Engine::ExportWorld(const std::string& manifestPath)
+{
+    SceneFile::Columns scene;
+    SnapshotScene(scene);
+    return WorldPartition::Export(scene, manifestPath, m_config.world.cellSize);
+}
+
+void Engine::RemoveStreamedEntities(const std::vector<int>* ids)
+{
+    if (ids && ids->empty()) return;
+    std::unordered_set<int> remove;
+    if (ids) remove.insert(ids->begin(), ids->end());
+    const int selectedId = (m_selectedEntityIndex >= 0 && m_selectedEntityIndex < (int)m_entities.size())
+        ? m_entities[m_selectedEntityIndex]->entId : -1;
+    m_entities.erase(std::remove_if(m_entities.begin(), m_entities.end(), [&](const std::unique_ptr<GameObj>& obj) {
+        return obj && obj->isStreamed && (!ids || remove.count(obj->entId) != 0);
+    }), m_entities.end());
+    // indices shifted; keep the selection on the same object if it survived
+    m_selectedEntityIndex = -1;
+    for (int i = 0; i < (int)m_entities.size() && selectedId >= 0; ++i) {
+        if (m_entities[i]->entId == selectedId) m_selectedEntityIndex = i;
+    }
+}
+
+void Engine::UpdateOrigin()
+{
+    const float limit = m_config.originRebaseDistance;
+    if (limit <= 0.0f) return;
+    const glm::vec3& camera = m_camera.Position;
+    if (std::abs(camera.x) < limit && std::abs(camera.y) < limit && std::abs(camera.z) < limit) return;
+    // whole multiples of a power of two limit: objects near the camera shift exactly, only
+    // those left far away round, to the float spacing they have at that distance anyway
+    ShiftOrigin(glm::round(camera / limit) * limit);
+}
+
+void Engine::ShiftOrigin(const glm::vec3& shift)
+{
+    // model = T * R * S, so the translation is column 3 and nothing else needs rebuilding
+    const glm::vec4 delta(shift, 0.0f);
+    Jobs::ParallelFor(m_entities.size(), 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            GameObj* obj = m_entities[i].get();
+            if (!obj) continue;
+            obj->position -= shift;
+            obj->modelMatrix[3] -= delta;
+        }
+    });
+    m_camera.Position -= shift;
+    m_origin += glm::dvec3(shift);
+    LOG_INFO("Engine: origin rebased by (" << shift.x << ", " << shift.y << ", " << shift.z << "), world origin now ("
+        << m_origin.x << ", " << m_origin.y << ", " << m_origin.z << ")");
+}
+
+void Engine::UpdateWorld()
+{
+    if (!m_world.IsOpen() || !m_entity) return;
+    m_world.Update(m_origin + glm::dvec3(m_camera.Position));
+    const std::vector<int> unloaded = m_world.TakeUnloaded();
+    RemoveStreamedEntities(&unloaded);
+    // cells exported from different scenes can share ids, so every streamed entity gets a
+    // new one; the cell keeps those to remove exactly its own entities
+    m_world.Spawn([this](const SceneFile::Columns& cell, size_t row) {
+        GameObj* obj = SpawnEntity(cell, row, m_currentEntityIndex);
+        if (!obj) return -1;
+        obj->isStreamed = true;
+        return obj->entId;
+    });
+}
+
+void Engine::SnapshotScene(SceneFile::Columns& scene) const
+{
+    scene.Clear();
+    scene.Reserve(m_entities.size());
+    for (const auto& obj : m_entities) {
+        if (!obj || obj->isStreamed) continue;
+        scene.ids.push_back(obj->entId);
+        scene.types.push_back(obj->entTypeID);
+        scene.objectIndices.push_back(obj->entObjectIndex);
+        scene.positions.push_back(glm::vec3(WorldPosition(*obj)));
+        scene.rotations.push_back(obj->rotation);
+        scene.scales.push_back(obj->scale);
+        uint8_t flags = 0;
+        if (obj->isActive) flags |= SceneFile::FlagActive;
+        if (obj->isHealthPack) flags |= SceneFile::FlagHealthPack;
+        if (obj->isDangerous) flags |= SceneFile::FlagDangerous;
+        if (obj->isCollidable) flags |= SceneFile::FlagCollidable;
+        if (obj->isVisible) flags |= SceneFile::FlagVisible;
+        scene.flags.push_back(flags);
+        scene.points.push_back(obj->entPoints);
+        scene.healthPoints.push_back(obj->HealthPackPoints);
+        scene.names.push_back(scene.Intern(obj->entName));
+        const std::string& texture = TextureManager::GetPath(obj->texHandle);
+        scene.textures.push_back(texture.empty() ? SceneFile::kNoString : scene.Intern(texture));
+        const auto* model = dynamic_cast<const MeshModel*>(obj.get());
+        scene.meshes.push_back(model && !model->meshPath.empty() ? scene.Intern(model->meshPath) : SceneFile::kNoString);
+    }
+}
+
+void Engine::UpdateSaves()
+{
+    if (!m_sceneSaver) return;
+    SceneSaver::Result result;
+    if (m_sceneSaver->Poll(result)) {
+        if (!result.ok) {
+            LOG_ERROR("Engine: failed to save scene " << result.path);
+        }
+        else if (!result.unchanged) {
+            LOG_INFO("Engine: " << (result.autosave ? "autosaved " : "saved ") << result.path << " ("
+                << result.bytes / 1024 << " KB) | snapshot " << result.snapshotSeconds * 1000.0
+                << " ms on the main thread, write " << result.saveSeconds * 1000.0 << " ms in the background");
+        }
+    }
+    if (m_sceneSaver->Busy()) return;
+
+    const auto now = std::chrono::steady_clock::now();
+    std::string path;
+    bool autosave = false;
+    if (!m_pendingSavePath.empty()) {
+        path.swap(m_pendingSavePath);
+    }
+    else if (m_running && m_config.autosaveSeconds > 0 && now - m_lastAutosave >= std::chrono::seconds(m_config.autosaveSeconds)) {
+        const std::string name = m_scenePath.empty() ? std::string("untitled") : std::filesystem::path(m_scenePath).stem().string();
+        path = (std::filesystem::path(m_config.autosaveDir) / (name + ".autosave" + SceneFile::kExtension)).generic_string();
+        autosave = true;
+    }
+    if (path.empty()) return;
+    m_lastAutosave = now; // a manual save restarts the autosave interval too
+
+    SnapshotScene(m_sceneSaver->Snapshot());
+    const double snapshotSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+    m_sceneSaver->Start(path, autosave, snapshotSeconds);
+}
+
+bool Engine::LoadScene(const std::string& path)
+{
+    if (!m_entity) return false;
+    auto t0 = std::chrono::steady_clock::now();
+    SceneFile::Columns scene;
+    if (!(SceneText::IsTextPath(path) ? SceneText::Read(path, scene) : SceneFile::Read(path, scene))) {
+        LOG_ERROR("Engine: failed to open scene " << path);
+        return false;
+    }
+    [[maybe_unused]] const double readMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    NewScene();
+    m_entities.reserve(scene.Size());
+    for (size_t i = 0; i < scene.Size(); ++i) SpawnEntity(scene, i);
+    m_scenePath = path;
+    LOG_INFO("Engine: loaded " << m_entities.size() << " entities from " << path << " (read " << readMs << " ms, total "
+        << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() << " ms)");
+    return true;
+}
 
 static glm::vec3 ClampPointToAABB(const glm::vec3& p, const glm::vec3& minB, const glm::vec3& maxB) {
     return glm::vec3(
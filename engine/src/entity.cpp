@@ -1,9 +1,11 @@
 #include "entity.h"
 #include "stb/stb_image.h"
-#include "../include/asset_path.h"
 #include "../include/log.h"
 #include "../include/textures.h"
 #include "../include/shader.h"
+#include "Camera/Camera.h"
+#include <algorithm>
+#include <filesystem>
 #include <memory>
 
 // This is my games engine start date 01/01/2026
@@ -19,6 +21,22 @@
 Entity::Entity() {}
 Entity::~Entity() {}
 
+void Entity::SetViewInfo(const Camera* camera, float viewportHeight) {
+    m_viewCamera = camera;
+    m_viewportHeight = viewportHeight;
+}
+
+// Tell the TextureManager how many pixels the object covers so it can stream the right mip
+void Entity::RequestTextureMip(const GameObj* obj) const {
+    if (!m_viewCamera || obj->texHandle == INVALID_TEXTURE) return;
+    // bounding sphere of the unit model scaled by the model matrix (0.866 = half diagonal of a unit cube)
+    const glm::mat4& m = obj->modelMatrix;
+    float maxScale = std::max({ glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])) });
+    glm::vec3 center = glm::vec3(m[3]);
+    float pixels = m_viewCamera->ProjectedSize(center, 0.866f * maxScale, m_viewportHeight);
+    TextureManager::RequestScreenSize(obj->texHandle, 2.0f * pixels);
+}
+
 void Entity::CreateCube(std::vector<std::unique_ptr<GameObj>>& entVector, int& currentIndex,
     int& CubeObjIdx, const glm::vec3& position)
 {
@@ -56,16 +74,12 @@ void Entity::CreateCube(std::vector<std::unique_ptr<GameObj>>& entVector, int& c
     newCube->modelMatrix = glm::scale(newCube->modelMatrix, newCube->scale);
 
     //// Load texture via SetTextureForGameObj
-    std::string texPath = GetAssetPath(TEXTURE_PATH);
-    std::string texFile = "crate.jpg";
-    std::string full = texPath + texFile;
-
-    if (!SetTextureForGameObj(newCube.get(), full)) {
-        LOG_WARNING("CreateCube: Failed to set texture: " << full);
+    if (!SetTextureForGameObj(newCube.get(), CUBE_TEXTURE)) {
+        LOG_WARNING("CreateCube: Failed to set texture: " << CUBE_TEXTURE);
         // newCube->tex_ID remains 0; shader should handle missing texture
     }
     else {
-        LOG_INFO("CreateCube: texture loaded tex_ID=" << newCube->tex_ID << " path=" << newCube->texPath);
+        LOG_INFO("CreateCube: texture loaded handle=" << newCube->texHandle << " path=" << TextureManager::GetPath(newCube->texHandle));
     }
 
     entVector.push_back(std::move(newCube));
@@ -86,6 +100,10 @@ void Entity::RenderCube(Shader* shader, const glm::mat4& view, const glm::mat4&
     shader->SetUniformInt("myTexture", 0);
     shader->setMat4("projection", projection);
     shader->setMat4("view", view);
+    // the shader is shared with meshes and terrain: back to plain float vertices and material
+    shader->SetUniformInt("u_vertexFormat", 0);
+    shader->SetUniformInt("u_flipV", 0);
+    shader->SetUniformInt("u_materialMode", 0);
 
     // Render stored planes using their stored modelMatrix and persistent texture id
     for (const auto& model : entVector) {
@@ -104,17 +122,13 @@ void Entity::RenderCube(Shader* shader, const glm::mat4& view, const glm::mat4&
 
 
 
-            if (cube->tex_ID) {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, cube->tex_ID);
-            }
-            else {
-                glBindTexture(GL_TEXTURE_2D, 0);
-            }
+            // Bind marks the texture as used for the memory budget and reloads it if evicted
+            RequestTextureMip(cube);
+            GLuint texId = TextureManager::Bind(cube->texHandle, 0);
 
             cube->DrawCube(); // assuming Draw() exists for CubeModel
 
-            if (cube->tex_ID) {
+            if (texId) {
                 glBindTexture(GL_TEXTURE_2D, 0);
             }
         }
@@ -161,15 +175,11 @@ void Entity::CreatePlane(std::vector<std::unique_ptr<GameObj>>& entVector, int&
     newPlane->modelMatrix = glm::scale(newPlane->modelMatrix, newPlane->scale);
 
     // Load texture via SetTextureForGameObj
-    std::string texPath = GetAssetPath(TEXTURE_PATH);
-    std::string texFile = "github.jpg";
-    std::string full = texPath + texFile;
-
-    if (!SetTextureForGameObj(newPlane.get(), full)) {
-        LOG_WARNING("CreatePlane: Failed to set texture: " << full);
+    if (!SetTextureForGameObj(newPlane.get(), PLANE_TEXTURE)) {
+        LOG_WARNING("CreatePlane: Failed to set texture: " << PLANE_TEXTURE);
     }
     else {
-        LOG_INFO("CreatePlane: texture loaded tex_ID=" << newPlane->tex_ID << " path=" << newPlane->texPath);
+        LOG_INFO("CreatePlane: texture loaded handle=" << newPlane->texHandle << " path=" << TextureManager::GetPath(newPlane->texHandle));
     }
 
     entVector.push_back(std::move(newPlane));
@@ -194,6 +204,10 @@ void Entity::RenderPlane(Shader* shader, const glm::mat4& view, const glm::mat4&
    // shader->SetUniformInt("u_selected", 0); // initialize selection uniform
     shader->setMat4("projection", projection);
     shader->setMat4("view", view);
+    // the shader is shared with meshes and terrain: back to plain float vertices and material
+    shader->SetUniformInt("u_vertexFormat", 0);
+    shader->SetUniformInt("u_flipV", 0);
+    shader->SetUniformInt("u_materialMode", 0);
 
     // Render stored planes using their stored modelMatrix and persistent texture id
     for (const auto& model : entVector) {
@@ -211,17 +225,13 @@ void Entity::RenderPlane(Shader* shader, const glm::mat4& view, const glm::mat4&
             shader->SetUniformInt("u_selected", isSelected);
             shader->setVec3("u_highlightColor", glm::vec3(0.2, 0.2f, 0.8f)); // orange-ish
 
-            if (plane->tex_ID) {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, plane->tex_ID);
-            }
-            else {
-                glBindTexture(GL_TEXTURE_2D, 0);
-            }
+            // Bind marks the texture as used for the memory budget and reloads it if evicted
+            RequestTextureMip(plane);
+            GLuint texId = TextureManager::Bind(plane->texHandle, 0);
 
             plane->DrawPlane();
 
-            if (plane->tex_ID) {
+            if (texId) {
                 glBindTexture(GL_TEXTURE_2D, 0);
             }
         }
@@ -248,15 +258,11 @@ void Entity::CreateFloor(std::vector<std::unique_ptr<GameObj>>& entVector, int&
     newFloor->modelMatrix = glm::scale(newFloor->modelMatrix, newFloor->scale);
 
     // Load texture via SetTextureForGameObj
-    std::string texPath = GetAssetPath(TEXTURE_PATH);
-    std::string texFile = "stone.jpg";
-    std::string full = texPath + texFile;
-
-    if (!SetTextureForGameObj(newFloor.get(), full)) {
-        LOG_WARNING("CreateFloor: Failed to set texture: " << full);
+    if (!SetTextureForGameObj(newFloor.get(), FLOOR_TEXTURE)) {
+        LOG_WARNING("CreateFloor: Failed to set texture: " << FLOOR_TEXTURE);
     }
     else {
-        LOG_INFO("CreateFloor: texture loaded tex_ID=" << newFloor->tex_ID << " path=" << newFloor->texPath);
+        LOG_INFO("CreateFloor: texture loaded handle=" << newFloor->texHandle << " path=" << TextureManager::GetPath(newFloor->texHandle));
     }
 
     entVector.push_back(std::move(newFloor));
@@ -279,6 +285,10 @@ void Entity::RenderFloor(Shader* shader, const glm::mat4& view, const glm::mat4&
     // shader->SetUniformInt("u_selected", 0); // initialize selection uniform
     shader->setMat4("projection", projection);
     shader->setMat4("view", view);
+    // the shader is shared with meshes and terrain: back to plain float vertices and material
+    shader->SetUniformInt("u_vertexFormat", 0);
+    shader->SetUniformInt("u_flipV", 0);
+    shader->SetUniformInt("u_materialMode", 0);
 
     // Render stored planes using their stored modelMatrix and persistent texture id
     for (const auto& model : entVector) {
@@ -296,17 +306,13 @@ void Entity::RenderFloor(Shader* shader, const glm::mat4& view, const glm::mat4&
             shader->SetUniformInt("u_selected", isSelected);
             shader->setVec3("u_highlightColor", glm::vec3(0.2, 0.2f, 0.8f)); // orange-ish
 
-            if (floor->tex_ID) {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, floor->tex_ID);
-            }
-            else {
-                glBindTexture(GL_TEXTURE_2D, 0);
-            }
+            // Bind marks the texture as used for the memory budget and reloads it if evicted
+            RequestTextureMip(floor);
+            GLuint texId = TextureManager::Bind(floor->texHandle, 0);
 
             floor->DrawFloorTerrain();
 
-            if (floor->tex_ID) {
+            if (texId) {
                 glBindTexture(GL_TEXTURE_2D, 0);
             }
         }
@@ -316,6 +322,121 @@ void Entity::RenderFloor(Shader* shader, const glm::mat4& view, const glm::mat4&
 
 }
 
+void Entity::CreateMesh(std::vector<std::unique_ptr<GameObj>>& entVector, int& currentIndex,
+    int& MeshObjIdx, const std::string& path, const glm::vec3& position)
+{
+    if (path.empty()) {
+        LOG_WARNING("CreateMesh: no model path given");
+        return;
+    }
+    std::string name = std::filesystem::path(path).stem().string();
+    auto newMesh = std::make_unique<MeshModel>(currentIndex, name.empty() ? "Model" : name, MeshObjIdx, path);
+
+    newMesh->position = position;
+    newMesh->scale = glm::vec3(1.0f);
+    newMesh->modelMatrix = glm::translate(glm::mat4(1.0f), newMesh->position);
+    LOG_INFO("CreateMesh: " << path << " (loading in the background)");
+
+    entVector.push_back(std::move(newMesh));
+    ++currentIndex;
+    ++MeshObjIdx;
+}
+
+void Entity::RenderMesh(Shader* shader, const glm::mat4& view, const glm::mat4& projection,
+    const std::vector<std::unique_ptr<GameObj>>& entVector, int selectedEntityId)
+{
+    if (!shader) {
+        LOG_WARNING("Entity::RenderMesh called without shader; skipping draw.");
+        return;
+    }
+
+    // cutout materials draw with the ALPHA_TEST variant (precompiled at startup), the rest
+    // with the base program; uniforms are per program, so a switch sets them again
+    const Shader::Permutation alphaTest = shader->Keyword("ALPHA_TEST");
+    Shader::Permutation bound = 0;
+    MeshModel* meshObj = nullptr;
+    auto setUniforms = [&]() {
+        shader->SetUniformInt("myTexture", 0);
+        shader->setMat4("projection", projection);
+        shader->setMat4("view", view);
+        shader->SetUniformInt("u_flipV", 0); // the importers already flip v to match our textures
+        if (!meshObj) return;
+        shader->setMat4("model", meshObj->modelMatrix);
+        shader->SetUniformInt("u_selected", (meshObj->entId == selectedEntityId) ? 1 : 0);
+        shader->setVec3("u_highlightColor", glm::vec3(0.2, 0.2f, 0.8f));
+        meshObj->mesh->gpu.ApplyDecodeUniforms(*shader);
+    };
+    shader->Use();
+    setUniforms();
+    m_meshStats = MeshDrawStats();
+
+    for (const auto& model : entVector) {
+        if (!model || !model->isVisible) continue;
+        meshObj = dynamic_cast<MeshModel*>(model.get());
+        if (!meshObj || !meshObj->mesh || !meshObj->mesh->IsReady()) continue;
+        const LoadedMesh& mesh = *meshObj->mesh;
+        setUniforms();
+
+        // The bounding sphere's size on screen picks the LOD and the texture mips.
+        // Without a camera (no SetViewInfo) everything draws at full detail.
+        float pixels = 0.0f;
+        int lod = 0;
+        if (m_viewCamera) {
+            const glm::mat4& m = meshObj->modelMatrix;
+            float maxScale = std::max({ glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])) });
+            glm::vec3 center = glm::vec3(m * glm::vec4(mesh.center, 1.0f));
+            pixels = m_viewCamera->ProjectedSize(center, mesh.radius * maxScale, m_viewportHeight);
+            // errors are in model units, so the unscaled radius goes with the scaled projection
+            lod = meshObj->lod.Select(mesh.gpu.Lods(), mesh.radius, pixels);
+        }
+
+        const std::vector<MeshSubmesh>& submeshes = mesh.gpu.Submeshes();
+        const std::vector<MeshLod>& lods = mesh.gpu.Lods();
+        size_t first = 0, count = submeshes.size();
+        if (!lods.empty()) {
+            const MeshLod& level = lods[std::min<size_t>(lod, lods.size() - 1)];
+            first = level.submeshOffset;
+            count = level.submeshCount;
+        }
+
+        glBindVertexArray(mesh.gpu.Vao());
+        for (size_t i = first; i < first + count && i < submeshes.size(); ++i) {
+            const MeshSubmesh& sub = submeshes[i];
+            const bool hasMaterial = sub.materialIndex >= 0 && sub.materialIndex < static_cast<int>(mesh.materials.size());
+            const float cutoff = hasMaterial ? mesh.materials[sub.materialIndex].alphaCutoff : 0.0f;
+            const Shader::Permutation variant = (cutoff > 0.0f) ? alphaTest : 0;
+            if (variant != bound) {
+                shader->Use(variant);
+                bound = variant;
+                setUniforms();
+            }
+            if (cutoff > 0.0f) shader->SetUniformFloat("u_alphaCutoff", cutoff);
+            // a texture picked in the inspector replaces the model's own
+            const bool ownTexture = meshObj->texHandle != INVALID_TEXTURE;
+            TextureHandle tex = ownTexture ? meshObj->texHandle : (hasMaterial ? mesh.textures[sub.materialIndex] : INVALID_TEXTURE);
+            if (m_viewCamera) TextureManager::RequestScreenSize(tex, 2.0f * pixels);
+            GLuint texId = TextureManager::Bind(tex, 0);
+
+            // 0 = texture, 1 = texture * material colour, 2 = material colour (no texture or still loading)
+            const glm::vec4 color = hasMaterial ? glm::vec4(mesh.materials[sub.materialIndex].diffuse, mesh.materials[sub.materialIndex].opacity) : glm::vec4(1.0f);
+            shader->SetUniformInt("u_materialMode", texId == 0 ? 2 : (ownTexture ? 0 : 1));
+            shader->setVec4("u_baseColor", color);
+            mesh.gpu.DrawSubmesh(sub);
+            m_meshStats.triangles += sub.indexCount / 3;
+        }
+        glBindVertexArray(0);
+        ++m_meshStats.drawn;
+        if (lod > 0) ++m_meshStats.reduced;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // leave the shared shader on the plain path for whoever draws next
+    if (bound != 0) shader->Use();
+    shader->SetUniformInt("u_selected", 0);
+    shader->SetUniformInt("u_vertexFormat", 0);
+    shader->SetUniformInt("u_materialMode", 0);
+}
+
 //bool SetTextureForGameObj(GameObj* obj, const std::string& path) {
 //    if (!obj) return false;
 //
@@ -350,32 +471,24 @@ void Entity::RenderFloor(Shader* shader, const glm::mat4& view, const glm::mat4&
 //    return true;
 //}
 
-bool Entity::SetTextureForGameObj(GameObj* obj, const std::string& path)
+bool Entity::SetTextureForGameObj(GameObj* obj, const std::string& path, bool async)
 {
     if (!obj) return false;
 
-    // If same path, nothing to do
-    if (!path.empty() && path == obj->texPath) return true;
-
-    // Unload old texture (by path if available, fallback to ID)
-    if (!obj->texPath.empty()) {
-        TextureManager::Unload(obj->texPath);
-        obj->texPath.clear();
-    }
-    else if (obj->tex_ID != 0) {
-        // manager supports unloading by ID too
-        TextureManager::Unload(obj->tex_ID);
-    }
-    obj->tex_ID = 0;
-
+    // Acquire the new texture first: if it is the same path the refcount just goes
+    // up then down again, and a failed load leaves the old texture in place.
+    TextureHandle newHandle = INVALID_TEXTURE;
     if (!path.empty()) {
-        GLuint tex = TextureManager::Load(path);
-        if (tex == 0) {
+        newHandle = async ? TextureManager::AcquireAsync(path) : TextureManager::Acquire(path);
+        if (newHandle == INVALID_TEXTURE) {
             LOG_ERROR("SetTextureForGameObj: Failed to load " << path.c_str());
             return false;
         }
-        obj->tex_ID = tex;
-        obj->texPath = path;
     }
+
+    if (obj->texHandle != INVALID_TEXTURE) {
+        TextureManager::Release(obj->texHandle);
+    }
+    obj->texHandle = newHandle;
     return true;
 }
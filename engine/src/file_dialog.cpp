@@ -0,0 +1,167 @@
+#include "../include/file_dialog.h"
+#include "../include/log.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <commdlg.h>
+#include <objbase.h>
+#endif
+
+namespace {
+    // Shared with the dialog thread, which may outlive a Shutdown
+    struct Request {
+        FileDialog::Filter filter = FileDialog::Filter::All;
+        bool save = false;
+        int requestId = -1;
+        std::string path;
+        std::atomic<bool> done{ false };
+    };
+
+    std::shared_ptr<Request> s_request; // main thread only
+    std::thread s_thread;
+
+#ifdef _WIN32
+    std::string ShowDialog(FileDialog::Filter filter, bool save) {
+        OPENFILENAMEW ofn;
+        // Wide buffer for file path
+        std::vector<wchar_t> filename(MAX_PATH, L'\0');
+
+        ZeroMemory(&ofn, sizeof(ofn));
+        ofn.lStructSize = sizeof(ofn);
+
+        // No owner: an owned dialog would disable the editor window while it is open
+        ofn.hwndOwner = NULL;
+
+        ofn.lpstrFile = filename.data();
+        ofn.nMaxFile = static_cast<DWORD>(filename.size());
+
+        // Double-null terminated wide-string filter (last \0 terminates the filter list)
+        static const wchar_t imageFilter[] =
+            L"Image Files\0*.jpg;*.jpeg;*.png;*.bmp;*.tga\0"
+            L"All Files\0*.*\0\0";
+        static const wchar_t sceneFilter[] =
+            L"Scene Files\0*.spxscene;*.spx\0"
+            L"Binary Scene (*.spxscene)\0*.spxscene\0"
+            L"Text Scene (*.spx)\0*.spx\0"
+            L"All Files\0*.*\0\0";
+        static const wchar_t worldFilter[] =
+            L"World Manifest (*.spxworld)\0*.spxworld\0"
+            L"All Files\0*.*\0\0";
+        static const wchar_t modelFilter[] =
+            L"Models\0*.obj;*.gltf;*.glb;*.spxmesh\0"
+            L"All Files\0*.*\0\0";
+        static const wchar_t allFilter[] =
+            L"All Files\0*.*\0\0";
+        switch (filter) {
+        case FileDialog::Filter::Images: ofn.lpstrFilter = imageFilter; break;
+        case FileDialog::Filter::Scenes: ofn.lpstrFilter = sceneFilter; ofn.lpstrDefExt = L"spxscene"; break;
+        case FileDialog::Filter::Worlds: ofn.lpstrFilter = worldFilter; ofn.lpstrDefExt = L"spxworld"; break;
+        case FileDialog::Filter::Models: ofn.lpstrFilter = modelFilter; break;
+        default: ofn.lpstrFilter = allFilter; break;
+        }
+        ofn.nFilterIndex = 1;
+
+        // Flags: require existing path (and file, when opening), Explorer-style dialog, leave
+        // the working directory alone (relative asset paths depend on it)
+        ofn.Flags = OFN_PATHMUSTEXIST | OFN_EXPLORER | OFN_NOCHANGEDIR;
+        ofn.Flags |= save ? OFN_OVERWRITEPROMPT : OFN_FILEMUSTEXIST;
+
+        if (save ? GetSaveFileNameW(&ofn) : GetOpenFileNameW(&ofn)) {
+            // Convert selected wide string to UTF-8
+            int required = WideCharToMultiByte(CP_UTF8, 0, ofn.lpstrFile, -1, nullptr, 0, nullptr, nullptr);
+            if (required > 0) {
+                std::vector<char> utf8(required, 0);
+                WideCharToMultiByte(CP_UTF8, 0, ofn.lpstrFile, -1, utf8.data(), required, nullptr, nullptr);
+                return std::string(utf8.data());
+            }
+            LOG_WARNING("FileDialog: WideCharToMultiByte failed converting path.");
+            return std::string();
+        }
+        // If user cancelled, CommDlgExtendedError returns 0. Otherwise log the error code.
+        DWORD err = CommDlgExtendedError();
+        if (err != 0) {
+            LOG_WARNING("FileDialog: " << (save ? "GetSaveFileNameW" : "GetOpenFileNameW") << " failed, CommDlgExtendedError=" << err);
+        }
+        return std::string();
+    }
+#else
+    std::string ShowDialog(FileDialog::Filter, bool) {
+        LOG_WARNING("FileDialog: no native file dialog on this platform");
+        return std::string();
+    }
+#endif
+
+    bool StartAsync(FileDialog::Filter filter, bool save, int requestId) {
+        if (s_request) return false; // showing, or closed but not taken yet
+        if (s_thread.joinable()) s_thread.join();
+
+        auto request = std::make_shared<Request>();
+        request->filter = filter;
+        request->save = save;
+        request->requestId = requestId;
+        s_request = request;
+        s_thread = std::thread([request]() {
+#ifdef _WIN32
+            // the shell parts of the dialog need COM on this thread
+            HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+            request->path = ShowDialog(request->filter, request->save);
+            if (SUCCEEDED(hr)) CoUninitialize();
+#else
+            request->path = ShowDialog(request->filter, request->save);
+#endif
+            request->done = true;
+        });
+        return true;
+    }
+}
+
+std::string FileDialog::Open(Filter filter) {
+    return ShowDialog(filter, false);
+}
+
+std::string FileDialog::Save(Filter filter) {
+    return ShowDialog(filter, true);
+}
+
+bool FileDialog::OpenAsync(Filter filter, int requestId) {
+    return StartAsync(filter, false, requestId);
+}
+
+bool FileDialog::SaveAsync(Filter filter, int requestId) {
+    return StartAsync(filter, true, requestId);
+}
+
+bool FileDialog::IsOpen() {
+    return s_request && !s_request->done;
+}
+
+bool FileDialog::TakeResult(int& requestId, std::string& path) {
+    if (!s_request || !s_request->done) return false;
+    if (s_thread.joinable()) s_thread.join();
+    requestId = s_request->requestId;
+    path = std::move(s_request->path);
+    s_request.reset();
+    return true;
+}
+
+void FileDialog::Shutdown() {
+    if (!s_thread.joinable()) return;
+    if (s_request && !s_request->done) {
+        // can't close the user's dialog from here; the thread only touches its own Request
+        s_thread.detach();
+    }
+    else {
+        s_thread.join();
+    }
+    s_request.reset();
+}
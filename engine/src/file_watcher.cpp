@@ -0,0 +1,245 @@
+#include "../include/file_watcher.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_map>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr int kPollMs = 50;   // how often the thread checks for stop and settled files
+}
+
+FileWatcher::~FileWatcher() {
+    Stop();
+}
+
+bool FileWatcher::Start(const std::vector<std::string>& roots, int debounceMs) {
+    Stop();
+    m_roots.clear();
+    std::error_code ec;
+    for (const std::string& root : roots) {
+        if (fs::is_directory(root, ec)) {
+            m_roots.push_back(root);
+        }
+        else {
+            LOG_WARNING("FileWatcher: not a folder, skipped: " << root);
+        }
+    }
+    if (m_roots.empty()) return false;
+
+    m_debounce = std::chrono::milliseconds(std::max(0, debounceMs));
+    m_stop = false;
+    m_thread = std::thread([this]() { Run(); });
+    return true;
+}
+
+void FileWatcher::Stop() {
+    if (!m_thread.joinable()) return;
+    m_stop = true;
+    m_thread.join();
+    m_pending.clear();
+}
+
+std::vector<FileWatcher::Change> FileWatcher::TakeChanges() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Change> changes;
+    changes.swap(m_ready);
+    return changes;
+}
+
+void FileWatcher::Touch(size_t root, std::string path) {
+    // restarts the quiet period on every write
+    m_pending[{ root, std::move(path) }] = Clock::now();
+}
+
+void FileWatcher::Settle() {
+    if (m_pending.empty()) return;
+    const Clock::time_point now = Clock::now();
+    std::vector<Change> settled;
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (now - it->second < m_debounce) {
+            ++it;
+            continue;
+        }
+        settled.push_back({ it->first.first, it->first.second });
+        it = m_pending.erase(it);
+    }
+    if (settled.empty()) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Change& change : settled) {
+        bool queued = std::any_of(m_ready.begin(), m_ready.end(),
+            [&](const Change& c) { return c.root == change.root && c.path == change.path; });
+        if (!queued) m_ready.push_back(std::move(change));
+    }
+}
+
+#ifdef _WIN32
+
+void FileWatcher::Run() {
+    struct DirWatch {
+        HANDLE dir = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped = {};
+        std::vector<DWORD> buffer = std::vector<DWORD>(16 * 1024); // DWORD aligned as the API requires
+    };
+    auto issue = [](DirWatch& w) {
+        return ReadDirectoryChangesW(w.dir, w.buffer.data(), static_cast<DWORD>(w.buffer.size() * sizeof(DWORD)), TRUE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+            nullptr, &w.overlapped, nullptr) != 0;
+    };
+
+    std::vector<DirWatch> watches(m_roots.size());
+    std::vector<HANDLE> events;
+    std::vector<size_t> eventRoot;
+    for (size_t i = 0; i < m_roots.size(); ++i) {
+        DirWatch& w = watches[i];
+        w.dir = CreateFileW(fs::path(m_roots[i]).c_str(), FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (w.dir == INVALID_HANDLE_VALUE) {
+            LOG_WARNING("FileWatcher: cannot watch " << m_roots[i] << " (error " << GetLastError() << ")");
+            continue;
+        }
+        w.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (!w.overlapped.hEvent || !issue(w)) {
+            LOG_WARNING("FileWatcher: ReadDirectoryChangesW failed for " << m_roots[i]);
+            continue;
+        }
+        events.push_back(w.overlapped.hEvent);
+        eventRoot.push_back(i);
+        LOG_INFO("FileWatcher: watching " << m_roots[i]);
+    }
+
+    while (!m_stop && !events.empty()) {
+        DWORD result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, kPollMs);
+        if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + events.size()) {
+            const size_t root = eventRoot[result - WAIT_OBJECT_0];
+            DirWatch& w = watches[root];
+            DWORD bytes = 0;
+            // 0 bytes = the buffer overflowed and the changes are lost; nothing to report
+            if (GetOverlappedResult(w.dir, &w.overlapped, &bytes, FALSE) && bytes > 0) {
+                const BYTE* p = reinterpret_cast<const BYTE*>(w.buffer.data());
+                while (true) {
+                    const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+                    if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED
+                        || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                        std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                        std::error_code ec;
+                        if (!fs::is_directory(fs::path(m_roots[root]) / name, ec)) Touch(root, fs::path(name).generic_string());
+                    }
+                    if (info->NextEntryOffset == 0) break;
+                    p += info->NextEntryOffset;
+                }
+            }
+            ResetEvent(w.overlapped.hEvent);
+            if (!issue(w)) {
+                LOG_WARNING("FileWatcher: lost the watch on " << m_roots[root]);
+            }
+        }
+        Settle();
+    }
+
+    for (DirWatch& w : watches) {
+        if (w.dir == INVALID_HANDLE_VALUE) continue;
+        CancelIoEx(w.dir, &w.overlapped);
+        DWORD bytes = 0;
+        if (w.overlapped.hEvent) GetOverlappedResult(w.dir, &w.overlapped, &bytes, TRUE);
+        CloseHandle(w.dir);
+        if (w.overlapped.hEvent) CloseHandle(w.overlapped.hEvent);
+    }
+}
+
+#elif defined(__linux__)
+
+void FileWatcher::Run() {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("FileWatcher: inotify_init1 failed");
+        return;
+    }
+
+    // inotify is not recursive: one watch per folder, added as folders appear
+    struct Watch {
+        size_t root = 0;
+        std::string dir;         // relative to the root, "" or ending in '/'
+    };
+    std::unordered_map<int, Watch> watches;
+    const uint32_t kMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+    auto addTree = [&](size_t root, const std::string& dir, bool reportFiles) {
+        const fs::path base = fs::path(m_roots[root]) / dir;
+        int wd = inotify_add_watch(fd, base.c_str(), kMask);
+        if (wd >= 0) watches[wd] = { root, dir };
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(base, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            std::string rel = it->path().lexically_relative(m_roots[root]).generic_string();
+            if (it->is_directory(ec)) {
+                wd = inotify_add_watch(fd, it->path().c_str(), kMask);
+                if (wd >= 0) watches[wd] = { root, rel + "/" };
+            }
+            else if (reportFiles) {
+                // copied in with the folder before its watch existed
+                Touch(root, rel);
+            }
+        }
+    };
+    for (size_t i = 0; i < m_roots.size(); ++i) {
+        addTree(i, std::string(), false);
+        LOG_INFO("FileWatcher: watching " << m_roots[i]);
+    }
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (!m_stop) {
+        pollfd p = { fd, POLLIN, 0 };
+        if (poll(&p, 1, kPollMs) > 0) {
+            ssize_t n;
+            while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + n;) {
+                    const inotify_event* ev = reinterpret_cast<const inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + ev->len;
+                    auto it = watches.find(ev->wd);
+                    if (it == watches.end()) continue;
+                    if (ev->mask & IN_IGNORED) {
+                        watches.erase(it);
+                        continue;
+                    }
+                    if (ev->len == 0) continue;
+                    const Watch watch = it->second;
+                    std::string rel = watch.dir + ev->name;
+                    if (ev->mask & IN_ISDIR) {
+                        if (ev->mask & (IN_CREATE | IN_MOVED_TO)) addTree(watch.root, rel + "/", true);
+                    }
+                    else if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                        Touch(watch.root, std::move(rel));
+                    }
+                }
+            }
+        }
+        Settle();
+    }
+    close(fd);
+}
+
+#else
+
+void FileWatcher::Run() {
+    LOG_WARNING("FileWatcher: not supported on this platform");
+}
+
+#endif
@@ -0,0 +1,340 @@
+#include "../include/font_cache.h"
+#include "../include/hash.h"
+#include "../include/log.h"
+#include "imgui/imgui.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char kMagic[8] = { 'S', 'P', 'X', 'F', 'O', 'N', 'T', '\0' };
+    constexpr int kMaxTexSize = 16384;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t imguiVersion;   // IMGUI_VERSION_NUM, the glyph and atlas layout may change with it
+        uint64_t key;
+        uint64_t payloadSize;
+        uint64_t checksum;       // Hash::Bytes64 of the payload
+    };
+    static_assert(sizeof(Header) == 40, "FontCache::Header layout changed, bump kVersion");
+
+    std::string s_directory;
+
+    std::string EntryPath(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return (fs::path(s_directory) / (std::string(name) + FontCache::kExtension)).string();
+    }
+
+    void Reject(const std::string& path, const char* why) {
+        LOG_WARNING("FontCache: dropping " << path << ": " << why);
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+
+    // Payload is a flat little-endian stream of PODs
+    struct Writer {
+        std::vector<uint8_t> bytes;
+
+        template <typename T>
+        void Put(const T& value) {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+            bytes.insert(bytes.end(), p, p + sizeof(T));
+        }
+        void PutBytes(const void* data, size_t size) {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            bytes.insert(bytes.end(), p, p + size);
+        }
+    };
+
+    struct Reader {
+        const uint8_t* p = nullptr;
+        const uint8_t* end = nullptr;
+        bool ok = true;
+
+        template <typename T>
+        T Get() {
+            T value{};
+            if (static_cast<size_t>(end - p) < sizeof(T)) {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, p, sizeof(T));
+            p += sizeof(T);
+            return value;
+        }
+        const uint8_t* GetBytes(size_t size) {
+            if (static_cast<size_t>(end - p) < size) {
+                ok = false;
+                return nullptr;
+            }
+            const uint8_t* data = p;
+            p += size;
+            return data;
+        }
+    };
+
+    // Glyph flags and codepoint share a bitfield in ImFontGlyph; stored as one word
+    uint32_t PackGlyphBits(const ImFontGlyph& g) {
+        return (g.Codepoint << 2) | (g.Visible ? 2u : 0u) | (g.Colored ? 1u : 0u);
+    }
+}
+
+void FontCache::SetDirectory(const std::string& directory) {
+    s_directory = directory;
+}
+
+const std::string& FontCache::Directory() {
+    return s_directory;
+}
+
+uint64_t FontCache::Key(const ImFontAtlas* atlas) {
+    uint64_t h = Hash::Fnv1a64("SpxFontAtlas");
+    auto mix = [&h](const void* data, size_t size) { h = Hash::Bytes64(data, size, h); };
+    auto mixValue = [&mix](const auto& value) { mix(&value, sizeof(value)); };
+
+    mixValue(atlas->Flags);
+    mixValue(atlas->TexDesiredWidth);
+    mixValue(atlas->TexGlyphPadding);
+    mixValue(atlas->FontBuilderFlags);
+    mixValue(atlas->ConfigData.Size);
+    for (const ImFontConfig& cfg : atlas->ConfigData) {
+        mix(cfg.FontData, static_cast<size_t>(cfg.FontDataSize));
+        mixValue(cfg.FontNo);
+        mixValue(cfg.SizePixels);
+        mixValue(cfg.OversampleH);
+        mixValue(cfg.OversampleV);
+        mixValue(cfg.PixelSnapH);
+        mixValue(cfg.GlyphExtraSpacing.x);
+        mixValue(cfg.GlyphExtraSpacing.y);
+        mixValue(cfg.GlyphOffset.x);
+        mixValue(cfg.GlyphOffset.y);
+        mixValue(cfg.GlyphMinAdvanceX);
+        mixValue(cfg.GlyphMaxAdvanceX);
+        mixValue(cfg.MergeMode);
+        mixValue(cfg.FontBuilderFlags);
+        mixValue(cfg.RasterizerMultiply);
+        mixValue(cfg.RasterizerDensity);
+        mixValue(cfg.EllipsisChar);
+        // NULL ranges = the default ranges, hashed as no ranges
+        const ImWchar* range = cfg.GlyphRanges;
+        size_t count = 0;
+        while (range && range[count]) ++count;
+        mixValue(count);
+        if (count) mix(range, count * sizeof(ImWchar));
+    }
+    return Hash::Mix64(h ^ kVersion);
+}
+
+bool FontCache::Load(ImFontAtlas* atlas, uint64_t key) {
+    if (s_directory.empty() || atlas->Fonts.empty() || atlas->IsBuilt()) return false;
+
+    const std::string path = EntryPath(key);
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    const std::streamsize size = in.tellg();
+    in.seekg(0);
+    Header header;
+    if (size < static_cast<std::streamsize>(sizeof(Header)) || !in.read(reinterpret_cast<char*>(&header), sizeof(Header))
+        || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.imguiVersion != IMGUI_VERSION_NUM) {
+        in.close();
+        Reject(path, "not a font cache entry of this version");
+        return false;
+    }
+    if (header.key != key || header.payloadSize != static_cast<uint64_t>(size) - sizeof(Header)) {
+        in.close();
+        Reject(path, "wrong key or truncated");
+        return false;
+    }
+    std::vector<uint8_t> payload(static_cast<size_t>(header.payloadSize));
+    if (!in.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload.size()))
+        || Hash::Bytes64(payload.data(), payload.size()) != header.checksum) {
+        in.close();
+        Reject(path, "checksum mismatch");
+        return false;
+    }
+    in.close();
+
+    // Parse everything before touching the atlas, so a bad entry leaves it unbuilt
+    Reader r{ payload.data(), payload.data() + payload.size() };
+    const int texWidth = r.Get<int32_t>();
+    const int texHeight = r.Get<int32_t>();
+    const ImVec2 uvWhitePixel = r.Get<ImVec2>();
+    const uint32_t lineCount = r.Get<uint32_t>();
+    const int packIdMouseCursors = r.Get<int32_t>();
+    const int packIdLines = r.Get<int32_t>();
+    const uint32_t rectCount = r.Get<uint32_t>();
+    const uint32_t fontCount = r.Get<uint32_t>();
+    if (!r.ok || texWidth <= 0 || texHeight <= 0 || texWidth > kMaxTexSize || texHeight > kMaxTexSize
+        || lineCount != static_cast<uint32_t>(IM_ARRAYSIZE(atlas->TexUvLines)) || fontCount != static_cast<uint32_t>(atlas->Fonts.Size)) {
+        Reject(path, "does not match the fonts");
+        return false;
+    }
+    ImVec4 uvLines[IM_ARRAYSIZE(atlas->TexUvLines)];
+    for (ImVec4& line : uvLines) line = r.Get<ImVec4>();
+
+    ImVector<ImFontAtlasCustomRect> rects;
+    for (uint32_t i = 0; i < rectCount && r.ok; ++i) {
+        ImFontAtlasCustomRect rect;
+        rect.Width = r.Get<uint16_t>();
+        rect.Height = r.Get<uint16_t>();
+        rect.X = r.Get<uint16_t>();
+        rect.Y = r.Get<uint16_t>();
+        rect.GlyphID = r.Get<uint32_t>();
+        rect.GlyphAdvanceX = r.Get<float>();
+        rect.GlyphOffset = r.Get<ImVec2>();
+        rects.push_back(rect);
+    }
+
+    struct FontData {
+        float fontSize, ascent, descent;
+        int metricsTotalSurface;
+        ImVector<ImFontGlyph> glyphs;
+    };
+    std::vector<FontData> fonts(fontCount);
+    for (FontData& font : fonts) {
+        font.fontSize = r.Get<float>();
+        font.ascent = r.Get<float>();
+        font.descent = r.Get<float>();
+        font.metricsTotalSurface = r.Get<int32_t>();
+        const uint32_t glyphCount = r.Get<uint32_t>();
+        if (!r.ok || glyphCount == 0 || glyphCount >= 0xFFFF) {
+            Reject(path, "bad glyph table");
+            return false;
+        }
+        font.glyphs.resize(static_cast<int>(glyphCount));
+        for (ImFontGlyph& g : font.glyphs) {
+            const uint32_t bits = r.Get<uint32_t>();
+            g.Colored = bits & 1u;
+            g.Visible = (bits >> 1) & 1u;
+            g.Codepoint = bits >> 2;
+            g.AdvanceX = r.Get<float>();
+            g.X0 = r.Get<float>();
+            g.Y0 = r.Get<float>();
+            g.X1 = r.Get<float>();
+            g.Y1 = r.Get<float>();
+            g.U0 = r.Get<float>();
+            g.V0 = r.Get<float>();
+            g.U1 = r.Get<float>();
+            g.V1 = r.Get<float>();
+        }
+    }
+    const size_t pixelCount = static_cast<size_t>(texWidth) * static_cast<size_t>(texHeight);
+    const uint8_t* pixels = r.GetBytes(pixelCount);
+    if (!r.ok || r.p != r.end) {
+        Reject(path, "truncated payload");
+        return false;
+    }
+
+    // What ImFontAtlas::Build would have produced, minus the rasterizing
+    atlas->ClearTexData();
+    atlas->TexWidth = texWidth;
+    atlas->TexHeight = texHeight;
+    atlas->TexUvScale = ImVec2(1.0f / texWidth, 1.0f / texHeight);
+    atlas->TexUvWhitePixel = uvWhitePixel;
+    for (int i = 0; i < IM_ARRAYSIZE(uvLines); ++i) atlas->TexUvLines[i] = uvLines[i];
+    atlas->CustomRects.swap(rects);
+    atlas->PackIdMouseCursors = packIdMouseCursors;
+    atlas->PackIdLines = packIdLines;
+    atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(pixelCount)); // freed by ClearTexData
+    std::memcpy(atlas->TexPixelsAlpha8, pixels, pixelCount);
+
+    for (size_t i = 0; i < fonts.size(); ++i) {
+        ImFont* font = atlas->Fonts[static_cast<int>(i)];
+        FontData& data = fonts[i];
+        font->ContainerAtlas = atlas;
+        font->FontSize = data.fontSize;
+        font->Ascent = data.ascent;
+        font->Descent = data.descent;
+        font->MetricsTotalSurface = data.metricsTotalSurface;
+        font->Glyphs.swap(data.glyphs);
+        // fallback and ellipsis are picked from the glyphs, as in the build
+        font->BuildLookupTable();
+    }
+    atlas->TexReady = true;
+    return true;
+}
+
+bool FontCache::Store(const ImFontAtlas* atlas, uint64_t key) {
+    if (s_directory.empty() || !atlas->IsBuilt() || !atlas->TexPixelsAlpha8) return false;
+    for (const ImFontAtlasCustomRect& rect : atlas->CustomRects) {
+        // custom glyphs point at fonts, which can't be restored from a file
+        if (rect.Font) return false;
+    }
+
+    Writer w;
+    w.Put<int32_t>(atlas->TexWidth);
+    w.Put<int32_t>(atlas->TexHeight);
+    w.Put(atlas->TexUvWhitePixel);
+    w.Put<uint32_t>(IM_ARRAYSIZE(atlas->TexUvLines));
+    w.Put<int32_t>(atlas->PackIdMouseCursors);
+    w.Put<int32_t>(atlas->PackIdLines);
+    w.Put<uint32_t>(static_cast<uint32_t>(atlas->CustomRects.Size));
+    w.Put<uint32_t>(static_cast<uint32_t>(atlas->Fonts.Size));
+    for (const ImVec4& line : atlas->TexUvLines) w.Put(line);
+    for (const ImFontAtlasCustomRect& rect : atlas->CustomRects) {
+        w.Put<uint16_t>(rect.Width);
+        w.Put<uint16_t>(rect.Height);
+        w.Put<uint16_t>(rect.X);
+        w.Put<uint16_t>(rect.Y);
+        w.Put<uint32_t>(rect.GlyphID);
+        w.Put(rect.GlyphAdvanceX);
+        w.Put(rect.GlyphOffset);
+    }
+    for (const ImFont* font : atlas->Fonts) {
+        w.Put(font->FontSize);
+        w.Put(font->Ascent);
+        w.Put(font->Descent);
+        w.Put<int32_t>(font->MetricsTotalSurface);
+        w.Put<uint32_t>(static_cast<uint32_t>(font->Glyphs.Size));
+        for (const ImFontGlyph& g : font->Glyphs) {
+            w.Put(PackGlyphBits(g));
+            w.Put(g.AdvanceX);
+            w.Put(g.X0);
+            w.Put(g.Y0);
+            w.Put(g.X1);
+            w.Put(g.Y1);
+            w.Put(g.U0);
+            w.Put(g.V0);
+            w.Put(g.U1);
+            w.Put(g.V1);
+        }
+    }
+    w.PutBytes(atlas->TexPixelsAlpha8, static_cast<size_t>(atlas->TexWidth) * static_cast<size_t>(atlas->TexHeight));
+
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.imguiVersion = IMGUI_VERSION_NUM;
+    header.key = key;
+    header.payloadSize = w.bytes.size();
+    header.checksum = Hash::Bytes64(w.bytes.data(), w.bytes.size());
+
+    std::error_code ec;
+    fs::create_directories(s_directory, ec);
+    // temp file + rename so a crash never leaves half an entry behind
+    const std::string path = EntryPath(key);
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.write(reinterpret_cast<const char*>(&header), sizeof(header))
+            || !out.write(reinterpret_cast<const char*>(w.bytes.data()), static_cast<std::streamsize>(w.bytes.size()))) {
+            LOG_WARNING("FontCache: cannot write " << tmp);
+            return false;
+        }
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
@@ -14,5 +14,6 @@ const int OBJ_PYRAMID = 10;
 const int OBJ_TRIANGEL = 11;
 
 const int OBJ_FLOOR = 12;
+const int OBJ_MESH = 13; // imported model (MeshModel)
 
 //bool ShouldAddPlane = false;
\ No newline at end of file
@@ -0,0 +1,565 @@
+#include "../include/gltf_loader.h"
+#include "../include/asset_path.h"
+#include "../include/json_tokens.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr uint32_t kGlbMagic = 0x46546C67;     // "glTF"
+    constexpr uint32_t kChunkJson = 0x4E4F534A;    // "JSON"
+    constexpr uint32_t kChunkBin = 0x004E4942;     // "BIN\0"
+
+    uint32_t ReadU32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    size_t ComponentSize(GLenum type) {
+        switch (type) {
+        case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+        case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+        case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+        default: return 0;
+        }
+    }
+
+    int TypeComponents(std::string_view type) {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT2") return 4;
+        if (type == "MAT3") return 9;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    // One component as float, applying the glTF normalisation rules
+    float ReadComponent(const uint8_t* p, GLenum type, bool normalized) {
+        switch (type) {
+        case GL_FLOAT: { float f; std::memcpy(&f, p, 4); return f; }
+        case GL_UNSIGNED_BYTE: return normalized ? p[0] / 255.0f : p[0];
+        case GL_BYTE: { int8_t v = static_cast<int8_t>(p[0]); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+        case GL_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p, 2); return normalized ? v / 65535.0f : v; }
+        case GL_SHORT: { int16_t v; std::memcpy(&v, p, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+        case GL_UNSIGNED_INT: { uint32_t v; std::memcpy(&v, p, 4); return static_cast<float>(v); }
+        default: return 0.0f;
+        }
+    }
+
+    // "%20" etc. in relative uris
+    std::string PercentDecode(const std::string& uri) {
+        std::string out;
+        out.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); ++i) {
+            if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+                out += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            }
+            else {
+                out += uri[i];
+            }
+        }
+        return out;
+    }
+
+    bool DecodeBase64(std::string_view text, std::vector<uint8_t>& out) {
+        auto value = [](char c) -> int {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+' || c == '-') return 62;
+            if (c == '/' || c == '_') return 63;
+            return -1;
+        };
+        out.clear();
+        out.reserve(text.size() * 3 / 4);
+        uint32_t bits = 0;
+        int count = 0;
+        for (char c : text) {
+            if (c == '=') break;
+            int v = value(c);
+            if (v < 0) return false;
+            bits = (bits << 6) | static_cast<uint32_t>(v);
+            count += 6;
+            if (count >= 8) {
+                count -= 8;
+                out.push_back(static_cast<uint8_t>((bits >> count) & 0xFF));
+            }
+        }
+        return true;
+    }
+
+    // "data:application/octet-stream;base64,...." -> payload, empty if not a data uri
+    std::string_view DataUriPayload(std::string_view uri) {
+        if (uri.substr(0, 5) != "data:") return std::string_view();
+        size_t comma = uri.find(";base64,");
+        return (comma == std::string_view::npos) ? std::string_view() : uri.substr(comma + 8);
+    }
+
+    int IndexOf(const JsonDocument& doc, int object, std::string_view key) {
+        return static_cast<int>(doc.IntOf(object, key, -1));
+    }
+
+    // Offsets, lengths and counts: false if negative or too big for size_t (32-bit builds)
+    bool SizeOf(const JsonDocument& doc, int object, std::string_view key, size_t& out) {
+        int64_t value = doc.IntOf(object, key);
+        if (value < 0 || static_cast<uint64_t>(value) > std::numeric_limits<size_t>::max()) return false;
+        out = static_cast<size_t>(value);
+        return true;
+    }
+
+    // File extension for an embedded image, from the mime type or else the magic bytes
+    std::string ImageExtension(const std::string& mimeType, const uint8_t* data, size_t size) {
+        if (mimeType == "image/png") return ".png";
+        if (mimeType == "image/jpeg") return ".jpg";
+        if (size >= 4 && data[0] == 0x89 && data[1] == 'P' && data[2] == 'N' && data[3] == 'G') return ".png";
+        if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) return ".jpg";
+        return ".img"; // stb sniffs the content anyway
+    }
+
+    // Accessors without a bufferView are zero filled, so their count is all that bounds the allocation
+    constexpr size_t kMaxZeroAccessorCount = size_t(1) << 24;
+}
+
+bool GltfModel::Load(const std::string& path) {
+    auto t0 = std::chrono::steady_clock::now();
+    m_path = path;
+    m_baseDir = fs::path(path).parent_path().generic_string();
+    if (!OpenAssetFile(path, m_file) || m_file.Size() < 12) {
+        LOG_ERROR("GltfModel: Failed to open " << path);
+        return false;
+    }
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(m_file.Data());
+    size_t size = m_file.Size();
+    bool ok = false;
+    if (ReadU32(data) == kGlbMagic) {
+        // GLB: 12 byte header, JSON chunk, optional BIN chunk
+        uint32_t version = ReadU32(data + 4);
+        size_t length = std::min<size_t>(ReadU32(data + 8), size);
+        if (version != 2) {
+            LOG_ERROR("GltfModel: unsupported GLB version " << version << " in " << path);
+            return false;
+        }
+        const uint8_t* json = nullptr;
+        size_t jsonSize = 0;
+        const uint8_t* bin = nullptr;
+        size_t binSize = 0;
+        size_t offset = 12;
+        while (offset + 8 <= length) {
+            uint32_t chunkLength = ReadU32(data + offset);
+            uint32_t chunkType = ReadU32(data + offset + 4);
+            if (chunkLength > length - offset - 8) break;
+            if (chunkType == kChunkJson && !json) { json = data + offset + 8; jsonSize = chunkLength; }
+            else if (chunkType == kChunkBin && !bin) { bin = data + offset + 8; binSize = chunkLength; }
+            offset += 8 + ((chunkLength + 3) & ~3u);
+        }
+        if (!json) {
+            LOG_ERROR("GltfModel: GLB without JSON chunk: " << path);
+            return false;
+        }
+        ok = ParseJson(reinterpret_cast<const char*>(json), jsonSize, bin, binSize);
+    }
+    else {
+        // plain .gltf, skip a UTF-8 BOM if the exporter wrote one
+        size_t bom = (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) ? 3 : 0;
+        ok = ParseJson(m_file.Data() + bom, size - bom, nullptr, 0);
+    }
+    if (!ok) {
+        LOG_ERROR("GltfModel: Failed to parse " << path);
+        return false;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    LOG_INFO("GltfModel: Loaded " << path << " (" << m_meshes.size() << " meshes, " << m_nodes.size()
+        << " nodes, " << m_materials.size() << " materials) in " << ms << " ms");
+    return true;
+}
+
+bool GltfModel::ParseJson(const char* json, size_t size, const uint8_t* glbBin, size_t glbBinSize) {
+    JsonDocument doc;
+    if (!doc.Parse(json, size)) {
+        LOG_ERROR("GltfModel: JSON error: " << doc.Error());
+        return false;
+    }
+    const int root = doc.Root();
+    if (doc.Type(root) != JsonToken::Object) return false;
+
+    // buffers: GLB chunk, external .bin (mapped) or base64 data uri
+    int buffers = doc.Find(root, "buffers");
+    for (int i = 0, b = doc.FirstChild(buffers); i < doc.Count(buffers); ++i, b = doc.Next(b)) {
+        Buffer buffer;
+        int uri = doc.Find(b, "uri");
+        size_t byteLength = 0;
+        if (!SizeOf(doc, b, "byteLength", byteLength)) {
+            LOG_ERROR("GltfModel: buffer " << i << " has an invalid byteLength");
+            return false;
+        }
+        if (uri < 0) {
+            buffer.data = glbBin;
+            buffer.size = glbBinSize;
+        }
+        else if (!DataUriPayload(doc.Raw(uri)).empty()) {
+            m_decoded.emplace_back();
+            if (!DecodeBase64(DataUriPayload(doc.Raw(uri)), m_decoded.back())) {
+                LOG_ERROR("GltfModel: bad base64 buffer " << i);
+                return false;
+            }
+            buffer.data = m_decoded.back().data();
+            buffer.size = m_decoded.back().size();
+        }
+        else {
+            std::string binPath = (fs::path(m_baseDir) / PercentDecode(doc.String(uri))).lexically_normal().generic_string();
+            m_binFiles.emplace_back();
+            if (!OpenAssetFile(binPath, m_binFiles.back())) {
+                LOG_ERROR("GltfModel: missing buffer " << binPath);
+                return false;
+            }
+            buffer.data = reinterpret_cast<const uint8_t*>(m_binFiles.back().Data());
+            buffer.size = m_binFiles.back().Size();
+        }
+        if (buffer.size < byteLength) {
+            LOG_ERROR("GltfModel: buffer " << i << " is shorter than its byteLength");
+            return false;
+        }
+        m_buffers.push_back(buffer);
+    }
+
+    int views = doc.Find(root, "bufferViews");
+    for (int i = 0, v = doc.FirstChild(views); i < doc.Count(views); ++i, v = doc.Next(v)) {
+        GltfBufferView view;
+        view.buffer = IndexOf(doc, v, "buffer");
+        // compare by subtraction, offset + length could wrap
+        if (!SizeOf(doc, v, "byteOffset", view.byteOffset) || !SizeOf(doc, v, "byteLength", view.byteLength)
+            || !SizeOf(doc, v, "byteStride", view.byteStride) || view.byteStride > 252
+            || view.buffer < 0 || view.buffer >= static_cast<int>(m_buffers.size())
+            || view.byteOffset > m_buffers[view.buffer].size
+            || view.byteLength > m_buffers[view.buffer].size - view.byteOffset) {
+            LOG_ERROR("GltfModel: bufferView " << i << " is out of range");
+            return false;
+        }
+        m_bufferViews.push_back(view);
+    }
+
+    int accessors = doc.Find(root, "accessors");
+    for (int i = 0, a = doc.FirstChild(accessors); i < doc.Count(accessors); ++i, a = doc.Next(a)) {
+        GltfAccessor acc;
+        acc.bufferView = IndexOf(doc, a, "bufferView");
+        const bool sized = SizeOf(doc, a, "byteOffset", acc.byteOffset) && SizeOf(doc, a, "count", acc.count);
+        acc.componentType = static_cast<GLenum>(doc.IntOf(a, "componentType", GL_FLOAT));
+        acc.normalized = doc.BoolOf(a, "normalized");
+        acc.components = TypeComponents(doc.Raw(doc.Find(a, "type")));
+        int mn = doc.Find(a, "min"), mx = doc.Find(a, "max");
+        if (acc.components == 3 && doc.Count(mn) == 3 && doc.Count(mx) == 3) {
+            acc.hasBounds = true;
+            for (int k = 0; k < 3; ++k) {
+                acc.min[k] = static_cast<float>(doc.Number(doc.At(mn, k)));
+                acc.max[k] = static_cast<float>(doc.Number(doc.At(mx, k)));
+            }
+        }
+        if (doc.Find(a, "sparse") >= 0) {
+            LOG_WARNING("GltfModel: sparse accessor " << i << " not supported, using base values");
+        }
+        if (!sized || acc.bufferView >= static_cast<int>(m_bufferViews.size()) || ComponentSize(acc.componentType) == 0 || acc.components == 0
+            || (acc.bufferView < 0 && acc.count > kMaxZeroAccessorCount)) {
+            LOG_ERROR("GltfModel: invalid accessor " << i);
+            return false;
+        }
+        if (acc.bufferView >= 0) {
+            const GltfBufferView& view = m_bufferViews[acc.bufferView];
+            size_t elementSize = ComponentSize(acc.componentType) * acc.components;
+            size_t stride = view.byteStride ? view.byteStride : elementSize;
+            // offset + stride * (count - 1) + elementSize <= byteLength, rearranged so nothing can wrap
+            if (acc.count > 0 && (acc.byteOffset > view.byteLength || elementSize > view.byteLength - acc.byteOffset
+                || acc.count - 1 > (view.byteLength - acc.byteOffset - elementSize) / stride)) {
+                LOG_ERROR("GltfModel: accessor " << i << " overruns its bufferView");
+                return false;
+            }
+        }
+        m_accessors.push_back(acc);
+    }
+
+    int images = doc.Find(root, "images");
+    for (int i = 0, im = doc.FirstChild(images); i < doc.Count(images); ++i, im = doc.Next(im)) {
+        GltfImage image;
+        image.bufferView = IndexOf(doc, im, "bufferView");
+        image.mimeType = doc.StringOf(im, "mimeType");
+        int uri = doc.Find(im, "uri");
+        if (uri >= 0) {
+            std::string_view payload = DataUriPayload(doc.Raw(uri));
+            if (!payload.empty()) {
+                // base64 image: decode into an extra buffer + synthetic view so it is handled like GLB images
+                m_decoded.emplace_back();
+                if (DecodeBase64(payload, m_decoded.back())) {
+                    Buffer buffer{ m_decoded.back().data(), m_decoded.back().size() };
+                    m_buffers.push_back(buffer);
+                    GltfBufferView view;
+                    view.buffer = static_cast<int>(m_buffers.size() - 1);
+                    view.byteLength = buffer.size;
+                    m_bufferViews.push_back(view);
+                    image.bufferView = static_cast<int>(m_bufferViews.size() - 1);
+                }
+            }
+            else {
+                image.path = (fs::path(m_baseDir) / PercentDecode(doc.String(uri))).lexically_normal().generic_string();
+            }
+        }
+        m_images.push_back(image);
+    }
+
+    int textures = doc.Find(root, "textures");
+    for (int i = 0, t = doc.FirstChild(textures); i < doc.Count(textures); ++i, t = doc.Next(t)) {
+        GltfTexture texture;
+        texture.image = IndexOf(doc, t, "source");
+        if (texture.image >= static_cast<int>(m_images.size())) texture.image = -1;
+        m_textures.push_back(texture);
+    }
+
+    int materials = doc.Find(root, "materials");
+    for (int i = 0, m = doc.FirstChild(materials); i < doc.Count(materials); ++i, m = doc.Next(m)) {
+        GltfMaterial mat;
+        mat.name = doc.StringOf(m, "name");
+        int pbr = doc.Find(m, "pbrMetallicRoughness");
+        int factor = doc.Find(pbr, "baseColorFactor");
+        if (doc.Count(factor) == 4) {
+            for (int k = 0; k < 4; ++k) mat.baseColor[k] = static_cast<float>(doc.Number(doc.At(factor, k), 1.0));
+        }
+        mat.metallic = static_cast<float>(doc.NumberOf(pbr, "metallicFactor", 1.0));
+        mat.roughness = static_cast<float>(doc.NumberOf(pbr, "roughnessFactor", 1.0));
+        mat.baseColorTexture = IndexOf(doc, doc.Find(pbr, "baseColorTexture"), "index");
+        mat.normalTexture = IndexOf(doc, doc.Find(m, "normalTexture"), "index");
+        if (mat.baseColorTexture >= static_cast<int>(m_textures.size())) mat.baseColorTexture = -1;
+        if (mat.normalTexture >= static_cast<int>(m_textures.size())) mat.normalTexture = -1;
+        mat.doubleSided = doc.BoolOf(m, "doubleSided");
+        mat.alphaBlend = doc.Equals(doc.Find(m, "alphaMode"), "BLEND");
+        if (doc.Equals(doc.Find(m, "alphaMode"), "MASK")) mat.alphaCutoff = static_cast<float>(doc.NumberOf(m, "alphaCutoff", 0.5));
+        m_materials.push_back(mat);
+    }
+
+    auto validAccessor = [this](int a) { return (a >= 0 && a < static_cast<int>(m_accessors.size())) ? a : -1; };
+    int meshes = doc.Find(root, "meshes");
+    for (int i = 0, me = doc.FirstChild(meshes); i < doc.Count(meshes); ++i, me = doc.Next(me)) {
+        GltfMesh mesh;
+        mesh.name = doc.StringOf(me, "name");
+        int prims = doc.Find(me, "primitives");
+        for (int k = 0, p = doc.FirstChild(prims); k < doc.Count(prims); ++k, p = doc.Next(p)) {
+            GltfPrimitive prim;
+            int attributes = doc.Find(p, "attributes");
+            prim.position = validAccessor(IndexOf(doc, attributes, "POSITION"));
+            prim.normal = validAccessor(IndexOf(doc, attributes, "NORMAL"));
+            prim.texcoord = validAccessor(IndexOf(doc, attributes, "TEXCOORD_0"));
+            prim.indices = validAccessor(IndexOf(doc, p, "indices"));
+            prim.material = IndexOf(doc, p, "material");
+            if (prim.material >= static_cast<int>(m_materials.size())) prim.material = -1;
+            prim.mode = static_cast<GLenum>(doc.IntOf(p, "mode", GL_TRIANGLES));
+            if (prim.position < 0) continue; // nothing to draw
+            mesh.primitives.push_back(prim);
+        }
+        m_meshes.push_back(std::move(mesh));
+    }
+
+    int nodes = doc.Find(root, "nodes");
+    m_nodes.resize(static_cast<size_t>(doc.Count(nodes)));
+    for (int i = 0, n = doc.FirstChild(nodes); i < doc.Count(nodes); ++i, n = doc.Next(n)) {
+        GltfNode& node = m_nodes[i];
+        node.name = doc.StringOf(n, "name");
+        node.mesh = IndexOf(doc, n, "mesh");
+        if (node.mesh >= static_cast<int>(m_meshes.size())) node.mesh = -1;
+
+        int matrix = doc.Find(n, "matrix");
+        if (doc.Count(matrix) == 16) {
+            int e = doc.FirstChild(matrix);
+            for (int k = 0; k < 16; ++k, e = doc.Next(e)) node.local[k / 4][k % 4] = static_cast<float>(doc.Number(e)); // column-major like glm
+        }
+        else {
+            glm::vec3 t(0.0f), s(1.0f);
+            glm::quat r(1.0f, 0.0f, 0.0f, 0.0f);
+            int tr = doc.Find(n, "translation"), ro = doc.Find(n, "rotation"), sc = doc.Find(n, "scale");
+            if (doc.Count(tr) == 3) for (int k = 0; k < 3; ++k) t[k] = static_cast<float>(doc.Number(doc.At(tr, k)));
+            if (doc.Count(sc) == 3) for (int k = 0; k < 3; ++k) s[k] = static_cast<float>(doc.Number(doc.At(sc, k), 1.0));
+            if (doc.Count(ro) == 4) {
+                r = glm::quat(static_cast<float>(doc.Number(doc.At(ro, 3), 1.0)), static_cast<float>(doc.Number(doc.At(ro, 0))),
+                    static_cast<float>(doc.Number(doc.At(ro, 1))), static_cast<float>(doc.Number(doc.At(ro, 2))));
+            }
+            node.local = glm::translate(glm::mat4(1.0f), t) * glm::mat4_cast(r) * glm::scale(glm::mat4(1.0f), s);
+        }
+
+        int children = doc.Find(n, "children");
+        for (int k = 0, c = doc.FirstChild(children); k < doc.Count(children); ++k, c = doc.Next(c)) {
+            int child = static_cast<int>(doc.Int(c, -1));
+            if (child >= 0 && child < static_cast<int>(m_nodes.size()) && child != i) node.children.push_back(child);
+        }
+    }
+    for (int i = 0; i < static_cast<int>(m_nodes.size()); ++i) {
+        for (int child : m_nodes[i].children) m_nodes[child].parent = i;
+    }
+
+    // default scene roots; without a scene every parentless node is a root
+    int scenes = doc.Find(root, "scenes");
+    int scene = doc.At(scenes, static_cast<int>(doc.IntOf(root, "scene", 0)));
+    int sceneNodes = doc.Find(scene, "nodes");
+    for (int k = 0, c = doc.FirstChild(sceneNodes); k < doc.Count(sceneNodes); ++k, c = doc.Next(c)) {
+        int node = static_cast<int>(doc.Int(c, -1));
+        if (node >= 0 && node < static_cast<int>(m_nodes.size())) m_sceneRoots.push_back(node);
+    }
+    if (m_sceneRoots.empty()) {
+        for (int i = 0; i < static_cast<int>(m_nodes.size()); ++i) {
+            if (m_nodes[i].parent < 0) m_sceneRoots.push_back(i);
+        }
+    }
+
+    // world transforms, iterative so deep hierarchies can't blow the stack
+    std::vector<int> stack(m_sceneRoots.rbegin(), m_sceneRoots.rend());
+    std::vector<uint8_t> visited(m_nodes.size(), 0);
+    while (!stack.empty()) {
+        int n = stack.back();
+        stack.pop_back();
+        if (visited[n]) continue; // malformed files can have cycles
+        visited[n] = 1;
+        GltfNode& node = m_nodes[n];
+        node.inScene = true;
+        node.world = (node.parent >= 0) ? m_nodes[node.parent].world * node.local : node.local;
+        for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) stack.push_back(*it);
+    }
+    return true;
+}
+
+const uint8_t* GltfModel::BufferViewData(int view) const {
+    if (view < 0 || view >= static_cast<int>(m_bufferViews.size())) return nullptr;
+    const GltfBufferView& v = m_bufferViews[view];
+    return m_buffers[v.buffer].data + v.byteOffset;
+}
+
+bool GltfModel::ReadAccessor(int accessor, int wantComponents, std::vector<float>& out) const {
+    out.clear();
+    if (accessor < 0) return false;
+    const GltfAccessor& acc = m_accessors[accessor];
+    out.assign(acc.count * wantComponents, 0.0f);
+    if (acc.bufferView < 0) return true; // all zeros by spec
+    const uint8_t* base = BufferViewData(acc.bufferView) + acc.byteOffset;
+    size_t componentSize = ComponentSize(acc.componentType);
+    size_t stride = m_bufferViews[acc.bufferView].byteStride ? m_bufferViews[acc.bufferView].byteStride : componentSize * acc.components;
+    int n = std::min(acc.components, wantComponents);
+    for (size_t i = 0; i < acc.count; ++i) {
+        const uint8_t* p = base + i * stride;
+        for (int c = 0; c < n; ++c) out[i * wantComponents + c] = ReadComponent(p + c * componentSize, acc.componentType, acc.normalized);
+    }
+    return true;
+}
+
+bool GltfModel::ReadIndices(int accessor, std::vector<uint32_t>& out) const {
+    out.clear();
+    const GltfAccessor& acc = m_accessors[accessor];
+    if (acc.bufferView < 0) return false;
+    const uint8_t* base = BufferViewData(acc.bufferView) + acc.byteOffset;
+    size_t size = ComponentSize(acc.componentType);
+    size_t stride = m_bufferViews[acc.bufferView].byteStride ? m_bufferViews[acc.bufferView].byteStride : size;
+    out.resize(acc.count);
+    for (size_t i = 0; i < acc.count; ++i) {
+        const uint8_t* p = base + i * stride;
+        if (size == 1) out[i] = p[0];
+        else if (size == 2) { uint16_t v; std::memcpy(&v, p, 2); out[i] = v; }
+        else { std::memcpy(&out[i], p, 4); }
+    }
+    return true;
+}
+
+bool GltfModel::ToMeshData(MeshData& mesh) const {
+    mesh.Clear();
+    // external images keep their path, embedded ones are copied out once and named after the model
+    std::vector<int> embedded(m_images.size(), -1);
+    auto textureName = [&](int texture) -> std::string {
+        if (texture < 0 || m_textures[texture].image < 0) return {};
+        int image = m_textures[texture].image;
+        const GltfImage& img = m_images[image];
+        if (!img.path.empty() || img.bufferView < 0) return img.path;
+        if (embedded[image] < 0) {
+            const uint8_t* data = BufferViewData(img.bufferView);
+            size_t size = m_bufferViews[img.bufferView].byteLength;
+            MeshImage out;
+            out.name = m_path + "#image" + std::to_string(image);
+            out.extension = ImageExtension(img.mimeType, data, size);
+            out.bytes.assign(data, data + size);
+            embedded[image] = static_cast<int>(mesh.images.size());
+            mesh.images.push_back(std::move(out));
+        }
+        return mesh.images[embedded[image]].name;
+    };
+
+    for (const GltfMaterial& mat : m_materials) {
+        MeshMaterial m;
+        m.name = mat.name;
+        m.diffuse = glm::vec3(mat.baseColor);
+        m.opacity = mat.baseColor.a;
+        m.alphaCutoff = mat.alphaCutoff;
+        m.shininess = (1.0f - mat.roughness) * 128.0f;
+        m.diffuseTexture = textureName(mat.baseColorTexture);
+        m.normalTexture = textureName(mat.normalTexture);
+        mesh.materials.push_back(m);
+    }
+
+    std::vector<float> positions, normals, uvs;
+    std::vector<uint32_t> indices;
+    for (const GltfNode& node : m_nodes) {
+        if (node.mesh < 0 || !node.inScene) continue;
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(node.world)));
+        bool flipWinding = glm::determinant(glm::mat3(node.world)) < 0.0f;
+        for (const GltfPrimitive& prim : m_meshes[node.mesh].primitives) {
+            if (prim.mode != GL_TRIANGLES) continue; // strips/fans/lines are not flattened
+            ReadAccessor(prim.position, 3, positions);
+            bool hasNormals = ReadAccessor(prim.normal, 3, normals);
+            bool hasUvs = ReadAccessor(prim.texcoord, 2, uvs);
+            size_t count = positions.size() / 3;
+            if (prim.indices >= 0) ReadIndices(prim.indices, indices);
+            else {
+                indices.resize(count);
+                for (size_t i = 0; i < count; ++i) indices[i] = static_cast<uint32_t>(i);
+            }
+
+            uint32_t firstVertex = static_cast<uint32_t>(mesh.VertexCount());
+            for (size_t i = 0; i < count; ++i) {
+                glm::vec3 p = glm::vec3(node.world * glm::vec4(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2], 1.0f));
+                glm::vec3 n = hasNormals ? normalMatrix * glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]) : glm::vec3(0.0f, 0.0f, 1.0f);
+                if (glm::dot(n, n) > 0.0f) n = glm::normalize(n);
+                float u = hasUvs ? uvs[i * 2] : 0.0f;
+                float v = hasUvs ? 1.0f - uvs[i * 2 + 1] : 0.0f;
+                const float vertex[MESH_VERTEX_FLOATS] = { p.x, p.y, p.z, n.x, n.y, n.z, u, v };
+                mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+            }
+
+            MeshSubmesh sub;
+            sub.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+            sub.materialIndex = prim.material;
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                if (a >= count || b >= count || c >= count) continue;
+                if (flipWinding) std::swap(b, c);
+                mesh.indices.push_back(firstVertex + a);
+                mesh.indices.push_back(firstVertex + b);
+                mesh.indices.push_back(firstVertex + c);
+            }
+            sub.indexCount = static_cast<uint32_t>(mesh.indices.size()) - sub.indexOffset;
+            if (sub.indexCount > 0) mesh.submeshes.push_back(sub);
+        }
+    }
+    if (mesh.indices.empty()) return false;
+
+    mesh.boundsMin = mesh.boundsMax = glm::vec3(mesh.vertices[0], mesh.vertices[1], mesh.vertices[2]);
+    for (size_t i = 0; i < mesh.VertexCount(); ++i) {
+        glm::vec3 p(mesh.vertices[i * MESH_VERTEX_FLOATS], mesh.vertices[i * MESH_VERTEX_FLOATS + 1], mesh.vertices[i * MESH_VERTEX_FLOATS + 2]);
+        mesh.boundsMin = glm::min(mesh.boundsMin, p);
+        mesh.boundsMax = glm::max(mesh.boundsMax, p);
+    }
+    return true;
+}
@@ -0,0 +1,164 @@
+#include "../include/gpu_mesh.h"
+#include "../include/log.h"
+#include "../include/shader.h"
+#include "../include/vertex_quantize.h"
+#include <algorithm>
+
+namespace {
+    size_t IndexSize(GLenum type) {
+        return (type == GL_UNSIGNED_SHORT) ? 2 : (type == GL_UNSIGNED_BYTE) ? 1 : 4;
+    }
+
+    // Attribute pointers for each vertex format (VAO and VBO must be bound)
+    void SetupAttributes(VertexFormat format) {
+        switch (format) {
+        case VertexFormat::Float8:
+        default: {
+            const GLsizei stride = 8 * sizeof(float);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+            break;
+        }
+        // packed layouts: the vertex fetch normalizes the snorm values, the shader
+        // applies the bounds and decodes the octahedral normal (2 components, z reads as 0)
+        case VertexFormat::Packed16: {
+            const GLsizei stride = 16;
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)8);
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)12);
+            break;
+        }
+        case VertexFormat::Packed12: {
+            const GLsizei stride = 12;
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_BYTE, GL_TRUE, stride, (void*)6);
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)8);
+            break;
+        }
+        }
+    }
+}
+
+GpuMesh::~GpuMesh() {
+    Release();
+}
+
+size_t GpuMesh::VertexStride(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Packed16: return 16;
+    case VertexFormat::Packed12: return 12;
+    case VertexFormat::Float8:
+    default: return 8 * sizeof(float);
+    }
+}
+
+bool GpuMesh::Upload(VertexFormat format, const void* vertices, size_t vertexCount,
+    const void* indices, size_t indexCount, GLenum indexType)
+{
+    Release();
+    if (!vertices || vertexCount == 0 || !indices || indexCount == 0) {
+        LOG_WARNING("GpuMesh: nothing to upload");
+        return false;
+    }
+    m_format = format;
+    m_vertexCount = vertexCount;
+    m_indexCount = indexCount;
+    m_indexType = indexType;
+    size_t vertexBytes = vertexCount * VertexStride(format);
+    size_t indexBytes = indexCount * IndexSize(indexType);
+    m_gpuBytes = vertexBytes + indexBytes;
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ebo);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexBytes), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indexBytes), indices, GL_STATIC_DRAW);
+    SetupAttributes(format);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // default: one submesh covering everything
+    m_submeshes.assign(1, MeshSubmesh{ 0, static_cast<uint32_t>(indexCount), -1 });
+    m_lods.clear();
+    return true;
+}
+
+bool GpuMesh::Upload(const MeshData& mesh, VertexFormat format) {
+    bool ok;
+    if (format == VertexFormat::Float8) {
+        ok = Upload(VertexFormat::Float8, mesh.vertices.data(), mesh.VertexCount(),
+            mesh.indices.data(), mesh.indices.size(), GL_UNSIGNED_INT);
+    }
+    else {
+        std::vector<uint8_t> packed;
+        ok = VertexQuantize::Encode(format, mesh.vertices.data(), mesh.VertexCount(), mesh.boundsMin, mesh.boundsMax, packed)
+            && Upload(format, packed.data(), mesh.VertexCount(), mesh.indices.data(), mesh.indices.size(), GL_UNSIGNED_INT);
+    }
+    if (!ok) return false;
+    SetBounds(mesh.boundsMin, mesh.boundsMax);
+    if (!mesh.submeshes.empty()) SetSubmeshes(mesh.submeshes, mesh.lods);
+    return true;
+}
+
+void GpuMesh::SetBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    m_boundsMin = boundsMin;
+    m_boundsMax = boundsMax;
+}
+
+void GpuMesh::ApplyDecodeUniforms(const Shader& shader) const {
+    if (!VertexQuantize::IsPacked(m_format)) {
+        shader.SetUniformInt("u_vertexFormat", 0);
+        return;
+    }
+    VertexQuantize::DecodeParams params = VertexQuantize::BoundsParams(m_boundsMin, m_boundsMax);
+    shader.SetUniformInt("u_vertexFormat", 1);
+    shader.setVec3("u_posCenter", params.center);
+    shader.setVec3("u_posExtent", params.extent);
+}
+
+void GpuMesh::SetSubmeshes(std::vector<MeshSubmesh> submeshes, std::vector<MeshLod> lods) {
+    m_submeshes = std::move(submeshes);
+    m_lods = std::move(lods);
+}
+
+void GpuMesh::DrawSubmesh(const MeshSubmesh& submesh) const {
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(submesh.indexCount), m_indexType,
+        reinterpret_cast<const void*>(static_cast<size_t>(submesh.indexOffset) * IndexSize(m_indexType)));
+}
+
+void GpuMesh::Draw(int lod) const {
+    if (!m_vao) return;
+    glBindVertexArray(m_vao);
+    size_t first = 0, count = m_submeshes.size();
+    if (!m_lods.empty()) {
+        const MeshLod& level = m_lods[std::clamp(lod, 0, static_cast<int>(m_lods.size()) - 1)];
+        first = level.submeshOffset;
+        count = level.submeshCount;
+    }
+    for (size_t i = first; i < first + count && i < m_submeshes.size(); ++i) DrawSubmesh(m_submeshes[i]);
+    glBindVertexArray(0);
+}
+
+void GpuMesh::Release() {
+    if (m_ebo) glDeleteBuffers(1, &m_ebo);
+    if (m_vbo) glDeleteBuffers(1, &m_vbo);
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+    m_vao = m_vbo = m_ebo = 0;
+    m_vertexCount = m_indexCount = m_gpuBytes = 0;
+    m_submeshes.clear();
+    m_lods.clear();
+}
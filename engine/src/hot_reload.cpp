@@ -0,0 +1,57 @@
+#include "../include/hot_reload.h"
+#include "../include/file_watcher.h"
+#include "../include/log.h"
+#include "../include/shader.h"
+#include "../include/textures.h"
+#include "../include/vfs.h"
+#include <string>
+#include <vector>
+
+namespace {
+    FileWatcher s_watcher;
+    std::vector<std::string> s_mountPoints;   // per watched root, prefix of its virtual paths
+}
+
+bool HotReload::Start(int debounceMs) {
+    Stop();
+    std::vector<std::string> roots;
+    for (const Vfs::DirectoryMount& mount : Vfs::DirectoryMounts()) {
+        roots.push_back(mount.root);
+        s_mountPoints.push_back(mount.mountPoint);
+    }
+    if (roots.empty()) {
+        LOG_INFO("HotReload: no asset folders mounted, nothing to watch");
+        return false;
+    }
+    if (!s_watcher.Start(roots, debounceMs)) {
+        s_mountPoints.clear();
+        return false;
+    }
+    return true;
+}
+
+void HotReload::Stop() {
+    s_watcher.Stop();
+    s_mountPoints.clear();
+}
+
+bool HotReload::IsRunning() {
+    return s_watcher.IsRunning();
+}
+
+int HotReload::Update() {
+    std::vector<FileWatcher::Change> changes = s_watcher.TakeChanges();
+    if (changes.empty()) return 0;
+
+    // new files may shadow others now, resolve everything again
+    Vfs::Invalidate();
+    int reloaded = 0;
+    for (const FileWatcher::Change& change : changes) {
+        // only assets something has asked for have an id
+        Vfs::AssetId asset = Vfs::Find(s_mountPoints[change.root] + change.path);
+        if (asset == Vfs::kInvalidAsset) continue;
+        if (TextureManager::Reload(asset)) ++reloaded;
+        reloaded += Shader::ReloadFile(asset);
+    }
+    return reloaded;
+}
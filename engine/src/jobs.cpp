@@ -0,0 +1,136 @@
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Internal pool state: one shared queue guarded by a mutex, workers sleep on a condition variable
+namespace {
+    static std::vector<std::thread> s_workers;
+    static std::deque<std::function<void()>> s_queue;
+    static std::mutex s_queueMutex;
+    static std::condition_variable s_queueCv;
+    static bool s_stopping = false;
+    static std::mutex s_poolMutex;                 // guards starting and stopping the workers
+    static std::atomic<unsigned> s_workerCount{ 0 }; // 0 = not running, Init starts them (again)
+
+    void WorkerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lk(s_queueMutex);
+                s_queueCv.wait(lk, [] { return s_stopping || !s_queue.empty(); });
+                if (s_stopping && s_queue.empty()) return;
+                task = std::move(s_queue.front());
+                s_queue.pop_front();
+            }
+            task();
+        }
+    }
+
+    void EnsureStarted() {
+        if (s_workerCount.load() == 0) Jobs::Init();
+    }
+}
+
+void Jobs::Init(unsigned workerCount) {
+    std::lock_guard<std::mutex> pool(s_poolMutex);
+    if (!s_workers.empty()) return; // already running
+    unsigned count = workerCount;
+    if (count == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        count = (hw > 1) ? hw - 1 : 1; // leave the main thread for GL + ImGui
+    }
+    {
+        std::lock_guard<std::mutex> lk(s_queueMutex);
+        s_stopping = false;
+    }
+    s_workers.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+        s_workers.emplace_back(WorkerLoop);
+    }
+    s_workerCount = count;
+    LOG_INFO("Jobs: started " << count << " worker threads");
+}
+
+void Jobs::Shutdown() {
+    std::lock_guard<std::mutex> pool(s_poolMutex);
+    if (s_workers.empty()) return;
+    {
+        std::lock_guard<std::mutex> lk(s_queueMutex);
+        s_stopping = true;
+    }
+    s_queueCv.notify_all();
+    // the workers drain the queue before they exit
+    for (auto& t : s_workers) {
+        if (t.joinable()) t.join();
+    }
+    s_workers.clear();
+    s_workerCount = 0;
+}
+
+unsigned Jobs::WorkerCount() {
+    return s_workerCount.load();
+}
+
+void Jobs::Submit(std::function<void()> task) {
+    EnsureStarted();
+    {
+        std::lock_guard<std::mutex> lk(s_queueMutex);
+        s_queue.push_back(std::move(task));
+    }
+    s_queueCv.notify_one();
+}
+
+void Jobs::ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) return;
+    if (batchSize == 0) batchSize = 1;
+    const size_t batches = (count + batchSize - 1) / batchSize;
+
+    // Small jobs are not worth the hand-off
+    if (batches == 1) {
+        fn(0, count);
+        return;
+    }
+    EnsureStarted();
+
+    // Shared so helpers that start after the caller has returned never touch freed memory
+    struct State {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::mutex m;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+    const auto* fnPtr = &fn;
+
+    // Grab batches until none are left. Returns only once our own batches are finished.
+    auto drain = [state, fnPtr, count, batchSize, batches]() {
+        for (;;) {
+            size_t b = state->next.fetch_add(1);
+            if (b >= batches) return;
+            size_t begin = b * batchSize;
+            size_t end = (begin + batchSize < count) ? begin + batchSize : count;
+            (*fnPtr)(begin, end);
+            if (state->done.fetch_add(1) + 1 == batches) {
+                std::lock_guard<std::mutex> lk(state->m);
+                state->cv.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = batches - 1;
+    if (helpers > s_workerCount.load()) helpers = s_workerCount.load();
+    for (size_t i = 0; i < helpers; ++i) {
+        Submit(drain);
+    }
+
+    drain(); // calling thread works too
+
+    std::unique_lock<std::mutex> lk(state->m);
+    state->cv.wait(lk, [&]() { return state->done.load() == batches; });
+}
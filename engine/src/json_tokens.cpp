@@ -0,0 +1,235 @@
+#include "../include/json_tokens.h"
+#include "../include/text_parse.h"
+#include <limits>
+
+namespace {
+    bool IsDelimiter(char c) {
+        return c == ',' || c == ']' || c == '}' || c == ':' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Append the UTF-8 encoding of a code point
+    void AppendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) out += static_cast<char>(cp);
+        else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    uint32_t Hex4(const char* p) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = p[i];
+            v <<= 4;
+            if (c >= '0' && c <= '9') v |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') v |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') v |= static_cast<uint32_t>(c - 'A' + 10);
+        }
+        return v;
+    }
+}
+
+bool JsonDocument::Parse(const char* text, size_t size) {
+    m_text = text;
+    m_tokens.clear();
+    m_error.clear();
+    if (size >= 0xFFFFFFFFu) {
+        m_error = "document too large";
+        return false;
+    }
+    m_tokens.reserve(size / 8 + 16); // glTF JSON averages well over 8 bytes per token
+
+    std::vector<uint32_t> stack; // open containers
+    stack.reserve(64);
+    auto addToken = [&](JsonToken::Type type, size_t start, size_t end) {
+        if (!stack.empty()) m_tokens[stack.back()].size++;
+        JsonToken t;
+        t.type = type;
+        t.start = static_cast<uint32_t>(start);
+        t.end = static_cast<uint32_t>(end);
+        t.next = static_cast<uint32_t>(m_tokens.size() + 1);
+        m_tokens.push_back(t);
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        char c = text[i];
+        switch (c) {
+        case '{':
+        case '[':
+            addToken(c == '{' ? JsonToken::Object : JsonToken::Array, i, i);
+            stack.push_back(static_cast<uint32_t>(m_tokens.size() - 1));
+            ++i;
+            break;
+        case '}':
+        case ']': {
+            if (stack.empty()) {
+                m_error = "unexpected '" + std::string(1, c) + "' at byte " + std::to_string(i);
+                return false;
+            }
+            JsonToken& open = m_tokens[stack.back()];
+            if ((c == '}') != (open.type == JsonToken::Object) || (open.type == JsonToken::Object && (open.size & 1))) {
+                m_error = "mismatched bracket at byte " + std::to_string(i);
+                return false;
+            }
+            open.end = static_cast<uint32_t>(i + 1);
+            open.next = static_cast<uint32_t>(m_tokens.size());
+            stack.pop_back();
+            ++i;
+            break;
+        }
+        case '"': {
+            size_t start = ++i;
+            while (i < size && text[i] != '"') {
+                if (text[i] == '\\') ++i; // skip the escaped char, resolved later by String()
+                ++i;
+            }
+            if (i >= size) {
+                m_error = "unterminated string at byte " + std::to_string(start - 1);
+                return false;
+            }
+            // inside an object every even child must be a key string
+            addToken(JsonToken::String, start, i);
+            ++i;
+            break;
+        }
+        case ' ': case '\t': case '\r': case '\n': case ':': case ',':
+            ++i;
+            break;
+        default: {
+            if (!(c == '-' || TextParse::IsDigit(c) || c == 't' || c == 'f' || c == 'n')) {
+                m_error = "unexpected character at byte " + std::to_string(i);
+                return false;
+            }
+            if (!stack.empty() && m_tokens[stack.back()].type == JsonToken::Object && (m_tokens[stack.back()].size & 1) == 0) {
+                m_error = "object key must be a string at byte " + std::to_string(i);
+                return false;
+            }
+            size_t start = i;
+            while (i < size && !IsDelimiter(text[i])) ++i;
+            addToken(JsonToken::Primitive, start, i);
+            break;
+        }
+        }
+    }
+    if (!stack.empty()) {
+        m_error = "unexpected end of document";
+        return false;
+    }
+    if (m_tokens.empty()) {
+        m_error = "empty document";
+        return false;
+    }
+    return true;
+}
+
+int JsonDocument::Count(int index) const {
+    if (index < 0) return 0;
+    const JsonToken& t = m_tokens[static_cast<size_t>(index)];
+    if (t.type == JsonToken::Object) return static_cast<int>(t.size / 2);
+    if (t.type == JsonToken::Array) return static_cast<int>(t.size);
+    return 0;
+}
+
+int JsonDocument::Find(int object, std::string_view key) const {
+    if (Type(object) != JsonToken::Object) return -1;
+    for (int k = FirstChild(object); k < End(object); k = Next(k + 1)) {
+        if (Equals(k, key)) return k + 1;
+    }
+    return -1;
+}
+
+int JsonDocument::At(int array, int i) const {
+    if (Type(array) != JsonToken::Array || i < 0 || i >= Count(array)) return -1;
+    int t = FirstChild(array);
+    while (i-- > 0) t = Next(t);
+    return t;
+}
+
+std::string_view JsonDocument::Raw(int index) const {
+    if (index < 0) return std::string_view();
+    const JsonToken& t = m_tokens[static_cast<size_t>(index)];
+    return std::string_view(m_text + t.start, t.end - t.start);
+}
+
+bool JsonDocument::Equals(int index, std::string_view text) const {
+    return Type(index) == JsonToken::String && Raw(index) == text;
+}
+
+std::string JsonDocument::String(int index) const {
+    std::string_view raw = Raw(index);
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\' || i + 1 >= raw.size()) {
+            out += raw[i];
+            continue;
+        }
+        char e = raw[++i];
+        switch (e) {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'u':
+            if (i + 4 < raw.size()) {
+                uint32_t cp = Hex4(raw.data() + i + 1);
+                i += 4;
+                // surrogate pair
+                if (cp >= 0xD800 && cp < 0xDC00 && i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+                    uint32_t lo = Hex4(raw.data() + i + 3);
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    i += 6;
+                }
+                AppendUtf8(out, cp);
+            }
+            break;
+        default: out += e; break; // \" \\ \/
+        }
+    }
+    return out;
+}
+
+double JsonDocument::Number(int index, double fallback) const {
+    if (Type(index) != JsonToken::Primitive) return fallback;
+    std::string_view raw = Raw(index);
+    float value = 0.0f;
+    const char* end = raw.data() + raw.size();
+    return (TextParse::ParseFloat(raw.data(), end, value) == raw.data()) ? fallback : static_cast<double>(value);
+}
+
+int64_t JsonDocument::Int(int index, int64_t fallback) const {
+    if (Type(index) != JsonToken::Primitive) return fallback;
+    std::string_view raw = Raw(index);
+    size_t i = 0;
+    bool negative = !raw.empty() && raw[0] == '-';
+    if (negative) ++i;
+    if (i >= raw.size() || !TextParse::IsDigit(raw[i])) return fallback;
+    int64_t value = 0;
+    for (; i < raw.size() && TextParse::IsDigit(raw[i]); ++i) {
+        const int digit = raw[i] - '0';
+        if (value > (std::numeric_limits<int64_t>::max() - digit) / 10) return fallback; // doesn't fit
+        value = value * 10 + digit;
+    }
+    return negative ? -value : value;
+}
+
+bool JsonDocument::Bool(int index, bool fallback) const {
+    if (Type(index) != JsonToken::Primitive) return fallback;
+    std::string_view raw = Raw(index);
+    if (raw == "true") return true;
+    if (raw == "false") return false;
+    return fallback;
+}
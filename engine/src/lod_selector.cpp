@@ -0,0 +1,43 @@
+#include "../include/lod_selector.h"
+#include <algorithm>
+
+namespace {
+    LodSelector::Settings s_settings;
+}
+
+void LodSelector::SetSettings(const Settings& settings) {
+    s_settings = settings;
+}
+
+const LodSelector::Settings& LodSelector::GetSettings() {
+    return s_settings;
+}
+
+float LodSelector::PixelError(const MeshLod& lod, float radius, float projectedRadius) {
+    return radius > 0.0f ? lod.error / radius * projectedRadius : 0.0f;
+}
+
+int LodSelector::Select(const std::vector<MeshLod>& lods, float radius, float projectedRadius) {
+    if (lods.size() <= 1) return m_current = 0;
+    const int last = static_cast<int>(lods.size()) - 1;
+    m_current = std::clamp(m_current, 0, last);
+
+    // coarsest level under a threshold (errors grow with the level)
+    auto coarsest = [&](float threshold) {
+        int level = 0;
+        for (int i = 1; i <= last; ++i) {
+            if (PixelError(lods[i], radius, projectedRadius) <= threshold) level = i;
+        }
+        return level;
+    };
+
+    if (PixelError(lods[m_current], radius, projectedRadius) > s_settings.pixelError) {
+        // too coarse for this size, refine straight away
+        m_current = coarsest(s_settings.pixelError);
+    }
+    else {
+        // only coarsen once the next level is comfortably inside the threshold
+        m_current = std::max(m_current, coarsest(s_settings.pixelError * (1.0f - s_settings.hysteresis)));
+    }
+    return m_current;
+}
@@ -0,0 +1,139 @@
+#include "../include/lz4.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr size_t kMinMatch = 4;
+    constexpr size_t kLastLiterals = 5;   // the block always ends with 5+ literal bytes
+    constexpr size_t kMatchLimit = 12;    // no match may start in the last 12 bytes
+    constexpr size_t kMaxOffset = 65535;
+    constexpr int kHashBits = 16;
+
+    uint32_t Read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint32_t Hash(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - kHashBits);
+    }
+
+    // 15 in the token nibble, then 255s, then the rest
+    bool WriteLength(size_t length, uint8_t*& op, const uint8_t* end) {
+        for (; length >= 255; length -= 255) {
+            if (op >= end) return false;
+            *op++ = 255;
+        }
+        if (op >= end) return false;
+        *op++ = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    bool ReadLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+        uint8_t b;
+        do {
+            if (ip >= end) return false;
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    }
+
+    bool EmitSequence(const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength,
+        uint8_t*& op, const uint8_t* end)
+    {
+        if (op >= end) return false;
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>((literalCount >= 15 ? 15 : literalCount) << 4);
+        if (literalCount >= 15 && !WriteLength(literalCount - 15, op, end)) return false;
+        if (static_cast<size_t>(end - op) < literalCount) return false;
+        std::memcpy(op, literals, literalCount);
+        op += literalCount;
+        if (matchLength == 0) return true; // last sequence: literals only
+
+        if (end - op < 2) return false;
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        size_t rest = matchLength - kMinMatch;
+        *token |= static_cast<uint8_t>(rest >= 15 ? 15 : rest);
+        return rest < 15 || WriteLength(rest - 15, op, end);
+    }
+}
+
+size_t Lz4::CompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t Lz4::Compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    uint8_t* op = dst;
+    const uint8_t* end = dst + capacity;
+    size_t anchor = 0;
+
+    if (size > kMatchLimit) {
+        std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+        const size_t matchStartLimit = size - kMatchLimit;
+        const size_t matchEndLimit = size - kLastLiterals;
+        size_t ip = 0;
+        while (ip < matchStartLimit) {
+            uint32_t sequence = Read32(src + ip);
+            uint32_t h = Hash(sequence);
+            size_t ref = table[h];
+            table[h] = static_cast<uint32_t>(ip);
+            if (ref >= ip || ip - ref > kMaxOffset || Read32(src + ref) != sequence) {
+                // skip faster through data that doesn't compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            // extend backwards over pending literals, then forwards
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) { --ip; --ref; }
+            size_t length = kMinMatch;
+            while (ip + length < matchEndLimit && src[ref + length] == src[ip + length]) ++length;
+
+            if (!EmitSequence(src + anchor, ip - anchor, ip - ref, length, op, end)) return 0;
+            ip += length;
+            anchor = ip;
+            if (ip >= 2 && ip < matchStartLimit) table[Hash(Read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+        }
+    }
+    if (!EmitSequence(src + anchor, size - anchor, 0, 0, op, end)) return 0;
+    return static_cast<size_t>(op - dst);
+}
+
+bool Lz4::Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    const uint8_t* ip = src;
+    const uint8_t* ipEnd = src + srcSize;
+    uint8_t* op = dst;
+    const uint8_t* opEnd = dst + dstSize;
+
+    while (ip < ipEnd) {
+        const uint8_t token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !ReadLength(ip, ipEnd, literals)) return false;
+        if (static_cast<size_t>(ipEnd - ip) < literals || static_cast<size_t>(opEnd - op) < literals) return false;
+        std::memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == ipEnd) break; // last sequence has no match
+
+        if (ipEnd - ip < 2) return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+        size_t length = token & 15;
+        if (length == 15 && !ReadLength(ip, ipEnd, length)) return false;
+        length += kMinMatch;
+        if (static_cast<size_t>(opEnd - op) < length) return false;
+
+        const uint8_t* match = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, match, length);
+            op += length;
+        }
+        else {
+            // overlapping copy repeats the last `offset` bytes
+            for (size_t i = 0; i < length; ++i) *op++ = match[i];
+        }
+    }
+    return op == opEnd;
+}
@@ -0,0 +1,139 @@
+#include "../include/mapped_file.h"
+#include "../include/log.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_open, other.m_open);
+        std::swap(m_mapped, other.m_mapped);
+        std::swap(m_buffer, other.m_buffer);
+        std::swap(m_owner, other.m_owner);
+#ifdef _WIN32
+        std::swap(m_file, other.m_file);
+        std::swap(m_mapping, other.m_mapping);
+#else
+        std::swap(m_fd, other.m_fd);
+#endif
+    }
+    return *this;
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_WARNING("MappedFile: cannot open " << path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_size = static_cast<size_t>(size.QuadPart);
+    m_open = true;
+    if (m_size == 0) return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        LOG_WARNING("MappedFile: CreateFileMapping failed for " << path);
+        Close();
+        return false;
+    }
+    m_mapping = mapping;
+    m_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_WARNING("MappedFile: cannot open " << path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_size = static_cast<size_t>(st.st_size);
+    m_open = true;
+    if (m_size == 0) return true;
+
+    void* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    m_data = (view == MAP_FAILED) ? nullptr : view;
+    if (m_data) madvise(m_data, m_size, MADV_SEQUENTIAL);
+#endif
+    m_mapped = m_data != nullptr;
+    if (!m_data) {
+        LOG_WARNING("MappedFile: mapping failed for " << path);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::OpenView(const void* data, size_t size, std::shared_ptr<const void> owner) {
+    Close();
+    m_owner = std::move(owner);
+    m_data = const_cast<void*>(data);
+    m_size = size;
+    m_open = true;
+    return true;
+}
+
+bool MappedFile::OpenBuffer(std::vector<uint8_t>&& buffer) {
+    Close();
+    m_buffer = std::move(buffer);
+    m_data = m_buffer.empty() ? nullptr : m_buffer.data();
+    m_size = m_buffer.size();
+    m_open = true;
+    return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (m_data && m_mapped) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(static_cast<HANDLE>(m_mapping));
+    if (m_file) CloseHandle(static_cast<HANDLE>(m_file));
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_data && m_mapped) munmap(m_data, m_size);
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+    m_mapped = false;
+    m_buffer.clear();
+    m_owner.reset();
+}
@@ -0,0 +1,134 @@
+#include "../include/mesh_cache.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include "../include/mesh_file.h"
+#include "../include/vfs.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // uploads are one glBufferData per buffer, but big models still cost a few ms each
+    constexpr size_t kMaxUploadsPerFrame = 2;
+
+    struct LoadResult {
+        Vfs::AssetId asset = Vfs::kInvalidAsset;
+        std::unique_ptr<CookedMesh> cooked;   // mapped and checked, nullptr = failed
+        double seconds = 0.0;
+    };
+
+    std::mutex s_mutex;                        // guards s_results, the only state workers touch
+    std::vector<LoadResult> s_results;
+    std::unordered_map<Vfs::AssetId, std::weak_ptr<LoadedMesh>> s_meshes;
+    std::unordered_set<Vfs::AssetId> s_inFlight; // on the workers; a mesh acquired again meanwhile waits for that load
+    int s_loading = 0;
+
+    bool IsCooked(const std::string& path) {
+        std::string ext = fs::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext == MeshFile::kExtension;
+    }
+
+    // Worker: cook when needed, then map and verify the cooked file
+    void Load(Vfs::AssetId asset, const std::string& path) {
+        const auto t0 = std::chrono::steady_clock::now();
+        LoadResult result;
+        result.asset = asset;
+        const std::string cookedPath = IsCooked(path) ? path : MeshFile::CookedPath(path);
+        if (cookedPath == path || MeshFile::IsUpToDate(path, cookedPath) || MeshFile::Cook(path, cookedPath)) {
+            auto cooked = std::make_unique<CookedMesh>();
+            if (cooked->Open(cookedPath)) result.cooked = std::move(cooked);
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_results.push_back(std::move(result));
+    }
+}
+
+LoadedMesh::~LoadedMesh() {
+    for (TextureHandle handle : textures) {
+        if (handle != INVALID_TEXTURE) TextureManager::Release(handle);
+    }
+}
+
+std::shared_ptr<const LoadedMesh> MeshCache::Acquire(const std::string& path) {
+    const Vfs::AssetId asset = Vfs::Intern(path);
+    if (asset == Vfs::kInvalidAsset) return nullptr;
+    std::weak_ptr<LoadedMesh>& entry = s_meshes[asset];
+    if (std::shared_ptr<LoadedMesh> mesh = entry.lock()) return mesh;
+
+    auto mesh = std::make_shared<LoadedMesh>();
+    entry = mesh;
+    // dropped and acquired again while its load still runs: that load fills the new mesh
+    if (!s_inFlight.insert(asset).second) return mesh;
+    ++s_loading;
+    const std::string name = Vfs::Name(asset);
+    Jobs::Submit([asset, name]() { Load(asset, name); });
+    return mesh;
+}
+
+void MeshCache::Update() {
+    std::vector<LoadResult> ready;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        const size_t count = std::min(s_results.size(), kMaxUploadsPerFrame);
+        for (size_t i = 0; i < count; ++i) ready.push_back(std::move(s_results[i]));
+        s_results.erase(s_results.begin(), s_results.begin() + count);
+    }
+
+    for (LoadResult& r : ready) {
+        --s_loading;
+        s_inFlight.erase(r.asset);
+        auto it = s_meshes.find(r.asset);
+        std::shared_ptr<LoadedMesh> mesh = (it != s_meshes.end()) ? it->second.lock() : nullptr;
+        // every user let go while it loaded
+        if (!mesh || mesh->IsReady()) continue;
+        const std::string& path = Vfs::Name(r.asset);
+        if (!r.cooked || !r.cooked->Upload(mesh->gpu)) {
+            mesh->failed = true;
+            LOG_WARNING("MeshCache: could not load " << path);
+            continue;
+        }
+        // textures decode on the workers, the mesh draws with its base colours until they land
+        mesh->materials = r.cooked->Materials();
+        for (const MeshMaterial& material : mesh->materials) {
+            mesh->textures.push_back(material.diffuseTexture.empty() ? INVALID_TEXTURE : TextureManager::AcquireAsync(material.diffuseTexture));
+        }
+        mesh->center = (mesh->gpu.BoundsMin() + mesh->gpu.BoundsMax()) * 0.5f;
+        mesh->radius = glm::length(mesh->gpu.BoundsMax() - mesh->gpu.BoundsMin()) * 0.5f;
+        LOG_INFO("MeshCache: Loaded " << path << " (" << mesh->gpu.VertexCount() << " vertices, "
+            << mesh->gpu.LodCount() << " LODs) in " << r.seconds * 1000.0 << " ms");
+    }
+
+    // forget meshes nobody draws any more
+    for (auto it = s_meshes.begin(); it != s_meshes.end();) {
+        if (it->second.expired()) it = s_meshes.erase(it);
+        else ++it;
+    }
+}
+
+void MeshCache::Shutdown() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_loading -= static_cast<int>(s_results.size());
+    s_results.clear();
+    s_inFlight.clear();
+}
+
+MeshCache::Stats MeshCache::GetStats() {
+    Stats stats;
+    stats.loading = s_loading;
+    for (const auto& entry : s_meshes) {
+        std::shared_ptr<LoadedMesh> mesh = entry.second.lock();
+        if (!mesh) continue;
+        ++stats.meshes;
+        stats.gpuBytes += mesh->gpu.GpuBytes();
+    }
+    return stats;
+}
@@ -0,0 +1,437 @@
+#include "../include/mesh_file.h"
+#include "../include/asset_path.h"
+#include "../include/gltf_loader.h"
+#include "../include/gpu_mesh.h"
+#include "../include/hash.h"
+#include "../include/log.h"
+#include "../include/mesh_optimize.h"
+#include "../include/mesh_simplify.h"
+#include "../include/obj_loader.h"
+#include "../include/vertex_quantize.h"
+#include "../include/vfs.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    VertexFormat s_cookFormat = VertexFormat::Float8;
+    int s_cookLodCount = 1;
+    std::atomic<unsigned> s_tempCounter{ 0 }; // two cooks of one file never share a temp file
+
+    size_t Align16(size_t v) { return (v + 15) & ~size_t(15); }
+
+    double Seconds(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double>(b - a).count();
+    }
+
+    std::string LowerExtension(const std::string& path) {
+        std::string ext = fs::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext;
+    }
+
+    // Append a string to the blob, return its (offset, length)
+    void AddString(std::vector<char>& blob, const std::string& s, uint32_t out[2]) {
+        out[0] = static_cast<uint32_t>(blob.size());
+        out[1] = static_cast<uint32_t>(s.size());
+        blob.insert(blob.end(), s.begin(), s.end());
+    }
+
+    // Texture paths are stored relative to the cooked file so cooked assets can move as a folder
+    std::string RelativeTo(const std::string& path, const std::string& dir) {
+        if (path.empty()) return path;
+        fs::path rel = fs::path(path).lexically_relative(dir);
+        return rel.empty() ? path : rel.generic_string();
+    }
+
+    // Write via a temp file + rename so readers never see half a file
+    bool WriteReplacing(const std::string& path, const void* data, size_t size) {
+        std::string tmp = path + "." + std::to_string(s_tempCounter.fetch_add(1)) + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size))) {
+                LOG_ERROR("MeshFile: failed to write " << tmp);
+                out.close();
+                std::error_code ec;
+                fs::remove(tmp, ec);
+                return false;
+            }
+        }
+        std::error_code ec;
+        fs::rename(tmp, path, ec);
+        if (ec) {
+            LOG_ERROR("MeshFile: failed to replace " << path << ": " << ec.message());
+            fs::remove(tmp, ec);
+            return false;
+        }
+        // a miss for the file may be cached from before it existed
+        Vfs::Invalidate(Vfs::Find(path));
+        return true;
+    }
+}
+
+std::string MeshFile::CookedPath(const std::string& sourcePath) {
+    return fs::path(sourcePath).replace_extension(kExtension).generic_string();
+}
+
+bool MeshFile::IsUpToDate(const std::string& sourcePath, const std::string& cookedPath) {
+    // packs and memory mounts hold cooked output only, whatever they have is current
+    Vfs::Location cooked = Vfs::Resolve(Vfs::Intern(cookedPath));
+    if (cooked.found && cooked.kind != Vfs::MountKind::Directory) return true;
+    std::error_code ec;
+    if (!fs::exists(cookedPath, ec)) return false;
+    if (fs::exists(sourcePath, ec) && fs::last_write_time(sourcePath, ec) > fs::last_write_time(cookedPath, ec)) return false;
+
+    // header only: version check, no checksum
+    std::ifstream in(cookedPath, std::ios::binary);
+    Header header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion
+        && header.cookFormat == static_cast<uint32_t>(s_cookFormat)
+        && header.cookLodCount == static_cast<uint32_t>(s_cookLodCount);
+}
+
+void MeshFile::SetCookFormat(VertexFormat format) {
+    s_cookFormat = format;
+}
+
+VertexFormat MeshFile::CookFormat() {
+    return s_cookFormat;
+}
+
+void MeshFile::SetCookLodCount(int lodCount) {
+    s_cookLodCount = std::max(lodCount, 1);
+}
+
+int MeshFile::CookLodCount() {
+    return s_cookLodCount;
+}
+
+bool MeshFile::ImportSource(const std::string& sourcePath, MeshData& mesh) {
+    std::string ext = LowerExtension(sourcePath);
+    if (ext == ".obj") return ObjLoader::Load(sourcePath, mesh);
+    if (ext == ".gltf" || ext == ".glb") {
+        GltfModel model;
+        return model.Load(sourcePath) && model.ToMeshData(mesh);
+    }
+    if (ext == kExtension) return Read(sourcePath, mesh);
+    LOG_ERROR("MeshFile: unsupported model format " << sourcePath);
+    return false;
+}
+
+bool MeshFile::Write(const std::string& path, const MeshData& mesh, VertexFormat format) {
+    if (mesh.indices.empty() || mesh.vertices.empty()) {
+        LOG_ERROR("MeshFile: refusing to write an empty mesh to " << path);
+        return false;
+    }
+    const size_t vertexCount = mesh.VertexCount();
+    const bool shortIndices = vertexCount <= 0xFFFF;
+    const size_t indexSize = shortIndices ? 2 : 4;
+    const std::string dir = fs::path(path).parent_path().generic_string();
+
+    // vertex blob in the requested layout
+    VertexFormat vertexFormat = format;
+    std::vector<uint8_t> packed;
+    if (VertexQuantize::IsPacked(format)) {
+        VertexQuantize::ErrorReport error = VertexQuantize::Measure(format, mesh, path.c_str());
+        if (error.maxUvError > VertexQuantize::kMaxUvError) {
+            LOG_WARNING("MeshFile: uvs of " << path << " need full precision, keeping Float8 vertices");
+            vertexFormat = VertexFormat::Float8;
+        }
+        else if (!VertexQuantize::Encode(format, mesh.vertices.data(), vertexCount, mesh.boundsMin, mesh.boundsMax, packed)) {
+            return false;
+        }
+    }
+    const size_t vertexBytes = vertexCount * GpuMesh::VertexStride(vertexFormat);
+    const void* vertexData = packed.empty() ? static_cast<const void*>(mesh.vertices.data()) : packed.data();
+
+    // section records
+    std::vector<SubmeshRecord> submeshes;
+    if (mesh.submeshes.empty()) {
+        submeshes.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), -1, 0 });
+    }
+    for (const MeshSubmesh& s : mesh.submeshes) submeshes.push_back({ s.indexOffset, s.indexCount, s.materialIndex, 0 });
+    std::vector<LodRecord> lods;
+    for (const MeshLod& l : mesh.lods) lods.push_back({ l.submeshOffset, l.submeshCount, l.error, 0 });
+    if (lods.empty()) lods.push_back({ 0, static_cast<uint32_t>(submeshes.size()), 0.0f, 0 });
+
+    // embedded images become files next to the cooked mesh (crate.spxmesh -> crate.image0.png)
+    std::unordered_map<std::string, std::string> imageFiles;
+    for (const MeshImage& image : mesh.images) {
+        std::string suffix = image.name.substr(image.name.rfind('#') + 1);
+        std::string file = fs::path(path).replace_extension("." + suffix + image.extension).generic_string();
+        if (!WriteReplacing(file, image.bytes.data(), image.bytes.size())) return false;
+        imageFiles[image.name] = file;
+    }
+    auto texturePath = [&](const std::string& texture) {
+        auto it = imageFiles.find(texture);
+        return RelativeTo(it != imageFiles.end() ? it->second : texture, dir);
+    };
+
+    std::vector<char> strings;
+    std::vector<MaterialRecord> materials;
+    for (const MeshMaterial& m : mesh.materials) {
+        MaterialRecord r{};
+        for (int i = 0; i < 3; ++i) {
+            r.ambient[i] = m.ambient[i];
+            r.diffuse[i] = m.diffuse[i];
+            r.specular[i] = m.specular[i];
+        }
+        r.shininess = m.shininess;
+        r.opacity = m.opacity;
+        r.alphaCutoff = m.alphaCutoff;
+        AddString(strings, m.name, r.name);
+        AddString(strings, texturePath(m.diffuseTexture), r.diffuseTexture);
+        AddString(strings, texturePath(m.normalTexture), r.normalTexture);
+        materials.push_back(r);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(Header);
+    header.vertexFormat = static_cast<uint32_t>(vertexFormat);
+    header.cookFormat = static_cast<uint32_t>(format);
+    header.vertexStride = static_cast<uint32_t>(GpuMesh::VertexStride(vertexFormat));
+    header.vertexCount = static_cast<uint32_t>(vertexCount);
+    header.indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.submeshCount = static_cast<uint32_t>(submeshes.size());
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.materialCount = static_cast<uint32_t>(materials.size());
+    header.cookLodCount = static_cast<uint32_t>(s_cookLodCount);
+    for (int i = 0; i < 3; ++i) {
+        header.boundsMin[i] = mesh.boundsMin[i];
+        header.boundsMax[i] = mesh.boundsMax[i];
+    }
+
+    size_t offset = Align16(sizeof(Header));
+    header.vertexOffset = offset;   offset = Align16(offset + vertexBytes);
+    header.indexOffset = offset;    offset = Align16(offset + mesh.indices.size() * indexSize);
+    header.submeshOffset = offset;  offset = Align16(offset + submeshes.size() * sizeof(SubmeshRecord));
+    header.lodOffset = offset;      offset = Align16(offset + lods.size() * sizeof(LodRecord));
+    header.materialOffset = offset; offset = Align16(offset + materials.size() * sizeof(MaterialRecord));
+    header.stringOffset = offset;
+    header.stringBytes = strings.size();
+    offset = Align16(offset + strings.size());
+    header.payloadBytes = offset - sizeof(Header);
+
+    // build the whole file in memory, it is written with a single call
+    std::vector<char> file(offset, 0);
+    std::memcpy(file.data() + header.vertexOffset, vertexData, vertexBytes);
+    if (shortIndices) {
+        uint16_t* dst = reinterpret_cast<uint16_t*>(file.data() + header.indexOffset);
+        for (size_t i = 0; i < mesh.indices.size(); ++i) dst[i] = static_cast<uint16_t>(mesh.indices[i]);
+    }
+    else {
+        std::memcpy(file.data() + header.indexOffset, mesh.indices.data(), mesh.indices.size() * 4);
+    }
+    std::memcpy(file.data() + header.submeshOffset, submeshes.data(), submeshes.size() * sizeof(SubmeshRecord));
+    std::memcpy(file.data() + header.lodOffset, lods.data(), lods.size() * sizeof(LodRecord));
+    if (!materials.empty()) std::memcpy(file.data() + header.materialOffset, materials.data(), materials.size() * sizeof(MaterialRecord));
+    if (!strings.empty()) std::memcpy(file.data() + header.stringOffset, strings.data(), strings.size());
+    header.checksum = Hash::Bytes64(file.data() + sizeof(Header), header.payloadBytes);
+    std::memcpy(file.data(), &header, sizeof(Header));
+
+    return WriteReplacing(path, file.data(), file.size());
+}
+
+bool MeshFile::Cook(const std::string& sourcePath, const std::string& cookedPath) {
+    auto t0 = Clock::now();
+    MeshData mesh;
+    if (!ImportSource(sourcePath, mesh)) return false;
+    // LOD chain first so the optimisers below reorder the LOD index ranges too
+    MeshSimplify::LodSettings lodSettings;
+    lodSettings.lodCount = s_cookLodCount;
+    MeshSimplify::GenerateLods(mesh, lodSettings, sourcePath);
+    // exporters write triangles in any order, fix that once here instead of every draw
+    MeshOptimize::Optimize(mesh, sourcePath);
+    if (!Write(cookedPath, mesh, s_cookFormat)) return false;
+    LOG_INFO("MeshFile: Cooked " << sourcePath << " -> " << cookedPath << " (" << mesh.TriangleCount()
+        << " triangles) in " << Seconds(t0, Clock::now()) * 1000.0 << " ms");
+    return true;
+}
+
+bool MeshFile::Read(const std::string& path, MeshData& mesh) {
+    CookedMesh cooked;
+    if (!cooked.Open(path)) return false;
+    const Header& h = cooked.Header();
+    mesh.Clear();
+    mesh.boundsMin = glm::vec3(h.boundsMin[0], h.boundsMin[1], h.boundsMin[2]);
+    mesh.boundsMax = glm::vec3(h.boundsMax[0], h.boundsMax[1], h.boundsMax[2]);
+    if (!VertexQuantize::Decode(static_cast<VertexFormat>(h.vertexFormat), cooked.Vertices(), h.vertexCount,
+        mesh.boundsMin, mesh.boundsMax, mesh.vertices)) return false;
+    mesh.indices.resize(h.indexCount);
+    if (h.indexType == GL_UNSIGNED_SHORT) {
+        const uint16_t* src = static_cast<const uint16_t*>(cooked.Indices());
+        std::copy(src, src + h.indexCount, mesh.indices.begin());
+    }
+    else {
+        std::memcpy(mesh.indices.data(), cooked.Indices(), static_cast<size_t>(h.indexCount) * 4);
+    }
+    mesh.submeshes = cooked.Submeshes();
+    mesh.lods = cooked.Lods();
+    if (mesh.lods.size() == 1) mesh.lods.clear(); // single level is implicit in MeshData
+    mesh.materials = cooked.Materials();
+    return true;
+}
+
+bool CookedMesh::Open(const std::string& path, bool verifyChecksum) {
+    Close();
+    if (!OpenAssetFile(path, m_file)) return false;
+    m_dir = fs::path(path).parent_path().generic_string();
+
+    const size_t size = m_file.Size();
+    const MeshFile::Header* h = reinterpret_cast<const MeshFile::Header*>(m_file.Data());
+    auto fail = [&](const char* why) {
+        LOG_WARNING("CookedMesh: " << path << ": " << why);
+        Close();
+        return false;
+    };
+    if (size < sizeof(MeshFile::Header) || std::memcmp(h->magic, MeshFile::kMagic, sizeof(MeshFile::kMagic)) != 0) return fail("not a .spxmesh file");
+    if (h->version != MeshFile::kVersion || h->headerSize != sizeof(MeshFile::Header)) return fail("version mismatch, needs a re-cook");
+    if (h->payloadBytes != size - sizeof(MeshFile::Header)) return fail("truncated");
+
+    // every section must lie inside the file
+    auto inside = [size](uint64_t offset, uint64_t bytes) { return offset <= size && bytes <= size - offset; };
+    size_t indexSize = (h->indexType == GL_UNSIGNED_SHORT) ? 2 : 4;
+    if (h->vertexStride != GpuMesh::VertexStride(static_cast<VertexFormat>(h->vertexFormat))
+        || !inside(h->vertexOffset, uint64_t(h->vertexCount) * h->vertexStride)
+        || !inside(h->indexOffset, uint64_t(h->indexCount) * indexSize)
+        || !inside(h->submeshOffset, uint64_t(h->submeshCount) * sizeof(MeshFile::SubmeshRecord))
+        || !inside(h->lodOffset, uint64_t(h->lodCount) * sizeof(MeshFile::LodRecord))
+        || !inside(h->materialOffset, uint64_t(h->materialCount) * sizeof(MeshFile::MaterialRecord))
+        || !inside(h->stringOffset, h->stringBytes)) {
+        return fail("section out of range");
+    }
+    if (verifyChecksum && Hash::Bytes64(m_file.Data() + sizeof(MeshFile::Header), h->payloadBytes) != h->checksum) {
+        return fail("checksum mismatch");
+    }
+    m_header = h;
+    return true;
+}
+
+void CookedMesh::Close() {
+    m_header = nullptr;
+    m_file.Close();
+}
+
+const void* CookedMesh::Vertices() const {
+    return m_header ? m_file.Data() + m_header->vertexOffset : nullptr;
+}
+
+const void* CookedMesh::Indices() const {
+    return m_header ? m_file.Data() + m_header->indexOffset : nullptr;
+}
+
+std::vector<MeshSubmesh> CookedMesh::Submeshes() const {
+    std::vector<MeshSubmesh> out;
+    if (!m_header) return out;
+    const MeshFile::SubmeshRecord* r = reinterpret_cast<const MeshFile::SubmeshRecord*>(m_file.Data() + m_header->submeshOffset);
+    for (uint32_t i = 0; i < m_header->submeshCount; ++i) {
+        // clamp so a bad record can never draw outside the index buffer
+        uint32_t offset = std::min(r[i].indexOffset, m_header->indexCount);
+        uint32_t count = std::min(r[i].indexCount, m_header->indexCount - offset);
+        out.push_back({ offset, count, r[i].materialIndex });
+    }
+    return out;
+}
+
+std::vector<MeshLod> CookedMesh::Lods() const {
+    std::vector<MeshLod> out;
+    if (!m_header) return out;
+    const MeshFile::LodRecord* r = reinterpret_cast<const MeshFile::LodRecord*>(m_file.Data() + m_header->lodOffset);
+    for (uint32_t i = 0; i < m_header->lodCount; ++i) {
+        uint32_t offset = std::min(r[i].submeshOffset, m_header->submeshCount);
+        out.push_back({ offset, std::min(r[i].submeshCount, m_header->submeshCount - offset), r[i].error });
+    }
+    return out;
+}
+
+std::string CookedMesh::String(const uint32_t ref[2]) const {
+    if (!m_header || uint64_t(ref[0]) + ref[1] > m_header->stringBytes) return std::string();
+    return std::string(m_file.Data() + m_header->stringOffset + ref[0], ref[1]);
+}
+
+std::vector<MeshMaterial> CookedMesh::Materials() const {
+    std::vector<MeshMaterial> out;
+    if (!m_header) return out;
+    const MeshFile::MaterialRecord* r = reinterpret_cast<const MeshFile::MaterialRecord*>(m_file.Data() + m_header->materialOffset);
+    auto resolve = [this](const std::string& rel) {
+        return rel.empty() ? rel : (fs::path(m_dir) / rel).lexically_normal().generic_string();
+    };
+    for (uint32_t i = 0; i < m_header->materialCount; ++i) {
+        MeshMaterial m;
+        m.ambient = glm::vec3(r[i].ambient[0], r[i].ambient[1], r[i].ambient[2]);
+        m.diffuse = glm::vec3(r[i].diffuse[0], r[i].diffuse[1], r[i].diffuse[2]);
+        m.specular = glm::vec3(r[i].specular[0], r[i].specular[1], r[i].specular[2]);
+        m.shininess = r[i].shininess;
+        m.opacity = r[i].opacity;
+        m.alphaCutoff = r[i].alphaCutoff;
+        m.name = String(r[i].name);
+        m.diffuseTexture = resolve(String(r[i].diffuseTexture));
+        m.normalTexture = resolve(String(r[i].normalTexture));
+        out.push_back(std::move(m));
+    }
+    return out;
+}
+
+bool CookedMesh::Upload(GpuMesh& gpu) const {
+    if (!m_header) return false;
+    if (!gpu.Upload(static_cast<VertexFormat>(m_header->vertexFormat), Vertices(), m_header->vertexCount,
+        Indices(), m_header->indexCount, m_header->indexType)) return false;
+    gpu.SetSubmeshes(Submeshes(), Lods());
+    gpu.SetBounds(glm::vec3(m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2]),
+        glm::vec3(m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2]));
+    return true;
+}
+
+MeshFile::BenchmarkReport MeshFile::BenchmarkLoad(const std::string& sourcePath, int iterations) {
+    BenchmarkReport report;
+    std::string cookedPath = CookedPath(sourcePath);
+    if (!IsUpToDate(sourcePath, cookedPath) && !Cook(sourcePath, cookedPath)) return report;
+
+    std::error_code ec;
+    report.sourceBytes = static_cast<size_t>(fs::file_size(sourcePath, ec));
+    report.cookedBytes = static_cast<size_t>(fs::file_size(cookedPath, ec));
+    report.sourceSeconds = report.cookedSeconds = report.uploadSeconds = 1e30;
+
+    // uploads are only timed when the engine has a GL context (glad loaded)
+    const bool haveGL = glad_glBufferData != nullptr;
+    for (int i = 0; i < std::max(1, iterations); ++i) {
+        auto t0 = Clock::now();
+        MeshData mesh;
+        if (!ImportSource(sourcePath, mesh)) return report;
+        auto t1 = Clock::now();
+        CookedMesh cooked;
+        if (!cooked.Open(cookedPath)) return report;
+        auto t2 = Clock::now();
+        if (haveGL) {
+            GpuMesh gpu;
+            cooked.Upload(gpu);
+            glFinish();
+            report.uploadSeconds = std::min(report.uploadSeconds, Seconds(t2, Clock::now()));
+        }
+        report.sourceSeconds = std::min(report.sourceSeconds, Seconds(t0, t1));
+        report.cookedSeconds = std::min(report.cookedSeconds, Seconds(t1, t2));
+    }
+    if (!haveGL) report.uploadSeconds = 0.0;
+    report.speedup = report.sourceSeconds / std::max(report.cookedSeconds, 1e-9);
+
+    LOG_INFO("MeshFile benchmark: " << sourcePath << " | source " << report.sourceBytes / 1024 << " KB in "
+        << report.sourceSeconds * 1000.0 << " ms | .spxmesh " << report.cookedBytes / 1024 << " KB map+verify in "
+        << report.cookedSeconds * 1000.0 << " ms" << (haveGL ? ", upload " : "")
+        << (haveGL ? std::to_string(report.uploadSeconds * 1000.0) + " ms" : std::string())
+        << " | " << report.speedup << "x faster");
+    return report;
+}
@@ -0,0 +1,325 @@
+#include "../include/mesh_optimize.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    // Forsyth score model (https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+    constexpr int kCacheSize = 32;
+    constexpr float kLastTriScore = 0.75f;
+    constexpr float kCacheDecayPower = 1.5f;
+    constexpr float kValenceBoostScale = 2.0f;
+    constexpr float kValenceBoostPower = 0.5f;
+    constexpr int kValenceTable = 32;
+
+    struct ScoreTables {
+        float cache[kCacheSize];
+        float valence[kValenceTable];
+        ScoreTables() {
+            for (int i = 0; i < kCacheSize; ++i) {
+                // the three vertices of the last triangle get a fixed score so the
+                // optimiser doesn't prefer strip-like order over fans
+                cache[i] = (i < 3) ? kLastTriScore
+                    : std::pow(1.0f - static_cast<float>(i - 3) / (kCacheSize - 3), kCacheDecayPower);
+            }
+            valence[0] = 0.0f;
+            for (int i = 1; i < kValenceTable; ++i) valence[i] = kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+        }
+    };
+    const ScoreTables& Tables() {
+        static const ScoreTables tables;
+        return tables;
+    }
+
+    float VertexScore(int cachePos, uint32_t remaining) {
+        if (remaining == 0) return -1.0f; // no triangles left, never pick
+        const ScoreTables& t = Tables();
+        float score = (cachePos >= 0) ? t.cache[cachePos] : 0.0f;
+        score += (remaining < kValenceTable) ? t.valence[remaining]
+            : kValenceBoostScale * std::pow(static_cast<float>(remaining), -kValenceBoostPower);
+        return score;
+    }
+
+    // FIFO post-transform cache simulation with timestamps: v is cached while
+    // timestamp - time[v] < size. Resetting is just jumping the timestamp.
+    struct FifoCache {
+        std::vector<uint32_t> time;
+        uint32_t timestamp;
+        unsigned size;
+        FifoCache(size_t vertexCount, unsigned cacheSize) : time(vertexCount, 0), timestamp(cacheSize + 1), size(cacheSize) {}
+        // returns 1 on a miss
+        unsigned Touch(uint32_t v) {
+            if (timestamp - time[v] > size) {
+                time[v] = timestamp++;
+                return 1;
+            }
+            return 0;
+        }
+        void Reset() { timestamp += size + 1; }
+    };
+
+    glm::vec3 Position(const float* vertices, size_t strideFloats, uint32_t v) {
+        const float* p = vertices + static_cast<size_t>(v) * strideFloats;
+        return glm::vec3(p[0], p[1], p[2]);
+    }
+}
+
+MeshOptimize::CacheStats MeshOptimize::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize) {
+    CacheStats stats;
+    if (indexCount < 3 || vertexCount == 0) return stats;
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> seen(vertexCount, 0);
+    size_t misses = 0, unique = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t v = indices[i];
+        if (v >= vertexCount) continue;
+        misses += cache.Touch(v);
+        if (!seen[v]) { seen[v] = 1; ++unique; }
+    }
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = unique ? static_cast<float>(misses) / static_cast<float>(unique) : 0.0f;
+    return stats;
+}
+
+void MeshOptimize::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    const size_t triCount = indexCount / 3;
+    if (triCount < 2) return;
+
+    // vertex -> triangles adjacency (CSR). Each vertex's live triangles are kept at the
+    // front of its range so emitted ones can be swapped out in O(valence).
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triCount * 3; ++i) remaining[indices[i]]++;
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(triCount * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triCount; ++t) {
+            for (int k = 0; k < 3; ++k) adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount, 0.0f);
+    for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = VertexScore(-1, remaining[v]);
+
+    std::vector<float> triScore(triCount);
+    std::vector<uint8_t> emitted(triCount, 0);
+    uint32_t best = 0;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triCount; ++t) {
+        triScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (triScore[t] > bestScore) { bestScore = triScore[t]; best = static_cast<uint32_t>(t); }
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(triCount * 3);
+    uint32_t cache[kCacheSize + 3];
+    int cacheCount = 0;
+    size_t cursor = 0; // fallback scan position when the cache has nothing left to offer
+
+    for (size_t n = 0; n < triCount; ++n) {
+        if (best == kNone) {
+            // cache ran dry (disconnected piece): continue with the next unemitted triangle
+            while (emitted[cursor]) ++cursor;
+            best = static_cast<uint32_t>(cursor);
+        }
+        const uint32_t tri[3] = { indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2] };
+        emitted[best] = 1;
+        output.insert(output.end(), tri, tri + 3);
+
+        // remove the triangle from its vertices' live lists
+        for (uint32_t v : tri) {
+            uint32_t* list = &adjacency[offsets[v]];
+            for (uint32_t i = 0; i < remaining[v]; ++i) {
+                if (list[i] == best) {
+                    std::swap(list[i], list[remaining[v] - 1]);
+                    --remaining[v];
+                    break;
+                }
+            }
+        }
+
+        // LRU: the triangle's vertices move to the front
+        uint32_t newCache[kCacheSize + 3];
+        int newCount = 0;
+        for (uint32_t v : tri) newCache[newCount++] = v;
+        for (int i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) newCache[newCount++] = v;
+        }
+        // anything pushed past the cache size falls out
+        for (int i = kCacheSize; i < newCount; ++i) {
+            cachePos[newCache[i]] = -1;
+            vertexScore[newCache[i]] = VertexScore(-1, remaining[newCache[i]]);
+        }
+        cacheCount = std::min(newCount, kCacheSize);
+        for (int i = 0; i < cacheCount; ++i) {
+            cache[i] = newCache[i];
+            cachePos[cache[i]] = i;
+            vertexScore[cache[i]] = VertexScore(i, remaining[cache[i]]);
+        }
+
+        // only triangles touching the cache changed score, the best one is among them
+        best = kNone;
+        bestScore = -1.0f;
+        for (int i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            const uint32_t* list = &adjacency[offsets[v]];
+            for (uint32_t k = 0; k < remaining[v]; ++k) {
+                uint32_t t = list[k];
+                float s = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                triScore[t] = s;
+                if (s > bestScore) { bestScore = s; best = t; }
+            }
+        }
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimize::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount,
+    size_t vertexStrideFloats, float threshold)
+{
+    const size_t triCount = indexCount / 3;
+    if (triCount < 2) return;
+    const unsigned cacheSize = 16;
+
+    // hard boundaries: triangles where all three vertices miss, i.e. the cache optimiser
+    // started a new region there. Reordering at those points costs nothing.
+    std::vector<size_t> hard;
+    {
+        FifoCache cache(vertexCount, cacheSize);
+        for (size_t t = 0; t < triCount; ++t) {
+            unsigned misses = cache.Touch(indices[t * 3]) + cache.Touch(indices[t * 3 + 1]) + cache.Touch(indices[t * 3 + 2]);
+            if (t == 0 || misses == 3) hard.push_back(t);
+        }
+    }
+    hard.push_back(triCount);
+
+    // soft boundaries: split a hard cluster further wherever the cache cost so far (with a
+    // cold cache at the split) stays within threshold of the whole cluster
+    std::vector<size_t> clusters;
+    {
+        FifoCache cache(vertexCount, cacheSize);
+        for (size_t h = 0; h + 1 < hard.size(); ++h) {
+            size_t start = hard[h], end = hard[h + 1];
+            cache.Reset();
+            size_t clusterMisses = 0;
+            for (size_t t = start; t < end; ++t) {
+                clusterMisses += cache.Touch(indices[t * 3]) + cache.Touch(indices[t * 3 + 1]) + cache.Touch(indices[t * 3 + 2]);
+            }
+            float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+            cache.Reset();
+            size_t misses = 0;
+            size_t sub = start;
+            clusters.push_back(start);
+            for (size_t t = start; t < end; ++t) {
+                misses += cache.Touch(indices[t * 3]) + cache.Touch(indices[t * 3 + 1]) + cache.Touch(indices[t * 3 + 2]);
+                size_t count = t - sub + 1;
+                float acmr = static_cast<float>(misses) / static_cast<float>(count);
+                if (t + 1 < end && count >= 16 && acmr <= clusterAcmr * threshold) {
+                    clusters.push_back(t + 1);
+                    sub = t + 1;
+                    misses = 0;
+                    cache.Reset();
+                }
+            }
+        }
+    }
+    clusters.push_back(triCount);
+    const size_t clusterCount = clusters.size() - 1;
+    if (clusterCount < 2) return;
+
+    // cluster centroid + average normal, both area weighted
+    std::vector<glm::vec3> centroid(clusterCount, glm::vec3(0.0f)), normal(clusterCount, glm::vec3(0.0f));
+    std::vector<float> area(clusterCount, 0.0f);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; ++c) {
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            glm::vec3 a = Position(vertices, vertexStrideFloats, indices[t * 3]);
+            glm::vec3 b = Position(vertices, vertexStrideFloats, indices[t * 3 + 1]);
+            glm::vec3 d = Position(vertices, vertexStrideFloats, indices[t * 3 + 2]);
+            glm::vec3 n = glm::cross(b - a, d - a);
+            float w = glm::length(n);
+            centroid[c] += (a + b + d) * (w / 3.0f);
+            normal[c] += n;
+            area[c] += w;
+        }
+        meshCentroid += centroid[c];
+        meshArea += area[c];
+        if (area[c] > 0.0f) centroid[c] /= area[c];
+    }
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+    // clusters facing outwards (away from the centre) first, they are the likely occluders
+    std::vector<float> key(clusterCount);
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        float len = glm::length(normal[c]);
+        key[c] = (len > 0.0f) ? glm::dot(centroid[c] - meshCentroid, normal[c] / len) : 0.0f;
+        order[c] = static_cast<uint32_t>(c);
+    }
+    std::stable_sort(order.begin(), order.end(), [&key](uint32_t a, uint32_t b) { return key[a] > key[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    for (uint32_t c : order) {
+        output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+size_t MeshOptimize::OptimizeVertexFetch(MeshData& mesh) {
+    const size_t vertexCount = mesh.VertexCount();
+    std::vector<uint32_t> remap(vertexCount, kNone);
+    uint32_t next = 0;
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == kNone) remap[index] = next++;
+        index = remap[index];
+    }
+
+    std::vector<float> vertices(static_cast<size_t>(next) * MESH_VERTEX_FLOATS);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] == kNone) continue;
+        std::copy(&mesh.vertices[v * MESH_VERTEX_FLOATS], &mesh.vertices[v * MESH_VERTEX_FLOATS] + MESH_VERTEX_FLOATS,
+            &vertices[static_cast<size_t>(remap[v]) * MESH_VERTEX_FLOATS]);
+    }
+    mesh.vertices.swap(vertices);
+    return next;
+}
+
+MeshOptimize::Report MeshOptimize::Optimize(MeshData& mesh, const std::string& name) {
+    Report report;
+    auto t0 = std::chrono::steady_clock::now();
+    report.triangles = mesh.TriangleCount();
+    report.verticesBefore = mesh.VertexCount();
+    report.before = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.VertexCount());
+
+    // submeshes (and LODs) are independent index ranges, do them in parallel
+    std::vector<MeshSubmesh> ranges = mesh.submeshes;
+    if (ranges.empty()) ranges.push_back(MeshSubmesh{ 0, static_cast<uint32_t>(mesh.indices.size()), -1 });
+    const size_t vertexCount = mesh.VertexCount();
+    Jobs::ParallelFor(ranges.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t* idx = mesh.indices.data() + ranges[i].indexOffset;
+            size_t count = ranges[i].indexCount;
+            OptimizeVertexCache(idx, count, vertexCount);
+            OptimizeOverdraw(idx, count, mesh.vertices.data(), vertexCount, MESH_VERTEX_FLOATS);
+        }
+    });
+    report.verticesAfter = OptimizeVertexFetch(mesh);
+    report.after = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.VertexCount());
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    LOG_INFO("MeshOptimize: " << (name.empty() ? std::string("mesh") : name) << " (" << report.triangles << " tris) ACMR "
+        << report.before.acmr << " -> " << report.after.acmr << ", ATVR " << report.before.atvr << " -> "
+        << report.after.atvr << " in " << report.seconds * 1000.0 << " ms");
+    return report;
+}
@@ -0,0 +1,588 @@
+#include "../include/mesh_simplify.h"
+#include "../include/jobs.h"
+#include "../include/lod_selector.h"
+#include "../include/log.h"
+#include "../include/mesh_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t kNone = 0xFFFFFFFFu;
+    constexpr int kMaxPasses = 100;
+    // Open edges get a plane perpendicular to their face, weighted this much more than
+    // the faces, so borders and seams keep their outline
+    constexpr float kBorderWeight = 10.0f;
+    // Attribute term: squared normal / uv difference, expressed as squared distance in
+    // the unit-box space the quadrics work in
+    constexpr float kNormalWeight = 0.01f;
+    constexpr float kUvWeight = 0.01f;
+
+    double Seconds(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double>(b - a).count();
+    }
+
+    // Manifold: interior, collapses anywhere. Border: on one open edge loop, only slides
+    // along it. Seam: two wedges (same position, different attributes) along a uv/normal
+    // seam, slides along the seam with both wedges. Locked: corners, seam ends etc.
+    enum class Kind : uint8_t { Manifold, Border, Seam, Locked };
+
+    struct Quadric {
+        float a00 = 0.0f, a11 = 0.0f, a22 = 0.0f, a10 = 0.0f, a20 = 0.0f, a21 = 0.0f;
+        float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f, c = 0.0f, w = 0.0f;
+
+        // plane n.p + d = 0 (n unit length)
+        void AddPlane(const glm::vec3& n, float d, float weight) {
+            a00 += weight * n.x * n.x; a11 += weight * n.y * n.y; a22 += weight * n.z * n.z;
+            a10 += weight * n.y * n.x; a20 += weight * n.z * n.x; a21 += weight * n.z * n.y;
+            b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+            c += weight * d * d;
+            w += weight;
+        }
+        void Add(const Quadric& q) {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22; a10 += q.a10; a20 += q.a20; a21 += q.a21;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; w += q.w;
+        }
+        // weighted mean squared distance of p to the planes
+        float Error(const glm::vec3& p) const {
+            float rx = a00 * p.x + a10 * p.y + a20 * p.z;
+            float ry = a10 * p.x + a11 * p.y + a21 * p.z;
+            float rz = a20 * p.x + a21 * p.y + a22 * p.z;
+            float r = rx * p.x + ry * p.y + rz * p.z + 2.0f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return std::abs(r) / std::max(w, 1e-20f);
+        }
+    };
+
+    struct Corner {
+        uint32_t next;      // the half-edge vertex -> next
+        uint32_t triangle;
+    };
+
+    // Per-vertex corner lists of the current triangles (counting sort, rebuilt every pass)
+    struct Adjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<Corner> corners;
+
+        void Build(const std::vector<uint32_t>& idx, size_t vertexCount) {
+            offsets.assign(vertexCount + 1, 0);
+            for (uint32_t v : idx) ++offsets[v + 1];
+            for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+            corners.resize(idx.size());
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < idx.size(); ++i) {
+                uint32_t t = static_cast<uint32_t>(i / 3);
+                uint32_t next = idx[t * 3 + (i + 1) % 3];
+                corners[fill[idx[i]]++] = { next, t };
+            }
+        }
+        bool HasEdge(uint32_t a, uint32_t b) const {
+            for (uint32_t i = offsets[a]; i < offsets[a + 1]; ++i) {
+                if (corners[i].next == b) return true;
+            }
+            return false;
+        }
+    };
+
+    struct Collapse {
+        uint32_t v;
+        uint32_t t;
+        float cost;
+    };
+
+    // Approximate ascending order by the top 16 bits of the (non-negative) float cost
+    void SortByCost(std::vector<Collapse>& collapses) {
+        std::vector<uint32_t> counts(65537, 0);
+        auto key = [](float f) { uint32_t bits; std::memcpy(&bits, &f, sizeof(bits)); return bits >> 16; };
+        for (const Collapse& c : collapses) ++counts[key(c.cost) + 1];
+        for (size_t i = 0; i < 65536; ++i) counts[i + 1] += counts[i];
+        std::vector<Collapse> sorted(collapses.size());
+        for (const Collapse& c : collapses) sorted[counts[key(c.cost)]++] = c;
+        collapses.swap(sorted);
+    }
+
+    class Simplifier {
+    public:
+        Simplifier(const uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount, size_t stride) {
+            // compact to the vertices this range uses
+            std::vector<uint32_t> local(vertexCount, kNone);
+            m_idx.resize(indexCount);
+            for (size_t i = 0; i < indexCount; ++i) {
+                uint32_t g = indices[i];
+                if (local[g] == kNone) {
+                    local[g] = static_cast<uint32_t>(m_global.size());
+                    m_global.push_back(g);
+                }
+                m_idx[i] = local[g];
+            }
+            const size_t n = m_global.size();
+
+            // positions in a unit box so the float quadrics keep their precision
+            glm::vec3 mn(std::numeric_limits<float>::max()), mx(-std::numeric_limits<float>::max());
+            for (uint32_t g : m_global) {
+                glm::vec3 p(vertices[g * stride], vertices[g * stride + 1], vertices[g * stride + 2]);
+                mn = glm::min(mn, p);
+                mx = glm::max(mx, p);
+            }
+            m_scale = std::max({ mx.x - mn.x, mx.y - mn.y, mx.z - mn.z, 1e-20f });
+            m_pos.resize(n);
+            m_normal.resize(n, glm::vec3(0.0f));
+            m_uv.resize(n, glm::vec2(0.0f));
+            for (size_t i = 0; i < n; ++i) {
+                const float* v = vertices + m_global[i] * stride;
+                m_pos[i] = (glm::vec3(v[0], v[1], v[2]) - mn) / m_scale;
+                if (stride >= 8) {
+                    m_normal[i] = glm::vec3(v[3], v[4], v[5]);
+                    m_uv[i] = glm::vec2(v[6], v[7]);
+                }
+            }
+            BuildWedges();
+            // triangles with two corners on one position have no area and would block
+            // every collapse around them in the flip check
+            size_t write = 0;
+            for (size_t i = 0; i < m_idx.size(); i += 3) {
+                uint32_t a = m_remap[m_idx[i]], b = m_remap[m_idx[i + 1]], c = m_remap[m_idx[i + 2]];
+                if (a == b || b == c || a == c) continue;
+                for (int k = 0; k < 3; ++k) m_idx[write++] = m_idx[i + k];
+            }
+            m_idx.resize(write);
+            m_adj.Build(m_idx, n);
+            Classify();
+            BuildQuadrics();
+        }
+
+        size_t Run(size_t targetIndexCount, float targetError, float& resultError) {
+            const float limit = (targetError / m_scale) * (targetError / m_scale);
+            float worst = 0.0f;
+            std::vector<Collapse> collapses;
+            std::vector<uint8_t> locked(m_pos.size());
+            std::vector<uint32_t> collapseTo(m_pos.size());
+
+            for (int pass = 0; pass < kMaxPasses && m_idx.size() > targetIndexCount; ++pass) {
+                if (pass > 0) m_adj.Build(m_idx, m_pos.size());
+                Candidates(collapses);
+                if (collapses.empty()) break;
+                SortByCost(collapses);
+
+                std::fill(locked.begin(), locked.end(), 0);
+                for (uint32_t i = 0; i < collapseTo.size(); ++i) collapseTo[i] = i;
+                const size_t goal = (m_idx.size() - targetIndexCount) / 3;
+                size_t removed = 0, performed = 0;
+                for (const Collapse& c : collapses) {
+                    if (c.cost > limit || removed >= goal) break;
+                    const uint32_t pv = m_remap[c.v], pt = m_remap[c.t];
+                    if (locked[pv] || locked[pt]) continue;
+                    uint32_t wedgeTarget = kNone;
+                    if (m_kind[c.v] == Kind::Seam && (wedgeTarget = MatchWedge(c.v, c.t)) == kNone) continue;
+                    size_t dropped = 0;
+                    if (!CheckFlips(c.v, c.t, dropped)) continue;
+
+                    collapseTo[c.v] = c.t;
+                    if (wedgeTarget != kNone) collapseTo[m_wedge[c.v]] = wedgeTarget;
+                    m_quadric[pt].Add(m_quadric[pv]);
+                    LockRing(c.v, locked);
+                    locked[pt] = 1;
+                    worst = std::max(worst, c.cost);
+                    removed += dropped;
+                    ++performed;
+                }
+                if (performed == 0) break;
+                Apply(collapseTo);
+            }
+            resultError = std::sqrt(worst) * m_scale;
+            return m_idx.size();
+        }
+
+        void Write(uint32_t* destination) const {
+            for (size_t i = 0; i < m_idx.size(); ++i) destination[i] = m_global[m_idx[i]];
+        }
+
+    private:
+        // Ring of vertices sharing a position: m_remap = first of the ring, m_wedge = next
+        void BuildWedges() {
+            const size_t n = m_pos.size();
+            std::vector<uint32_t> order(n);
+            for (uint32_t i = 0; i < n; ++i) order[i] = i;
+            auto less = [this](uint32_t a, uint32_t b) {
+                const glm::vec3& p = m_pos[a];
+                const glm::vec3& q = m_pos[b];
+                if (p.x != q.x) return p.x < q.x;
+                if (p.y != q.y) return p.y < q.y;
+                if (p.z != q.z) return p.z < q.z;
+                return a < b;
+            };
+            std::sort(order.begin(), order.end(), less);
+            m_remap.resize(n);
+            m_wedge.resize(n);
+            for (size_t i = 0; i < n;) {
+                size_t j = i + 1;
+                while (j < n && m_pos[order[j]] == m_pos[order[i]]) ++j;
+                for (size_t k = i; k < j; ++k) {
+                    m_remap[order[k]] = order[i];
+                    m_wedge[order[k]] = order[(k + 1 < j) ? k + 1 : i];
+                }
+                i = j;
+            }
+        }
+
+        bool IsOpen(uint32_t a, uint32_t b) const {
+            return m_adj.HasEdge(a, b) != m_adj.HasEdge(b, a);
+        }
+
+        void Classify() {
+            const size_t n = m_pos.size();
+            std::vector<uint32_t> openOut(n, 0), openIn(n, 0), openNext(n, kNone), openPrev(n, kNone);
+            for (uint32_t a = 0; a < n; ++a) {
+                for (uint32_t i = m_adj.offsets[a]; i < m_adj.offsets[a + 1]; ++i) {
+                    uint32_t b = m_adj.corners[i].next;
+                    if (m_adj.HasEdge(b, a)) continue;
+                    ++openOut[a];
+                    ++openIn[b];
+                    openNext[a] = b;
+                    openPrev[b] = a;
+                }
+            }
+            m_kind.assign(n, Kind::Locked);
+            for (uint32_t v = 0; v < n; ++v) {
+                const bool oneLoop = openOut[v] == 1 && openIn[v] == 1;
+                if (m_wedge[v] == v) {
+                    if (openOut[v] == 0 && openIn[v] == 0) m_kind[v] = Kind::Manifold;
+                    else if (oneLoop) m_kind[v] = Kind::Border;
+                    continue;
+                }
+                // exactly two wedges whose open edges mirror each other = a closed seam
+                const uint32_t w = m_wedge[v];
+                if (m_wedge[w] != v || !oneLoop || openOut[w] != 1 || openIn[w] != 1) continue;
+                if (m_remap[openNext[v]] == m_remap[openPrev[w]] && m_remap[openPrev[v]] == m_remap[openNext[w]]) {
+                    m_kind[v] = Kind::Seam;
+                }
+            }
+        }
+
+        void BuildQuadrics() {
+            m_quadric.assign(m_pos.size(), Quadric());
+            for (size_t t = 0; t < m_idx.size(); t += 3) {
+                for (int k = 0; k < 3; ++k) {
+                    const uint32_t a = m_idx[t + k], b = m_idx[t + (k + 1) % 3], c = m_idx[t + (k + 2) % 3];
+                    glm::vec3 normal = glm::cross(m_pos[b] - m_pos[a], m_pos[c] - m_pos[a]);
+                    float area = glm::length(normal);
+                    if (area < 1e-30f) break;
+                    normal /= area;
+                    if (k == 0) {
+                        // face plane, area weighted, on all three corners
+                        Quadric q;
+                        q.AddPlane(normal, -glm::dot(normal, m_pos[a]), area * 0.5f);
+                        for (int j = 0; j < 3; ++j) m_quadric[m_remap[m_idx[t + j]]].Add(q);
+                    }
+                    if (!m_adj.HasEdge(b, a)) {
+                        // open edge a->b: plane through the edge, perpendicular to the face
+                        glm::vec3 edge = m_pos[b] - m_pos[a];
+                        float length = glm::length(edge);
+                        glm::vec3 side = glm::cross(edge, normal);
+                        float sideLength = glm::length(side);
+                        if (sideLength < 1e-30f) continue;
+                        side /= sideLength;
+                        Quadric q;
+                        q.AddPlane(side, -glm::dot(side, m_pos[a]), length * length * kBorderWeight);
+                        m_quadric[m_remap[a]].Add(q);
+                        m_quadric[m_remap[b]].Add(q);
+                    }
+                }
+            }
+        }
+
+        float AttributeCost(uint32_t a, uint32_t b) const {
+            glm::vec3 dn = m_normal[a] - m_normal[b];
+            glm::vec2 duv = m_uv[a] - m_uv[b];
+            return kNormalWeight * glm::dot(dn, dn) + kUvWeight * glm::dot(duv, duv);
+        }
+
+        // The other wedge of seam vertex v must follow onto the wedge of t across its seam edge
+        uint32_t MatchWedge(uint32_t v, uint32_t t) const {
+            const uint32_t w = m_wedge[v];
+            for (uint32_t s = m_wedge[t]; s != t; s = m_wedge[s]) {
+                if (IsOpen(w, s)) return s;
+            }
+            return kNone;
+        }
+
+        bool CanCollapse(uint32_t v, uint32_t t) const {
+            switch (m_kind[v]) {
+            case Kind::Manifold: return true;
+            case Kind::Border: return IsOpen(v, t);
+            case Kind::Seam: return IsOpen(v, t) && MatchWedge(v, t) != kNone;
+            default: return false;
+            }
+        }
+
+        float Cost(uint32_t v, uint32_t t) const {
+            float cost = m_quadric[m_remap[v]].Error(m_pos[t]) + AttributeCost(v, t);
+            if (m_kind[v] == Kind::Seam) {
+                uint32_t s = MatchWedge(v, t);
+                if (s != kNone) cost = std::max(cost, m_quadric[m_remap[v]].Error(m_pos[t]) + AttributeCost(m_wedge[v], s));
+            }
+            return cost;
+        }
+
+        void Candidates(std::vector<Collapse>& out) const {
+            out.clear();
+            constexpr float kInf = std::numeric_limits<float>::infinity();
+            for (size_t i = 0; i < m_idx.size(); ++i) {
+                const uint32_t a = m_idx[i], b = m_idx[i - i % 3 + (i + 1) % 3];
+                if (m_remap[a] == m_remap[b]) continue;
+                // each interior edge once, open edges from their only half-edge
+                if (m_remap[a] > m_remap[b] && m_adj.HasEdge(b, a)) continue;
+                float ab = CanCollapse(a, b) ? Cost(a, b) : kInf;
+                float ba = CanCollapse(b, a) ? Cost(b, a) : kInf;
+                if (ab == kInf && ba == kInf) continue;
+                out.push_back(ab <= ba ? Collapse{ a, b, ab } : Collapse{ b, a, ba });
+            }
+        }
+
+        // Reject collapses that turn a remaining triangle around v over. `dropped` gets
+        // the number of triangles that become degenerate.
+        bool CheckFlips(uint32_t v, uint32_t t, size_t& dropped) const {
+            const uint32_t pv = m_remap[v], pt = m_remap[t];
+            uint32_t w = v;
+            do {
+                for (uint32_t i = m_adj.offsets[w]; i < m_adj.offsets[w + 1]; ++i) {
+                    const uint32_t* tri = &m_idx[m_adj.corners[i].triangle * 3];
+                    if (m_remap[tri[0]] == pt || m_remap[tri[1]] == pt || m_remap[tri[2]] == pt) {
+                        ++dropped;
+                        continue;
+                    }
+                    glm::vec3 p[3], q[3];
+                    for (int k = 0; k < 3; ++k) {
+                        p[k] = m_pos[tri[k]];
+                        q[k] = (m_remap[tri[k]] == pv) ? m_pos[t] : p[k];
+                    }
+                    glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                    float d = glm::dot(before, after);
+                    if (d < 0.0f || (d == 0.0f && glm::dot(before, before) > 0.0f)) return false;
+                }
+                w = m_wedge[w];
+            } while (w != v);
+            return true;
+        }
+
+        // Everything touching v's triangles keeps still for the rest of the pass, so the
+        // flip checks of later collapses see final positions
+        void LockRing(uint32_t v, std::vector<uint8_t>& locked) const {
+            uint32_t w = v;
+            do {
+                for (uint32_t i = m_adj.offsets[w]; i < m_adj.offsets[w + 1]; ++i) {
+                    const uint32_t* tri = &m_idx[m_adj.corners[i].triangle * 3];
+                    for (int k = 0; k < 3; ++k) locked[m_remap[tri[k]]] = 1;
+                }
+                w = m_wedge[w];
+            } while (w != v);
+        }
+
+        void Apply(const std::vector<uint32_t>& collapseTo) {
+            size_t write = 0;
+            for (size_t i = 0; i < m_idx.size(); i += 3) {
+                uint32_t a = collapseTo[m_idx[i]], b = collapseTo[m_idx[i + 1]], c = collapseTo[m_idx[i + 2]];
+                if (m_remap[a] == m_remap[b] || m_remap[b] == m_remap[c] || m_remap[a] == m_remap[c]) continue;
+                m_idx[write++] = a;
+                m_idx[write++] = b;
+                m_idx[write++] = c;
+            }
+            m_idx.resize(write);
+        }
+
+        float m_scale = 1.0f;
+        std::vector<uint32_t> m_idx;      // local vertex ids
+        std::vector<uint32_t> m_global;   // local -> mesh vertex
+        std::vector<glm::vec3> m_pos;
+        std::vector<glm::vec3> m_normal;
+        std::vector<glm::vec2> m_uv;
+        std::vector<uint32_t> m_remap;
+        std::vector<uint32_t> m_wedge;
+        std::vector<Kind> m_kind;
+        std::vector<Quadric> m_quadric;   // per position (m_remap)
+        Adjacency m_adj;
+    };
+
+    float BoundingRadius(const MeshData& mesh) {
+        return glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f;
+    }
+
+    // UV sphere with some noise, ~2 * rings * segments triangles
+    void MakeSphere(MeshData& mesh, int rings, int segments) {
+        mesh.Clear();
+        for (int r = 0; r <= rings; ++r) {
+            for (int s = 0; s <= segments; ++s) {
+                float theta = 3.14159265f * r / rings, phi = 6.28318531f * s / segments;
+                glm::vec3 n(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+                float bump = 1.0f + 0.05f * std::sin(phi * 7.0f) * std::sin(theta * 5.0f);
+                glm::vec3 p = n * bump;
+                float v[MESH_VERTEX_FLOATS] = { p.x, p.y, p.z, n.x, n.y, n.z,
+                    static_cast<float>(s) / segments, static_cast<float>(r) / rings };
+                mesh.vertices.insert(mesh.vertices.end(), v, v + MESH_VERTEX_FLOATS);
+            }
+        }
+        for (int r = 0; r < rings; ++r) {
+            for (int s = 0; s < segments; ++s) {
+                uint32_t a = r * (segments + 1) + s, b = a + 1, c = a + segments + 1, d = c + 1;
+                uint32_t tri[6] = { a, c, b, b, c, d };
+                mesh.indices.insert(mesh.indices.end(), tri, tri + 6);
+            }
+        }
+        mesh.boundsMin = glm::vec3(-1.05f);
+        mesh.boundsMax = glm::vec3(1.05f);
+    }
+}
+
+size_t MeshSimplify::Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+    const float* vertices, size_t vertexCount, size_t vertexStrideFloats,
+    size_t targetIndexCount, float targetError, float* resultError)
+{
+    float error = 0.0f;
+    size_t count = 0;
+    if (indexCount >= 3 && vertexStrideFloats >= 3) {
+        Simplifier simplifier(indices, indexCount - indexCount % 3, vertices, vertexCount, vertexStrideFloats);
+        count = simplifier.Run(targetIndexCount, targetError, error);
+        simplifier.Write(destination);
+    }
+    if (resultError) *resultError = error;
+    return count;
+}
+
+bool MeshSimplify::GenerateLods(MeshData& mesh, const LodSettings& settings, const std::string& name) {
+    if (!mesh.lods.empty() || settings.lodCount <= 1 || mesh.indices.empty()) return true;
+    auto t0 = Clock::now();
+    if (mesh.submeshes.empty()) mesh.submeshes.push_back(MeshSubmesh{ 0, static_cast<uint32_t>(mesh.indices.size()), -1 });
+    mesh.lods.push_back(MeshLod{ 0, static_cast<uint32_t>(mesh.submeshes.size()), 0.0f });
+
+    const float maxError = settings.maxError * BoundingRadius(mesh);
+    const size_t vertexCount = mesh.VertexCount();
+    size_t previousTriangles = mesh.TriangleCount();
+    std::string counts = std::to_string(previousTriangles);
+
+    for (int level = 1; level < settings.lodCount; ++level) {
+        const MeshLod previous = mesh.lods.back();
+        const size_t target = static_cast<size_t>(previousTriangles * settings.reduction);
+        if (target < settings.minTriangles || previous.error >= maxError) break;
+
+        // simplify every submesh of the previous level on its own (materials stay apart)
+        std::vector<std::vector<uint32_t>> results(previous.submeshCount);
+        std::vector<float> errors(previous.submeshCount, 0.0f);
+        Jobs::ParallelFor(previous.submeshCount, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const MeshSubmesh& s = mesh.submeshes[previous.submeshOffset + i];
+                results[i].resize(s.indexCount);
+                size_t keep = std::max<size_t>(static_cast<size_t>(s.indexCount / 3 * settings.reduction), 1) * 3;
+                size_t count = Simplify(results[i].data(), mesh.indices.data() + s.indexOffset, s.indexCount,
+                    mesh.vertices.data(), vertexCount, MESH_VERTEX_FLOATS, keep, maxError - previous.error, &errors[i]);
+                results[i].resize(count);
+            }
+        });
+
+        size_t triangles = 0;
+        for (const std::vector<uint32_t>& r : results) triangles += r.size() / 3;
+        // stuck (everything locked or over the error budget): no point in another level
+        if (triangles == 0 || triangles > previousTriangles * 0.9) break;
+
+        MeshLod lod{ static_cast<uint32_t>(mesh.submeshes.size()), 0, previous.error };
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].empty()) continue;
+            const MeshSubmesh& s = mesh.submeshes[previous.submeshOffset + i];
+            MeshSubmesh out{ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(results[i].size()), s.materialIndex };
+            mesh.indices.insert(mesh.indices.end(), results[i].begin(), results[i].end());
+            mesh.submeshes.push_back(out);
+            ++lod.submeshCount;
+            lod.error = std::max(lod.error, previous.error + errors[i]);
+        }
+        mesh.lods.push_back(lod);
+        previousTriangles = triangles;
+        counts += " / " + std::to_string(triangles);
+    }
+
+    LOG_INFO("MeshSimplify: " << (name.empty() ? std::string("mesh") : name) << " " << mesh.lods.size()
+        << " LODs (" << counts << " tris), max error " << mesh.lods.back().error << " in "
+        << Seconds(t0, Clock::now()) * 1000.0 << " ms");
+    return true;
+}
+
+void MeshSimplify::GenerateLods(const std::vector<MeshData*>& meshes, const LodSettings& settings) {
+    Jobs::ParallelFor(meshes.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (meshes[i]) GenerateLods(*meshes[i], settings);
+        }
+    });
+}
+
+std::vector<MeshSimplify::DistanceSample> MeshSimplify::BenchmarkDistance(const MeshData& mesh, float fovYDegrees,
+    float viewportHeight, float farRadii, int steps)
+{
+    std::vector<DistanceSample> samples;
+    const float radius = BoundingRadius(mesh);
+    if (radius <= 0.0f || steps < 2) return samples;
+
+    std::vector<MeshLod> lods = mesh.lods;
+    if (lods.empty()) lods.push_back(MeshLod{ 0, static_cast<uint32_t>(std::max<size_t>(mesh.submeshes.size(), 1)), 0.0f });
+    auto lodTriangles = [&](const MeshLod& lod) {
+        if (mesh.submeshes.empty()) return mesh.TriangleCount();
+        size_t triangles = 0;
+        for (uint32_t i = lod.submeshOffset; i < lod.submeshOffset + lod.submeshCount; ++i) triangles += mesh.submeshes[i].indexCount / 3;
+        return triangles;
+    };
+
+    // walk away from the mesh on a log scale, same projection as Camera::ProjectedSize
+    LodSelector selector;
+    const float tanHalf = std::tan(glm::radians(fovYDegrees) * 0.5f);
+    size_t total = 0;
+    std::string table;
+    for (int i = 0; i < steps; ++i) {
+        float distance = radius * 2.0f * std::pow(farRadii / 2.0f, static_cast<float>(i) / (steps - 1));
+        float projected = radius / (distance * tanHalf) * viewportHeight * 0.5f;
+        DistanceSample sample;
+        sample.distance = distance;
+        sample.lod = selector.Select(lods, radius, projected);
+        sample.triangles = lodTriangles(lods[sample.lod]);
+        sample.pixelError = LodSelector::PixelError(lods[sample.lod], radius, projected);
+        total += sample.triangles;
+        samples.push_back(sample);
+        table += "\n    d " + std::to_string(distance) + " | " + std::to_string(static_cast<int>(projected)) + " px | LOD "
+            + std::to_string(sample.lod) + " | " + std::to_string(sample.triangles) + " tris | err "
+            + std::to_string(sample.pixelError) + " px";
+    }
+    LOG_INFO("MeshSimplify: triangles vs distance (radius " << radius << ", " << viewportHeight << " px, fov "
+        << fovYDegrees << "), " << total << " tris drawn vs " << lodTriangles(lods[0]) * steps << " without LODs" << table);
+    return samples;
+}
+
+MeshSimplify::BenchmarkReport MeshSimplify::Benchmark(const std::string& path, const LodSettings& settings) {
+    BenchmarkReport report;
+    MeshData mesh;
+    if (path.empty()) MakeSphere(mesh, 500, 1000); // 1M triangles
+    else if (!MeshFile::ImportSource(path, mesh)) return report;
+    if (!mesh.lods.empty()) {
+        // cooked file with LODs: start over from LOD 0, which comes first in the submeshes
+        // and the index buffer, and drop the other LODs' indices with their submeshes
+        mesh.submeshes.resize(mesh.lods[0].submeshCount);
+        mesh.lods.clear();
+        size_t indexEnd = 0;
+        for (const MeshSubmesh& sub : mesh.submeshes) indexEnd = std::max<size_t>(indexEnd, size_t(sub.indexOffset) + sub.indexCount);
+        mesh.indices.resize(std::min(indexEnd, mesh.indices.size()));
+    }
+    report.triangles = mesh.TriangleCount();
+
+    auto t0 = Clock::now();
+    GenerateLods(mesh, settings, path.empty() ? std::string("synthetic sphere") : path);
+    report.seconds = Seconds(t0, Clock::now());
+    for (const MeshLod& lod : mesh.lods) {
+        size_t triangles = 0;
+        for (uint32_t i = lod.submeshOffset; i < lod.submeshOffset + lod.submeshCount; ++i) triangles += mesh.submeshes[i].indexCount / 3;
+        report.lodTriangles.push_back(triangles);
+    }
+    LOG_INFO("MeshSimplify benchmark: " << report.triangles << " tris, " << report.lodTriangles.size() << " LODs in "
+        << report.seconds * 1000.0 << " ms (" << report.triangles / 1e6 / std::max(report.seconds, 1e-9)
+        << " Mtris/s) on " << Jobs::WorkerCount() + 1 << " threads");
+    report.samples = BenchmarkDistance(mesh);
+    return report;
+}
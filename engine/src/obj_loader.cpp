@@ -0,0 +1,609 @@
+#include "../include/obj_loader.h"
+#include "../include/asset_path.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include "../include/mapped_file.h"
+#include "../include/text_parse.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t kAbsent = 0xFFFFFFFFu;
+    constexpr size_t kMinChunkBytes = 1 << 20;
+
+    // One face corner as written in the file: v/t/n, 0 = not given.
+    // Negative (relative) indices are turned into chunk-local ones while parsing
+    // and flagged in relMask, the chunk's base offsets are added in the resolve step.
+    struct RawCorner {
+        int32_t v = 0, t = 0, n = 0;
+    };
+    enum : uint8_t { kRelV = 1, kRelT = 2, kRelN = 4 };
+
+    struct MaterialSwitch {
+        uint32_t triangle; // first triangle (chunk-local) using the material
+        std::string name;
+    };
+
+    // Everything one chunk parses, later stitched together in file order
+    struct Chunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        std::vector<float> positions;  // xyz
+        std::vector<float> normals;    // xyz
+        std::vector<float> uvs;        // uv
+        std::vector<RawCorner> corners; // 3 per triangle
+        std::vector<uint8_t> relMask;   // per corner, kRel* bits
+        std::vector<MaterialSwitch> materials;
+        std::vector<std::string> mtllibs;
+        size_t badLines = 0;
+    };
+
+    // "v/t/n", "v//n", "v/t" or "v"
+    const char* ParseCorner(const char* p, const char* end, RawCorner& c) {
+        c = RawCorner();
+        p = TextParse::ParseInt(p, end, c.v);
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') p = TextParse::ParseInt(p, end, c.t);
+            if (p < end && *p == '/') {
+                ++p;
+                p = TextParse::ParseInt(p, end, c.n);
+            }
+        }
+        return p;
+    }
+
+    // 1-based / negative OBJ index -> 0-based, relative ones stay chunk-local
+    inline int32_t LocalIndex(int32_t raw, size_t count, uint8_t relBit, uint8_t& mask) {
+        if (raw > 0) return raw - 1;
+        if (raw < 0) {
+            mask |= relBit;
+            return static_cast<int32_t>(count) + raw;
+        }
+        return -1;
+    }
+
+    void ParseChunk(Chunk& chunk) {
+        // rough reservation: a typical OBJ line is ~30 bytes
+        size_t guess = static_cast<size_t>(chunk.end - chunk.begin) / 32;
+        chunk.positions.reserve(guess);
+        chunk.corners.reserve(guess * 2);
+        chunk.relMask.reserve(guess * 2);
+
+        std::vector<RawCorner> poly;
+        const char* p = chunk.begin;
+        const char* end = chunk.end;
+        while (p < end) {
+            const char* lineEnd = TextParse::LineEnd(p, end);
+            const char* next = TextParse::NextLine(p, end);
+            p = TextParse::SkipSpaces(p, lineEnd);
+            if (p >= lineEnd) { p = next; continue; }
+
+            if (p[0] == 'v') {
+                const char* q = p + 1;
+                if (q < lineEnd && TextParse::IsSpace(*q)) {
+                    float xyz[3] = { 0.0f, 0.0f, 0.0f };
+                    for (float& f : xyz) q = TextParse::ParseFloat(TextParse::SkipSpaces(q, lineEnd), lineEnd, f);
+                    chunk.positions.insert(chunk.positions.end(), xyz, xyz + 3);
+                }
+                else if (q < lineEnd && *q == 'n') {
+                    float xyz[3] = { 0.0f, 0.0f, 0.0f };
+                    ++q;
+                    for (float& f : xyz) q = TextParse::ParseFloat(TextParse::SkipSpaces(q, lineEnd), lineEnd, f);
+                    chunk.normals.insert(chunk.normals.end(), xyz, xyz + 3);
+                }
+                else if (q < lineEnd && *q == 't') {
+                    float uv[2] = { 0.0f, 0.0f };
+                    ++q;
+                    for (float& f : uv) q = TextParse::ParseFloat(TextParse::SkipSpaces(q, lineEnd), lineEnd, f);
+                    chunk.uvs.insert(chunk.uvs.end(), uv, uv + 2);
+                }
+            }
+            else if (p[0] == 'f' && p + 1 < lineEnd && TextParse::IsSpace(p[1])) {
+                poly.clear();
+                const char* q = p + 1;
+                for (;;) {
+                    q = TextParse::SkipSpaces(q, lineEnd);
+                    if (q >= lineEnd) break;
+                    RawCorner c;
+                    const char* after = ParseCorner(q, lineEnd, c);
+                    if (after == q || c.v == 0) break;
+                    poly.push_back(c);
+                    q = after;
+                }
+                if (poly.size() < 3) {
+                    ++chunk.badLines;
+                }
+                else {
+                    size_t nv = chunk.positions.size() / 3;
+                    size_t nt = chunk.uvs.size() / 2;
+                    size_t nn = chunk.normals.size() / 3;
+                    // fan triangulation (0, i, i+1)
+                    for (size_t i = 1; i + 1 < poly.size(); ++i) {
+                        const RawCorner* tri[3] = { &poly[0], &poly[i], &poly[i + 1] };
+                        for (const RawCorner* c : tri) {
+                            uint8_t mask = 0;
+                            RawCorner out;
+                            out.v = LocalIndex(c->v, nv, kRelV, mask);
+                            out.t = LocalIndex(c->t, nt, kRelT, mask);
+                            out.n = LocalIndex(c->n, nn, kRelN, mask);
+                            chunk.corners.push_back(out);
+                            chunk.relMask.push_back(mask);
+                        }
+                    }
+                }
+            }
+            else if (TextParse::StartsWithWord(p, lineEnd, "usemtl")) {
+                const char* name = TextParse::SkipSpaces(p + 6, lineEnd);
+                chunk.materials.push_back({ static_cast<uint32_t>(chunk.corners.size() / 3), std::string(name, lineEnd) });
+            }
+            else if (TextParse::StartsWithWord(p, lineEnd, "mtllib")) {
+                const char* name = TextParse::SkipSpaces(p + 6, lineEnd);
+                chunk.mtllibs.emplace_back(name, lineEnd);
+            }
+            // '#', o, g, s, l, p and anything else is ignored
+            p = next;
+        }
+    }
+
+    // Split [data, data + size) into roughly equal chunks that start at a line start
+    std::vector<Chunk> SplitChunks(const char* data, size_t size) {
+        size_t workers = std::max<size_t>(1, Jobs::WorkerCount() + 1);
+        size_t target = std::max(kMinChunkBytes, size / (workers * 4) + 1);
+        std::vector<Chunk> chunks;
+        const char* end = data + size;
+        const char* p = data;
+        while (p < end) {
+            Chunk c;
+            c.begin = p;
+            const char* cut = (static_cast<size_t>(end - p) > target) ? p + target : end;
+            if (cut < end) cut = TextParse::NextLine(cut, end);
+            c.end = cut;
+            chunks.push_back(std::move(c));
+            p = cut;
+        }
+        return chunks;
+    }
+
+    struct KeyHash {
+        static uint64_t Hash(uint32_t v, uint32_t t, uint32_t n) {
+            uint64_t h = (uint64_t(v) * 0x9E3779B97F4A7C15ull) ^ (uint64_t(t) * 0xC2B2AE3D27D4EB4Full) ^ (uint64_t(n) * 0x165667B19E3779F9ull);
+            return h ^ (h >> 29);
+        }
+    };
+
+    // Open addressing (linear probing) table of unique corners -> vertex index.
+    // Much faster than std::unordered_map for the millions of lookups a big model needs.
+    class CornerTable {
+    public:
+        explicit CornerTable(size_t expected) {
+            size_t cap = 16;
+            while (cap < expected * 2) cap <<= 1;
+            Reset(cap);
+        }
+        // Returns the existing vertex index or inserts `next`
+        uint32_t FindOrInsert(uint32_t v, uint32_t t, uint32_t n, uint32_t next) {
+            size_t i = Probe(v, t, n);
+            if (m_values[i] != kAbsent) return m_values[i];
+            if ((m_count + 1) * 2 > m_values.size()) {
+                Grow();
+                i = Probe(v, t, n);
+            }
+            m_keys[i * 3 + 0] = v;
+            m_keys[i * 3 + 1] = t;
+            m_keys[i * 3 + 2] = n;
+            m_values[i] = next;
+            ++m_count;
+            return next;
+        }
+    private:
+        void Reset(size_t cap) {
+            m_mask = cap - 1;
+            m_count = 0;
+            m_keys.assign(cap * 3, kAbsent);
+            m_values.assign(cap, kAbsent);
+        }
+        // slot holding the key, or the empty slot where it would go
+        size_t Probe(uint32_t v, uint32_t t, uint32_t n) const {
+            size_t i = static_cast<size_t>(KeyHash::Hash(v, t, n)) & m_mask;
+            while (m_values[i] != kAbsent
+                && !(m_keys[i * 3] == v && m_keys[i * 3 + 1] == t && m_keys[i * 3 + 2] == n)) {
+                i = (i + 1) & m_mask;
+            }
+            return i;
+        }
+        void Grow() {
+            std::vector<uint32_t> keys = std::move(m_keys);
+            std::vector<uint32_t> values = std::move(m_values);
+            Reset(values.size() * 2);
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (values[i] == kAbsent) continue;
+                size_t j = Probe(keys[i * 3], keys[i * 3 + 1], keys[i * 3 + 2]);
+                std::copy(&keys[i * 3], &keys[i * 3] + 3, &m_keys[j * 3]);
+                m_values[j] = values[i];
+                ++m_count;
+            }
+        }
+
+        size_t m_mask = 0;
+        size_t m_count = 0;
+        std::vector<uint32_t> m_keys;
+        std::vector<uint32_t> m_values;
+    };
+
+    // Shared material-file parser (also used for LoadMaterials)
+    void ParseMtl(const char* data, size_t size, const std::string& baseDir, std::vector<MeshMaterial>& materials) {
+        const char* p = data;
+        const char* end = data + size;
+        MeshMaterial* current = nullptr;
+
+        auto readVec3 = [](const char* q, const char* e, glm::vec3& out) {
+            for (int i = 0; i < 3; ++i) q = TextParse::ParseFloat(TextParse::SkipSpaces(q, e), e, out[i]);
+        };
+        // map_* lines can carry options ("-s 1 1 1 file.png"), the file name is the last token
+        auto texturePath = [&baseDir](const char* q, const char* e) {
+            const char* name = q;
+            for (const char* s = q; s < e; ++s) {
+                if (TextParse::IsSpace(*s) && s + 1 < e && !TextParse::IsSpace(s[1])) name = s + 1;
+            }
+            std::string file(name, e);
+            std::replace(file.begin(), file.end(), '\\', '/');
+            return (fs::path(baseDir) / file).lexically_normal().generic_string();
+        };
+
+        while (p < end) {
+            const char* lineEnd = TextParse::LineEnd(p, end);
+            const char* next = TextParse::NextLine(p, end);
+            p = TextParse::SkipSpaces(p, lineEnd);
+
+            if (TextParse::StartsWithWord(p, lineEnd, "newmtl")) {
+                materials.emplace_back();
+                current = &materials.back();
+                current->name.assign(TextParse::SkipSpaces(p + 6, lineEnd), lineEnd);
+            }
+            else if (current) {
+                if (TextParse::StartsWithWord(p, lineEnd, "Ka")) readVec3(p + 2, lineEnd, current->ambient);
+                else if (TextParse::StartsWithWord(p, lineEnd, "Kd")) readVec3(p + 2, lineEnd, current->diffuse);
+                else if (TextParse::StartsWithWord(p, lineEnd, "Ks")) readVec3(p + 2, lineEnd, current->specular);
+                else if (TextParse::StartsWithWord(p, lineEnd, "Ns")) TextParse::ParseFloat(TextParse::SkipSpaces(p + 2, lineEnd), lineEnd, current->shininess);
+                else if (TextParse::StartsWithWord(p, lineEnd, "d")) TextParse::ParseFloat(TextParse::SkipSpaces(p + 1, lineEnd), lineEnd, current->opacity);
+                else if (TextParse::StartsWithWord(p, lineEnd, "Tr")) {
+                    float tr = 0.0f;
+                    TextParse::ParseFloat(TextParse::SkipSpaces(p + 2, lineEnd), lineEnd, tr);
+                    current->opacity = 1.0f - tr;
+                }
+                else if (TextParse::StartsWithWord(p, lineEnd, "map_Kd")) current->diffuseTexture = texturePath(p + 6, lineEnd);
+                else if (TextParse::StartsWithWord(p, lineEnd, "map_Bump") || TextParse::StartsWithWord(p, lineEnd, "map_bump")) current->normalTexture = texturePath(p + 8, lineEnd);
+                else if (TextParse::StartsWithWord(p, lineEnd, "bump") || TextParse::StartsWithWord(p, lineEnd, "norm")) current->normalTexture = texturePath(p + 4, lineEnd);
+            }
+            p = next;
+        }
+    }
+
+    double Seconds(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double>(b - a).count();
+    }
+
+    // Synthetic n x n quad grid with positions, uvs and normals, as OBJ text
+    std::string MakeGridObj(int n) {
+        std::string text;
+        text.reserve(static_cast<size_t>(n + 1) * (n + 1) * 64 + static_cast<size_t>(n) * n * 2 * 40);
+        char line[128];
+        text += "# synthetic benchmark grid\nvn 0 1 0\n";
+        for (int z = 0; z <= n; ++z) {
+            for (int x = 0; x <= n; ++x) {
+                float fx = static_cast<float>(x) / n, fz = static_cast<float>(z) / n;
+                float h = 0.05f * std::sin(fx * 31.0f) * std::cos(fz * 17.0f);
+                int len = std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", fx * 100.0f - 50.0f, h, fz * 100.0f - 50.0f, fx, fz);
+                text.append(line, static_cast<size_t>(len));
+            }
+        }
+        for (int z = 0; z < n; ++z) {
+            for (int x = 0; x < n; ++x) {
+                int a = z * (n + 1) + x + 1, b = a + 1, c = a + n + 1, d = c + 1;
+                int len = std::snprintf(line, sizeof(line), "f %d/%d/1 %d/%d/1 %d/%d/1\nf %d/%d/1 %d/%d/1 %d/%d/1\n",
+                    a, a, c, c, b, b, b, b, c, c, d, d);
+                text.append(line, static_cast<size_t>(len));
+            }
+        }
+        return text;
+    }
+}
+
+bool ObjLoader::LoadMaterials(const std::string& path, std::vector<MeshMaterial>& materials) {
+    MappedFile file;
+    if (!OpenAssetFile(path, file)) {
+        LOG_WARNING("ObjLoader: cannot open material library " << path);
+        return false;
+    }
+    ParseMtl(file.Data(), file.Size(), fs::path(path).parent_path().generic_string(), materials);
+    return true;
+}
+
+bool ObjLoader::LoadFromMemory(const char* data, size_t size, const std::string& baseDir,
+    MeshData& mesh, ImportStats* stats)
+{
+    auto t0 = Clock::now();
+    mesh.Clear();
+
+    // 1) parse line-aligned chunks in parallel
+    std::vector<Chunk> chunks = SplitChunks(data, size);
+    Jobs::ParallelFor(chunks.size(), 1, [&chunks](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) ParseChunk(chunks[i]);
+    });
+    auto t1 = Clock::now();
+
+    // 2) prefix sums so every chunk knows where its data lands in the combined arrays
+    struct Base { size_t v, t, n, tri; };
+    std::vector<Base> bases(chunks.size() + 1, Base{ 0, 0, 0, 0 });
+    size_t badLines = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        bases[i + 1].v = bases[i].v + chunks[i].positions.size() / 3;
+        bases[i + 1].t = bases[i].t + chunks[i].uvs.size() / 2;
+        bases[i + 1].n = bases[i].n + chunks[i].normals.size() / 3;
+        bases[i + 1].tri = bases[i].tri + chunks[i].corners.size() / 3;
+        badLines += chunks[i].badLines;
+    }
+    const size_t totalV = bases.back().v, totalT = bases.back().t, totalN = bases.back().n;
+    const size_t totalTris = bases.back().tri;
+    if (badLines) {
+        LOG_WARNING("ObjLoader: skipped " << badLines << " malformed face lines");
+    }
+    if (totalTris == 0) {
+        LOG_WARNING("ObjLoader: no faces found");
+        return false;
+    }
+
+    // 3) materials: load the libraries, then map usemtl names to indices
+    for (const Chunk& c : chunks) {
+        for (const std::string& lib : c.mtllibs) {
+            LoadMaterials((fs::path(baseDir) / lib).lexically_normal().generic_string(), mesh.materials);
+        }
+    }
+    std::unordered_map<std::string, int> materialIds;
+    for (size_t i = 0; i < mesh.materials.size(); ++i) materialIds.emplace(mesh.materials[i].name, static_cast<int>(i));
+    auto materialIndex = [&](const std::string& name) {
+        auto it = materialIds.find(name);
+        if (it != materialIds.end()) return it->second;
+        // referenced but never defined: keep the name with default values
+        LOG_WARNING("ObjLoader: material '" << name << "' not found, using defaults");
+        MeshMaterial m;
+        m.name = name;
+        mesh.materials.push_back(m);
+        int id = static_cast<int>(mesh.materials.size() - 1);
+        materialIds.emplace(name, id);
+        return id;
+    };
+    // material active at the start of each chunk
+    std::vector<int> chunkStartMaterial(chunks.size(), -1);
+    std::vector<std::vector<std::pair<uint32_t, int>>> chunkSwitches(chunks.size());
+    int activeMaterial = -1;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        chunkStartMaterial[i] = activeMaterial;
+        for (const MaterialSwitch& s : chunks[i].materials) {
+            activeMaterial = materialIndex(s.name);
+            chunkSwitches[i].push_back({ s.triangle, activeMaterial });
+        }
+    }
+
+    // 4) resolve every corner to absolute 0-based indices, per chunk in parallel
+    std::vector<uint32_t> corners(totalTris * 9); // v, t, n per corner
+    std::vector<int> triMaterial(totalTris);
+    std::vector<float> positions(totalV * 3), uvs(totalT * 2), normals(totalN * 3);
+    size_t invalid = 0;
+    std::vector<size_t> chunkInvalid(chunks.size(), 0);
+    Jobs::ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t ci = begin; ci < end; ++ci) {
+            const Chunk& c = chunks[ci];
+            const Base& b = bases[ci];
+            std::copy(c.positions.begin(), c.positions.end(), positions.begin() + b.v * 3);
+            std::copy(c.uvs.begin(), c.uvs.end(), uvs.begin() + b.t * 2);
+            std::copy(c.normals.begin(), c.normals.end(), normals.begin() + b.n * 3);
+
+            auto resolve = [](int32_t local, bool relative, size_t base, size_t count) -> uint32_t {
+                if (local < 0 && !relative) return kAbsent;
+                int64_t abs = relative ? static_cast<int64_t>(base) + local : local;
+                return (abs >= 0 && abs < static_cast<int64_t>(count)) ? static_cast<uint32_t>(abs) : kAbsent;
+            };
+            size_t bad = 0;
+            size_t out = b.tri * 9;
+            for (size_t k = 0; k < c.corners.size(); ++k) {
+                const RawCorner& rc = c.corners[k];
+                uint8_t rel = c.relMask[k];
+                uint32_t v = resolve(rc.v, (rel & kRelV) != 0, b.v, totalV);
+                if (v == kAbsent) ++bad;
+                corners[out++] = v;
+                corners[out++] = resolve(rc.t, (rel & kRelT) != 0, b.t, totalT);
+                corners[out++] = resolve(rc.n, (rel & kRelN) != 0, b.n, totalN);
+            }
+            chunkInvalid[ci] = bad;
+
+            int material = chunkStartMaterial[ci];
+            size_t next = 0;
+            const auto& switches = chunkSwitches[ci];
+            size_t chunkTris = c.corners.size() / 3;
+            for (size_t t = 0; t < chunkTris; ++t) {
+                while (next < switches.size() && switches[next].first <= t) material = switches[next++].second;
+                triMaterial[b.tri + t] = material;
+            }
+        }
+    });
+    chunks.clear(); // free the per-chunk copies early, big models need the memory
+    for (size_t n : chunkInvalid) invalid += n;
+    if (invalid) {
+        LOG_WARNING("ObjLoader: " << invalid << " face corners reference missing vertices, dropping their triangles");
+    }
+
+    // 5) group triangles by material (counting sort keeps file order inside a group)
+    const int materialCount = static_cast<int>(mesh.materials.size());
+    std::vector<uint32_t> groupStart(materialCount + 2, 0);
+    for (int m : triMaterial) ++groupStart[m + 2];
+    for (size_t i = 2; i < groupStart.size(); ++i) groupStart[i] += groupStart[i - 1];
+    std::vector<uint32_t> order(totalTris);
+    for (size_t t = 0; t < totalTris; ++t) order[groupStart[triMaterial[t] + 1]++] = static_cast<uint32_t>(t);
+
+    // 6) deduplicate corners into vertices
+    CornerTable table(std::min(totalTris * 3, totalV + totalV / 2 + 16)); // grows if uv/normal seams need more
+    std::vector<uint32_t> uniqueCorners; // v, t, n per output vertex
+    uniqueCorners.reserve(totalV * 3 + 16);
+    mesh.indices.reserve(totalTris * 3);
+    int currentMaterial = -2;
+    for (uint32_t t : order) {
+        const uint32_t* c = &corners[static_cast<size_t>(t) * 9];
+        if (c[0] == kAbsent || c[3] == kAbsent || c[6] == kAbsent) continue;
+        if (triMaterial[t] != currentMaterial) {
+            currentMaterial = triMaterial[t];
+            MeshSubmesh sub;
+            sub.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+            sub.materialIndex = currentMaterial;
+            mesh.submeshes.push_back(sub);
+        }
+        for (int k = 0; k < 3; ++k) {
+            uint32_t next = static_cast<uint32_t>(uniqueCorners.size() / 3);
+            uint32_t index = table.FindOrInsert(c[k * 3], c[k * 3 + 1], c[k * 3 + 2], next);
+            if (index == next) uniqueCorners.insert(uniqueCorners.end(), c + k * 3, c + k * 3 + 3);
+            mesh.indices.push_back(index);
+        }
+    }
+    for (MeshSubmesh& sub : mesh.submeshes) sub.indexCount = 0;
+    for (size_t i = 0; i < mesh.submeshes.size(); ++i) {
+        uint32_t endIndex = (i + 1 < mesh.submeshes.size()) ? mesh.submeshes[i + 1].indexOffset : static_cast<uint32_t>(mesh.indices.size());
+        mesh.submeshes[i].indexCount = endIndex - mesh.submeshes[i].indexOffset;
+    }
+    if (mesh.indices.empty()) {
+        LOG_WARNING("ObjLoader: no valid triangles");
+        return false;
+    }
+
+    // 7) build the interleaved vertices
+    const size_t vertexCount = uniqueCorners.size() / 3;
+    mesh.vertices.resize(vertexCount * MESH_VERTEX_FLOATS);
+    bool missingNormals = false;
+    for (size_t i = 0; i < vertexCount && !missingNormals; ++i) missingNormals = uniqueCorners[i * 3 + 2] == kAbsent;
+
+    // smooth normals per position for corners that didn't give one
+    std::vector<glm::vec3> generated;
+    if (missingNormals) {
+        generated.assign(totalV, glm::vec3(0.0f));
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            uint32_t a = uniqueCorners[mesh.indices[i] * 3], b = uniqueCorners[mesh.indices[i + 1] * 3], c = uniqueCorners[mesh.indices[i + 2] * 3];
+            glm::vec3 pa(positions[a * 3], positions[a * 3 + 1], positions[a * 3 + 2]);
+            glm::vec3 pb(positions[b * 3], positions[b * 3 + 1], positions[b * 3 + 2]);
+            glm::vec3 pc(positions[c * 3], positions[c * 3 + 1], positions[c * 3 + 2]);
+            glm::vec3 fn = glm::cross(pb - pa, pc - pa); // area weighted
+            generated[a] += fn;
+            generated[b] += fn;
+            generated[c] += fn;
+        }
+    }
+
+    Jobs::ParallelFor(vertexCount, 16384, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t v = uniqueCorners[i * 3], t = uniqueCorners[i * 3 + 1], n = uniqueCorners[i * 3 + 2];
+            float* out = &mesh.vertices[i * MESH_VERTEX_FLOATS];
+            out[0] = positions[v * 3];
+            out[1] = positions[v * 3 + 1];
+            out[2] = positions[v * 3 + 2];
+            glm::vec3 normal(0.0f, 1.0f, 0.0f);
+            if (n != kAbsent) normal = glm::vec3(normals[n * 3], normals[n * 3 + 1], normals[n * 3 + 2]);
+            else if (glm::dot(generated[v], generated[v]) > 0.0f) normal = glm::normalize(generated[v]);
+            out[3] = normal.x;
+            out[4] = normal.y;
+            out[5] = normal.z;
+            out[6] = (t != kAbsent) ? uvs[t * 2] : 0.0f;
+            out[7] = (t != kAbsent) ? uvs[t * 2 + 1] : 0.0f;
+        }
+    });
+
+    mesh.boundsMin = mesh.boundsMax = glm::vec3(mesh.vertices[0], mesh.vertices[1], mesh.vertices[2]);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        glm::vec3 p(mesh.vertices[i * MESH_VERTEX_FLOATS], mesh.vertices[i * MESH_VERTEX_FLOATS + 1], mesh.vertices[i * MESH_VERTEX_FLOATS + 2]);
+        mesh.boundsMin = glm::min(mesh.boundsMin, p);
+        mesh.boundsMax = glm::max(mesh.boundsMax, p);
+    }
+    auto t2 = Clock::now();
+
+    if (stats) {
+        stats->bytes = size;
+        stats->triangles = mesh.TriangleCount();
+        stats->vertices = vertexCount;
+        stats->corners = totalTris * 3;
+        stats->parseSeconds = Seconds(t0, t1);
+        stats->resolveSeconds = Seconds(t1, t2);
+        stats->totalSeconds = Seconds(t0, t2);
+    }
+    return true;
+}
+
+bool ObjLoader::Load(const std::string& path, MeshData& mesh, ImportStats* stats) {
+    auto t0 = Clock::now();
+    MappedFile file;
+    if (!OpenAssetFile(path, file)) {
+        LOG_ERROR("ObjLoader: Failed to open " << path);
+        return false;
+    }
+    std::string baseDir = fs::path(path).parent_path().generic_string();
+    if (!LoadFromMemory(file.Data(), file.Size(), baseDir, mesh, stats)) {
+        LOG_ERROR("ObjLoader: Failed to import " << path);
+        return false;
+    }
+    double total = Seconds(t0, Clock::now());
+    if (stats) stats->totalSeconds = total;
+    LOG_INFO("ObjLoader: Loaded " << path << " (" << mesh.TriangleCount() << " triangles, "
+        << mesh.VertexCount() << " vertices, " << mesh.materials.size() << " materials) in "
+        << total * 1000.0 << " ms");
+    return true;
+}
+
+ObjLoader::BenchmarkReport ObjLoader::BenchmarkParse(const std::string& path, int iterations) {
+    BenchmarkReport report;
+    MappedFile file;
+    std::string synthetic;
+    const char* data = nullptr;
+    size_t size = 0;
+    std::string baseDir;
+    if (path.empty()) {
+        synthetic = MakeGridObj(708); // 708^2 quads = ~1.0M triangles
+        data = synthetic.data();
+        size = synthetic.size();
+    }
+    else {
+        if (!file.Open(path)) {
+            LOG_ERROR("ObjLoader: benchmark cannot open " << path);
+            return report;
+        }
+        data = file.Data();
+        size = file.Size();
+        baseDir = fs::path(path).parent_path().generic_string();
+    }
+
+    MeshData mesh;
+    ImportStats best;
+    best.totalSeconds = 1e30;
+    for (int i = 0; i < std::max(1, iterations); ++i) {
+        ImportStats stats;
+        if (!LoadFromMemory(data, size, baseDir, mesh, &stats)) return report;
+        if (stats.totalSeconds < best.totalSeconds) best = stats;
+    }
+
+    report.bytes = size;
+    report.triangles = best.triangles;
+    report.bestSeconds = best.totalSeconds;
+    report.mbPerSec = (size / (1024.0 * 1024.0)) / best.totalSeconds;
+    report.mTrianglesPerSec = (best.triangles / 1e6) / best.totalSeconds;
+    LOG_INFO("ObjLoader benchmark: " << (path.empty() ? std::string("synthetic grid") : path) << ", "
+        << size / (1024 * 1024) << " MB, " << best.triangles << " tris, " << best.vertices << " verts | best "
+        << best.totalSeconds * 1000.0 << " ms (parse " << best.parseSeconds * 1000.0 << " ms, resolve+dedup "
+        << best.resolveSeconds * 1000.0 << " ms) | " << report.mbPerSec << " MB/s, "
+        << report.mTrianglesPerSec << " Mtris/s on " << Jobs::WorkerCount() + 1 << " threads");
+    return report;
+}
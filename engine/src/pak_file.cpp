@@ -0,0 +1,312 @@
+#include "../include/pak_file.h"
+#include "../include/hash.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include "../include/lz4.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+    size_t Align(size_t v) { return (v + PakFile::kAlignment - 1) & ~(PakFile::kAlignment - 1); }
+
+    // One input after reading/compressing
+    struct Packed {
+        std::string name;
+        uint64_t hash = 0;
+        uint64_t size = 0;
+        uint64_t checksum = 0;
+        PakFile::Compression compression = PakFile::Compression::None;
+        std::vector<uint8_t> bytes;   // stored bytes
+        bool ok = false;
+    };
+
+    bool ReadWholeFile(const std::string& path, std::vector<uint8_t>& out) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        std::streamsize size = in.tellg();
+        in.seekg(0);
+        out.resize(static_cast<size_t>(size));
+        return size == 0 || static_cast<bool>(in.read(reinterpret_cast<char*>(out.data()), size));
+    }
+}
+
+size_t PakFile::NameStart(std::string_view name) {
+    size_t start = 0;
+    while (true) {
+        if (start + 1 < name.size() && name[start] == '.' && NormalizeChar(name[start + 1]) == '/') start += 2;
+        else if (start < name.size() && NormalizeChar(name[start]) == '/') ++start;
+        else break;
+    }
+    return start;
+}
+
+std::string PakFile::NormalizeName(std::string_view name) {
+    std::string out;
+    out.reserve(name.size());
+    for (size_t i = NameStart(name); i < name.size(); ++i) out.push_back(NormalizeChar(name[i]));
+    return out;
+}
+
+uint64_t PakFile::HashName(std::string_view name) {
+    // same as Fnv1a64(NormalizeName(name)) without the string
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = NameStart(name); i < name.size(); ++i) {
+        h ^= static_cast<unsigned char>(NormalizeChar(name[i]));
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+bool PakFile::Collect(const std::string& root, const std::string& dir, std::vector<Input>& inputs) {
+    std::error_code ec;
+    fs::path base = fs::path(root) / dir;
+    if (fs::is_regular_file(base, ec)) {
+        inputs.push_back({ fs::path(dir).generic_string(), base.string() });
+        return true;
+    }
+    if (!fs::is_directory(base, ec)) {
+        LOG_ERROR("PakFile: no such file or folder " << base.string());
+        return false;
+    }
+    for (auto it = fs::recursive_directory_iterator(base, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        fs::path rel = it->path().lexically_relative(root);
+        inputs.push_back({ rel.generic_string(), it->path().string() });
+    }
+    return !ec;
+}
+
+bool PakFile::Write(const std::string& path, const std::vector<Input>& inputs, const WriteOptions& options, WriteReport* report) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Packed> packed(inputs.size());
+
+    Jobs::ParallelFor(inputs.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Packed& p = packed[i];
+            p.name = inputs[i].name;
+            p.hash = HashName(p.name);
+            std::vector<uint8_t> raw;
+            if (!ReadWholeFile(inputs[i].sourcePath, raw)) continue;
+            p.size = raw.size();
+            p.checksum = Hash::Bytes64(raw.data(), raw.size());
+            p.ok = true;
+
+            std::string ext = fs::path(p.name).extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            bool store = !options.compress || raw.empty()
+                || std::find(options.storeExtensions.begin(), options.storeExtensions.end(), ext) != options.storeExtensions.end();
+            if (!store) {
+                std::vector<uint8_t> lz(Lz4::CompressBound(raw.size()));
+                size_t size = Lz4::Compress(raw.data(), raw.size(), lz.data(), lz.size());
+                if (size > 0 && size <= raw.size() * (1.0f - options.minSaving)) {
+                    lz.resize(size);
+                    p.bytes.swap(lz);
+                    p.compression = Compression::Lz4;
+                    continue;
+                }
+            }
+            p.bytes.swap(raw);
+        }
+    });
+
+    for (const Packed& p : packed) {
+        if (!p.ok) {
+            LOG_ERROR("PakFile: cannot read " << p.name);
+            return false;
+        }
+    }
+    std::sort(packed.begin(), packed.end(), [](const Packed& a, const Packed& b) { return a.hash < b.hash; });
+    for (size_t i = 1; i < packed.size(); ++i) {
+        if (packed[i].hash == packed[i - 1].hash) {
+            LOG_ERROR("PakFile: " << packed[i - 1].name << " and " << packed[i].name << " map to the same entry");
+            return false;
+        }
+    }
+
+    // index
+    std::vector<Entry> entries(packed.size());
+    std::vector<char> strings;
+    for (size_t i = 0; i < packed.size(); ++i) {
+        Entry& e = entries[i];
+        std::memset(&e, 0, sizeof(e));
+        e.hash = packed[i].hash;
+        e.storedSize = packed[i].bytes.size();
+        e.size = packed[i].size;
+        e.checksum = packed[i].checksum;
+        e.compression = static_cast<uint32_t>(packed[i].compression);
+        e.nameOffset = static_cast<uint32_t>(strings.size());
+        e.nameLength = static_cast<uint32_t>(packed[i].name.size());
+        strings.insert(strings.end(), packed[i].name.begin(), packed[i].name.end());
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(Header);
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.entryOffset = Align(sizeof(Header));
+    header.stringOffset = header.entryOffset + entries.size() * sizeof(Entry);
+    header.stringBytes = strings.size();
+    uint64_t offset = Align(header.stringOffset + strings.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i].offset = offset;
+        offset = Align(offset + entries[i].storedSize);
+    }
+    header.fileSize = offset;
+
+    std::vector<uint8_t> index(entries.size() * sizeof(Entry) + strings.size());
+    if (!entries.empty()) std::memcpy(index.data(), entries.data(), entries.size() * sizeof(Entry));
+    if (!strings.empty()) std::memcpy(index.data() + entries.size() * sizeof(Entry), strings.data(), strings.size());
+    header.indexChecksum = Hash::Bytes64(index.data(), index.size());
+
+    // stream out: header, index, then each entry at its aligned offset
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        static const char zeros[kAlignment] = {};
+        auto pad = [&](uint64_t to) {
+            uint64_t at = static_cast<uint64_t>(out.tellp());
+            if (to > at) out.write(zeros, static_cast<std::streamsize>(to - at));
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad(header.entryOffset);
+        out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+        for (size_t i = 0; i < entries.size(); ++i) {
+            pad(entries[i].offset);
+            out.write(reinterpret_cast<const char*>(packed[i].bytes.data()), static_cast<std::streamsize>(packed[i].bytes.size()));
+        }
+        pad(header.fileSize);
+        if (!out) {
+            LOG_ERROR("PakFile: failed to write " << tmp);
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        LOG_ERROR("PakFile: failed to replace " << path << ": " << ec.message());
+        fs::remove(tmp, ec);
+        return false;
+    }
+
+    WriteReport r;
+    r.files = packed.size();
+    for (const Packed& p : packed) {
+        r.bytesIn += p.size;
+        if (p.compression != Compression::None) ++r.compressed;
+    }
+    r.bytesOut = header.fileSize;
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    LOG_INFO("PakFile: wrote " << path << ": " << r.files << " files (" << r.compressed << " lz4), "
+        << r.bytesIn / 1024 << " KB -> " << r.bytesOut / 1024 << " KB in " << r.seconds * 1000.0 << " ms");
+    if (report) *report = r;
+    return true;
+}
+
+bool PakArchive::Open(const std::string& path) {
+    Close();
+    if (!m_file.Open(path)) return false;
+    m_path = path;
+
+    const size_t size = m_file.Size();
+    const PakFile::Header* h = reinterpret_cast<const PakFile::Header*>(m_file.Data());
+    auto fail = [&](const char* why) {
+        LOG_ERROR("PakArchive: " << path << ": " << why);
+        Close();
+        return false;
+    };
+    if (size < sizeof(PakFile::Header) || std::memcmp(h->magic, PakFile::kMagic, sizeof(PakFile::kMagic)) != 0) return fail("not a .spxpak file");
+    if (h->version != PakFile::kVersion || h->headerSize != sizeof(PakFile::Header)) return fail("version mismatch, rebuild the pack");
+    if (h->fileSize != size) return fail("truncated");
+    const uint64_t indexBytes = uint64_t(h->entryCount) * sizeof(PakFile::Entry);
+    if (h->entryOffset > size || indexBytes > size - h->entryOffset || h->stringOffset != h->entryOffset + indexBytes
+        || h->stringBytes > size - h->stringOffset) {
+        return fail("index out of range");
+    }
+    if (Hash::Bytes64(m_file.Data() + h->entryOffset, indexBytes + h->stringBytes) != h->indexChecksum) return fail("index checksum mismatch");
+
+    // entries are trusted from here on, so check their ranges once
+    const PakFile::Entry* entries = reinterpret_cast<const PakFile::Entry*>(m_file.Data() + h->entryOffset);
+    for (uint32_t i = 0; i < h->entryCount; ++i) {
+        const PakFile::Entry& e = entries[i];
+        if (e.offset > size || e.storedSize > size - e.offset || uint64_t(e.nameOffset) + e.nameLength > h->stringBytes
+            || (e.compression == static_cast<uint32_t>(PakFile::Compression::None) && e.storedSize != e.size)
+            || e.compression > static_cast<uint32_t>(PakFile::Compression::Lz4)) {
+            return fail("entry out of range");
+        }
+    }
+    m_header = h;
+    m_entries = entries;
+    LOG_INFO("PakArchive: mounted " << path << " (" << h->entryCount << " entries)");
+    return true;
+}
+
+void PakArchive::Close() {
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_file.Close();
+    m_path.clear();
+}
+
+const PakFile::Entry* PakArchive::Find(std::string_view name) const {
+    return FindHash(PakFile::HashName(name));
+}
+
+const PakFile::Entry* PakArchive::FindHash(uint64_t hash) const {
+    if (!m_header) return nullptr;
+    const PakFile::Entry* end = m_entries + m_header->entryCount;
+    const PakFile::Entry* it = std::lower_bound(m_entries, end, hash,
+        [](const PakFile::Entry& e, uint64_t h) { return e.hash < h; });
+    return (it != end && it->hash == hash) ? it : nullptr;
+}
+
+const uint8_t* PakArchive::View(const PakFile::Entry& entry) const {
+    if (!m_header || entry.compression != static_cast<uint32_t>(PakFile::Compression::None)) return nullptr;
+    return reinterpret_cast<const uint8_t*>(m_file.Data() + entry.offset);
+}
+
+bool PakArchive::Read(const PakFile::Entry& entry, std::vector<uint8_t>& out) const {
+    if (!m_header) return false;
+    const uint8_t* stored = reinterpret_cast<const uint8_t*>(m_file.Data() + entry.offset);
+    out.resize(static_cast<size_t>(entry.size));
+    if (entry.compression == static_cast<uint32_t>(PakFile::Compression::None)) {
+        if (entry.size) std::memcpy(out.data(), stored, static_cast<size_t>(entry.size));
+        return true;
+    }
+    if (!Lz4::Decompress(stored, static_cast<size_t>(entry.storedSize), out.data(), out.size())) {
+        LOG_ERROR("PakArchive: corrupt entry " << Name(entry) << " in " << m_path);
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool PakArchive::Read(std::string_view name, std::vector<uint8_t>& out) const {
+    const PakFile::Entry* entry = Find(name);
+    return entry && Read(*entry, out);
+}
+
+std::string_view PakArchive::Name(const PakFile::Entry& entry) const {
+    if (!m_header) return std::string_view();
+    return std::string_view(m_file.Data() + m_header->stringOffset + entry.nameOffset, entry.nameLength);
+}
+
+bool PakArchive::Verify() const {
+    bool ok = true;
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i < EntryCount(); ++i) {
+        const PakFile::Entry& e = m_entries[i];
+        if (!Read(e, bytes) || Hash::Bytes64(bytes.data(), bytes.size()) != e.checksum) {
+            LOG_ERROR("PakArchive: checksum mismatch for " << Name(e));
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,192 @@
+#include "../include/program_cache.h"
+#include "../include/hash.h"
+#include "../include/log.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char kMagic[8] = { 'S', 'P', 'X', 'P', 'R', 'O', 'G', '\0' };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t binaryFormat;   // GLenum from glGetProgramBinary
+        uint64_t key;
+        uint64_t driverHash;
+        uint64_t binarySize;
+        uint64_t checksum;       // Hash::Bytes64 of the binary
+    };
+    static_assert(sizeof(Header) == 48, "ProgramCache::Header layout changed, bump kVersion");
+
+    std::string s_directory;
+    uint64_t s_driverHash = 0;
+    int s_enabled = -1;          // -1 = not checked yet (needs a GL context)
+    ProgramCache::Stats s_stats;
+
+    const char* GLString(GLenum name) {
+        const GLubyte* s = glGetString(name);
+        return s ? reinterpret_cast<const char*>(s) : "";
+    }
+
+    uint64_t DriverHash() {
+        if (s_driverHash == 0) {
+            uint64_t h = Hash::Fnv1a64(GLString(GL_VENDOR));
+            h = Hash::Fnv1a64(GLString(GL_RENDERER), h);
+            h = Hash::Fnv1a64(GLString(GL_VERSION), h);
+            s_driverHash = h;
+        }
+        return s_driverHash;
+    }
+
+    std::string EntryPath(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return (fs::path(s_directory) / (std::string(name) + ProgramCache::kExtension)).string();
+    }
+
+    void Reject(const std::string& path, const char* why) {
+        LOG_WARNING("ProgramCache: dropping " << path << ": " << why);
+        std::error_code ec;
+        fs::remove(path, ec);
+        ++s_stats.rejected;
+    }
+}
+
+void ProgramCache::SetDirectory(const std::string& directory) {
+    s_directory = directory;
+    s_enabled = -1;
+}
+
+const std::string& ProgramCache::Directory() {
+    return s_directory;
+}
+
+bool ProgramCache::IsEnabled() {
+    if (s_directory.empty()) return false;
+    if (s_enabled < 0) {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        s_enabled = formats > 0 ? 1 : 0;
+        if (!s_enabled) {
+            LOG_INFO("ProgramCache: driver offers no program binary formats, cache off");
+        }
+    }
+    return s_enabled == 1;
+}
+
+uint64_t ProgramCache::Key(std::string_view vertexSource, std::string_view fragmentSource) {
+    uint64_t h = Hash::Bytes64(vertexSource.data(), vertexSource.size(), DriverHash());
+    h = Hash::Bytes64(fragmentSource.data(), fragmentSource.size(), h);
+    return Hash::Mix64(h ^ kVersion);
+}
+
+GLuint ProgramCache::Load(uint64_t key) {
+    if (!IsEnabled()) return 0;
+    auto t0 = std::chrono::steady_clock::now();
+    auto done = [&](GLuint program) {
+        s_stats.loadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return program;
+    };
+
+    const std::string path = EntryPath(key);
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        ++s_stats.misses;
+        return done(0);
+    }
+    const std::streamsize size = in.tellg();
+    in.seekg(0);
+    Header header;
+    if (size < static_cast<std::streamsize>(sizeof(Header)) || !in.read(reinterpret_cast<char*>(&header), sizeof(Header))
+        || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        in.close();
+        Reject(path, "not a program cache entry of this version");
+        return done(0);
+    }
+    if (header.key != key || header.driverHash != DriverHash()) {
+        in.close();
+        Reject(path, "built for other sources or another driver");
+        return done(0);
+    }
+    if (header.binarySize != static_cast<uint64_t>(size) - sizeof(Header)) {
+        in.close();
+        Reject(path, "truncated");
+        return done(0);
+    }
+    std::vector<char> binary(static_cast<size_t>(header.binarySize));
+    if (!in.read(binary.data(), static_cast<std::streamsize>(binary.size()))
+        || Hash::Bytes64(binary.data(), binary.size()) != header.checksum) {
+        in.close();
+        Reject(path, "checksum mismatch");
+        return done(0);
+    }
+    in.close();
+
+    // the driver may still refuse the binary (it is allowed to after any update)
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        glDeleteProgram(program);
+        Reject(path, "driver rejected the binary");
+        return done(0);
+    }
+    ++s_stats.hits;
+    return done(program);
+}
+
+bool ProgramCache::Store(uint64_t key, GLuint program) {
+    if (!IsEnabled() || program == 0) return false;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return false;
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return false;
+    binary.resize(static_cast<size_t>(written));
+
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.binaryFormat = format;
+    header.key = key;
+    header.driverHash = DriverHash();
+    header.binarySize = binary.size();
+    header.checksum = Hash::Bytes64(binary.data(), binary.size());
+
+    std::error_code ec;
+    fs::create_directories(s_directory, ec);
+    // temp file + rename so a crash never leaves half an entry behind
+    const std::string path = EntryPath(key);
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.write(reinterpret_cast<const char*>(&header), sizeof(header))
+            || !out.write(binary.data(), static_cast<std::streamsize>(binary.size()))) {
+            LOG_WARNING("ProgramCache: cannot write " << tmp);
+            return false;
+        }
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    ++s_stats.stores;
+    return true;
+}
+
+ProgramCache::Stats ProgramCache::GetStats() {
+    return s_stats;
+}
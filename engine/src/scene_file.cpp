@@ -0,0 +1,361 @@
+#include "../include/scene_file.h"
+#include "../include/hash.h"
+#include "../include/log.h"
+#include "../include/lz4.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+using namespace SceneFile;
+
+static_assert(sizeof(glm::vec3) == 12, "SceneFile stores glm::vec3 columns as three packed floats");
+
+namespace {
+    size_t Align16(size_t v) { return (v + 15) & ~size_t(15); }
+
+    // Block element size of the known columns, 0 for blocks this reader doesn't know
+    size_t EntityColumnSize(uint32_t id) {
+        switch (id) {
+        case kBlockIds:
+        case kBlockTypes:
+        case kBlockObjIndex:
+        case kBlockPoints:
+        case kBlockHealth:
+        case kBlockNames:
+        case kBlockTextures:
+        case kBlockMeshes:
+            return 4;
+        case kBlockPositions:
+        case kBlockRotations:
+        case kBlockScales:
+            return sizeof(glm::vec3);
+        case kBlockFlags:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+
+    // Copy a mapped column into a vector, or fill it with a default when the block is missing
+    template <typename T>
+    void CopyColumn(const SceneView& view, uint32_t id, std::vector<T>& out, const T& fallback) {
+        const T* column = view.Column<T>(id);
+        if (column) out.assign(column, column + view.EntityCount());
+        else out.assign(view.EntityCount(), fallback);
+    }
+}
+
+void SceneFile::Columns::Clear() {
+    ids.clear();
+    types.clear();
+    objectIndices.clear();
+    positions.clear();
+    rotations.clear();
+    scales.clear();
+    flags.clear();
+    points.clear();
+    healthPoints.clear();
+    names.clear();
+    textures.clear();
+    meshes.clear();
+    strings.clear();
+    lookup.clear();
+}
+
+void SceneFile::Columns::Reserve(size_t count) {
+    ids.reserve(count);
+    types.reserve(count);
+    objectIndices.reserve(count);
+    positions.reserve(count);
+    rotations.reserve(count);
+    scales.reserve(count);
+    flags.reserve(count);
+    points.reserve(count);
+    healthPoints.reserve(count);
+    names.reserve(count);
+    textures.reserve(count);
+    meshes.reserve(count);
+}
+
+size_t SceneFile::Columns::AddEntity(int32_t id) {
+    ids.push_back(id);
+    types.push_back(-1);
+    objectIndices.push_back(-1);
+    positions.emplace_back(0.0f);
+    rotations.emplace_back(0.0f);
+    scales.emplace_back(1.0f);
+    flags.push_back(kDefaultFlags);
+    points.push_back(0);
+    healthPoints.push_back(0);
+    names.push_back(kNoString);
+    textures.push_back(kNoString);
+    meshes.push_back(kNoString);
+    return ids.size() - 1;
+}
+
+uint32_t SceneFile::Columns::Intern(std::string_view s) {
+    auto it = lookup.find(s);
+    if (it != lookup.end()) return it->second;
+    const uint32_t index = static_cast<uint32_t>(strings.size());
+    strings.emplace_back(s);
+    lookup.emplace(strings.back(), index);
+    return index;
+}
+
+const std::string& SceneFile::Columns::String(uint32_t index) const {
+    static const std::string empty;
+    return index < strings.size() ? strings[index] : empty;
+}
+
+bool SceneFile::Encode(const Columns& scene, std::vector<char>& file, bool compress) {
+    const size_t count = scene.Size();
+    if (scene.types.size() != count || scene.objectIndices.size() != count || scene.positions.size() != count
+        || scene.rotations.size() != count || scene.scales.size() != count || scene.flags.size() != count
+        || scene.points.size() != count || scene.healthPoints.size() != count || scene.names.size() != count
+        || scene.textures.size() != count || scene.meshes.size() != count) {
+        LOG_ERROR("SceneFile: columns of different length, not encoding the scene");
+        return false;
+    }
+
+    std::vector<uint32_t> stringOffsets;
+    stringOffsets.reserve(scene.strings.size() + 1);
+    size_t stringBytes = 0;
+    for (const std::string& s : scene.strings) {
+        stringOffsets.push_back(static_cast<uint32_t>(stringBytes));
+        stringBytes += s.size();
+    }
+    stringOffsets.push_back(static_cast<uint32_t>(stringBytes));
+    if (stringBytes > 0xFFFFFFFFu) {
+        LOG_ERROR("SceneFile: string table too large, not encoding the scene");
+        return false;
+    }
+
+    struct Source {
+        uint32_t id;
+        uint32_t elementSize;
+        const void* data;
+        size_t count;
+    };
+    const Source sources[] = {
+        { kBlockIds, 4, scene.ids.data(), count },
+        { kBlockTypes, 4, scene.types.data(), count },
+        { kBlockObjIndex, 4, scene.objectIndices.data(), count },
+        { kBlockPositions, sizeof(glm::vec3), scene.positions.data(), count },
+        { kBlockRotations, sizeof(glm::vec3), scene.rotations.data(), count },
+        { kBlockScales, sizeof(glm::vec3), scene.scales.data(), count },
+        { kBlockFlags, 1, scene.flags.data(), count },
+        { kBlockPoints, 4, scene.points.data(), count },
+        { kBlockHealth, 4, scene.healthPoints.data(), count },
+        { kBlockNames, 4, scene.names.data(), count },
+        { kBlockTextures, 4, scene.textures.data(), count },
+        { kBlockMeshes, 4, scene.meshes.data(), count },
+        { kBlockStringOffsets, 4, stringOffsets.data(), stringOffsets.size() },
+        { kBlockStringData, 1, nullptr, stringBytes },   // gathered from the strings below
+    };
+    constexpr size_t kBlockCount = sizeof(sources) / sizeof(sources[0]);
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(Header);
+    header.entityCount = count;
+    header.blockCount = static_cast<uint32_t>(kBlockCount);
+    header.stringCount = static_cast<uint32_t>(scene.strings.size());
+
+    BlockRecord records[kBlockCount];
+    size_t offset = Align16(sizeof(Header) + sizeof(records));
+    for (size_t i = 0; i < kBlockCount; ++i) {
+        records[i] = { sources[i].id, sources[i].elementSize, offset, sources[i].count };
+        offset = Align16(offset + sources[i].count * sources[i].elementSize);
+    }
+    header.payloadBytes = offset - sizeof(Header);
+
+    // build the whole file in memory, it is written with a single call
+    file.assign(offset, 0);
+    std::memcpy(file.data() + sizeof(Header), records, sizeof(records));
+    for (size_t i = 0; i < kBlockCount; ++i) {
+        const size_t bytes = sources[i].count * sources[i].elementSize;
+        if (sources[i].data && bytes) std::memcpy(file.data() + records[i].offset, sources[i].data, bytes);
+    }
+    char* strings = file.data() + records[kBlockCount - 1].offset;
+    for (const std::string& s : scene.strings) {
+        std::memcpy(strings, s.data(), s.size());
+        strings += s.size();
+    }
+    header.checksum = Hash::Bytes64(file.data() + sizeof(Header), header.payloadBytes);
+    std::memcpy(file.data(), &header, sizeof(Header));
+    if (!compress) return true;
+
+    std::vector<char> packed(sizeof(PackedHeader) + Lz4::CompressBound(file.size()));
+    const size_t stored = Lz4::Compress(reinterpret_cast<const uint8_t*>(file.data()), file.size(),
+        reinterpret_cast<uint8_t*>(packed.data() + sizeof(PackedHeader)), packed.size() - sizeof(PackedHeader));
+    if (stored == 0) {
+        LOG_ERROR("SceneFile: LZ4 compression failed");
+        return false;
+    }
+    PackedHeader packedHeader{};
+    std::memcpy(packedHeader.magic, kPackedMagic, sizeof(kPackedMagic));
+    packedHeader.version = kVersion;
+    packedHeader.headerSize = sizeof(PackedHeader);
+    packedHeader.rawSize = file.size();
+    packedHeader.storedSize = stored;
+    packedHeader.checksum = Hash::Bytes64(packed.data() + sizeof(PackedHeader), stored);
+    std::memcpy(packed.data(), &packedHeader, sizeof(PackedHeader));
+    packed.resize(sizeof(PackedHeader) + stored);
+    file.swap(packed);
+    return true;
+}
+
+bool SceneFile::Write(const std::string& path, const Columns& scene, bool compress) {
+    std::vector<char> file;
+    if (!Encode(scene, file, compress)) {
+        LOG_ERROR("SceneFile: not writing " << path);
+        return false;
+    }
+
+    std::error_code ec;
+    if (fs::path(path).has_parent_path()) fs::create_directories(fs::path(path).parent_path(), ec);
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.write(file.data(), static_cast<std::streamsize>(file.size()))) {
+            LOG_ERROR("SceneFile: failed to write " << tmp);
+            return false;
+        }
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        LOG_ERROR("SceneFile: failed to replace " << path << ": " << ec.message());
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool SceneFile::Read(const std::string& path, Columns& scene) {
+    SceneView view;
+    if (!view.Open(path)) return false;
+
+    scene.Clear();
+    const glm::vec3 zero(0.0f), one(1.0f);
+    CopyColumn<int32_t>(view, kBlockIds, scene.ids, -1);
+    CopyColumn<int32_t>(view, kBlockTypes, scene.types, -1);
+    CopyColumn<int32_t>(view, kBlockObjIndex, scene.objectIndices, -1);
+    CopyColumn(view, kBlockPositions, scene.positions, zero);
+    CopyColumn(view, kBlockRotations, scene.rotations, zero);
+    CopyColumn(view, kBlockScales, scene.scales, one);
+    CopyColumn<uint8_t>(view, kBlockFlags, scene.flags, kDefaultFlags);
+    CopyColumn<int32_t>(view, kBlockPoints, scene.points, 0);
+    CopyColumn<int32_t>(view, kBlockHealth, scene.healthPoints, 0);
+    CopyColumn<uint32_t>(view, kBlockNames, scene.names, kNoString);
+    CopyColumn<uint32_t>(view, kBlockTextures, scene.textures, kNoString);
+    CopyColumn<uint32_t>(view, kBlockMeshes, scene.meshes, kNoString);
+
+    scene.strings.reserve(view.StringCount());
+    for (uint32_t i = 0; i < view.StringCount(); ++i) {
+        scene.strings.emplace_back(view.String(i));
+        scene.lookup.emplace(scene.strings.back(), i);
+    }
+    return true;
+}
+
+bool SceneView::Open(const std::string& path, bool verifyChecksum) {
+    Close();
+    if (!m_file.Open(path)) return false;
+
+    // a packed file: check the LZ4 block and swap the mapping for the unpacked bytes
+    if (m_file.Size() >= sizeof(PackedHeader) && std::memcmp(m_file.Data(), kPackedMagic, sizeof(kPackedMagic)) == 0) {
+        const PackedHeader* packed = reinterpret_cast<const PackedHeader*>(m_file.Data());
+        const char* why = nullptr;
+        if (packed->version != kVersion || packed->headerSize != sizeof(PackedHeader)) why = "unsupported version";
+        else if (packed->storedSize != m_file.Size() - sizeof(PackedHeader)) why = "truncated";
+        else if (verifyChecksum && Hash::Bytes64(m_file.Data() + sizeof(PackedHeader), packed->storedSize) != packed->checksum) why = "checksum mismatch";
+        else if (packed->rawSize < sizeof(Header) || packed->rawSize > (uint64_t(1) << 36)) why = "bad unpacked size";
+        std::vector<uint8_t> raw;
+        if (!why) {
+            raw.resize(static_cast<size_t>(packed->rawSize));
+            if (!Lz4::Decompress(reinterpret_cast<const uint8_t*>(m_file.Data() + sizeof(PackedHeader)),
+                    static_cast<size_t>(packed->storedSize), raw.data(), raw.size())) {
+                why = "corrupt LZ4 data";
+            }
+        }
+        if (why) {
+            LOG_WARNING("SceneView: " << path << ": " << why);
+            Close();
+            return false;
+        }
+        m_file.OpenBuffer(std::move(raw));
+        verifyChecksum = false;   // the packed checksum already covered these bytes
+    }
+
+    const size_t size = m_file.Size();
+    const Header* h = reinterpret_cast<const Header*>(m_file.Data());
+    auto fail = [&](const char* why) {
+        LOG_WARNING("SceneView: " << path << ": " << why);
+        Close();
+        return false;
+    };
+    if (size < sizeof(Header) || std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0) return fail("not a .spxscene file");
+    if (h->version != kVersion || h->headerSize != sizeof(Header)) return fail("unsupported version");
+    if (h->payloadBytes != size - sizeof(Header)) return fail("truncated");
+    if (h->blockCount > (size - sizeof(Header)) / sizeof(BlockRecord)) return fail("block table out of range");
+
+    // every block must lie inside the file, aligned, with the row count its kind requires
+    const BlockRecord* blocks = reinterpret_cast<const BlockRecord*>(m_file.Data() + sizeof(Header));
+    auto inside = [size](uint64_t offset, uint64_t bytes) { return offset <= size && bytes <= size - offset; };
+    const BlockRecord* offsets = nullptr;
+    const BlockRecord* data = nullptr;
+    bool hasIds = false;
+    for (uint32_t i = 0; i < h->blockCount; ++i) {
+        const BlockRecord& b = blocks[i];
+        if (b.elementSize == 0 || b.count > size / b.elementSize || !inside(b.offset, b.count * b.elementSize) || (b.offset & 15) != 0) {
+            return fail("block out of range");
+        }
+        const size_t columnSize = EntityColumnSize(b.id);
+        if (columnSize != 0 && (b.elementSize != columnSize || b.count != h->entityCount)) return fail("column size mismatch");
+        if (b.id == kBlockIds) hasIds = true;
+        if (b.id == kBlockStringOffsets) offsets = &b;
+        if (b.id == kBlockStringData) data = &b;
+    }
+    if (!hasIds && h->entityCount > 0) return fail("no entity id column");
+    if (!offsets || !data || offsets->elementSize != 4 || data->elementSize != 1 || offsets->count != uint64_t(h->stringCount) + 1) {
+        return fail("bad string table");
+    }
+    const uint32_t* stringOffsets = reinterpret_cast<const uint32_t*>(m_file.Data() + offsets->offset);
+    for (uint32_t i = 0; i < h->stringCount; ++i) {
+        if (stringOffsets[i] > stringOffsets[i + 1]) return fail("bad string table");
+    }
+    if (stringOffsets[h->stringCount] > data->count) return fail("bad string table");
+    if (verifyChecksum && Hash::Bytes64(m_file.Data() + sizeof(Header), h->payloadBytes) != h->checksum) {
+        return fail("checksum mismatch");
+    }
+
+    m_header = h;
+    m_blocks = blocks;
+    m_stringOffsets = stringOffsets;
+    m_stringData = m_file.Data() + data->offset;
+    return true;
+}
+
+void SceneView::Close() {
+    m_header = nullptr;
+    m_blocks = nullptr;
+    m_stringOffsets = nullptr;
+    m_stringData = nullptr;
+    m_file.Close();
+}
+
+std::string_view SceneView::String(uint32_t index) const {
+    if (!m_header || index >= m_header->stringCount) return std::string_view();
+    return std::string_view(m_stringData + m_stringOffsets[index], m_stringOffsets[index + 1] - m_stringOffsets[index]);
+}
+
+const void* SceneView::Find(uint32_t id, size_t elementSize) const {
+    if (!m_header) return nullptr;
+    for (uint32_t i = 0; i < m_header->blockCount; ++i) {
+        if (m_blocks[i].id == id && m_blocks[i].elementSize == elementSize) return m_file.Data() + m_blocks[i].offset;
+    }
+    return nullptr;
+}
@@ -0,0 +1,111 @@
+#include "../include/scene_saver.h"
+#include "../include/hash.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include "../include/scene_text.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+    bool WriteAtomic(const std::string& path, const char* data, size_t size) {
+        std::error_code ec;
+        if (fs::path(path).has_parent_path()) fs::create_directories(fs::path(path).parent_path(), ec);
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.write(data, static_cast<std::streamsize>(size))) {
+                LOG_ERROR("SceneSaver: failed to write " << tmp);
+                return false;
+            }
+        }
+        fs::rename(tmp, path, ec);
+        if (ec) {
+            LOG_ERROR("SceneSaver: failed to replace " << path << ": " << ec.message());
+            fs::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+}
+
+SceneSaver::~SceneSaver() {
+    Wait();
+}
+
+void SceneSaver::Start(const std::string& path, bool autosave, double snapshotSeconds) {
+    if (m_busy) {
+        LOG_WARNING("SceneSaver: a save is still running, " << path << " not saved");
+        return;
+    }
+    m_path = path;
+    m_autosave = autosave;
+    m_snapshotSeconds = snapshotSeconds;
+    m_busy = true;
+    Jobs::Submit([this]() { Save(); });
+}
+
+void SceneSaver::Save() {
+    auto t0 = std::chrono::steady_clock::now();
+    Result result;
+    result.path = m_path;
+    result.autosave = m_autosave;
+    result.snapshotSeconds = m_snapshotSeconds;
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool encoded = true;
+    if (SceneText::IsTextPath(m_path)) {
+        m_text.clear();
+        SceneText::Serialize(m_snapshot, m_text);
+        data = m_text.data();
+        size = m_text.size();
+    }
+    else {
+        encoded = SceneFile::Encode(m_snapshot, m_bytes, m_autosave);
+        data = m_bytes.data();
+        size = m_bytes.size();
+    }
+
+    if (encoded) {
+        result.bytes = size;
+        // an idle editor would otherwise rewrite the same autosave every interval
+        const uint64_t hash = m_autosave ? Hash::Bytes64(data, size) : 0;
+        if (m_autosave && hash == m_lastAutosaveHash && m_path == m_lastAutosavePath && fs::exists(m_path)) {
+            result.ok = true;
+            result.unchanged = true;
+        }
+        else {
+            result.ok = WriteAtomic(m_path, data, size);
+            if (result.ok && m_autosave) {
+                m_lastAutosaveHash = hash;
+                m_lastAutosavePath = m_path;
+            }
+        }
+    }
+    result.saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_result = std::move(result);
+    m_done = true;
+    m_doneCv.notify_all();
+}
+
+bool SceneSaver::Poll(Result& result) {
+    if (!m_busy) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_done) return false;
+    result = std::move(m_result);
+    m_done = false;
+    m_busy = false;
+    return true;
+}
+
+void SceneSaver::Wait() {
+    if (!m_busy) return;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCv.wait(lock, [this]() { return m_done; });
+}
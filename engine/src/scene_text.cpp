@@ -0,0 +1,456 @@
+#include "../include/scene_text.h"
+#include "../include/globalVar.h"
+#include "../include/log.h"
+#include "../include/mapped_file.h"
+#include "../include/text_parse.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+
+namespace fs = std::filesystem;
+using namespace SceneFile;
+using namespace TextParse;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double Seconds(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double>(b - a).count();
+    }
+
+    struct NamedType {
+        int type;
+        const char* name;
+    };
+    const NamedType kTypeNames[] = {
+        { OBJ_CUBE, "cube" }, { OBJ_PLANE, "plane" }, { OBJ_CIRCLE, "circle" }, { OBJ_LINE, "line" },
+        { OBJ_SPHERE, "sphere" }, { OBJ_CYLINDER, "cylinder" }, { OBJ_TORUS, "torus" }, { OBJ_GRID, "grid" },
+        { OBJ_CONE, "cone" }, { OBJ_PYRAMID, "pyramid" }, { OBJ_TRIANGEL, "triangle" }, { OBJ_FLOOR, "floor" },
+        { OBJ_MESH, "mesh" },
+    };
+
+    struct NamedFlag {
+        uint8_t flag;
+        const char* name;
+    };
+    const NamedFlag kFlagNames[] = {
+        { FlagActive, "active" }, { FlagHealthPack, "healthpack" }, { FlagDangerous, "dangerous" },
+        { FlagCollidable, "collidable" }, { FlagVisible, "visible" },
+    };
+
+    void AppendInt(std::string& out, int64_t value) {
+        char buffer[24];
+        std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    // Shortest text that reads back to the same float
+    void AppendFloat(std::string& out, float value) {
+        char buffer[32];
+        std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    void AppendVec3(std::string& out, const char* key, const glm::vec3& v) {
+        out += key;
+        for (int i = 0; i < 3; ++i) {
+            out += ' ';
+            AppendFloat(out, v[i]);
+        }
+        out += '\n';
+    }
+
+    void AppendQuoted(std::string& out, std::string_view s) {
+        static const char kHex[] = "0123456789abcdef";
+        out += '"';
+        for (char c : s) {
+            switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) {
+                    out += "\\x";
+                    out += kHex[static_cast<unsigned char>(c) >> 4];
+                    out += kHex[c & 15];
+                }
+                else {
+                    out += c;   // UTF-8 passes through
+                }
+            }
+        }
+        out += '"';
+    }
+
+    int HexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Quoted string at p. out views the buffer, or scratch when the string had escapes.
+    // Returns p unchanged on a missing quote or a bad escape.
+    const char* ParseQuoted(const char* p, const char* end, std::string& scratch, std::string_view& out) {
+        if (p >= end || *p != '"') return p;
+        const char* start = p + 1;
+        const char* q = start;
+        bool escaped = false;
+        while (q < end && *q != '"') {
+            if (*q == '\\') {
+                escaped = true;
+                ++q;
+            }
+            ++q;
+        }
+        if (q >= end) return p;
+        if (!escaped) {
+            out = std::string_view(start, static_cast<size_t>(q - start));
+            return q + 1;
+        }
+
+        scratch.clear();
+        for (const char* c = start; c < q; ++c) {
+            if (*c != '\\') {
+                scratch += *c;
+                continue;
+            }
+            switch (*++c) {
+            case '\\': scratch += '\\'; break;
+            case '"': scratch += '"'; break;
+            case 'n': scratch += '\n'; break;
+            case 'r': scratch += '\r'; break;
+            case 't': scratch += '\t'; break;
+            case 'x': {
+                const int hi = c + 2 < q ? HexDigit(c[1]) : -1;
+                const int lo = c + 2 < q ? HexDigit(c[2]) : -1;
+                if (hi < 0 || lo < 0) return p;
+                scratch += static_cast<char>(hi << 4 | lo);
+                c += 2;
+                break;
+            }
+            default:
+                return p;
+            }
+        }
+        out = scratch;
+        return q + 1;
+    }
+
+    const char* ParseVec3(const char* p, const char* end, glm::vec3& out) {
+        const char* start = p;
+        for (int i = 0; i < 3; ++i) {
+            p = SkipSpaces(p, end);
+            const char* next = ParseFloatExact(p, end, out[i]);
+            if (next == p) return start;
+            p = next;
+        }
+        return p;
+    }
+
+    const char* ParseWord(const char* p, const char* end, std::string_view& out) {
+        const char* start = p;
+        while (p < end && !IsSpace(*p)) ++p;
+        out = std::string_view(start, static_cast<size_t>(p - start));
+        return p;
+    }
+
+    // Resolved string of a name/texture column, so scenes with different string tables compare
+    bool SameString(const Columns& a, uint32_t ia, const Columns& b, uint32_t ib) {
+        if ((ia == kNoString) != (ib == kNoString)) return false;
+        return ia == kNoString || a.String(ia) == b.String(ib);
+    }
+
+    bool SameEntities(const Columns& a, const Columns& b) {
+        if (a.Size() != b.Size()) return false;
+        if (a.ids != b.ids || a.types != b.types || a.objectIndices != b.objectIndices || a.flags != b.flags
+            || a.points != b.points || a.healthPoints != b.healthPoints) {
+            return false;
+        }
+        // bitwise, -0 and NaN payloads included
+        const size_t vecBytes = a.Size() * sizeof(glm::vec3);
+        if (vecBytes && (std::memcmp(a.positions.data(), b.positions.data(), vecBytes) != 0
+            || std::memcmp(a.rotations.data(), b.rotations.data(), vecBytes) != 0
+            || std::memcmp(a.scales.data(), b.scales.data(), vecBytes) != 0)) {
+            return false;
+        }
+        for (size_t i = 0; i < a.Size(); ++i) {
+            if (!SameString(a, a.names[i], b, b.names[i]) || !SameString(a, a.textures[i], b, b.textures[i])
+                || !SameString(a, a.meshes[i], b, b.meshes[i])) return false;
+        }
+        return true;
+    }
+
+    // Entities spread over a big area with awkward floats and a few escaped names
+    Columns MakeSyntheticScene(size_t count) {
+        const char* textures[] = { CUBE_TEXTURE, PLANE_TEXTURE, FLOOR_TEXTURE };
+        const int types[] = { OBJ_CUBE, OBJ_PLANE, OBJ_FLOOR };
+        Columns scene;
+        scene.Reserve(count);
+        std::string name;
+        uint32_t state = 0x9E3779B9u;
+        auto next = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<float>(state >> 8) / 16777216.0f;
+        };
+        for (size_t i = 0; i < count; ++i) {
+            const size_t row = scene.AddEntity(static_cast<int32_t>(i));
+            const size_t kind = i % 3;
+            scene.types[row] = types[kind];
+            scene.objectIndices[row] = static_cast<int32_t>(i / 3);
+            scene.positions[row] = glm::vec3(next() * 2000.0f - 1000.0f, next() * 50.0f, next() * 2000.0f - 1000.0f);
+            scene.rotations[row] = glm::vec3(0.0f, next() * 6.2831853f, 0.0f);
+            scene.scales[row] = glm::vec3(1.0f + next());
+            if (i % 7 == 0) scene.flags[row] |= FlagDangerous;
+            scene.points[row] = static_cast<int32_t>(i % 100);
+            name = (i % 97 == 0) ? "Crate \"big\"\t" : "Entity ";
+            name += std::to_string(i);
+            scene.names[row] = scene.Intern(name);
+            if (i % 5 != 0) scene.textures[row] = scene.Intern(textures[kind]);
+        }
+        return scene;
+    }
+}
+
+bool SceneText::IsTextPath(const std::string& path) {
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == kExtension;
+}
+
+void SceneText::Serialize(const Columns& scene, std::string& out) {
+    // ~300 bytes per entity
+    out.reserve(out.size() + 64 + scene.Size() * 320);
+    out += "# Spx scene, one block per entity\nspx scene ";
+    AppendInt(out, kVersion);
+    out += '\n';
+    for (size_t i = 0; i < scene.Size(); ++i) {
+        out += "\nentity ";
+        AppendInt(out, scene.ids[i]);
+        out += "\n    type ";
+        const NamedType* named = std::find_if(std::begin(kTypeNames), std::end(kTypeNames),
+            [&](const NamedType& t) { return t.type == scene.types[i]; });
+        if (named != std::end(kTypeNames)) out += named->name;
+        else AppendInt(out, scene.types[i]);
+        // name before texture and mesh, so parsing interns the strings in the same order
+        if (scene.names[i] != kNoString) {
+            out += "\n    name ";
+            AppendQuoted(out, scene.String(scene.names[i]));
+        }
+        out += "\n    index ";
+        AppendInt(out, scene.objectIndices[i]);
+        out += '\n';
+        AppendVec3(out, "    position", scene.positions[i]);
+        AppendVec3(out, "    rotation", scene.rotations[i]);
+        AppendVec3(out, "    scale", scene.scales[i]);
+        out += "    flags";
+        if (scene.flags[i] == 0) out += " none";
+        for (const NamedFlag& f : kFlagNames) {
+            if (scene.flags[i] & f.flag) {
+                out += ' ';
+                out += f.name;
+            }
+        }
+        out += "\n    points ";
+        AppendInt(out, scene.points[i]);
+        out += "\n    health ";
+        AppendInt(out, scene.healthPoints[i]);
+        if (scene.textures[i] != kNoString) {
+            out += "\n    texture ";
+            AppendQuoted(out, scene.String(scene.textures[i]));
+        }
+        if (scene.meshes[i] != kNoString) {
+            out += "\n    mesh ";
+            AppendQuoted(out, scene.String(scene.meshes[i]));
+        }
+        out += "\nend\n";
+    }
+}
+
+bool SceneText::Parse(const char* text, size_t size, Columns& scene, const std::string& name) {
+    scene.Clear();
+    const char* p = text;
+    const char* end = text + size;
+    int line = 0;
+    bool header = false;
+    bool inEntity = false;
+    size_t row = 0;
+    std::string scratch;   // unescaped strings, reused
+
+    auto fail = [&](const char* why) {
+        LOG_ERROR("SceneText: " << name << ":" << line << ": " << why);
+        scene.Clear();
+        return false;
+    };
+
+    while (p < end) {
+        ++line;
+        const char* next = NextLine(p, end);
+        const char* s = SkipSpaces(p, next);
+        const char* e = LineEnd(s, next);
+        p = next;
+        if (s == e || *s == '#') continue;
+
+        std::string_view key;
+        s = SkipSpaces(ParseWord(s, e, key), e);
+
+        if (!header) {
+            std::string_view kind;
+            int32_t version = 0;
+            const char* v = SkipSpaces(ParseWord(s, e, kind), e);
+            if (key != "spx" || kind != "scene" || ParseInt(v, e, version) == v) return fail("missing the 'spx scene <version>' header");
+            if (version < 1 || version > kVersion) return fail("unsupported version");
+            header = true;
+            continue;
+        }
+
+        const char* value = s;
+        if (key == "entity") {
+            if (inEntity) return fail("'entity' inside an entity, missing 'end'");
+            int32_t id = -1;
+            s = ParseInt(s, e, id);
+            if (s == value) return fail("'entity' needs an id");
+            row = scene.AddEntity(id);
+            inEntity = true;
+        }
+        else if (key == "end") {
+            if (!inEntity) return fail("'end' outside an entity");
+            inEntity = false;
+        }
+        else if (!inEntity) {
+            return fail("field outside an entity block");
+        }
+        else if (key == "type") {
+            std::string_view type;
+            s = ParseWord(s, e, type);
+            const NamedType* named = std::find_if(std::begin(kTypeNames), std::end(kTypeNames),
+                [&](const NamedType& t) { return type == t.name; });
+            if (named != std::end(kTypeNames)) scene.types[row] = named->type;
+            else if (ParseInt(value, e, scene.types[row]) != s || s == value) return fail("unknown type");
+        }
+        else if (key == "name" || key == "texture" || key == "mesh") {
+            std::string_view str;
+            s = ParseQuoted(s, e, scratch, str);
+            if (s == value) return fail("expected a quoted string");
+            (key == "name" ? scene.names : key == "texture" ? scene.textures : scene.meshes)[row] = scene.Intern(str);
+        }
+        else if (key == "index" || key == "points" || key == "health") {
+            int32_t& out = key == "index" ? scene.objectIndices[row] : key == "points" ? scene.points[row] : scene.healthPoints[row];
+            s = ParseInt(s, e, out);
+            if (s == value) return fail("expected an integer");
+        }
+        else if (key == "position" || key == "rotation" || key == "scale") {
+            glm::vec3& out = key == "position" ? scene.positions[row] : key == "rotation" ? scene.rotations[row] : scene.scales[row];
+            s = ParseVec3(s, e, out);
+            if (s == value) return fail("expected three numbers");
+        }
+        else if (key == "flags") {
+            uint8_t flags = 0;
+            while (s < e) {
+                std::string_view word;
+                s = SkipSpaces(ParseWord(s, e, word), e);
+                const NamedFlag* named = std::find_if(std::begin(kFlagNames), std::end(kFlagNames),
+                    [&](const NamedFlag& f) { return word == f.name; });
+                if (named != std::end(kFlagNames)) {
+                    flags |= named->flag;
+                }
+                else if (word != "none") {
+                    LOG_WARNING("SceneText: " << name << ":" << line << ": unknown flag '" << word << "' ignored");
+                }
+            }
+            scene.flags[row] = flags;
+        }
+        else {
+            // newer files may carry fields this build doesn't know
+            LOG_WARNING("SceneText: " << name << ":" << line << ": unknown field '" << key << "' ignored");
+            continue;
+        }
+
+        if (SkipSpaces(s, e) != e) return fail("unexpected text after the value");
+    }
+
+    if (!header) return fail("missing the 'spx scene <version>' header");
+    if (inEntity) return fail("last entity has no 'end'");
+    return true;
+}
+
+bool SceneText::Write(const std::string& path, const Columns& scene) {
+    std::string text;
+    Serialize(scene, text);
+
+    std::error_code ec;
+    if (fs::path(path).has_parent_path()) fs::create_directories(fs::path(path).parent_path(), ec);
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+            LOG_ERROR("SceneText: failed to write " << tmp);
+            return false;
+        }
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        LOG_ERROR("SceneText: failed to replace " << path << ": " << ec.message());
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool SceneText::Read(const std::string& path, Columns& scene) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        LOG_ERROR("SceneText: cannot open " << path);
+        return false;
+    }
+    return Parse(file.Data(), file.Size(), scene, path);
+}
+
+SceneText::BenchmarkReport SceneText::Benchmark(const std::string& path, int iterations) {
+    BenchmarkReport report;
+    Columns source;
+    if (path.empty()) {
+        source = MakeSyntheticScene(100000);
+    }
+    else {
+        if (!(IsTextPath(path) ? SceneText::Read(path, source) : SceneFile::Read(path, source))) {
+            LOG_ERROR("SceneText: benchmark cannot load " << path);
+            return report;
+        }
+    }
+
+    std::string text;
+    Columns parsed;
+    report.saveSeconds = 1e30;
+    report.loadSeconds = 1e30;
+    for (int i = 0; i < std::max(1, iterations); ++i) {
+        text.clear();
+        auto t0 = Clock::now();
+        Serialize(source, text);
+        auto t1 = Clock::now();
+        if (!Parse(text.data(), text.size(), parsed, "benchmark")) return report;
+        auto t2 = Clock::now();
+        report.saveSeconds = std::min(report.saveSeconds, Seconds(t0, t1));
+        report.loadSeconds = std::min(report.loadSeconds, Seconds(t1, t2));
+    }
+
+    const double mb = text.size() / (1024.0 * 1024.0);
+    report.bytes = text.size();
+    report.entities = source.Size();
+    report.saveMBps = mb / report.saveSeconds;
+    report.loadMBps = mb / report.loadSeconds;
+    report.roundTrip = SameEntities(source, parsed);
+    LOG_INFO("SceneText benchmark: " << (path.empty() ? std::string("synthetic scene") : path) << ", "
+        << report.entities << " entities, " << mb << " MB | save " << report.saveSeconds * 1000.0 << " ms ("
+        << report.saveMBps << " MB/s), load " << report.loadSeconds * 1000.0 << " ms (" << report.loadMBps
+        << " MB/s) | round trip " << (report.roundTrip ? "exact" : "MISMATCH"));
+    return report;
+}
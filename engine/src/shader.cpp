@@ -1,149 +1,421 @@
 #include "../include/shader.h"
+#include "../include/asset_path.h"
 #include "../include/log.h"
+#include "../include/program_cache.h"
+#include <GLFW/glfw3.h>
 
-#include <fstream> // for file reading
-#include <sstream> // for string stream
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
-Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath)
-	: programID(0)
+// GL_KHR_parallel_shader_compile (same values as the ARB version), not in our glad
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace {
+	// Live shaders, so a changed source file can find the programs built from it
+	std::vector<Shader*> s_liveShaders;
+
+	int s_parallelCompile = -1; // -1 = not checked yet
+
+	bool HasExtension(const char* name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			const GLubyte* ext = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+			if (ext && std::strcmp(reinterpret_cast<const char*>(ext), name) == 0) return true;
+		}
+		return false;
+	}
+}
+
+Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath, std::vector<std::string> keywords)
+	: programID(0), m_vertexPath(vertexPath), m_fragmentPath(fragmentPath), m_keywords(std::move(keywords))
 {
-	std::string vertCode = ReadFile(vertexPath);  // read vertex shader code
-	std::string fragCode = ReadFile(fragmentPath); // read fragment shader code
+	if (m_keywords.size() > kMaxKeywords) {
+		LOG_WARNING("Shader: " + m_vertexPath + " has more than 32 keywords, the rest are ignored");
+		m_keywords.resize(kMaxKeywords);
+	}
+	m_variants.push_back({});
+	// the base variant is built right away, it stands in for every variant still compiling
+	if (ReadSources(m_vertexSource, m_fragmentSource)) {
+		StartBuild(m_variants[0]);
+		FinishBuild(m_variants[0]);
+	}
+	m_activeProgram = programID;
+	s_liveShaders.push_back(this);
+}
+
+Shader::~Shader() {
+	for (Variant& variant : m_variants) {
+		DiscardBuild(variant);
+		if (variant.program) glDeleteProgram(variant.program); // delete the shader program if it exists
+	}
+	s_liveShaders.erase(std::remove(s_liveShaders.begin(), s_liveShaders.end(), this), s_liveShaders.end());
+}
+
+bool Shader::ParallelCompileSupported() {
+	if (s_parallelCompile < 0) {
+		using MaxThreadsFn = void(APIENTRYP)(GLuint count);
+		MaxThreadsFn maxThreads = nullptr;
+		if (HasExtension("GL_KHR_parallel_shader_compile")) {
+			maxThreads = reinterpret_cast<MaxThreadsFn>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+		}
+		else if (HasExtension("GL_ARB_parallel_shader_compile")) {
+			maxThreads = reinterpret_cast<MaxThreadsFn>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+		}
+		s_parallelCompile = maxThreads ? 1 : 0;
+		if (maxThreads) {
+			maxThreads(0xFFFFFFFFu); // let the driver pick its thread count
+			LOG_INFO("Shader: parallel shader compile available");
+		}
+		else {
+			LOG_INFO("Shader: no parallel shader compile, variants finish one per frame");
+		}
+	}
+	return s_parallelCompile == 1;
+}
+
+Shader::Variant* Shader::FindVariant(Permutation variant) {
+	for (Variant& v : m_variants) {
+		if (v.keywords == variant) return &v;
+	}
+	return nullptr;
+}
+
+const Shader::Variant* Shader::FindVariant(Permutation variant) const {
+	for (const Variant& v : m_variants) {
+		if (v.keywords == variant) return &v;
+	}
+	return nullptr;
+}
+
+Shader::Permutation Shader::Keyword(std::string_view name) const {
+	for (size_t i = 0; i < m_keywords.size(); ++i) {
+		if (m_keywords[i] == name) return Permutation(1) << i;
+	}
+	return 0;
+}
+
+std::string Shader::VariantName(Permutation variant) const {
+	std::string name;
+	for (size_t i = 0; i < m_keywords.size(); ++i) {
+		if (!(variant & (Permutation(1) << i))) continue;
+		if (!name.empty()) name += '|';
+		name += m_keywords[i];
+	}
+	return name.empty() ? std::string("base") : name;
+}
+
+bool Shader::ReadSources(std::string& vertexSource, std::string& fragmentSource) const {
+	std::string vertCode = ReadFile(m_vertexPath);  // read vertex shader code
+	std::string fragCode = ReadFile(m_fragmentPath); // read fragment shader code
 
 	if (vertCode.empty() || fragCode.empty()) { // do a basic check for empty shader code
-		//std::cerr << "Shader: one or more shader files are empty or failed to load\n";
 		LOG_WARNING("Shader: one or more shader files are empty or failed to load");
-		return;
+		return false;
 	}
+	vertexSource = std::move(vertCode);
+	fragmentSource = std::move(fragCode);
+	return true;
+}
 
-	GLuint vertShader = 0, fragShader = 0;
-	if (!CompileShader(vertCode.c_str(), GL_VERTEX_SHADER, vertShader)) {
-		// this will log the error if the code is incorrect
-		LOG_WARNING("Shader: vertex compile failed");
-		return;
+std::string Shader::Preprocess(const std::string& source, Permutation variant) const {
+	if (variant == 0) return source;
+	std::string defines;
+	for (size_t i = 0; i < m_keywords.size(); ++i) {
+		if (variant & (Permutation(1) << i)) defines += "#define " + m_keywords[i] + "\n";
+	}
+	// #version must stay the first statement: the defines go right after it and
+	// #line puts the line numbers of compile errors back to the file's own
+	size_t insert = 0;
+	size_t version = source.find("#version");
+	if (version != std::string::npos) {
+		size_t eol = source.find('\n', version);
+		insert = (eol == std::string::npos) ? source.size() : eol + 1;
 	}
-	if (!CompileShader(fragCode.c_str(), GL_FRAGMENT_SHADER, fragShader)) {
-		// this will log the error if the code is incorrect
-		LOG_WARNING("Shader: fragment compile failed");
-		glDeleteShader(vertShader); // clean up vertex shader
-		return;
+	const long nextLine = 1 + std::count(source.begin(), source.begin() + insert, '\n');
+	std::string out = source.substr(0, insert);
+	if (!out.empty() && out.back() != '\n') out += '\n';
+	out += defines;
+	out += "#line " + std::to_string(nextLine) + "\n";
+	out.append(source, insert, std::string::npos);
+	return out;
+}
+
+void Shader::StartBuild(Variant& variant) {
+	StartBuild(variant, m_vertexSource, m_fragmentSource);
+}
+
+void Shader::StartBuild(Variant& variant, const std::string& vertexSource, const std::string& fragmentSource) {
+	DiscardBuild(variant);
+	variant.failed = false;
+	const std::string vertCode = Preprocess(vertexSource, variant.keywords);
+	const std::string fragCode = Preprocess(fragmentSource, variant.keywords);
+
+	// a warm cache skips compile and link entirely; an edited source is a new key
+	const bool cached = ProgramCache::IsEnabled();
+	variant.cacheKey = cached ? ProgramCache::Key(vertCode, fragCode) : 0;
+	if (cached) {
+		if (GLuint program = ProgramCache::Load(variant.cacheKey)) {
+			variant.pending = program;
+			variant.cacheKey = 0; // nothing left to store
+			return;
+		}
 	}
 
+	// compile and link are only issued here; nothing queries a status until FinishBuild,
+	// which lets a parallel-compile driver work on them in the background
+	const char* vertSource = vertCode.c_str();
+	const char* fragSource = fragCode.c_str();
+	variant.vertShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(variant.vertShader, 1, &vertSource, nullptr);
+	glCompileShader(variant.vertShader);
+	variant.fragShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(variant.fragShader, 1, &fragSource, nullptr);
+	glCompileShader(variant.fragShader);
+
 	// Link program
-	programID = glCreateProgram();          // create shader program
-	glAttachShader(programID, vertShader);  // attach vertex shader
-	glAttachShader(programID, fragShader);  // attach fragment shader
-	glLinkProgram(programID);               // link the program
+	variant.pending = glCreateProgram();                // create shader program
+	glAttachShader(variant.pending, variant.vertShader); // attach vertex shader
+	glAttachShader(variant.pending, variant.fragShader); // attach fragment shader
+	if (cached) glProgramParameteri(variant.pending, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(variant.pending);                     // link the program
+}
+
+bool Shader::IsBuildDone(const Variant& variant) const {
+	if (!variant.pending) return true;
+	if (!ParallelCompileSupported()) return true; // can't ask, finishing will block
+	GLint done = GL_FALSE;
+	glGetProgramiv(variant.pending, GL_COMPLETION_STATUS_KHR, &done);
+	return done == GL_TRUE;
+}
+
+bool Shader::FinishBuild(Variant& variant) {
+	if (!variant.pending) return false;
+	GLuint program = variant.pending;
+	variant.pending = 0;
+
+	bool ok = true;
+	if (variant.vertShader) {
+		// the shader objects only exist when the program wasn't loaded from the cache
+		const bool vertOk = CheckCompile(variant.vertShader, "vertex");
+		const bool fragOk = CheckCompile(variant.fragShader, "fragment");
+		ok = vertOk && fragOk;
+	}
 
 	// Check link status
-	GLint success;
-	glGetProgramiv(programID, GL_LINK_STATUS, &success); // check for any linking errors
-	if (!success) {
+	GLint success = GL_FALSE;
+	if (ok) glGetProgramiv(program, GL_LINK_STATUS, &success); // check for any linking errors
+	if (ok && !success) {
 		GLint logLen = 0; // get length of info log
-		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLen); // retrieve the length of the program info log
-		std::string infoLog(logLen, '\0');                      // create a string to hold the log
-		glGetProgramInfoLog(programID, logLen, nullptr, &infoLog[0]); // get the log
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLen); // retrieve the length of the program info log
+		std::string infoLog(logLen, '\0');                     // create a string to hold the log
+		glGetProgramInfoLog(program, logLen, nullptr, &infoLog[0]); // get the log
 		LOG_ERROR("ERROR::SHADER::PROGRAM::LINK_FAILED\n" + infoLog); // show any linking errors
-		glDeleteProgram(programID); // delete the program clean up
-		programID = 0; // reset programID to 0 on failure
+		ok = false;
 	}
+	if (ok && variant.cacheKey) ProgramCache::Store(variant.cacheKey, program);
 
 	// shaders can be deleted once linked into the program
-	glDeleteShader(vertShader);
-	glDeleteShader(fragShader);
+	if (variant.vertShader) glDeleteShader(variant.vertShader);
+	if (variant.fragShader) glDeleteShader(variant.fragShader);
+	variant.vertShader = variant.fragShader = 0;
+	variant.cacheKey = 0;
+
+	if (!ok) {
+		LOG_WARNING("Shader: variant " + VariantName(variant.keywords) + " of " + m_vertexPath + " failed to build");
+		glDeleteProgram(program); // delete the program clean up
+		variant.failed = true;
+		return false;
+	}
+	Adopt(variant, program);
+	return true;
 }
 
-Shader::~Shader() {
-	if (programID) glDeleteProgram(programID); // delete the shader program if it exists
+void Shader::DiscardBuild(Variant& variant) {
+	if (variant.pending) glDeleteProgram(variant.pending);
+	if (variant.vertShader) glDeleteShader(variant.vertShader);
+	if (variant.fragShader) glDeleteShader(variant.fragShader);
+	variant.pending = variant.vertShader = variant.fragShader = 0;
+	variant.cacheKey = 0;
+}
+
+void Shader::Adopt(Variant& variant, GLuint program) {
+	if (variant.program) {
+		if (m_activeProgram == variant.program) m_activeProgram = program;
+		glDeleteProgram(variant.program);
+	}
+	variant.program = program;
+	if (variant.keywords == 0) programID = program;
+}
+
+bool Shader::Reload() {
+	std::string vertexSource, fragmentSource;
+	if (!ReadSources(vertexSource, fragmentSource)) {
+		LOG_WARNING("Shader: reload of " + m_vertexPath + " / " + m_fragmentPath + " failed, keeping the previous program");
+		return false;
+	}
+	// base variant right away, the others in the background (their old programs stay until then)
+	Variant& base = m_variants[0];
+	StartBuild(base, vertexSource, fragmentSource);
+	if (!FinishBuild(base)) {
+		// a typo mid-edit must not leave the scene without a shader, and the variants
+		// built later (first use, Precompile) keep compiling the sources that worked
+		LOG_WARNING("Shader: reload of " + m_vertexPath + " / " + m_fragmentPath + " failed, keeping the previous program");
+		return false;
+	}
+	m_vertexSource = std::move(vertexSource);
+	m_fragmentSource = std::move(fragmentSource);
+	for (size_t i = 1; i < m_variants.size(); ++i) StartBuild(m_variants[i]);
+	LOG_INFO("Shader: reloaded " + m_vertexPath + " / " + m_fragmentPath);
+	return true;
+}
+
+void Shader::Precompile(const std::vector<Permutation>& variants) {
+	for (Permutation keywords : variants) {
+		if (FindVariant(keywords)) continue;
+		Variant variant;
+		variant.keywords = keywords;
+		StartBuild(variant);
+		m_variants.push_back(variant);
+	}
+}
+
+bool Shader::IsReady(Permutation variant) const {
+	const Variant* v = FindVariant(variant);
+	return v && v->program != 0;
+}
+
+GLuint Shader::Program(Permutation variant) {
+	if (variant == 0) return programID;
+	const Variant* v = FindVariant(variant);
+	if (!v) {
+		// first use: start it now, the base program fills in until Poll picks it up
+		Precompile({ variant });
+		v = FindVariant(variant);
+	}
+	return v->program ? v->program : programID;
+}
+
+void Shader::Poll() {
+	const bool parallel = ParallelCompileSupported();
+	for (Variant& variant : m_variants) {
+		if (!variant.pending || !IsBuildDone(variant)) continue;
+		FinishBuild(variant);
+		if (!parallel) break; // that one blocked, leave the rest for later frames
+	}
+}
+
+void Shader::PollAll() {
+	for (Shader* shader : s_liveShaders) shader->Poll();
+}
+
+bool Shader::UsesFile(Vfs::AssetId asset) const {
+	return asset != Vfs::kInvalidAsset && (Vfs::Find(m_vertexPath) == asset || Vfs::Find(m_fragmentPath) == asset);
+}
+
+int Shader::ReloadFile(Vfs::AssetId asset) {
+	int reloaded = 0;
+	for (Shader* shader : s_liveShaders) {
+		if (shader->UsesFile(asset) && shader->Reload()) ++reloaded;
+	}
+	return reloaded;
 }
 
 void Shader::Use() const {
+	m_activeProgram = programID;
 	if (programID) glUseProgram(programID); // use / bind the shader program
 }
+
+void Shader::Use(Permutation variant) {
+	m_activeProgram = Program(variant);
+	if (m_activeProgram) glUseProgram(m_activeProgram);
+}
 // set a vec3 uniform variable in the shader
 void Shader::SetUniformVec3(const char* name, float x, float y, float z) const {
-	if (!programID) return;
-	GLint loc = glGetUniformLocation(programID, name); // get the location of the uniform variable
+	if (!m_activeProgram) return;
+	GLint loc = glGetUniformLocation(m_activeProgram, name); // get the location of the uniform variable
 	if (loc != -1) glUniform3f(loc, x, y, z);
 }
 // set a float uniform variable in the shader
 void Shader::SetUniformFloat(const char* name, float value) const {
-	if (!programID) return;
-	GLint loc = glGetUniformLocation(programID, name); // get the location of the uniform variable
+	if (!m_activeProgram) return;
+	GLint loc = glGetUniformLocation(m_activeProgram, name); // get the location of the uniform variable
 	if (loc != -1) glUniform1f(loc, value);
 }
 void Shader::SetUniformInt(const char* name, int value) const
 {
-	if (!programID) return;
-	GLint loc = glGetUniformLocation(programID, name); // get the location of the uniform variable
+	if (!m_activeProgram) return;
+	GLint loc = glGetUniformLocation(m_activeProgram, name); // get the location of the uniform variable
 	if (loc != -1) glUniform1i(loc, value);
 }
 void Shader::setVec2(const std::string& name, const glm::vec2 value) const
 {
-	if (!programID) return;
-	glUniform2fv(glGetUniformLocation(programID, name.c_str()), 1, &value[0]);
+	if (!m_activeProgram) return;
+	glUniform2fv(glGetUniformLocation(m_activeProgram, name.c_str()), 1, &value[0]);
 }
 void Shader::setVec2(const std::string& name, float x, float y) const
 {
-	if (!programID) return;
-	glUniform2f(glGetUniformLocation(programID, name.c_str()), x, y);
+	if (!m_activeProgram) return;
+	glUniform2f(glGetUniformLocation(m_activeProgram, name.c_str()), x, y);
 }
 // ------------------------------------------------------------------------
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const
 {
-	if (!programID) return;
-	glUniform3fv(glGetUniformLocation(programID, name.c_str()), 1, &value[0]);
+	if (!m_activeProgram) return;
+	glUniform3fv(glGetUniformLocation(m_activeProgram, name.c_str()), 1, &value[0]);
 }
 void Shader::setVec3(const std::string& name, float x, float y, float z) const
 {
-	if (!programID) return;
-	glUniform3f(glGetUniformLocation(programID, name.c_str()), x, y, z);
+	if (!m_activeProgram) return;
+	glUniform3f(glGetUniformLocation(m_activeProgram, name.c_str()), x, y, z);
 }
 // ######################### My Vec4 ###########################################
 void Shader::setRGBAVec4(const std::string& name, float r, float g, float b, float a)
 {
-	if (!programID) return;
-	glUniform4f(glGetUniformLocation(programID, name.c_str()), r, g, b, a);
+	if (!m_activeProgram) return;
+	glUniform4f(glGetUniformLocation(m_activeProgram, name.c_str()), r, g, b, a);
 }
 // ------------------------------------------------------------------------
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const
 {
-	if (!programID) return;
-	glUniform4fv(glGetUniformLocation(programID, name.c_str()), 1, &value[0]);
+	if (!m_activeProgram) return;
+	glUniform4fv(glGetUniformLocation(m_activeProgram, name.c_str()), 1, &value[0]);
 }
 void Shader::setVec4(const std::string& name, float x, float y, float z, float w)
 {
-	if (!programID) return;
-	glUniform4f(glGetUniformLocation(programID, name.c_str()), x, y, z, w);
+	if (!m_activeProgram) return;
+	glUniform4f(glGetUniformLocation(m_activeProgram, name.c_str()), x, y, z, w);
 }
 // ------------------------------------------------------------------------
 void Shader::setMat2(const std::string& name, const glm::mat2& mat) const
 {
-	if (!programID) return;
-	glUniformMatrix2fv(glGetUniformLocation(programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	if (!m_activeProgram) return;
+	glUniformMatrix2fv(glGetUniformLocation(m_activeProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 // ------------------------------------------------------------------------
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const
 {
-	if (!programID) return;
-	glUniformMatrix3fv(glGetUniformLocation(programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	if (!m_activeProgram) return;
+	glUniformMatrix3fv(glGetUniformLocation(m_activeProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 // ------------------------------------------------------------------------
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 {
-	if (!programID) return;
-	glUniformMatrix4fv(glGetUniformLocation(programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	if (!m_activeProgram) return;
+	glUniformMatrix4fv(glGetUniformLocation(m_activeProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
 
 
-// Compile a shader from source code
-bool Shader::CompileShader(const char* source, GLenum shaderType, GLuint& outShader) const {
-	GLuint shader = glCreateShader(shaderType); // create shader object
-	glShaderSource(shader, 1, &source, nullptr);// set shader source code
-	glCompileShader(shader);		  // compile the shader 
-
+// Compile status of a shader object, logs the info log on failure
+bool Shader::CheckCompile(GLuint shader, const char* stage) const {
 	GLint success = 0;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 	if (!success) {
@@ -151,22 +423,17 @@ bool Shader::CompileShader(const char* source, GLenum shaderType, GLuint& outSha
 		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLen); // retrieve the length of the shader info log
 		std::string infoLog(logLen, '\0'); // create a string to hold the log
 		glGetShaderInfoLog(shader, logLen, nullptr, &infoLog[0]); // get the log
-		LOG_ERROR("ERROR::SHADER::COMPILE_FAILED\n" + infoLog); // log the error message
-		glDeleteShader(shader); // clean up shader
+		LOG_ERROR(std::string("ERROR::SHADER::COMPILE_FAILED (") + stage + ")\n" + infoLog); // log the error message
 		return false;
 	}
-
-	outShader = shader; // set output shader if compilation was successful
 	return true;
 }
 
 std::string Shader::ReadFile(const std::string& path) const {
-	std::ifstream file(path, std::ios::in | std::ios::binary); // open file in binary mode
-	if (!file) { // if file failed to open show an error
+	std::vector<unsigned char> bytes; // from the mounted asset pack or the file on disk
+	if (!ReadAssetFile(path, bytes)) { // if file failed to open show an error
 		LOG_ERROR("Shader::ReadFile: failed to open " + path);
 		return {};
 	}
-	std::ostringstream ss;	//if the file opened successfully read its contents into a string stream
-	ss << file.rdbuf();		// read file contents into stringstream
-	return ss.str();		// return the file contents as a string
+	return std::string(bytes.begin(), bytes.end());		// return the file contents as a string
 }
\ No newline at end of file
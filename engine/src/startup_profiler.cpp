@@ -0,0 +1,83 @@
+#include "../include/startup_profiler.h"
+#include "../include/log.h"
+#include <cstdio>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point s_start;
+    Clock::time_point s_last;
+    std::vector<StartupProfiler::Phase> s_phases;
+    std::vector<StartupProfiler::Task> s_tasks;
+    bool s_running = false;
+    bool s_firstFrame = false;   // waiting for FirstFrame
+
+    double MsBetween(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    }
+}
+
+void StartupProfiler::Begin() {
+    s_phases.clear();
+    s_tasks.clear();
+    s_start = s_last = Clock::now();
+    s_running = true;
+    s_firstFrame = true;
+}
+
+void StartupProfiler::Mark(const std::string& phase) {
+    if (!s_running) return;
+    Clock::time_point now = Clock::now();
+    s_phases.push_back({ phase, MsBetween(s_last, now) });
+    s_last = now;
+}
+
+void StartupProfiler::AddTask(const std::string& name, bool worker, Clock::time_point start, Clock::time_point end) {
+    if (!s_running) return;
+    s_tasks.push_back({ name, worker, MsBetween(s_start, start), MsBetween(s_start, end) });
+}
+
+void StartupProfiler::End() {
+    if (!s_running) return;
+    s_running = false;
+    s_last = Clock::now(); // the total runs up to here, not just the last mark
+    LOG_INFO("Startup profile:");
+    if (!s_tasks.empty()) {
+        // start/end since Begin show what overlapped
+        LOG_INFO("  task                           thread    start      end   duration");
+        for (const Task& task : s_tasks) {
+            char line[160];
+            std::snprintf(line, sizeof(line), "  %-30s %-6s %8.2f %8.2f %8.2f ms", task.name.c_str(),
+                task.worker ? "worker" : "main", task.startMs, task.endMs, task.endMs - task.startMs);
+            LOG_INFO(line);
+        }
+    }
+    for (const Phase& phase : s_phases) {
+        char line[128];
+        std::snprintf(line, sizeof(line), "  %-30s %8.2f ms", phase.name.c_str(), phase.ms);
+        LOG_INFO(line);
+    }
+    char total[128];
+    std::snprintf(total, sizeof(total), "  %-30s %8.2f ms", "total", TotalMs());
+    LOG_INFO(total);
+}
+
+void StartupProfiler::FirstFrame() {
+    if (!s_firstFrame) return;
+    s_firstFrame = false;
+    char line[128];
+    std::snprintf(line, sizeof(line), "Startup: first frame after %.2f ms", MsBetween(s_start, Clock::now()));
+    LOG_INFO(line);
+}
+
+const std::vector<StartupProfiler::Phase>& StartupProfiler::Phases() {
+    return s_phases;
+}
+
+const std::vector<StartupProfiler::Task>& StartupProfiler::Tasks() {
+    return s_tasks;
+}
+
+double StartupProfiler::TotalMs() {
+    return MsBetween(s_start, s_last);
+}
@@ -0,0 +1,111 @@
+#include "../include/task_graph.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace {
+    enum class State {
+        Waiting,
+        Running,
+        Done,
+        Failed,   // failed itself or a dependency failed
+    };
+
+    // Shared with the worker tasks, which only touch their own entries under the mutex
+    struct RunState {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<State> states;
+        std::vector<TaskGraph::Timing>* timings = nullptr;
+    };
+}
+
+TaskGraph::TaskId TaskGraph::Add(std::string name, Thread thread, std::vector<TaskId> dependsOn, std::function<bool()> task) {
+    const TaskId id = static_cast<TaskId>(m_tasks.size());
+    for (TaskId dep : dependsOn) {
+        if (dep < 0 || dep >= id) {
+            LOG_ERROR("TaskGraph: " << name << " depends on a task that was not added before it");
+        }
+    }
+    m_tasks.push_back({ thread, std::move(dependsOn), std::move(task) });
+    Timing timing;
+    timing.name = std::move(name);
+    timing.thread = thread;
+    m_timings.push_back(std::move(timing));
+    return id;
+}
+
+bool TaskGraph::Run() {
+    auto run = std::make_shared<RunState>();
+    run->states.assign(m_tasks.size(), State::Waiting);
+    run->timings = &m_timings;
+    bool failed = false;
+
+    std::unique_lock<std::mutex> lock(run->mutex);
+    for (;;) {
+        // Start every worker task that is ready, find the first ready main task, and
+        // skip whatever depends on a failure
+        bool pending = false;
+        int mainTask = -1;
+        for (size_t i = 0; i < m_tasks.size(); ++i) {
+            if (run->states[i] == State::Running) pending = true;
+            if (run->states[i] != State::Waiting) continue;
+            bool ready = true;
+            bool blocked = false;
+            for (TaskId dep : m_tasks[i].dependsOn) {
+                if (dep < 0 || dep >= static_cast<TaskId>(i) || run->states[dep] == State::Failed) blocked = true;
+                else if (run->states[dep] != State::Done) ready = false;
+            }
+            if (blocked) {
+                run->states[i] = State::Failed;
+                failed = true;
+                continue;
+            }
+            pending = true;
+            if (!ready) continue;
+            if (m_tasks[i].thread == Thread::Main) {
+                if (mainTask < 0) mainTask = static_cast<int>(i);
+                continue;
+            }
+            run->states[i] = State::Running;
+            m_timings[i].ran = true;
+            m_timings[i].start = std::chrono::steady_clock::now();
+            Jobs::Submit([run, i, fn = m_tasks[i].fn]() {
+                bool ok = fn();
+                std::lock_guard<std::mutex> lk(run->mutex);
+                (*run->timings)[i].end = std::chrono::steady_clock::now();
+                (*run->timings)[i].ok = ok;
+                run->states[i] = ok ? State::Done : State::Failed;
+                run->changed.notify_all();
+            });
+        }
+        if (!pending) break;
+
+        if (mainTask >= 0) {
+            // main tasks run unlocked so finishing workers can report in meanwhile
+            run->states[mainTask] = State::Running;
+            m_timings[mainTask].ran = true;
+            m_timings[mainTask].start = std::chrono::steady_clock::now();
+            lock.unlock();
+            bool ok = m_tasks[mainTask].fn();
+            lock.lock();
+            m_timings[mainTask].end = std::chrono::steady_clock::now();
+            m_timings[mainTask].ok = ok;
+            run->states[mainTask] = ok ? State::Done : State::Failed;
+            continue;
+        }
+        // only workers can make progress now
+        run->changed.wait(lock);
+    }
+
+    for (size_t i = 0; i < m_tasks.size(); ++i) {
+        if (run->states[i] != State::Failed) continue;
+        failed = true;
+        if (m_timings[i].ran) {
+            LOG_ERROR("TaskGraph: task failed: " << m_timings[i].name);
+        }
+    }
+    return !failed;
+}
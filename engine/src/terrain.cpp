@@ -0,0 +1,544 @@
+#include "../include/terrain.h"
+#include "../include/asset_path.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include "../include/mapped_file.h"
+#include "../include/shader.h"
+#include "stb/stb_image.h"
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    constexpr uint8_t kNotWanted = 0xFF;
+    constexpr int kFloatsPerVertex = 8;
+    // Sides of a chunk whose neighbour is one LOD coarser, the bits of the stitch mask
+    constexpr int kSideNorth = 1; // -Z
+    constexpr int kSideEast = 2;  // +X
+    constexpr int kSideSouth = 4; // +Z
+    constexpr int kSideWest = 8;  // -X
+
+    struct Plane {
+        glm::vec3 normal;
+        float d;
+    };
+
+    // Frustum planes of a view-projection matrix, pointing inwards (Gribb/Hartmann)
+    void ExtractFrustum(const glm::mat4& m, Plane planes[6]) {
+        const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        const glm::vec4 p[6] = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+        for (int i = 0; i < 6; ++i) planes[i] = { glm::vec3(p[i]), p[i].w };
+    }
+
+    bool BoxInFrustum(const Plane planes[6], const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        for (int i = 0; i < 6; ++i) {
+            // the corner furthest along the normal; if even that is behind, the box is out
+            const glm::vec3& n = planes[i].normal;
+            const glm::vec3 corner(n.x >= 0.0f ? boxMax.x : boxMin.x, n.y >= 0.0f ? boxMax.y : boxMin.y, n.z >= 0.0f ? boxMax.z : boxMin.z);
+            if (glm::dot(n, corner) + planes[i].d < 0.0f) return false;
+        }
+        return true;
+    }
+
+    bool IsRawPath(const std::string& path) {
+        std::string ext = std::filesystem::path(path).extension().string();
+        for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return ext == ".r16" || ext == ".raw";
+    }
+
+    // Chunk coordinate of a terrain space position, clamped so a far camera can't overflow
+    int ChunkCoord(double v, double chunkSize, int count) {
+        return static_cast<int>(std::clamp(std::floor(v / chunkSize), -1.0, static_cast<double>(count)));
+    }
+}
+
+struct Terrain::Heightmap {
+    MappedFile file;                  // raw: samples are read straight from the mapping
+    std::vector<uint16_t> decoded;    // PNG
+    int width = 0;
+    int height = 0;
+
+    uint16_t Sample(int x, int z) const {
+        x = std::clamp(x, 0, width - 1);
+        z = std::clamp(z, 0, height - 1);
+        const size_t i = static_cast<size_t>(z) * width + x;
+        if (!decoded.empty()) return decoded[i];
+        // a view into a pack entry need not be aligned
+        uint16_t value;
+        std::memcpy(&value, file.Data() + i * 2, 2);
+        return value;
+    }
+};
+
+// Results of the workers. Shared with the jobs, so a Close() while they run just lets
+// their results fall on the floor.
+struct Terrain::Inbox {
+    struct Built {
+        int key = 0;
+        std::vector<float> vertices;
+        float minY = 0.0f;
+        float maxY = 0.0f;
+    };
+    std::mutex mutex;
+    std::vector<Built> built;
+    std::shared_ptr<const Heightmap> heightmap;   // decoded PNG
+    bool decodeFailed = false;
+};
+
+Terrain::~Terrain() {
+    Close();
+}
+
+bool Terrain::Open(const Settings& settings) {
+    Close();
+    const int quads = settings.chunkQuads;
+    if (quads < 2 || quads > 128 || (quads & (quads - 1)) != 0) {
+        LOG_ERROR("Terrain: chunkQuads must be a power of two from 2 to 128, not " << quads);
+        return false;
+    }
+    if (!(settings.sampleSpacing > 0.0f) || !(settings.textureTiling > 0.0f) || !(settings.unloadRadius > settings.loadRadius)) {
+        LOG_ERROR("Terrain: sampleSpacing and textureTiling must be positive and unloadRadius larger than loadRadius");
+        return false;
+    }
+
+    auto heightmap = std::make_shared<Heightmap>();
+    if (!OpenAssetFile(settings.heightmap, heightmap->file) || heightmap->file.Size() == 0) {
+        LOG_ERROR("Terrain: could not open heightmap " << settings.heightmap);
+        return false;
+    }
+    const bool raw = IsRawPath(settings.heightmap);
+    if (raw) {
+        const size_t samples = heightmap->file.Size() / 2;
+        const int width = static_cast<int>(std::lround(std::sqrt(static_cast<double>(samples))));
+        if (width < 2 || static_cast<size_t>(width) * width != samples) {
+            LOG_ERROR("Terrain: " << settings.heightmap << " is not a square 16-bit raw heightmap");
+            return false;
+        }
+        heightmap->width = width;
+        heightmap->height = width;
+    }
+
+    m_settings = settings;
+    m_open = true;
+    m_inbox = std::make_shared<Inbox>();
+    m_lodCount = 1;
+    while ((1 << m_lodCount) <= quads) ++m_lodCount;
+    BuildIndices();
+    if (!settings.texture.empty()) m_texture = TextureManager::AcquireAsync(settings.texture);
+
+    if (raw) {
+        SetHeightmap(std::move(heightmap));
+        return true;
+    }
+    // a PNG has to be decoded whole, off the main thread; chunks are built once it is in
+    Jobs::Submit([inbox = m_inbox, heightmap, path = settings.heightmap]() {
+        const auto* bytes = reinterpret_cast<const stbi_uc*>(heightmap->file.Data());
+        const int size = static_cast<int>(heightmap->file.Size());
+        if (!stbi_is_16_bit_from_memory(bytes, size)) {
+            LOG_WARNING("Terrain: " << path << " is not a 16-bit image, the heights will be stepped");
+        }
+        // workers that loaded textures have flipping on (thread-local); rows stay in file
+        // order, the same as a .r16
+        stbi_set_flip_vertically_on_load_thread(0);
+        int w = 0, h = 0, channels = 0;
+        stbi_us* pixels = stbi_load_16_from_memory(bytes, size, &w, &h, &channels, 1);
+        const bool ok = pixels && w >= 2 && h >= 2;
+        if (ok) {
+            heightmap->decoded.assign(pixels, pixels + static_cast<size_t>(w) * h);
+            heightmap->width = w;
+            heightmap->height = h;
+            heightmap->file.Close();
+        }
+        else {
+            LOG_ERROR("Terrain: could not decode heightmap " << path);
+        }
+        if (pixels) stbi_image_free(pixels);
+        std::lock_guard<std::mutex> lock(inbox->mutex);
+        if (ok) inbox->heightmap = heightmap;
+        else inbox->decodeFailed = true;
+    });
+    return true;
+}
+
+void Terrain::SetHeightmap(std::shared_ptr<const Heightmap> heightmap) {
+    const int quads = m_settings.chunkQuads;
+    m_chunksX = std::max(1, (heightmap->width - 1 + quads - 1) / quads);
+    m_chunksZ = std::max(1, (heightmap->height - 1 + quads - 1) / quads);
+    m_heightmap = std::move(heightmap);
+    m_stats.chunks = m_chunksX * m_chunksZ;
+    LOG_INFO("Terrain: " << m_settings.heightmap << " " << m_heightmap->width << "x" << m_heightmap->height << " samples, "
+        << m_chunksX << "x" << m_chunksZ << " chunks of " << quads << " quads, " << m_lodCount << " LODs");
+}
+
+void Terrain::Close() {
+    for (auto& entry : m_chunks) FreeChunk(entry.second);
+    m_chunks.clear();
+    m_uploads.clear();
+    if (m_ebo) {
+        glDeleteBuffers(1, &m_ebo);
+        m_ebo = 0;
+    }
+    m_ranges.clear();
+    m_indexBytes = 0;
+    if (m_texture != INVALID_TEXTURE) {
+        TextureManager::Release(m_texture);
+        m_texture = INVALID_TEXTURE;
+    }
+    m_heightmap.reset();
+    m_inbox.reset();
+    m_inFlight = 0;
+    m_chunksX = m_chunksZ = 0;
+    m_windowW = m_windowH = 0;
+    m_lods.clear();
+    m_stats = Stats();
+    m_open = false;
+}
+
+void Terrain::FreeChunk(Chunk& chunk) {
+    if (chunk.vao) glDeleteVertexArrays(1, &chunk.vao);
+    if (chunk.vbo) glDeleteBuffers(1, &chunk.vbo);
+    chunk.vao = 0;
+    chunk.vbo = 0;
+}
+
+void Terrain::BuildIndices() {
+    const int quads = m_settings.chunkQuads;
+    const int stride = quads + 1;
+    std::vector<uint16_t> indices;
+    m_ranges.assign(static_cast<size_t>(m_lodCount) * 16, IndexRange());
+    for (int lod = 0; lod < m_lodCount; ++lod) {
+        const int step = 1 << lod;
+        const int cells = quads / step;
+        for (int mask = 0; mask < 16; ++mask) {
+            // nothing is coarser than the last LOD, its variants are all the plain grid
+            const int stitch = (lod + 1 < m_lodCount) ? mask : 0;
+            // Vertex at LOD grid coordinates. On a side next to a coarser chunk the odd
+            // vertices fold onto the even one before them, so that side only has the
+            // vertices the neighbour has; the triangles that collapse are dropped.
+            auto vertex = [&](int gx, int gz) {
+                if ((gx & 1) && (((stitch & kSideNorth) && gz == 0) || ((stitch & kSideSouth) && gz == cells))) --gx;
+                if ((gz & 1) && (((stitch & kSideWest) && gx == 0) || ((stitch & kSideEast) && gx == cells))) --gz;
+                return static_cast<uint16_t>(gz * step * stride + gx * step);
+            };
+            auto triangle = [&](uint16_t a, uint16_t b, uint16_t c) {
+                if (a == b || b == c || a == c) return;
+                indices.push_back(a);
+                indices.push_back(b);
+                indices.push_back(c);
+            };
+
+            IndexRange& range = m_ranges[lod * 16 + mask];
+            range.first = static_cast<uint32_t>(indices.size());
+            for (int gz = 0; gz < cells; ++gz) {
+                for (int gx = 0; gx < cells; ++gx) {
+                    // counter-clockwise seen from above
+                    const uint16_t a = vertex(gx, gz), b = vertex(gx, gz + 1), c = vertex(gx + 1, gz + 1), d = vertex(gx + 1, gz);
+                    triangle(a, b, c);
+                    triangle(a, c, d);
+                }
+            }
+            range.count = static_cast<uint32_t>(indices.size()) - range.first;
+        }
+    }
+
+    // no VAO bound, the element binding would land in it
+    glBindVertexArray(0);
+    glGenBuffers(1, &m_ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(uint16_t)), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    m_indexBytes = indices.size() * sizeof(uint16_t);
+}
+
+double Terrain::DistanceToChunk(const glm::dvec3& p, int x, int z) const {
+    const double size = ChunkSize();
+    const double minX = x * size, minZ = z * size;
+    double minY = 0.0, maxY = m_settings.heightScale;
+    auto it = m_chunks.find(Key(x, z));
+    if (it != m_chunks.end()) {
+        minY = it->second.minY;
+        maxY = it->second.maxY;
+    }
+    const double dx = std::max({ minX - p.x, 0.0, p.x - (minX + size) });
+    const double dy = std::max({ minY - p.y, 0.0, p.y - maxY });
+    const double dz = std::max({ minZ - p.z, 0.0, p.z - (minZ + size) });
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+void Terrain::Update(const glm::dvec3& camera) {
+    if (!m_open) return;
+
+    std::vector<Inbox::Built> built;
+    std::shared_ptr<const Heightmap> decoded;
+    bool decodeFailed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_inbox->mutex);
+        built.swap(m_inbox->built);
+        decoded = std::move(m_inbox->heightmap);
+        decodeFailed = m_inbox->decodeFailed;
+    }
+    if (decodeFailed) {
+        Close();
+        return;
+    }
+    if (decoded) SetHeightmap(std::move(decoded));
+    if (!m_heightmap) return;
+
+    for (Inbox::Built& result : built) {
+        --m_inFlight;
+        auto it = m_chunks.find(result.key);
+        if (it == m_chunks.end() || !it->second.building) continue;
+        it->second.vertices = std::move(result.vertices);
+        it->second.minY = result.minY;
+        it->second.maxY = result.maxY;
+        m_uploads.push_back(result.key);
+    }
+
+    // upload within the budget; the element buffer binding is VAO state, so every chunk
+    // VAO draws from the shared indices
+    for (int uploads = 0; uploads < m_settings.uploadsPerFrame && !m_uploads.empty();) {
+        auto it = m_chunks.find(m_uploads.front());
+        m_uploads.pop_front();
+        if (it == m_chunks.end() || !it->second.building || it->second.vertices.empty()) continue;
+        Chunk& chunk = it->second;
+        const size_t bytes = chunk.vertices.size() * sizeof(float);
+        glGenVertexArrays(1, &chunk.vao);
+        glGenBuffers(1, &chunk.vbo);
+        glBindVertexArray(chunk.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes), chunk.vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+        const GLsizei stride = kFloatsPerVertex * sizeof(float);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        std::vector<float>().swap(chunk.vertices);
+        chunk.building = false;
+        ++uploads;
+    }
+
+    // LOD of every chunk within loadRadius: full detail up to lodDistance, then one level
+    // coarser per doubling of the distance
+    const glm::dvec3 local = camera - m_settings.origin;
+    const double size = ChunkSize();
+    const double radius = m_settings.loadRadius;
+    const int x0 = std::max(0, ChunkCoord(local.x - radius, size, m_chunksX));
+    const int x1 = std::min(m_chunksX - 1, ChunkCoord(local.x + radius, size, m_chunksX));
+    const int z0 = std::max(0, ChunkCoord(local.z - radius, size, m_chunksZ));
+    const int z1 = std::min(m_chunksZ - 1, ChunkCoord(local.z + radius, size, m_chunksZ));
+    m_windowX = x0;
+    m_windowZ = z0;
+    m_windowW = std::max(0, x1 - x0 + 1);
+    m_windowH = std::max(0, z1 - z0 + 1);
+    m_lods.assign(static_cast<size_t>(m_windowW) * m_windowH, kNotWanted);
+    for (int wz = 0; wz < m_windowH; ++wz) {
+        for (int wx = 0; wx < m_windowW; ++wx) {
+            const double distance = DistanceToChunk(local, x0 + wx, z0 + wz);
+            if (distance > radius) continue;
+            int lod = 0;
+            if (m_settings.lodDistance > 0.0f && distance > m_settings.lodDistance) {
+                lod = std::min(m_lodCount - 1, 1 + static_cast<int>(std::log2(distance / m_settings.lodDistance)));
+            }
+            m_lods[wz * m_windowW + wx] = static_cast<uint8_t>(lod);
+        }
+    }
+    // The stitching closes the gap to a neighbour one LOD coarser, not more. Only ever
+    // refine a chunk that is too coarse, so this settles within m_lodCount passes.
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int wz = 0; wz < m_windowH; ++wz) {
+            for (int wx = 0; wx < m_windowW; ++wx) {
+                uint8_t& lod = m_lods[wz * m_windowW + wx];
+                if (lod == kNotWanted) continue;
+                uint8_t finest = kNotWanted;
+                if (wx > 0) finest = std::min(finest, m_lods[wz * m_windowW + wx - 1]);
+                if (wx + 1 < m_windowW) finest = std::min(finest, m_lods[wz * m_windowW + wx + 1]);
+                if (wz > 0) finest = std::min(finest, m_lods[(wz - 1) * m_windowW + wx]);
+                if (wz + 1 < m_windowH) finest = std::min(finest, m_lods[(wz + 1) * m_windowW + wx]);
+                if (finest != kNotWanted && lod > finest + 1) {
+                    lod = static_cast<uint8_t>(finest + 1);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // free uploaded chunks that fell behind; chunks still building finish first
+    for (auto it = m_chunks.begin(); it != m_chunks.end();) {
+        if (!it->second.building && DistanceToChunk(local, it->first % m_chunksX, it->first / m_chunksX) > m_settings.unloadRadius) {
+            FreeChunk(it->second);
+            it = m_chunks.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    StartBuilds(local);
+
+    m_stats.resident = 0;
+    m_stats.building = 0;
+    for (const auto& entry : m_chunks) {
+        if (entry.second.building) ++m_stats.building;
+        else ++m_stats.resident;
+    }
+    const int stride = m_settings.chunkQuads + 1;
+    m_stats.gpuBytes = m_indexBytes + static_cast<size_t>(m_stats.resident) * stride * stride * kFloatsPerVertex * sizeof(float);
+}
+
+void Terrain::StartBuilds(const glm::dvec3& local) {
+    if (m_inFlight >= m_settings.maxBuildsInFlight) return;
+    // wanted chunks without buffers, nearest first
+    std::vector<std::pair<double, int>> wanted;
+    for (int wz = 0; wz < m_windowH; ++wz) {
+        for (int wx = 0; wx < m_windowW; ++wx) {
+            if (m_lods[wz * m_windowW + wx] == kNotWanted) continue;
+            const int x = m_windowX + wx, z = m_windowZ + wz;
+            if (m_chunks.count(Key(x, z))) continue;
+            wanted.emplace_back(DistanceToChunk(local, x, z), Key(x, z));
+        }
+    }
+    const size_t starts = std::min(wanted.size(), static_cast<size_t>(m_settings.maxBuildsInFlight - m_inFlight));
+    std::partial_sort(wanted.begin(), wanted.begin() + starts, wanted.end());
+
+    const int quads = m_settings.chunkQuads;
+    const float spacing = m_settings.sampleSpacing;
+    const float scale = m_settings.heightScale / 65535.0f;
+    const double tiles = static_cast<double>(spacing) / m_settings.textureTiling;
+    for (size_t i = 0; i < starts; ++i) {
+        const int key = wanted[i].second;
+        Chunk& chunk = m_chunks[key];
+        chunk.maxY = m_settings.heightScale;
+        ++m_inFlight;
+        const int sx0 = (key % m_chunksX) * quads;
+        const int sz0 = (key / m_chunksX) * quads;
+        Jobs::Submit([inbox = m_inbox, heightmap = m_heightmap, key, sx0, sz0, quads, spacing, scale, tiles]() {
+            Inbox::Built result;
+            result.key = key;
+            const int stride = quads + 1;
+            result.vertices.resize(static_cast<size_t>(stride) * stride * kFloatsPerVertex);
+            result.minY = FLT_MAX;
+            result.maxY = -FLT_MAX;
+            auto height = [&](int sx, int sz) { return heightmap->Sample(sx, sz) * scale; };
+            // uvs run on across chunks; only the fraction of the chunk's offset matters,
+            // which keeps them precise on far chunks
+            const float u0 = static_cast<float>(std::fmod(sx0 * tiles, 1.0));
+            const float v0 = static_cast<float>(std::fmod(sz0 * tiles, 1.0));
+            float* v = result.vertices.data();
+            for (int z = 0; z <= quads; ++z) {
+                for (int x = 0; x <= quads; ++x) {
+                    const int sx = sx0 + x, sz = sz0 + z;
+                    const float y = height(sx, sz);
+                    // central differences over the chunk border too, so neighbours shade alike
+                    const float dx = (height(sx + 1, sz) - height(sx - 1, sz)) / (2.0f * spacing);
+                    const float dz = (height(sx, sz + 1) - height(sx, sz - 1)) / (2.0f * spacing);
+                    const glm::vec3 normal = glm::normalize(glm::vec3(-dx, 1.0f, -dz));
+                    *v++ = x * spacing;
+                    *v++ = y;
+                    *v++ = z * spacing;
+                    *v++ = normal.x;
+                    *v++ = normal.y;
+                    *v++ = normal.z;
+                    *v++ = u0 + static_cast<float>(x * tiles);
+                    *v++ = v0 + static_cast<float>(z * tiles);
+                    result.minY = std::min(result.minY, y);
+                    result.maxY = std::max(result.maxY, y);
+                }
+            }
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->built.push_back(std::move(result));
+        });
+    }
+}
+
+void Terrain::Draw(Shader& shader, const glm::mat4& view, const glm::mat4& projection, const glm::dvec3& origin) {
+    m_stats.drawn = 0;
+    m_stats.triangles = 0;
+    if (!m_open || m_lods.empty()) return;
+
+    Plane planes[6];
+    ExtractFrustum(projection * view, planes);
+
+    shader.Use();
+    shader.SetUniformInt("myTexture", 0);
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    shader.SetUniformInt("u_selected", 0);
+    shader.SetUniformInt("u_vertexFormat", 0);
+    shader.SetUniformInt("u_flipV", 0);
+    shader.SetUniformInt("u_materialMode", 0);
+    // tiled right under the camera, so always wants the full resolution
+    TextureManager::RequestMip(m_texture, 0);
+    const GLuint texId = TextureManager::Bind(m_texture, 0);
+
+    // chunk corners relative to the floating origin, in double until the offset is small
+    const glm::dvec3 base = m_settings.origin - origin;
+    const double size = ChunkSize();
+    for (int wz = 0; wz < m_windowH; ++wz) {
+        for (int wx = 0; wx < m_windowW; ++wx) {
+            const uint8_t lod = m_lods[wz * m_windowW + wx];
+            if (lod == kNotWanted) continue;
+            const int x = m_windowX + wx, z = m_windowZ + wz;
+            auto it = m_chunks.find(Key(x, z));
+            if (it == m_chunks.end() || it->second.building) continue;
+            const Chunk& chunk = it->second;
+
+            const glm::vec3 corner(base + glm::dvec3(x * size, 0.0, z * size));
+            const glm::vec3 boxMin = corner + glm::vec3(0.0f, chunk.minY, 0.0f);
+            const glm::vec3 boxMax = corner + glm::vec3(static_cast<float>(size), chunk.maxY, static_cast<float>(size));
+            if (!BoxInFrustum(planes, boxMin, boxMax)) continue;
+
+            auto coarser = [&](int nx, int nz) {
+                if (nx < 0 || nz < 0 || nx >= m_windowW || nz >= m_windowH) return false;
+                const uint8_t other = m_lods[nz * m_windowW + nx];
+                return other != kNotWanted && other > lod;
+            };
+            int mask = 0;
+            if (coarser(wx, wz - 1)) mask |= kSideNorth;
+            if (coarser(wx + 1, wz)) mask |= kSideEast;
+            if (coarser(wx, wz + 1)) mask |= kSideSouth;
+            if (coarser(wx - 1, wz)) mask |= kSideWest;
+            const IndexRange& range = m_ranges[lod * 16 + mask];
+
+            shader.setMat4("model", glm::translate(glm::mat4(1.0f), corner));
+            glBindVertexArray(chunk.vao);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(range.count), GL_UNSIGNED_SHORT,
+                (void*)(static_cast<size_t>(range.first) * sizeof(uint16_t)));
+            ++m_stats.drawn;
+            m_stats.triangles += range.count / 3;
+        }
+    }
+    glBindVertexArray(0);
+    if (texId) {
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+bool Terrain::HeightAt(double x, double z, float& height) const {
+    if (!m_heightmap) return false;
+    const double sx = (x - m_settings.origin.x) / m_settings.sampleSpacing;
+    const double sz = (z - m_settings.origin.z) / m_settings.sampleSpacing;
+    if (sx < 0.0 || sz < 0.0 || sx > m_heightmap->width - 1 || sz > m_heightmap->height - 1) return false;
+    const int ix = static_cast<int>(sx), iz = static_cast<int>(sz);
+    const float fx = static_cast<float>(sx - ix), fz = static_cast<float>(sz - iz);
+    const float h00 = m_heightmap->Sample(ix, iz), h10 = m_heightmap->Sample(ix + 1, iz);
+    const float h01 = m_heightmap->Sample(ix, iz + 1), h11 = m_heightmap->Sample(ix + 1, iz + 1);
+    const float h = (h00 * (1.0f - fx) + h10 * fx) * (1.0f - fz) + (h01 * (1.0f - fx) + h11 * fx) * fz;
+    height = static_cast<float>(m_settings.origin.y) + h * (m_settings.heightScale / 65535.0f);
+    return true;
+}
@@ -0,0 +1,689 @@
+#include "../include/texture_compress.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// SSE2 is baseline on x64 (MSVC defines _M_X64, gcc/clang define __SSE2__)
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define SPX_TC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Block encoders work on one 4x4 block at a time. Pixels are kept twice: as floats
+// in SoA order for the SIMD projection, and as bytes for exact error measurement.
+namespace {
+    using TextureCompress::Format;
+    using TextureCompress::Quality;
+
+    struct Block {
+        alignas(16) float ch[4][16]; // r, g, b, a planes
+        unsigned char px[16][4];
+    };
+
+    // BC7 4-bit index interpolation weights (out of 64)
+    static const int kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    void FetchBlock(const unsigned char* rgba, int w, int h, int bx, int by, Block& blk) {
+        for (int y = 0; y < 4; ++y) {
+            int sy = std::min(by * 4 + y, h - 1); // replicate edge texels for partial blocks
+            for (int x = 0; x < 4; ++x) {
+                int sx = std::min(bx * 4 + x, w - 1);
+                const unsigned char* s = rgba + (static_cast<size_t>(sy) * w + sx) * 4;
+                int i = y * 4 + x;
+                std::memcpy(blk.px[i], s, 4);
+                for (int c = 0; c < 4; ++c) blk.ch[c][i] = static_cast<float>(s[c]);
+            }
+        }
+    }
+
+    // t[i] = dot(pixel[i] - origin, axis) over the first `channels` channels
+    void ProjectBlock(const Block& blk, int channels, const float origin[4], const float axis[4], float t[16]) {
+#ifdef SPX_TC_SSE2
+        for (int i = 0; i < 16; i += 4) {
+            __m128 acc = _mm_setzero_ps();
+            for (int c = 0; c < channels; ++c) {
+                __m128 v = _mm_sub_ps(_mm_load_ps(&blk.ch[c][i]), _mm_set1_ps(origin[c]));
+                acc = _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(axis[c])));
+            }
+            _mm_storeu_ps(&t[i], acc);
+        }
+#else
+        for (int i = 0; i < 16; ++i) {
+            float acc = 0.0f;
+            for (int c = 0; c < channels; ++c) acc += (blk.ch[c][i] - origin[c]) * axis[c];
+            t[i] = acc;
+        }
+#endif
+    }
+
+    // Find the line the block's colours lie along, returned as two (unquantized) endpoints.
+    // Fast: bounding box diagonal, with each channel flipped to follow its correlation with
+    // the widest channel. High: principal axis of the covariance matrix via power iteration.
+    void FitLine(const Block& blk, int channels, Quality quality, float e0[4], float e1[4]) {
+        float mn[4], mx[4], mean[4];
+        for (int c = 0; c < channels; ++c) {
+            mn[c] = mx[c] = blk.ch[c][0];
+            float sum = 0.0f;
+            for (int i = 0; i < 16; ++i) {
+                mn[c] = std::min(mn[c], blk.ch[c][i]);
+                mx[c] = std::max(mx[c], blk.ch[c][i]);
+                sum += blk.ch[c][i];
+            }
+            mean[c] = sum / 16.0f;
+        }
+
+        float cov[4][4] = {};
+        for (int i = 0; i < 16; ++i) {
+            for (int a = 0; a < channels; ++a) {
+                float da = blk.ch[a][i] - mean[a];
+                for (int b = a; b < channels; ++b) cov[a][b] += da * (blk.ch[b][i] - mean[b]);
+            }
+        }
+        for (int a = 0; a < channels; ++a)
+            for (int b = 0; b < a; ++b) cov[a][b] = cov[b][a];
+
+        if (quality == Quality::Fast) {
+            int major = 0;
+            for (int c = 1; c < channels; ++c)
+                if (mx[c] - mn[c] > mx[major] - mn[major]) major = c;
+            for (int c = 0; c < channels; ++c) {
+                // inset by 1/16 of the range so the end points sit on the colours, not outside them
+                float inset = (mx[c] - mn[c]) / 16.0f;
+                float lo = mn[c] + inset, hi = mx[c] - inset;
+                if (c != major && cov[major][c] < 0.0f) std::swap(lo, hi);
+                e0[c] = lo;
+                e1[c] = hi;
+            }
+            return;
+        }
+
+        float axis[4] = {};
+        for (int c = 0; c < channels; ++c) axis[c] = mx[c] - mn[c];
+        for (int iter = 0; iter < 8; ++iter) {
+            float next[4] = {};
+            for (int a = 0; a < channels; ++a)
+                for (int b = 0; b < channels; ++b) next[a] += cov[a][b] * axis[b];
+            float len = 0.0f;
+            for (int c = 0; c < channels; ++c) len = std::max(len, std::fabs(next[c]));
+            if (len < 1e-6f) break; // flat block, keep the previous axis
+            for (int c = 0; c < channels; ++c) axis[c] = next[c] / len;
+        }
+        float len2 = 0.0f;
+        for (int c = 0; c < channels; ++c) len2 += axis[c] * axis[c];
+        if (len2 < 1e-12f) {
+            for (int c = 0; c < channels; ++c) e0[c] = e1[c] = mean[c];
+            return;
+        }
+        for (int c = 0; c < channels; ++c) axis[c] /= std::sqrt(len2);
+
+        float t[16];
+        ProjectBlock(blk, channels, mean, axis, t);
+        float tmin = t[0], tmax = t[0];
+        for (int i = 1; i < 16; ++i) { tmin = std::min(tmin, t[i]); tmax = std::max(tmax, t[i]); }
+        for (int c = 0; c < channels; ++c) {
+            e0[c] = std::clamp(mean[c] + axis[c] * tmin, 0.0f, 255.0f);
+            e1[c] = std::clamp(mean[c] + axis[c] * tmax, 0.0f, 255.0f);
+        }
+    }
+
+    // Least-squares endpoints for fixed per-pixel weights w in [0,1] (0 = e0, 1 = e1)
+    bool LeastSquaresEndpoints(const Block& blk, int channels, const float w[16], float e0[4], float e1[4]) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (int i = 0; i < 16; ++i) {
+            float a = 1.0f - w[i], b = w[i];
+            aa += a * a; ab += a * b; bb += b * b;
+            for (int c = 0; c < channels; ++c) {
+                ax[c] += a * blk.ch[c][i];
+                bx[c] += b * blk.ch[c][i];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) < 1e-6f) return false;
+        float inv = 1.0f / det;
+        for (int c = 0; c < channels; ++c) {
+            e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) * inv, 0.0f, 255.0f);
+            e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) * inv, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    // ------------------------------------------------------------------ BC1 colour
+
+    uint16_t To565(const float c[4]) {
+        int r = static_cast<int>(c[0] * 31.0f / 255.0f + 0.5f);
+        int g = static_cast<int>(c[1] * 63.0f / 255.0f + 0.5f);
+        int b = static_cast<int>(c[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((std::clamp(r, 0, 31) << 11) | (std::clamp(g, 0, 63) << 5) | std::clamp(b, 0, 31));
+    }
+
+    void From565(uint16_t v, int out[3]) {
+        int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        out[0] = (r << 3) | (r >> 2);
+        out[1] = (g << 2) | (g >> 4);
+        out[2] = (b << 3) | (b >> 2);
+    }
+
+    // Palette exactly as the decoder builds it (4-colour mode when c0 > c1)
+    void BC1Palette(uint16_t c0, uint16_t c1, int pal[4][4]) {
+        From565(c0, pal[0]);
+        From565(c1, pal[1]);
+        pal[0][3] = pal[1][3] = 255;
+        if (c0 > c1) {
+            for (int c = 0; c < 3; ++c) {
+                pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+                pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+            }
+            pal[2][3] = pal[3][3] = 255;
+        }
+        else {
+            for (int c = 0; c < 3; ++c) {
+                pal[2][c] = (pal[0][c] + pal[1][c]) / 2;
+                pal[3][c] = 0;
+            }
+            pal[2][3] = 255;
+            pal[3][3] = 0;
+        }
+    }
+
+    // Pick indices for a 4-colour BC1 palette, returns squared RGB error
+    int BC1Indices(const Block& blk, const int pal[4][4], Quality quality, uint8_t idx[16]) {
+        int err = 0;
+        if (quality == Quality::Fast) {
+            // project onto the palette line; levels 0..3 along the line map to indices 0,2,3,1
+            static const uint8_t kMap[4] = { 0, 2, 3, 1 };
+            float origin[4] = { (float)pal[0][0], (float)pal[0][1], (float)pal[0][2], 0.0f };
+            float axis[4] = { (float)(pal[1][0] - pal[0][0]), (float)(pal[1][1] - pal[0][1]), (float)(pal[1][2] - pal[0][2]), 0.0f };
+            float len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+            float t[16];
+            ProjectBlock(blk, 3, origin, axis, t);
+            float scale = (len2 > 0.0f) ? 3.0f / len2 : 0.0f;
+            for (int i = 0; i < 16; ++i) {
+                int level = std::clamp(static_cast<int>(t[i] * scale + 0.5f), 0, 3);
+                idx[i] = kMap[level];
+                for (int c = 0; c < 3; ++c) {
+                    int d = blk.px[i][c] - pal[idx[i]][c];
+                    err += d * d;
+                }
+            }
+            return err;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = std::numeric_limits<int>::max();
+            for (int p = 0; p < 4; ++p) {
+                int e = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = blk.px[i][c] - pal[p][c];
+                    e += d * d;
+                }
+                if (e < best) { best = e; idx[i] = static_cast<uint8_t>(p); }
+            }
+            err += best;
+        }
+        return err;
+    }
+
+    void WriteBC1(uint16_t c0, uint16_t c1, const uint8_t idx[16], uint8_t* out) {
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; ++i) bits |= static_cast<uint32_t>(idx[i] & 3) << (2 * i);
+        out[0] = static_cast<uint8_t>(c0); out[1] = static_cast<uint8_t>(c0 >> 8);
+        out[2] = static_cast<uint8_t>(c1); out[3] = static_cast<uint8_t>(c1 >> 8);
+        for (int i = 0; i < 4; ++i) out[4 + i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+
+    // Quantize endpoints and force 4-colour mode (c0 > c1), then choose indices
+    int BC1Try(const Block& blk, const float e0[4], const float e1[4], Quality quality,
+        uint16_t& c0, uint16_t& c1, uint8_t idx[16]) {
+        c0 = To565(e0);
+        c1 = To565(e1);
+        if (c0 < c1) std::swap(c0, c1);
+        if (c0 == c1) {
+            // solid block: nudge c1 so we stay in 4-colour mode, every index picks c0
+            if (c0 > 0) --c1; else ++c0;
+        }
+        int pal[4][4];
+        BC1Palette(c0, c1, pal);
+        return BC1Indices(blk, pal, quality, idx);
+    }
+
+    void EncodeBC1Block(const Block& blk, Quality quality, uint8_t* out) {
+        float e0[4], e1[4];
+        FitLine(blk, 3, quality, e0, e1);
+
+        uint16_t c0, c1;
+        uint8_t idx[16];
+        int err = BC1Try(blk, e0, e1, quality, c0, c1, idx);
+
+        if (quality == Quality::High) {
+            // Refine endpoints from the chosen indices, keep whichever is better
+            static const float kWeight[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            for (int iter = 0; iter < 2 && err > 0; ++iter) {
+                float w[16];
+                for (int i = 0; i < 16; ++i) w[i] = kWeight[idx[i]];
+                float r0[4], r1[4];
+                if (!LeastSquaresEndpoints(blk, 3, w, r0, r1)) break;
+                uint16_t n0, n1;
+                uint8_t nidx[16];
+                int nerr = BC1Try(blk, r0, r1, quality, n0, n1, nidx);
+                if (nerr >= err) break;
+                err = nerr; c0 = n0; c1 = n1;
+                std::memcpy(idx, nidx, sizeof(nidx));
+            }
+        }
+        WriteBC1(c0, c1, idx, out);
+    }
+
+    // ------------------------------------------------------------------ BC3 alpha (BC4 layout)
+
+    void AlphaPalette(int a0, int a1, int pal[8]) {
+        pal[0] = a0;
+        pal[1] = a1;
+        if (a0 > a1) {
+            for (int i = 2; i < 8; ++i) pal[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+        else {
+            for (int i = 2; i < 6; ++i) pal[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+            pal[6] = 0;
+            pal[7] = 255;
+        }
+    }
+
+    void EncodeAlphaBlock(const Block& blk, uint8_t* out) {
+        int amin = 255, amax = 0;
+        for (int i = 0; i < 16; ++i) {
+            amin = std::min<int>(amin, blk.px[i][3]);
+            amax = std::max<int>(amax, blk.px[i][3]);
+        }
+        uint64_t bits = 0;
+        if (amax != amin) {
+            // 8-level mode; with only 8 values an exhaustive search is as cheap as projecting
+            int pal[8];
+            AlphaPalette(amax, amin, pal);
+            for (int i = 0; i < 16; ++i) {
+                int best = 256, bestIdx = 0;
+                for (int p = 0; p < 8; ++p) {
+                    int d = std::abs(blk.px[i][3] - pal[p]);
+                    if (d < best) { best = d; bestIdx = p; }
+                }
+                bits |= static_cast<uint64_t>(bestIdx) << (3 * i);
+            }
+        }
+        out[0] = static_cast<uint8_t>(amax);
+        out[1] = static_cast<uint8_t>(amin);
+        for (int i = 0; i < 6; ++i) out[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+
+    // ------------------------------------------------------------------ BC7 mode 6
+
+    // LSB-first bit packer for a 128-bit block
+    struct BitWriter {
+        uint8_t* out;
+        int pos = 0;
+        void Put(uint32_t value, int bits) {
+            for (int b = 0; b < bits; ++b, ++pos) {
+                if (value & (1u << b)) out[pos >> 3] |= static_cast<uint8_t>(1u << (pos & 7));
+            }
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* in;
+        int pos = 0;
+        uint32_t Get(int bits) {
+            uint32_t v = 0;
+            for (int b = 0; b < bits; ++b, ++pos) {
+                if (in[pos >> 3] & (1u << (pos & 7))) v |= 1u << b;
+            }
+            return v;
+        }
+    };
+
+    struct BC7Ends {
+        int q[2][4]; // 7-bit endpoints
+        int p[2];    // p-bits
+    };
+
+    // Quantize an 8-bit endpoint to 7 bits + shared p-bit
+    void QuantizeBC7(const float e[4], int pbit, int q[4]) {
+        for (int c = 0; c < 4; ++c) {
+            q[c] = std::clamp(static_cast<int>((e[c] - pbit) / 2.0f + 0.5f), 0, 127);
+        }
+    }
+
+    void BC7Palette(const BC7Ends& ends, int pal[16][4]) {
+        int e0[4], e1[4];
+        for (int c = 0; c < 4; ++c) {
+            e0[c] = (ends.q[0][c] << 1) | ends.p[0];
+            e1[c] = (ends.q[1][c] << 1) | ends.p[1];
+        }
+        for (int i = 0; i < 16; ++i) {
+            int w = kBC7Weights[i];
+            for (int c = 0; c < 4; ++c) pal[i][c] = ((64 - w) * e0[c] + w * e1[c] + 32) >> 6;
+        }
+    }
+
+    int BC7Indices(const Block& blk, const BC7Ends& ends, Quality quality, uint8_t idx[16]) {
+        int pal[16][4];
+        BC7Palette(ends, pal);
+        int err = 0;
+        if (quality == Quality::Fast) {
+            float origin[4], axis[4];
+            float len2 = 0.0f;
+            for (int c = 0; c < 4; ++c) {
+                origin[c] = static_cast<float>(pal[0][c]);
+                axis[c] = static_cast<float>(pal[15][c] - pal[0][c]);
+                len2 += axis[c] * axis[c];
+            }
+            float t[16];
+            ProjectBlock(blk, 4, origin, axis, t);
+            float scale = (len2 > 0.0f) ? 15.0f / len2 : 0.0f;
+            for (int i = 0; i < 16; ++i) {
+                idx[i] = static_cast<uint8_t>(std::clamp(static_cast<int>(t[i] * scale + 0.5f), 0, 15));
+                for (int c = 0; c < 4; ++c) {
+                    int d = blk.px[i][c] - pal[idx[i]][c];
+                    err += d * d;
+                }
+            }
+            return err;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = std::numeric_limits<int>::max();
+            for (int p = 0; p < 16; ++p) {
+                int e = 0;
+                for (int c = 0; c < 4; ++c) {
+                    int d = blk.px[i][c] - pal[p][c];
+                    e += d * d;
+                }
+                if (e < best) { best = e; idx[i] = static_cast<uint8_t>(p); }
+            }
+            err += best;
+        }
+        return err;
+    }
+
+    // Quantize both endpoints, trying every p-bit pair in High quality
+    int BC7Try(const Block& blk, const float e0[4], const float e1[4], Quality quality, BC7Ends& ends, uint8_t idx[16]) {
+        int bestErr = std::numeric_limits<int>::max();
+        for (int combo = 0; combo < 4; ++combo) {
+            BC7Ends cand;
+            cand.p[0] = combo & 1;
+            cand.p[1] = (combo >> 1) & 1;
+            if (quality == Quality::Fast) {
+                // pick each p-bit from the endpoint's own rounding (average low bit)
+                float s0 = 0.0f, s1 = 0.0f;
+                for (int c = 0; c < 4; ++c) { s0 += e0[c]; s1 += e1[c]; }
+                cand.p[0] = (static_cast<int>(s0 / 4.0f + 0.5f) & 1);
+                cand.p[1] = (static_cast<int>(s1 / 4.0f + 0.5f) & 1);
+            }
+            QuantizeBC7(e0, cand.p[0], cand.q[0]);
+            QuantizeBC7(e1, cand.p[1], cand.q[1]);
+            uint8_t cidx[16];
+            int err = BC7Indices(blk, cand, quality, cidx);
+            if (err < bestErr) {
+                bestErr = err;
+                ends = cand;
+                std::memcpy(idx, cidx, sizeof(cidx));
+            }
+            if (quality == Quality::Fast) break;
+        }
+        return bestErr;
+    }
+
+    void EncodeBC7Block(const Block& blk, Quality quality, uint8_t* out) {
+        float e0[4], e1[4];
+        FitLine(blk, 4, quality, e0, e1);
+
+        BC7Ends ends;
+        uint8_t idx[16];
+        int err = BC7Try(blk, e0, e1, quality, ends, idx);
+
+        if (quality == Quality::High) {
+            for (int iter = 0; iter < 2 && err > 0; ++iter) {
+                float w[16];
+                for (int i = 0; i < 16; ++i) w[i] = kBC7Weights[idx[i]] / 64.0f;
+                float r0[4], r1[4];
+                if (!LeastSquaresEndpoints(blk, 4, w, r0, r1)) break;
+                BC7Ends nends;
+                uint8_t nidx[16];
+                int nerr = BC7Try(blk, r0, r1, quality, nends, nidx);
+                if (nerr >= err) break;
+                err = nerr; ends = nends;
+                std::memcpy(idx, nidx, sizeof(nidx));
+            }
+        }
+
+        // Anchor index (pixel 0) only stores 3 bits, so its MSB must be 0.
+        // The weight table is symmetric, so swapping the endpoints and inverting is lossless.
+        if (idx[0] & 8) {
+            for (int c = 0; c < 4; ++c) std::swap(ends.q[0][c], ends.q[1][c]);
+            std::swap(ends.p[0], ends.p[1]);
+            for (int i = 0; i < 16; ++i) idx[i] = static_cast<uint8_t>(15 - idx[i]);
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter bw{ out };
+        bw.Put(1u << 6, 7); // mode 6
+        for (int c = 0; c < 4; ++c) {
+            bw.Put(static_cast<uint32_t>(ends.q[0][c]), 7);
+            bw.Put(static_cast<uint32_t>(ends.q[1][c]), 7);
+        }
+        bw.Put(static_cast<uint32_t>(ends.p[0]), 1);
+        bw.Put(static_cast<uint32_t>(ends.p[1]), 1);
+        bw.Put(idx[0], 3);
+        for (int i = 1; i < 16; ++i) bw.Put(idx[i], 4);
+    }
+
+    // ------------------------------------------------------------------ decoders
+
+    void DecodeBC1Block(const uint8_t* in, uint8_t px[16][4]) {
+        uint16_t c0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+        uint16_t c1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+        int pal[4][4];
+        BC1Palette(c0, c1, pal);
+        uint32_t bits = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+        for (int i = 0; i < 16; ++i) {
+            int p = (bits >> (2 * i)) & 3;
+            for (int c = 0; c < 4; ++c) px[i][c] = static_cast<uint8_t>(pal[p][c]);
+        }
+    }
+
+    void DecodeAlphaBlock(const uint8_t* in, uint8_t px[16][4]) {
+        int pal[8];
+        AlphaPalette(in[0], in[1], pal);
+        uint64_t bits = 0;
+        for (int i = 0; i < 6; ++i) bits |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+        for (int i = 0; i < 16; ++i) px[i][3] = static_cast<uint8_t>(pal[(bits >> (3 * i)) & 7]);
+    }
+
+    bool DecodeBC7Block(const uint8_t* in, uint8_t px[16][4]) {
+        if ((in[0] & 0x7F) != 0x40) { // we only ever write mode 6
+            std::memset(px, 0, 16 * 4);
+            return false;
+        }
+        BitReader br{ in };
+        br.Get(7);
+        BC7Ends ends;
+        for (int c = 0; c < 4; ++c) {
+            ends.q[0][c] = static_cast<int>(br.Get(7));
+            ends.q[1][c] = static_cast<int>(br.Get(7));
+        }
+        ends.p[0] = static_cast<int>(br.Get(1));
+        ends.p[1] = static_cast<int>(br.Get(1));
+        int pal[16][4];
+        BC7Palette(ends, pal);
+        for (int i = 0; i < 16; ++i) {
+            int p = static_cast<int>(br.Get(i == 0 ? 3 : 4));
+            for (int c = 0; c < 4; ++c) px[i][c] = static_cast<uint8_t>(pal[p][c]);
+        }
+        return true;
+    }
+}
+
+size_t TextureCompress::BlockBytes(Format format) {
+    switch (format) {
+    case Format::BC1: return 8;
+    case Format::BC3: return 16;
+    case Format::BC7: return 16;
+    default:          return 0;
+    }
+}
+
+size_t TextureCompress::CompressedSize(Format format, int w, int h) {
+    size_t bx = static_cast<size_t>((std::max(w, 1) + 3) / 4);
+    size_t by = static_cast<size_t>((std::max(h, 1) + 3) / 4);
+    return bx * by * BlockBytes(format);
+}
+
+GLenum TextureCompress::GLInternalFormat(Format format) {
+    switch (format) {
+    case Format::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case Format::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case Format::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default:          return 0;
+    }
+}
+
+const char* TextureCompress::FormatName(Format format) {
+    switch (format) {
+    case Format::BC1:  return "BC1";
+    case Format::BC3:  return "BC3";
+    case Format::BC7:  return "BC7";
+    case Format::Auto: return "Auto";
+    default:           return "RGBA8";
+    }
+}
+
+TextureCompress::Format TextureCompress::ResolveFormat(Format format, const unsigned char* rgba, int w, int h) {
+    if (format != Format::Auto) return format;
+    const size_t count = static_cast<size_t>(w) * h;
+    for (size_t i = 0; i < count; ++i) {
+        if (rgba[i * 4 + 3] != 255) return Format::BC3;
+    }
+    return Format::BC1;
+}
+
+bool TextureCompress::Encode(const unsigned char* rgba, int w, int h, Format format, Quality quality,
+    std::vector<unsigned char>& out)
+{
+    if (!rgba || w <= 0 || h <= 0) return false;
+    format = ResolveFormat(format, rgba, w, h);
+    const size_t blockBytes = BlockBytes(format);
+    if (blockBytes == 0) return false;
+
+    const int blocksX = (w + 3) / 4;
+    const int blocksY = (h + 3) / 4;
+    out.assign(CompressedSize(format, w, h), 0);
+    unsigned char* dst = out.data();
+
+    // one batch = a few block rows, enough work per hand-off to hide the queue cost
+    Jobs::ParallelFor(static_cast<size_t>(blocksY), 4, [&](size_t rowBegin, size_t rowEnd) {
+        Block blk;
+        for (size_t by = rowBegin; by < rowEnd; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                FetchBlock(rgba, w, h, bx, static_cast<int>(by), blk);
+                uint8_t* o = dst + (by * blocksX + bx) * blockBytes;
+                switch (format) {
+                case Format::BC1:
+                    EncodeBC1Block(blk, quality, o);
+                    break;
+                case Format::BC3:
+                    EncodeAlphaBlock(blk, o);
+                    EncodeBC1Block(blk, quality, o + 8);
+                    break;
+                case Format::BC7:
+                    EncodeBC7Block(blk, quality, o);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    });
+    return true;
+}
+
+bool TextureCompress::Decode(const unsigned char* blocks, int w, int h, Format format,
+    std::vector<unsigned char>& outRgba)
+{
+    const size_t blockBytes = BlockBytes(format);
+    if (!blocks || w <= 0 || h <= 0 || blockBytes == 0) return false;
+
+    const int blocksX = (w + 3) / 4;
+    const int blocksY = (h + 3) / 4;
+    outRgba.assign(static_cast<size_t>(w) * h * 4, 0);
+    bool ok = true;
+
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const uint8_t* in = blocks + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+            uint8_t px[16][4];
+            switch (format) {
+            case Format::BC1:
+                DecodeBC1Block(in, px);
+                break;
+            case Format::BC3:
+                DecodeBC1Block(in + 8, px);
+                DecodeAlphaBlock(in, px);
+                break;
+            case Format::BC7:
+                ok &= DecodeBC7Block(in, px);
+                break;
+            default:
+                return false;
+            }
+            for (int y = 0; y < 4; ++y) {
+                int dy = by * 4 + y;
+                if (dy >= h) break;
+                for (int x = 0; x < 4; ++x) {
+                    int dx = bx * 4 + x;
+                    if (dx >= w) break;
+                    std::memcpy(&outRgba[(static_cast<size_t>(dy) * w + dx) * 4], px[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+TextureCompress::EncodeReport TextureCompress::MeasureEncode(const unsigned char* rgba, int w, int h,
+    Format format, Quality quality)
+{
+    EncodeReport report;
+    format = ResolveFormat(format, rgba, w, h);
+
+    std::vector<unsigned char> blocks;
+    auto start = std::chrono::steady_clock::now();
+    if (!Encode(rgba, w, h, format, quality, blocks)) return report;
+    auto end = std::chrono::steady_clock::now();
+
+    report.seconds = std::chrono::duration<double>(end - start).count();
+    report.bytes = blocks.size();
+    if (report.seconds > 0.0) {
+        report.mpixelsPerSec = (static_cast<double>(w) * h / 1.0e6) / report.seconds;
+    }
+
+    std::vector<unsigned char> decoded;
+    Decode(blocks.data(), w, h, format, decoded);
+
+    // BC1 carries no alpha so only RGB counts towards its error
+    const int channels = (format == Format::BC1) ? 3 : 4;
+    double sse = 0.0;
+    const size_t count = static_cast<size_t>(w) * h;
+    for (size_t i = 0; i < count; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            double d = static_cast<double>(rgba[i * 4 + c]) - decoded[i * 4 + c];
+            sse += d * d;
+        }
+    }
+    double mse = sse / (static_cast<double>(count) * channels);
+    report.psnr = (mse > 0.0) ? 10.0 * std::log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+
+    LOG_INFO("TextureCompress: " << FormatName(format) << (quality == Quality::High ? " high" : " fast")
+        << " " << w << "x" << h << " PSNR=" << report.psnr << "dB " << report.mpixelsPerSec << " MPix/s");
+    return report;
+}
@@ -1,118 +1,962 @@
 #include "textures.h"
 #include "stb/stb_image.h"
+#include "../include/asset_path.h"
+#include "../include/hash.h"
+#include "../include/jobs.h"
 #include "../include/log.h"
-#include <unordered_map>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <system_error>
 #include <utility>
+#include <vector>
 
-// Internal cache: path -> (texID, refcount)
+namespace fs = std::filesystem;
+
+// Internal tables. Slot 0 is reserved so a zero handle is always invalid.
 namespace {
-    static std::unordered_map<std::string, std::pair<GLuint, int>> s_cache;
-    static std::mutex s_cacheMutex;
-}
+    using TextureManager::TextureInfo;
 
-GLuint TextureManager::Load(const std::string& path) {
+    constexpr uint32_t kSlotBits = 20;
+    constexpr uint32_t kSlotMask = (1u << kSlotBits) - 1;
+    constexpr uint32_t kGenerationMask = (1u << (32 - kSlotBits)) - 1;
+
+    static std::vector<TextureInfo> s_slots(1);       // handle slot -> texture
+    static std::vector<uint32_t> s_freeSlots;         // recycled slots
+
+    // Textures are keyed by Vfs asset id, so "Assets\Textures\crate.jpg" and
+    // "assets/textures/crate.jpg" share one texture
+    static std::vector<TextureHandle> s_handleByPath(1); // asset id -> live handle
+    static std::vector<TextureHandle> s_handleByGL;      // GL texture name -> live handle
+
+    // Encoded image bytes for textures that don't come from a file (AcquireFromMemory),
+    // kept so evicted / streamed textures can be rebuilt. Keyed by path id.
+    using EncodedImage = std::shared_ptr<const std::vector<unsigned char>>;
+    static std::unordered_map<uint32_t, EncodedImage> s_memorySources;
+
+    EncodedImage MemorySource(uint32_t pathId) {
+        auto it = s_memorySources.find(pathId);
+        return (it != s_memorySources.end()) ? it->second : EncodedImage();
+    }
+
+    // Cook settings (see SetCookSettings)
+    static TextureCompress::Format s_cookFormat = TextureCompress::Format::None;
+    static TextureCompress::Quality s_cookQuality = TextureCompress::Quality::Fast;
+
+    TextureHandle MakeHandle(uint32_t slot, uint32_t generation) {
+        return (generation << kSlotBits) | slot;
+    }
+
+    TextureInfo* Resolve(TextureHandle handle) {
+        uint32_t slot = handle & kSlotMask;
+        if (slot == 0 || slot >= s_slots.size()) return nullptr;
+        TextureInfo& info = s_slots[slot];
+        if (info.refCount <= 0 || info.generation != (handle >> kSlotBits)) return nullptr;
+        return &info;
+    }
+
+    uint32_t TrackPath(Vfs::AssetId id) {
+        if (id >= s_handleByPath.size()) s_handleByPath.resize(id + 1, INVALID_TEXTURE);
+        return id;
+    }
+
+    // Budget / residency bookkeeping
+    static uint64_t s_frame = 1;
+    static size_t s_budgetBytes = 0;
+    static size_t s_residentBytes = 0;
+    static uint64_t s_evictions = 0;
+    static uint64_t s_mipDrops = 0;
+    static uint64_t s_reloads = 0;
+    static uint64_t s_streamIns = 0;
+
+    // Never drop mips below this size, tiny textures are not worth the bookkeeping
+    constexpr int kMinDropSize = 64;
+    // Frames a texture must want a coarser mip before its fine levels are released
+    constexpr int kDropDelayFrames = 60;
+    // Finished mip streams uploaded per frame, keeps upload hitches bounded
+    constexpr int kMaxStreamUploadsPerFrame = 2;
+
+    int MipLevels(int w, int h) {
+        int levels = 1;
+        while (w > 1 || h > 1) {
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+            ++levels;
+        }
+        return levels;
+    }
+
+    // Coarsest base level we are willing to drop to
+    int MaxBaseLevel(const TextureInfo& info) {
+        int level = 0;
+        while (level + 1 < MipLevels(info.width, info.height)
+            && std::max(info.width >> (level + 1), info.height >> (level + 1)) >= kMinDropSize) {
+            ++level;
+        }
+        return level;
+    }
+
+    TextureCompress::Format FormatFromGL(GLenum internalFormat) {
+        switch (internalFormat) {
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: return TextureCompress::Format::BC1;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return TextureCompress::Format::BC3;
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:    return TextureCompress::Format::BC7;
+        default:                               return TextureCompress::Format::None;
+        }
+    }
+
+    // GPU bytes for `levels` mips starting at w x h
+    size_t ChainBytes(GLenum internalFormat, int w, int h, int levels) {
+        TextureCompress::Format format = FormatFromGL(internalFormat);
+        size_t total = 0;
+        for (int l = 0; l < levels; ++l) {
+            total += (format == TextureCompress::Format::None)
+                ? static_cast<size_t>(w) * h * 4
+                : TextureCompress::CompressedSize(format, w, h);
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        return total;
+    }
+
+    // Swap the GL texture behind a slot, keeping the GL-name lookup table in sync
+    void SetGLId(uint32_t slot, GLuint tex) {
+        TextureInfo& info = s_slots[slot];
+        if (info.glId != 0 && info.glId < s_handleByGL.size()) s_handleByGL[info.glId] = INVALID_TEXTURE;
+        info.glId = tex;
+        if (tex != 0) {
+            if (tex >= s_handleByGL.size()) s_handleByGL.resize(tex + 1, INVALID_TEXTURE);
+            s_handleByGL[tex] = MakeHandle(slot, info.generation);
+        }
+    }
+
+    // 2x2 box filter down to the next mip level (odd edges reuse the last texel)
+    void DownsampleRGBA(const std::vector<unsigned char>& src, int w, int h,
+        std::vector<unsigned char>& dst, int& outW, int& outH)
     {
-        std::lock_guard<std::mutex> lk(s_cacheMutex);
-        auto it = s_cache.find(path);
-        if (it != s_cache.end()) {
-            // Increment refcount and return existing texture id
-            it->second.second += 1;
-            return it->second.first;
+        outW = (w > 1) ? w / 2 : 1;
+        outH = (h > 1) ? h / 2 : 1;
+        dst.resize(static_cast<size_t>(outW) * outH * 4);
+        for (int y = 0; y < outH; ++y) {
+            int y0 = (y * 2 < h) ? y * 2 : h - 1;
+            int y1 = (y * 2 + 1 < h) ? y * 2 + 1 : h - 1;
+            for (int x = 0; x < outW; ++x) {
+                int x0 = (x * 2 < w) ? x * 2 : w - 1;
+                int x1 = (x * 2 + 1 < w) ? x * 2 + 1 : w - 1;
+                for (int c = 0; c < 4; ++c) {
+                    int sum = src[(static_cast<size_t>(y0) * w + x0) * 4 + c] + src[(static_cast<size_t>(y0) * w + x1) * 4 + c]
+                        + src[(static_cast<size_t>(y1) * w + x0) * 4 + c] + src[(static_cast<size_t>(y1) * w + x1) * 4 + c];
+                    dst[(static_cast<size_t>(y) * outW + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
         }
     }
 
-    stbi_set_flip_vertically_on_load(true);
-    int w = 0, h = 0, n = 0;
-    unsigned char* data = stbi_load(path.c_str(), &w, &h, &n, 4);
-    if (!data) {
-        LOG_WARNING("TextureManager: Failed to load image: " << path.c_str());
-        return 0;
+    // CPU side of a texture load: pixel data for mips firstMip..lastMip, ready for upload.
+    // Touches no GL or manager state so it can run on a Jobs worker.
+    struct MipChain {
+        int width = 0;        // mip 0 size
+        int height = 0;
+        int totalLevels = 0;  // full chain length
+        GLenum internalFormat = GL_RGBA8;
+        int firstMip = 0;
+        std::vector<std::vector<unsigned char>> levels; // levels[i] = mip firstMip + i
+    };
+
+    // ---------------------------------------------------------------- cooked chain cache
+    // Block compression is the slow part of a load, so a compressed chain is written to
+    // disk once and read back by later launches, reloads after an eviction and mip
+    // streams. Keys work like the thumbnail cache: loose files by path, size and write
+    // time, packed and in-memory images by their bytes, plus the format and quality.
+    constexpr char kCacheMagic[8] = { 'S', 'P', 'X', 'T', 'E', 'X', 'C', '\0' };
+    constexpr uint32_t kCacheVersion = 1;
+
+    struct CacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t internalFormat;
+        int32_t width;
+        int32_t height;
+        int32_t levels;      // full chain; a table of uint64 level sizes follows, then the levels
+        uint32_t reserved;
+    };
+    static_assert(sizeof(CacheHeader) == 32, "texture cache header layout changed, bump kCacheVersion");
+
+    static std::string s_cacheDir;   // set before the first load, read by the workers
+
+    // Path, size and write time of a loose file; 0 when the asset isn't one
+    uint64_t LooseFileKey(const std::string& path) {
+        const std::string disk = Vfs::DiskPath(Vfs::Intern(path));
+        if (disk.empty()) return 0;
+        std::error_code ec;
+        const auto size = fs::file_size(disk, ec);
+        if (ec) return 0;
+        const auto time = fs::last_write_time(disk, ec);
+        if (ec) return 0;
+        uint64_t h = Hash::Fnv1a64(disk);
+        h = Hash::Mix64(h ^ static_cast<uint64_t>(size));
+        return Hash::Mix64(h ^ static_cast<uint64_t>(time.time_since_epoch().count()));
     }
 
-    GLuint tex = 0;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
+    uint64_t CookKey(uint64_t sourceKey, TextureCompress::Format format, TextureCompress::Quality quality) {
+        const uint64_t settings = (static_cast<uint64_t>(format) << 8) | static_cast<uint64_t>(quality);
+        return Hash::Mix64(sourceKey ^ Hash::Mix64(settings ^ (static_cast<uint64_t>(kCacheVersion) << 32)));
+    }
+
+    std::string CachePath(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.spxtex", static_cast<unsigned long long>(key));
+        return (fs::path(s_cacheDir) / name).string();
+    }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    // Mips firstMip..lastMip of a cached chain. format is the requested one: Auto takes
+    // whatever the entry holds, anything else must match it.
+    bool ReadCachedChain(uint64_t key, TextureCompress::Format format, int firstMip, int lastMip, MipChain& chain) {
+        std::ifstream in(CachePath(key), std::ios::binary);
+        CacheHeader header;
+        if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.version != kCacheVersion
+            || header.width <= 0 || header.height <= 0 || header.levels != MipLevels(header.width, header.height)) {
+            return false;
+        }
+        const TextureCompress::Format stored = FormatFromGL(header.internalFormat);
+        if (stored == TextureCompress::Format::None) return false;
+        if (format != TextureCompress::Format::Auto && stored != format) return false;
+
+        std::vector<uint64_t> sizes(header.levels);
+        if (!in.read(reinterpret_cast<char*>(sizes.data()), static_cast<std::streamsize>(sizes.size() * sizeof(uint64_t)))) return false;
+        // every level must have the size its dimensions give, which also catches truncated entries early
+        for (int l = 0; l < header.levels; ++l) {
+            if (sizes[l] != TextureCompress::CompressedSize(stored, std::max(1, header.width >> l), std::max(1, header.height >> l))) return false;
+        }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        chain.width = header.width;
+        chain.height = header.height;
+        chain.totalLevels = header.levels;
+        chain.internalFormat = header.internalFormat;
+        chain.firstMip = std::clamp(firstMip, 0, chain.totalLevels - 1);
+        if (lastMip < 0 || lastMip >= chain.totalLevels) lastMip = chain.totalLevels - 1;
+        uint64_t skip = 0;
+        for (int l = 0; l < chain.firstMip; ++l) skip += sizes[l];
+        in.seekg(static_cast<std::streamoff>(skip), std::ios::cur);
+        chain.levels.clear();
+        for (int l = chain.firstMip; l <= lastMip; ++l) {
+            chain.levels.emplace_back(static_cast<size_t>(sizes[l]));
+            if (!in.read(reinterpret_cast<char*>(chain.levels.back().data()), static_cast<std::streamsize>(sizes[l]))) return false;
+        }
+        return !chain.levels.empty();
+    }
 
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Store a full chain (firstMip 0) via a temp file + rename, another editor instance
+    // may be reading the same cache
+    void WriteCachedChain(uint64_t key, const MipChain& chain) {
+        std::error_code ec;
+        fs::create_directories(s_cacheDir, ec);
+        CacheHeader header = {};
+        std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+        header.version = kCacheVersion;
+        header.internalFormat = chain.internalFormat;
+        header.width = chain.width;
+        header.height = chain.height;
+        header.levels = chain.totalLevels;
+        std::vector<uint64_t> sizes;
+        for (const std::vector<unsigned char>& level : chain.levels) sizes.push_back(level.size());
 
-    stbi_image_free(data);
+        const std::string path = CachePath(key);
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            bool ok = out.write(reinterpret_cast<const char*>(&header), sizeof(header))
+                && out.write(reinterpret_cast<const char*>(sizes.data()), static_cast<std::streamsize>(sizes.size() * sizeof(uint64_t)));
+            for (size_t i = 0; ok && i < chain.levels.size(); ++i) {
+                ok = static_cast<bool>(out.write(reinterpret_cast<const char*>(chain.levels[i].data()), static_cast<std::streamsize>(chain.levels[i].size())));
+            }
+            if (!ok) {
+                out.close();
+                fs::remove(tmp, ec);
+                return;
+            }
+        }
+        fs::rename(tmp, path, ec);
+        if (ec) fs::remove(tmp, ec);
+    }
 
+    // lastMip < 0 means "down to 1x1". With `encoded` set the image is decoded from
+    // those bytes instead of the file (path is then only used for messages).
+    bool BuildMipChain(const std::string& path, const EncodedImage& encoded, TextureCompress::Format format,
+        TextureCompress::Quality quality, int firstMip, int lastMip, MipChain& chain)
     {
-        std::lock_guard<std::mutex> lk(s_cacheMutex);
-        s_cache.emplace(path, std::make_pair(tex, 1));
+        // files go through the asset reader so a mounted pack serves them
+        std::vector<unsigned char> fileBytes;
+        bool haveBytes = encoded != nullptr;
+        const bool useCache = !s_cacheDir.empty() && format != TextureCompress::Format::None;
+        uint64_t cacheKey = 0;
+        const int wantFirst = firstMip;
+        const int wantLast = lastMip;
+        if (useCache) {
+            uint64_t source = encoded ? 0 : LooseFileKey(path);
+            if (!source) {
+                if (!haveBytes && !ReadAssetFile(path, fileBytes)) return false;
+                haveBytes = true;
+                const std::vector<unsigned char>& bytes = encoded ? *encoded : fileBytes;
+                source = Hash::Mix64(Hash::Bytes64(bytes.data(), bytes.size()) ^ Hash::Fnv1a64(path));
+            }
+            cacheKey = CookKey(source, format, quality);
+            if (ReadCachedChain(cacheKey, format, firstMip, lastMip, chain)) return true;
+            // streams ask for the format an Auto load resolved to, the entry is under Auto
+            if ((format == TextureCompress::Format::BC1 || format == TextureCompress::Format::BC3)
+                && ReadCachedChain(CookKey(source, TextureCompress::Format::Auto, quality), format, firstMip, lastMip, chain)) {
+                return true;
+            }
+            // a miss cooks the whole chain so the entry serves every later request
+            firstMip = 0;
+            lastMip = -1;
+        }
+        if (!haveBytes && !ReadAssetFile(path, fileBytes)) return false;
+        const std::vector<unsigned char>& bytes = encoded ? *encoded : fileBytes;
+
+        stbi_set_flip_vertically_on_load_thread(1);
+        int w = 0, h = 0, n = 0;
+        unsigned char* data = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &w, &h, &n, 4);
+        if (!data) {
+            LOG_WARNING("TextureManager: Failed to load image: " << path.c_str());
+            return false;
+        }
+
+        format = TextureCompress::ResolveFormat(format, data, w, h);
+        chain.width = w;
+        chain.height = h;
+        chain.totalLevels = MipLevels(w, h);
+        chain.internalFormat = (format == TextureCompress::Format::None) ? GL_RGBA8 : TextureCompress::GLInternalFormat(format);
+        chain.firstMip = std::clamp(firstMip, 0, chain.totalLevels - 1);
+        if (lastMip < 0 || lastMip >= chain.totalLevels) lastMip = chain.totalLevels - 1;
+        chain.levels.clear();
+
+        std::vector<unsigned char> level(data, data + static_cast<size_t>(w) * h * 4);
+        stbi_image_free(data);
+        std::vector<unsigned char> next;
+        int lw = w, lh = h;
+        for (int mip = 0; mip <= lastMip; ++mip) {
+            if (mip >= chain.firstMip) {
+                if (format == TextureCompress::Format::None) {
+                    chain.levels.push_back(level);
+                }
+                else {
+                    chain.levels.emplace_back();
+                    if (!TextureCompress::Encode(level.data(), lw, lh, format, quality, chain.levels.back())) return false;
+                }
+            }
+            if (mip == lastMip) break;
+            DownsampleRGBA(level, lw, lh, next, lw, lh);
+            level.swap(next);
+        }
+        if (useCache) {
+            WriteCachedChain(cacheKey, chain);
+            // hand back only the mips that were asked for
+            const int first = std::clamp(wantFirst, 0, chain.totalLevels - 1);
+            const int last = (wantLast < 0 || wantLast >= chain.totalLevels) ? chain.totalLevels - 1 : std::max(wantLast, first);
+            chain.levels.erase(chain.levels.begin() + (last + 1), chain.levels.end());
+            chain.levels.erase(chain.levels.begin(), chain.levels.begin() + first);
+            chain.firstMip = first;
+        }
+        return !chain.levels.empty();
     }
 
-    LOG_INFO("TextureManager: Loaded texture " + path);
-    return tex;
-}
+    // Upload every level of the chain into the currently bound texture
+    void UploadMips(const MipChain& chain) {
+        bool compressed = chain.internalFormat != GL_RGBA8;
+        for (size_t i = 0; i < chain.levels.size(); ++i) {
+            int mip = chain.firstMip + static_cast<int>(i);
+            int lw = std::max(1, chain.width >> mip);
+            int lh = std::max(1, chain.height >> mip);
+            const std::vector<unsigned char>& px = chain.levels[i];
+            if (compressed) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, mip, chain.internalFormat, lw, lh, 0,
+                    static_cast<GLsizei>(px.size()), px.data());
+            }
+            else {
+                glTexImage2D(GL_TEXTURE_2D, mip, GL_RGBA8, lw, lh, 0, GL_RGBA, GL_UNSIGNED_BYTE, px.data());
+            }
+        }
+    }
 
-bool TextureManager::IsLoaded(const std::string& path) {
-    std::lock_guard<std::mutex> lk(s_cacheMutex);
-    return s_cache.find(path) != s_cache.end();
-}
+    // Create a GL texture from a built chain, filling size/format/bytes. The new GL name is
+    // returned in outTex; the caller installs it with SetGLId.
+    void CreateTextureFromChain(const MipChain& chain, TextureInfo& info, GLuint& outTex) {
+        GLuint tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
 
-bool TextureManager::Unload(const std::string& path) {
-    std::lock_guard<std::mutex> lk(s_cacheMutex);
-    auto it = s_cache.find(path);
-    if (it == s_cache.end()) {
-        return false;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Levels below the base are left undefined; the sampler never looks at them
+        UploadMips(chain);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, chain.firstMip);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, chain.totalLevels - 1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        outTex = tex;
+        info.width = chain.width;
+        info.height = chain.height;
+        info.internalFormat = chain.internalFormat;
+        info.mipBias = chain.firstMip;
+        info.levels = chain.totalLevels - chain.firstMip;
+        info.bytes = ChainBytes(chain.internalFormat, std::max(1, chain.width >> chain.firstMip),
+            std::max(1, chain.height >> chain.firstMip), info.levels);
+        info.resident = true;
     }
 
-    // decrement refcount
-    it->second.second -= 1;
-    if (it->second.second <= 0) {
-        GLuint tex = it->second.first;
-        if (tex != 0) {
-            glDeleteTextures(1, &tex);
+    // Decode the image file and create a GL texture holding mips baseMip..end
+    bool CreateTexture(uint32_t pathId, TextureInfo& info, GLuint& outTex, int baseMip = 0) {
+        MipChain chain;
+        if (!BuildMipChain(Vfs::Name(pathId), MemorySource(pathId), s_cookFormat, s_cookQuality, baseMip, -1, chain)) return false;
+        CreateTextureFromChain(chain, info, outTex);
+        return true;
+    }
+
+    // Release the GPU memory but keep the slot, path and refcount so handles stay valid
+    void EvictTexture(uint32_t slot) {
+        TextureInfo& info = s_slots[slot];
+        if (!info.resident) return;
+        if (info.glId != 0) glDeleteTextures(1, &info.glId);
+        SetGLId(slot, 0);
+        ++info.loadGeneration;
+        s_residentBytes -= info.bytes;
+        info.bytes = 0;
+        info.levels = 0;
+        info.resident = false;
+        ++s_evictions;
+        LOG_INFO("TextureManager: Evicted " + Vfs::Name(info.pathId));
+    }
+
+    // Raise GL_TEXTURE_BASE_LEVEL and free the finer levels below it.
+    // Respecifying a level as 0x0 releases its storage; levels under the base don't affect completeness.
+    // A compressed texture is respecified in its own format so no level changes format.
+    bool RaiseBaseLevel(uint32_t slot, int newBase) {
+        TextureInfo& info = s_slots[slot];
+        newBase = std::min(newBase, MaxBaseLevel(info));
+        if (!info.resident || newBase <= info.mipBias) return false;
+
+        glBindTexture(GL_TEXTURE_2D, info.glId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, newBase);
+        const bool compressed = info.internalFormat != GL_RGBA8;
+        for (int l = info.mipBias; l < newBase; ++l) {
+            if (compressed) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, l, info.internalFormat, 0, 0, 0, 0, nullptr);
+            }
+            else {
+                glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
         }
-        s_cache.erase(it);
-        LOG_INFO("TextureManager: Unloaded texture " + path);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        s_mipDrops += static_cast<uint64_t>(newBase - info.mipBias);
+        info.levels -= newBase - info.mipBias;
+        info.mipBias = newBase;
+        size_t newBytes = ChainBytes(info.internalFormat, std::max(1, info.width >> newBase),
+            std::max(1, info.height >> newBase), info.levels);
+        s_residentBytes = s_residentBytes - info.bytes + newBytes;
+        info.bytes = newBytes;
+        return true;
     }
-    else {
-        LOG_INFO("TextureManager: Decremented refcount for " + path + " -> " + std::to_string(it->second.second));
+
+    // ---------------------------------------------------------------- mip streaming
+    // Finer mips are rebuilt from the source image on a worker and uploaded by Update()
+
+    struct StreamResult {
+        TextureHandle handle = INVALID_TEXTURE;
+        uint32_t loadGeneration = 0; // image the levels were built for; GL names get reused
+        int expectedBase = 0;  // base level when the request was made
+        bool ok = false;
+        MipChain chain;
+    };
+    static std::mutex s_streamMutex; // guards s_streamResults and s_loadResults, the only state workers touch
+    static std::vector<StreamResult> s_streamResults;
+
+    // ---------------------------------------------------------------- background loads
+    // AcquireAsync builds the whole chain on a worker and Update creates the texture
+
+    struct LoadResult {
+        TextureHandle handle = INVALID_TEXTURE;
+        bool reload = false;   // bringing back an evicted texture
+        bool replace = false;  // hot reload: swapped for the texture still drawing
+        bool ok = false;
+        MipChain chain;
+    };
+    static std::vector<LoadResult> s_loadResults;
+    static int s_loadingCount = 0;
+    static int s_loadBatch = 0;
+
+    void StartStreamIn(uint32_t slot, int targetMip) {
+        TextureInfo& info = s_slots[slot];
+        info.streaming = true;
+
+        StreamResult request;
+        request.handle = MakeHandle(slot, info.generation);
+        request.loadGeneration = info.loadGeneration;
+        request.expectedBase = info.mipBias;
+        std::string path = Vfs::Name(info.pathId);
+        EncodedImage encoded = MemorySource(info.pathId);
+        TextureCompress::Format format = FormatFromGL(info.internalFormat);
+        TextureCompress::Quality quality = s_cookQuality;
+
+        Jobs::Submit([request, path, encoded, format, quality, targetMip]() mutable {
+            request.ok = BuildMipChain(path, encoded, format, quality, targetMip, request.expectedBase - 1, request.chain);
+            std::lock_guard<std::mutex> lk(s_streamMutex);
+            s_streamResults.push_back(std::move(request));
+        });
     }
-    return true;
-}
 
-bool TextureManager::Unload(GLuint texID) {
-    std::lock_guard<std::mutex> lk(s_cacheMutex);
-    for (auto it = s_cache.begin(); it != s_cache.end(); ++it) {
-        if (it->second.first == texID) {
-            // found entry
-            it->second.second -= 1;
-            const std::string path = it->first;
-            if (it->second.second <= 0) {
-                if (texID != 0) {
-                    glDeleteTextures(1, &texID);
+    void ApplyStreamResults() {
+        std::vector<StreamResult> ready;
+        {
+            std::lock_guard<std::mutex> lk(s_streamMutex);
+            size_t count = std::min<size_t>(s_streamResults.size(), kMaxStreamUploadsPerFrame);
+            for (size_t i = 0; i < count; ++i) ready.push_back(std::move(s_streamResults[i]));
+            s_streamResults.erase(s_streamResults.begin(), s_streamResults.begin() + count);
+        }
+
+        for (StreamResult& r : ready) {
+            TextureInfo* info = Resolve(r.handle);
+            if (!info) continue;
+            info->streaming = false;
+            // Texture was evicted, reloaded or trimmed while we worked: the levels no longer fit
+            if (!r.ok || info->loadGeneration != r.loadGeneration || !info->resident || info->mipBias != r.expectedBase) continue;
+
+            glBindTexture(GL_TEXTURE_2D, info->glId);
+            UploadMips(r.chain);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, r.chain.firstMip);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            info->levels += info->mipBias - r.chain.firstMip;
+            info->mipBias = r.chain.firstMip;
+            size_t newBytes = ChainBytes(info->internalFormat, std::max(1, info->width >> info->mipBias),
+                std::max(1, info->height >> info->mipBias), info->levels);
+            s_residentBytes = s_residentBytes - info->bytes + newBytes;
+            info->bytes = newBytes;
+            ++s_streamIns;
+        }
+    }
+
+    // Build the chain from baseMip down on a worker; ApplyLoadResults creates the texture.
+    // With replace (hot reload) the current texture stays and keeps drawing until then.
+    void StartLoad(uint32_t slot, int baseMip = 0, bool replace = false) {
+        TextureInfo& info = s_slots[slot];
+        if (!replace) {
+            info.loading = true;
+            ++s_loadingCount;
+            ++s_loadBatch;
+        }
+
+        LoadResult request;
+        request.handle = MakeHandle(slot, info.generation);
+        request.reload = info.width > 0;
+        request.replace = replace;
+        std::string path = Vfs::Name(info.pathId);
+        EncodedImage encoded = MemorySource(info.pathId);
+        TextureCompress::Format format = s_cookFormat;
+        TextureCompress::Quality quality = s_cookQuality;
+
+        Jobs::Submit([request, path, encoded, format, quality, baseMip]() mutable {
+            request.ok = BuildMipChain(path, encoded, format, quality, baseMip, -1, request.chain);
+            std::lock_guard<std::mutex> lk(s_streamMutex);
+            s_loadResults.push_back(std::move(request));
+        });
+    }
+
+    // Swap a hot reloaded chain in for the current texture
+    void ApplyReload(LoadResult& r) {
+        TextureInfo* info = Resolve(r.handle);
+        // released, or evicted meanwhile: the next draw reads the new file anyway
+        if (!info || info->loading || (!info->resident && !info->loadFailed)) return;
+        const std::string& name = Vfs::Name(info->pathId);
+        if (!r.ok) {
+            LOG_WARNING("TextureManager: reload of " + name + " failed, keeping the old texture");
+            return;
+        }
+        const uint32_t slot = r.handle & kSlotMask;
+        const size_t oldBytes = info->resident ? info->bytes : 0;
+        GLuint tex = 0;
+        CreateTextureFromChain(r.chain, *info, tex);
+        if (info->glId != 0) glDeleteTextures(1, &info->glId);
+        SetGLId(slot, tex);
+        ++info->loadGeneration;
+        info->loadFailed = false;
+        s_residentBytes = s_residentBytes - oldBytes + info->bytes;
+        ++s_reloads;
+        LOG_INFO("TextureManager: Reloaded texture " + name);
+    }
+
+    void ApplyLoadResults() {
+        std::vector<LoadResult> ready;
+        {
+            std::lock_guard<std::mutex> lk(s_streamMutex);
+            size_t count = std::min<size_t>(s_loadResults.size(), kMaxStreamUploadsPerFrame);
+            for (size_t i = 0; i < count; ++i) ready.push_back(std::move(s_loadResults[i]));
+            s_loadResults.erase(s_loadResults.begin(), s_loadResults.begin() + count);
+        }
+
+        for (LoadResult& r : ready) {
+            if (r.replace) {
+                ApplyReload(r);
+                continue;
+            }
+            // released while it loaded: FreeSlot already took it off the count
+            TextureInfo* info = Resolve(r.handle);
+            if (!info || !info->loading) continue;
+            info->loading = false;
+            --s_loadingCount;
+            if (!r.ok) {
+                info->loadFailed = true;
+                LOG_WARNING("TextureManager: background load of " + Vfs::Name(info->pathId) + " failed");
+                continue;
+            }
+            GLuint tex = 0;
+            CreateTextureFromChain(r.chain, *info, tex);
+            SetGLId(r.handle & kSlotMask, tex);
+            s_residentBytes += info->bytes;
+            if (r.reload) ++s_reloads;
+            LOG_INFO("TextureManager: " + std::string(r.reload ? "Reloaded" : "Loaded") + " texture " + Vfs::Name(info->pathId) + " (background)");
+        }
+        if (s_loadingCount == 0) s_loadBatch = 0;
+    }
+
+    // Move each texture drawn this frame towards the mip its draws asked for
+    void UpdateScreenSizeMips() {
+        for (uint32_t slot = 1; slot < s_slots.size(); ++slot) {
+            TextureInfo& info = s_slots[slot];
+            if (info.refCount <= 0 || !info.resident || info.requestFrame != s_frame) continue;
+
+            int target = std::clamp(info.requestedMip, 0, MaxBaseLevel(info));
+            if (target < info.mipBias) {
+                info.coarseFrames = 0;
+                size_t extra = ChainBytes(info.internalFormat, std::max(1, info.width >> target),
+                    std::max(1, info.height >> target), info.mipBias - target);
+                bool fits = (s_budgetBytes == 0) || (s_residentBytes + extra <= s_budgetBytes);
+                if (!info.streaming && fits) StartStreamIn(slot, target);
+            }
+            else if (target > info.mipBias) {
+                // hysteresis so a camera hovering around a mip boundary doesn't thrash
+                if (++info.coarseFrames >= kDropDelayFrames && !info.streaming) {
+                    RaiseBaseLevel(slot, target);
+                    info.coarseFrames = 0;
                 }
-                s_cache.erase(it);
-                LOG_INFO("TextureManager: Unloaded texture (by ID) " + path);
             }
             else {
-                LOG_INFO("TextureManager: Decremented refcount for (by ID) " + path + " -> " + std::to_string(it->second.second));
+                info.coarseFrames = 0;
             }
-            return true;
         }
     }
-    return false;
+
+    // While over budget the least recently used textures first lose their top mip, then get evicted
+    void EnforceBudget() {
+        if (s_budgetBytes == 0 || s_residentBytes <= s_budgetBytes) return;
+
+        // Least recently used first; anything drawn this frame is off limits
+        std::vector<uint32_t> lru;
+        for (uint32_t slot = 1; slot < s_slots.size(); ++slot) {
+            const TextureInfo& info = s_slots[slot];
+            if (info.refCount > 0 && info.resident && info.lastUsedFrame < s_frame) lru.push_back(slot);
+        }
+        std::sort(lru.begin(), lru.end(), [](uint32_t a, uint32_t b) {
+            return s_slots[a].lastUsedFrame < s_slots[b].lastUsedFrame;
+        });
+
+        // Pass 1: shed the top mip (75% of a texture's memory), cheapest to undo
+        for (uint32_t slot : lru) {
+            if (s_residentBytes <= s_budgetBytes) break;
+            RaiseBaseLevel(slot, s_slots[slot].mipBias + 1);
+        }
+        // Pass 2: evict whole textures
+        for (uint32_t slot : lru) {
+            if (s_residentBytes <= s_budgetBytes) break;
+            EvictTexture(slot);
+        }
+    }
+
+    // Delete the GL texture and recycle the slot; the generation bump invalidates old handles
+    void FreeSlot(uint32_t slot) {
+        TextureInfo& info = s_slots[slot];
+        if (info.glId != 0) {
+            glDeleteTextures(1, &info.glId);
+            SetGLId(slot, 0);
+        }
+        if (info.resident) s_residentBytes -= info.bytes;
+        if (info.loading) --s_loadingCount; // its result is dropped when it arrives
+        s_handleByPath[info.pathId] = INVALID_TEXTURE;
+        s_memorySources.erase(info.pathId);
+        LOG_INFO("TextureManager: Unloaded texture " + Vfs::Name(info.pathId));
+
+        uint32_t generation = (info.generation + 1) & kGenerationMask;
+        info = TextureInfo();
+        info.generation = generation;
+        s_freeSlots.push_back(slot);
+    }
+}
+
+void TextureManager::SetCacheDirectory(const std::string& directory) {
+    s_cacheDir = directory;
+}
+
+void TextureManager::SetCookSettings(TextureCompress::Format format, TextureCompress::Quality quality) {
+    s_cookFormat = format;
+    s_cookQuality = quality;
+    LOG_INFO("TextureManager: cook format " << TextureCompress::FormatName(format)
+        << (quality == TextureCompress::Quality::High ? " (high quality)" : " (fast)"));
+}
+
+static bool AllocSlot(uint32_t& slot) {
+    if (!s_freeSlots.empty()) {
+        slot = s_freeSlots.back();
+        s_freeSlots.pop_back();
+        return true;
+    }
+    if (s_slots.size() > kSlotMask) {
+        LOG_ERROR("TextureManager: out of texture slots");
+        return false;
+    }
+    slot = static_cast<uint32_t>(s_slots.size());
+    s_slots.emplace_back();
+    return true;
+}
+
+// Shared by Acquire and AcquireFromMemory
+static TextureHandle AcquireTexture(Vfs::AssetId asset, const unsigned char* encoded, size_t encodedSize) {
+    if (asset == Vfs::kInvalidAsset) return INVALID_TEXTURE;
+
+    uint32_t pathId = TrackPath(asset);
+    TextureHandle existing = s_handleByPath[pathId];
+    if (TextureInfo* info = Resolve(existing)) {
+        // Increment refcount and return existing handle
+        info->refCount += 1;
+        return existing;
+    }
+    if (encoded) {
+        s_memorySources[pathId] = std::make_shared<const std::vector<unsigned char>>(encoded, encoded + encodedSize);
+    }
+
+    uint32_t slot;
+    if (!AllocSlot(slot)) return INVALID_TEXTURE;
+
+    TextureInfo& info = s_slots[slot];
+    GLuint tex = 0;
+    if (!CreateTexture(pathId, info, tex)) {
+        uint32_t generation = info.generation;
+        info = TextureInfo();
+        info.generation = generation;
+        s_freeSlots.push_back(slot);
+        s_memorySources.erase(pathId);
+        return INVALID_TEXTURE;
+    }
+    info.refCount = 1;
+    info.pathId = pathId;
+    info.lastUsedFrame = s_frame;
+    SetGLId(slot, tex);
+    s_residentBytes += info.bytes;
+
+    TextureHandle handle = MakeHandle(slot, info.generation);
+    s_handleByPath[pathId] = handle;
+
+    LOG_INFO("TextureManager: Loaded texture " + Vfs::Name(asset));
+    return handle;
+}
+
+TextureHandle TextureManager::Acquire(const std::string& path) {
+    return AcquireTexture(Vfs::Intern(path), nullptr, 0);
+}
+
+TextureHandle TextureManager::Acquire(Vfs::AssetId asset) {
+    return AcquireTexture(asset, nullptr, 0);
+}
+
+TextureHandle TextureManager::AcquireFromMemory(const std::string& name, const unsigned char* data, size_t size) {
+    if (!data || size == 0) return INVALID_TEXTURE;
+    return AcquireTexture(Vfs::Intern(name), data, size);
+}
+
+TextureHandle TextureManager::AcquireAsync(const std::string& path) {
+    Vfs::AssetId asset = Vfs::Intern(path);
+    if (asset == Vfs::kInvalidAsset) return INVALID_TEXTURE;
+
+    uint32_t pathId = TrackPath(asset);
+    TextureHandle existing = s_handleByPath[pathId];
+    if (TextureInfo* info = Resolve(existing)) {
+        info->refCount += 1;
+        return existing;
+    }
+
+    uint32_t slot;
+    if (!AllocSlot(slot)) return INVALID_TEXTURE;
+    TextureInfo& info = s_slots[slot];
+    info.refCount = 1;
+    info.pathId = pathId;
+    info.lastUsedFrame = s_frame;
+    TextureHandle handle = MakeHandle(slot, info.generation);
+    s_handleByPath[pathId] = handle;
+    StartLoad(slot);
+    return handle;
+}
+
+bool TextureManager::IsLoading(TextureHandle handle) {
+    const TextureInfo* info = Resolve(handle);
+    return info && info->loading;
+}
+
+void TextureManager::AddRef(TextureHandle handle) {
+    if (TextureInfo* info = Resolve(handle)) info->refCount += 1;
+}
+
+bool TextureManager::Release(TextureHandle handle) {
+    TextureInfo* info = Resolve(handle);
+    if (!info) return false;
+
+    // decrement refcount
+    info->refCount -= 1;
+    if (info->refCount <= 0) {
+        FreeSlot(handle & kSlotMask);
+    }
+    return true;
+}
+
+GLuint TextureManager::GetGLId(TextureHandle handle) {
+    const TextureInfo* info = Resolve(handle);
+    return info ? info->glId : 0;
+}
+
+const TextureManager::TextureInfo* TextureManager::GetInfo(TextureHandle handle) {
+    return Resolve(handle);
+}
+
+const std::string& TextureManager::GetPath(TextureHandle handle) {
+    const TextureInfo* info = Resolve(handle);
+    return Vfs::Name(info ? info->pathId : Vfs::kInvalidAsset);
+}
+
+TextureHandle TextureManager::Find(const std::string& path) {
+    Vfs::AssetId id = Vfs::Find(path);
+    if (id == Vfs::kInvalidAsset || id >= s_handleByPath.size()) return INVALID_TEXTURE;
+    return Resolve(s_handleByPath[id]) ? s_handleByPath[id] : INVALID_TEXTURE;
+}
+
+bool TextureManager::Reload(Vfs::AssetId asset) {
+    if (asset >= s_handleByPath.size() || MemorySource(asset)) return false;
+    TextureHandle handle = s_handleByPath[asset];
+    TextureInfo* info = Resolve(handle);
+    // evicted textures read the new file when they are next drawn; a failed load gets another try
+    if (!info || info->loading || (!info->resident && !info->loadFailed)) return false;
+    // decode and encode on a worker, a big image would stall the editor for a while
+    StartLoad(handle & kSlotMask, info->resident ? info->mipBias : 0, true);
+    return true;
+}
+
+GLuint TextureManager::Touch(TextureHandle handle) {
+    TextureInfo* info = Resolve(handle);
+    if (!info) return 0;
+    info->lastUsedFrame = s_frame;
+    if (info->loading || info->loadFailed) return 0;
+    if (!info->resident) {
+        // rebuild on a worker at the mip the draws want this frame if we already know it;
+        // the draw goes without the texture until Update uploads it
+        int baseMip = (info->requestFrame == s_frame) ? std::min(info->requestedMip, MaxBaseLevel(*info)) : 0;
+        StartLoad(handle & kSlotMask, baseMip);
+        return 0;
+    }
+    return info->glId;
+}
+
+GLuint TextureManager::Bind(TextureHandle handle, GLuint unit) {
+    GLuint tex = Touch(handle);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    return tex;
+}
+
+void TextureManager::RequestMip(TextureHandle handle, int mip) {
+    TextureInfo* info = Resolve(handle);
+    if (!info) return;
+    mip = std::max(mip, 0);
+    if (info->requestFrame != s_frame) {
+        info->requestFrame = s_frame;
+        info->requestedMip = mip;
+    }
+    else {
+        info->requestedMip = std::min(info->requestedMip, mip); // finest request wins
+    }
+}
+
+void TextureManager::RequestScreenSize(TextureHandle handle, float screenPixels) {
+    const TextureInfo* info = Resolve(handle);
+    if (!info || info->width <= 0) return; // size unknown until the load finishes
+    // one texel per pixel: mip = log2(texture size / on-screen size)
+    float texels = static_cast<float>(std::max(info->width, info->height));
+    int mip = (screenPixels > 0.0f) ? static_cast<int>(std::floor(std::log2(texels / screenPixels))) : INT_MAX / 2;
+    RequestMip(handle, mip);
+}
+
+void TextureManager::BeginFrame() {
+    ++s_frame;
+}
+
+void TextureManager::Update() {
+    ApplyLoadResults();
+    ApplyStreamResults();
+    UpdateScreenSizeMips();
+    EnforceBudget();
+}
+
+void TextureManager::SetBudget(size_t bytes) {
+    s_budgetBytes = bytes;
+}
+
+TextureManager::TextureStats TextureManager::GetStats() {
+    TextureStats stats;
+    stats.residentBytes = s_residentBytes;
+    stats.budgetBytes = s_budgetBytes;
+    for (uint32_t slot = 1; slot < s_slots.size(); ++slot) {
+        const TextureInfo& info = s_slots[slot];
+        if (info.refCount <= 0) continue;
+        ++stats.textureCount;
+        if (info.resident) ++stats.residentCount;
+        if (info.resident && info.mipBias > 0) ++stats.reducedCount;
+    }
+    stats.evictions = s_evictions;
+    stats.mipDrops = s_mipDrops;
+    stats.reloads = s_reloads;
+    stats.streamIns = s_streamIns;
+    stats.loadingCount = s_loadingCount;
+    stats.loadBatch = s_loadBatch;
+    return stats;
+}
+
+GLuint TextureManager::Load(const std::string& path) {
+    return GetGLId(Acquire(path));
+}
+
+bool TextureManager::IsLoaded(const std::string& path) {
+    return Find(path) != INVALID_TEXTURE;
+}
+
+bool TextureManager::Unload(const std::string& path) {
+    return Release(Find(path));
+}
+
+bool TextureManager::Unload(GLuint texID) {
+    if (texID == 0 || texID >= s_handleByGL.size()) return false;
+    return Release(s_handleByGL[texID]);
 }
 
 void TextureManager::UnloadAll() {
-    std::lock_guard<std::mutex> lk(s_cacheMutex);
-    for (auto& entry : s_cache) {
-        GLuint tex = entry.second.first;
-        if (tex != 0) {
-            glDeleteTextures(1, &tex);
-        }
+    for (uint32_t slot = 1; slot < s_slots.size(); ++slot) {
+        if (s_slots[slot].refCount > 0) FreeSlot(slot);
     }
-    s_cache.clear();
     LOG_INFO("TextureManager: Unloaded all textures");
 }
 
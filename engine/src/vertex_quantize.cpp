@@ -0,0 +1,268 @@
+#include "../include/vertex_quantize.h"
+#include "../include/gpu_mesh.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    struct Packed16Vertex {
+        int16_t pos[4];      // xyz + pad, keeps the normal 4 byte aligned
+        int16_t normal[2];
+        uint16_t uv[2];
+    };
+    static_assert(sizeof(Packed16Vertex) == 16, "Packed16 vertex must be 16 bytes");
+
+    struct Packed12Vertex {
+        int16_t pos[3];
+        int8_t normal[2];
+        uint16_t uv[2];
+    };
+    static_assert(sizeof(Packed12Vertex) == 12, "Packed12 vertex must be 12 bytes");
+
+    constexpr size_t kParallelBatch = 16384;
+
+    float SignNotZero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+    // GL snorm conversion: c / max, clamped to -1
+    template <typename T>
+    T ToSnorm(float v) {
+        constexpr float kMax = static_cast<float>((1 << (8 * sizeof(T) - 1)) - 1);
+        return static_cast<T>(std::lround(std::clamp(v, -1.0f, 1.0f) * kMax));
+    }
+
+    template <typename T>
+    float FromSnorm(T v) {
+        constexpr float kMax = static_cast<float>((1 << (8 * sizeof(T) - 1)) - 1);
+        return std::max(static_cast<float>(v) / kMax, -1.0f);
+    }
+
+    // Octahedral encode that tries the four roundings around the exact point and keeps
+    // the one that decodes closest to the input (plain rounding loses ~2x precision)
+    template <typename T>
+    void OctQuantize(const glm::vec3& n, T out[2]) {
+        constexpr float kMax = static_cast<float>((1 << (8 * sizeof(T) - 1)) - 1);
+        glm::vec2 p = VertexQuantize::OctEncode(n) * kMax;
+        float best = -2.0f;
+        for (int i = 0; i < 4; ++i) {
+            float x = std::clamp((i & 1) ? std::ceil(p.x) : std::floor(p.x), -kMax, kMax);
+            float y = std::clamp((i & 2) ? std::ceil(p.y) : std::floor(p.y), -kMax, kMax);
+            float d = glm::dot(n, VertexQuantize::OctDecode(glm::vec2(x, y) / kMax));
+            if (d > best) {
+                best = d;
+                out[0] = static_cast<T>(x);
+                out[1] = static_cast<T>(y);
+            }
+        }
+    }
+
+    glm::vec3 SafeNormal(const float* v) {
+        glm::vec3 n(v[3], v[4], v[5]);
+        float len = glm::length(n);
+        return len > 1e-20f ? n / len : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    glm::vec3 ToUnit(const float* v, const VertexQuantize::DecodeParams& p) {
+        return (glm::vec3(v[0], v[1], v[2]) - p.center) / p.extent;
+    }
+
+    void RunParallel(size_t count, const std::function<void(size_t, size_t)>& fn) {
+        if (count > kParallelBatch) Jobs::ParallelFor(count, kParallelBatch, fn);
+        else fn(0, count);
+    }
+}
+
+uint16_t VertexQuantize::FloatToHalf(float value) {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+    const uint32_t absx = x & 0x7FFFFFFF;
+    if (absx > 0x7F800000) return sign | 0x7E00;           // nan
+    if (absx >= 0x477FF000) return sign | 0x7C00;          // >= 65520 rounds to inf
+    if (absx < 0x38800000) {                               // half subnormal or zero
+        float a;
+        std::memcpy(&a, &absx, sizeof(a));
+        return sign | static_cast<uint16_t>(std::lrint(a * 16777216.0f));
+    }
+    // rebias the exponent (127 -> 15) and round the mantissa to nearest even
+    uint32_t h = (absx >> 13) - (112u << 10);
+    uint32_t rest = absx & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1))) ++h;
+    return sign | static_cast<uint16_t>(h);
+}
+
+float VertexQuantize::HalfToFloat(uint16_t value) {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+    if (exponent == 0) {
+        float f = static_cast<float>(mantissa) / 16777216.0f;
+        return sign ? -f : f;
+    }
+    uint32_t bits = (exponent == 31) ? (sign | 0x7F800000 | (mantissa << 13))
+        : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+glm::vec2 VertexQuantize::OctEncode(const glm::vec3& normal) {
+    float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 < 1e-20f) return glm::vec2(0.0f);
+    glm::vec2 p(normal.x / l1, normal.y / l1);
+    if (normal.z < 0.0f) {
+        p = glm::vec2((1.0f - std::abs(p.y)) * SignNotZero(p.x), (1.0f - std::abs(p.x)) * SignNotZero(p.y));
+    }
+    return p;
+}
+
+glm::vec3 VertexQuantize::OctDecode(const glm::vec2& encoded) {
+    // same code as OctDecode in default.vert
+    glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+VertexQuantize::DecodeParams VertexQuantize::BoundsParams(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    DecodeParams p;
+    p.center = (boundsMin + boundsMax) * 0.5f;
+    // flat axes get a tiny extent so the encode never divides by zero
+    p.extent = glm::max((boundsMax - boundsMin) * 0.5f, glm::vec3(1e-20f));
+    return p;
+}
+
+bool VertexQuantize::IsPacked(VertexFormat format) {
+    return format == VertexFormat::Packed16 || format == VertexFormat::Packed12;
+}
+
+const char* VertexQuantize::FormatName(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Float8: return "Float8";
+    case VertexFormat::Packed16: return "Packed16";
+    case VertexFormat::Packed12: return "Packed12";
+    default: return "Unknown";
+    }
+}
+
+bool VertexQuantize::Encode(VertexFormat format, const float* vertices, size_t vertexCount,
+    const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<uint8_t>& out)
+{
+    out.assign(vertexCount * GpuMesh::VertexStride(format), 0);
+    if (vertexCount == 0) return true;
+    const DecodeParams params = BoundsParams(boundsMin, boundsMax);
+
+    switch (format) {
+    case VertexFormat::Float8:
+        std::memcpy(out.data(), vertices, out.size());
+        return true;
+    case VertexFormat::Packed16: {
+        Packed16Vertex* dst = reinterpret_cast<Packed16Vertex*>(out.data());
+        RunParallel(vertexCount, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const float* v = vertices + i * MESH_VERTEX_FLOATS;
+                glm::vec3 u = ToUnit(v, params);
+                for (int c = 0; c < 3; ++c) dst[i].pos[c] = ToSnorm<int16_t>(u[c]);
+                OctQuantize(SafeNormal(v), dst[i].normal);
+                dst[i].uv[0] = FloatToHalf(v[6]);
+                dst[i].uv[1] = FloatToHalf(v[7]);
+            }
+        });
+        return true;
+    }
+    case VertexFormat::Packed12: {
+        Packed12Vertex* dst = reinterpret_cast<Packed12Vertex*>(out.data());
+        RunParallel(vertexCount, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const float* v = vertices + i * MESH_VERTEX_FLOATS;
+                glm::vec3 u = ToUnit(v, params);
+                for (int c = 0; c < 3; ++c) dst[i].pos[c] = ToSnorm<int16_t>(u[c]);
+                OctQuantize(SafeNormal(v), dst[i].normal);
+                dst[i].uv[0] = FloatToHalf(v[6]);
+                dst[i].uv[1] = FloatToHalf(v[7]);
+            }
+        });
+        return true;
+    }
+    default:
+        LOG_ERROR("VertexQuantize: unknown vertex format " << static_cast<uint32_t>(format));
+        out.clear();
+        return false;
+    }
+}
+
+bool VertexQuantize::Decode(VertexFormat format, const void* vertices, size_t vertexCount,
+    const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<float>& out)
+{
+    out.resize(vertexCount * MESH_VERTEX_FLOATS);
+    const DecodeParams params = BoundsParams(boundsMin, boundsMax);
+    auto write = [&](size_t i, const glm::vec3& unitPos, const glm::vec2& oct, uint16_t u, uint16_t v) {
+        float* dst = out.data() + i * MESH_VERTEX_FLOATS;
+        glm::vec3 p = params.center + unitPos * params.extent;
+        glm::vec3 n = OctDecode(oct);
+        dst[0] = p.x; dst[1] = p.y; dst[2] = p.z;
+        dst[3] = n.x; dst[4] = n.y; dst[5] = n.z;
+        dst[6] = HalfToFloat(u);
+        dst[7] = HalfToFloat(v);
+    };
+
+    switch (format) {
+    case VertexFormat::Float8:
+        std::memcpy(out.data(), vertices, out.size() * sizeof(float));
+        return true;
+    case VertexFormat::Packed16: {
+        const Packed16Vertex* src = static_cast<const Packed16Vertex*>(vertices);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            const Packed16Vertex& s = src[i];
+            write(i, glm::vec3(FromSnorm(s.pos[0]), FromSnorm(s.pos[1]), FromSnorm(s.pos[2])),
+                glm::vec2(FromSnorm(s.normal[0]), FromSnorm(s.normal[1])), s.uv[0], s.uv[1]);
+        }
+        return true;
+    }
+    case VertexFormat::Packed12: {
+        const Packed12Vertex* src = static_cast<const Packed12Vertex*>(vertices);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            const Packed12Vertex& s = src[i];
+            write(i, glm::vec3(FromSnorm(s.pos[0]), FromSnorm(s.pos[1]), FromSnorm(s.pos[2])),
+                glm::vec2(FromSnorm(s.normal[0]), FromSnorm(s.normal[1])), s.uv[0], s.uv[1]);
+        }
+        return true;
+    }
+    default:
+        LOG_ERROR("VertexQuantize: unknown vertex format " << static_cast<uint32_t>(format));
+        out.clear();
+        return false;
+    }
+}
+
+VertexQuantize::ErrorReport VertexQuantize::Measure(VertexFormat format, const MeshData& mesh, const char* name) {
+    ErrorReport report;
+    const size_t count = mesh.VertexCount();
+    report.floatBytes = count * GpuMesh::VertexStride(VertexFormat::Float8);
+    report.packedBytes = count * GpuMesh::VertexStride(format);
+
+    std::vector<uint8_t> packed;
+    std::vector<float> decoded;
+    if (!Encode(format, mesh.vertices.data(), count, mesh.boundsMin, mesh.boundsMax, packed)
+        || !Decode(format, packed.data(), count, mesh.boundsMin, mesh.boundsMax, decoded)) return report;
+
+    float minDot = 1.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const float* a = mesh.vertices.data() + i * MESH_VERTEX_FLOATS;
+        const float* b = decoded.data() + i * MESH_VERTEX_FLOATS;
+        report.maxPositionError = std::max(report.maxPositionError,
+            glm::length(glm::vec3(a[0], a[1], a[2]) - glm::vec3(b[0], b[1], b[2])));
+        minDot = std::min(minDot, glm::dot(SafeNormal(a), glm::vec3(b[3], b[4], b[5])));
+        report.maxUvError = std::max({ report.maxUvError, std::abs(a[6] - b[6]), std::abs(a[7] - b[7]) });
+    }
+    report.maxNormalDegrees = glm::degrees(std::acos(std::clamp(minDot, -1.0f, 1.0f)));
+
+    LOG_INFO("VertexQuantize: " << (name ? name : "mesh") << " " << FormatName(format) << ": "
+        << report.floatBytes / 1024 << " KB -> " << report.packedBytes / 1024 << " KB ("
+        << (report.packedBytes ? static_cast<double>(report.floatBytes) / report.packedBytes : 0.0)
+        << "x smaller), max error pos " << report.maxPositionError << ", normal "
+        << report.maxNormalDegrees << " deg, uv " << report.maxUvError);
+    return report;
+}
@@ -0,0 +1,410 @@
+#include "../include/vfs.h"
+#include "../include/log.h"
+#include "../include/mapped_file.h"
+#include "../include/pak_file.h"
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+    using MemoryFile = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Asset {
+        std::string name;            // first spelling, as given
+        std::string normalized;      // PakFile::NormalizeName(name)
+        uint64_t hash = 0;           // PakFile::HashName(name)
+
+        // Cached location, valid while generation == s_generation
+        uint64_t generation = 0;
+        Vfs::Location location;
+        std::shared_ptr<const PakArchive> pack;
+        const PakFile::Entry* entry = nullptr;   // inside pack's mapping
+        MemoryFile memory;
+        std::string diskPath;
+    };
+
+    struct Mount {
+        Vfs::MountId id = Vfs::kInvalidMount;
+        Vfs::MountKind kind = Vfs::MountKind::Directory;
+        std::string point;           // normalized, "" or ending in '/'
+        fs::path root;               // Directory
+        std::shared_ptr<PakArchive> pack; // Pack, shared with the reads and views still using it
+        std::unordered_map<Vfs::AssetId, MemoryFile> files; // Memory, keyed by the full virtual path
+    };
+
+    std::mutex s_mutex;
+    std::deque<Asset> s_assets;                  // AssetId - 1, never shrinks so names stay put
+    std::vector<Vfs::AssetId> s_table;           // open addressing on Asset::hash, 0 = empty
+    std::vector<std::unique_ptr<Mount>> s_mounts; // mount order, searched newest first
+    Vfs::MountId s_nextMount = 0;
+    uint64_t s_generation = 1;                   // bumped whenever a cached location may be stale
+    bool s_defaultMounted = false;
+    uint64_t s_resolves = 0;
+    uint64_t s_cacheHits = 0;
+    const std::string s_noName;
+
+    // Try several strategies in order:
+    // 1) Look upward from this source file's directory for a directory that contains "assets"
+    // 2) Look upward from the working directory for a directory that contains "assets"
+    // 3) Fall back to the working directory
+    fs::path FindAssetsRoot()
+    {
+        std::error_code ec;
+        fs::path cur = fs::path(__FILE__).parent_path();
+        while (true) {
+            if (fs::exists(cur / "assets", ec)) return cur;
+            if (!cur.has_parent_path() || cur.parent_path() == cur) break;
+            cur = cur.parent_path();
+        }
+
+        cur = fs::current_path(ec);
+        while (!ec) {
+            if (fs::exists(cur / "assets", ec)) return cur;
+            if (!cur.has_parent_path() || cur.parent_path() == cur) break;
+            cur = cur.parent_path();
+        }
+        return fs::current_path(ec);
+    }
+
+    std::string NormalizeMountPoint(std::string_view mountPoint) {
+        std::string point = PakFile::NormalizeName(mountPoint);
+        if (!point.empty() && point.back() != '/') point.push_back('/');
+        return point;
+    }
+
+    bool SameName(std::string_view path, const std::string& normalized) {
+        const size_t start = PakFile::NameStart(path);
+        if (path.size() - start != normalized.size()) return false;
+        for (size_t i = 0; i < normalized.size(); ++i) {
+            if (PakFile::NormalizeChar(path[start + i]) != normalized[i]) return false;
+        }
+        return true;
+    }
+
+    Vfs::AssetId FindLocked(std::string_view path, uint64_t hash) {
+        if (s_table.empty()) return Vfs::kInvalidAsset;
+        const size_t mask = s_table.size() - 1;
+        for (size_t i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask) {
+            Vfs::AssetId id = s_table[i];
+            if (id == Vfs::kInvalidAsset) return Vfs::kInvalidAsset;
+            const Asset& asset = s_assets[id - 1];
+            if (asset.hash == hash && SameName(path, asset.normalized)) return id;
+        }
+    }
+
+    void InsertLocked(Vfs::AssetId id, uint64_t hash) {
+        const size_t mask = s_table.size() - 1;
+        size_t i = static_cast<size_t>(hash) & mask;
+        while (s_table[i] != Vfs::kInvalidAsset) i = (i + 1) & mask;
+        s_table[i] = id;
+    }
+
+    Vfs::AssetId InternLocked(std::string_view path) {
+        const uint64_t hash = PakFile::HashName(path);
+        if (Vfs::AssetId id = FindLocked(path, hash)) return id;
+
+        // keep the table at most half full
+        if ((s_assets.size() + 1) * 2 > s_table.size()) {
+            s_table.assign(s_table.empty() ? 1024 : s_table.size() * 2, Vfs::kInvalidAsset);
+            for (size_t i = 0; i < s_assets.size(); ++i) InsertLocked(static_cast<Vfs::AssetId>(i + 1), s_assets[i].hash);
+        }
+        Asset& asset = s_assets.emplace_back();
+        asset.name.assign(path);
+        asset.normalized = PakFile::NormalizeName(path);
+        asset.hash = hash;
+        Vfs::AssetId id = static_cast<Vfs::AssetId>(s_assets.size());
+        InsertLocked(id, hash);
+        return id;
+    }
+
+    Mount& AddMountLocked(Vfs::MountKind kind, std::string_view mountPoint) {
+        auto mount = std::make_unique<Mount>();
+        mount->id = s_nextMount++;
+        mount->kind = kind;
+        mount->point = NormalizeMountPoint(mountPoint);
+        s_mounts.push_back(std::move(mount));
+        ++s_generation;
+        return *s_mounts.back();
+    }
+
+    Mount* FindMountLocked(Vfs::MountId id) {
+        for (auto& mount : s_mounts) {
+            if (mount->id == id) return mount.get();
+        }
+        return nullptr;
+    }
+
+    // Let the cached locations go of a mount's pack and buffers (all mounts for kInvalidMount),
+    // so they are freed as soon as the last read or view is done with them
+    void ForgetMountLocked(Vfs::MountId id) {
+        for (Asset& asset : s_assets) {
+            if (id != Vfs::kInvalidMount && asset.location.mount != id) continue;
+            asset.pack.reset();
+            asset.entry = nullptr;
+            asset.memory.reset();
+        }
+    }
+
+    void EnsureDefaultMountLocked() {
+        if (s_defaultMounted || !s_mounts.empty()) return;
+        s_defaultMounted = true;
+        Mount& mount = AddMountLocked(Vfs::MountKind::Directory, {});
+        mount.root = FindAssetsRoot();
+        LOG_INFO("Vfs: mounted assets root " << mount.root.string());
+    }
+
+    Asset& ResolveLocked(Vfs::AssetId id) {
+        Asset& asset = s_assets[id - 1];
+        ++s_resolves;
+        if (asset.generation == s_generation) {
+            ++s_cacheHits;
+            return asset;
+        }
+        EnsureDefaultMountLocked();
+        asset.location = Vfs::Location();
+        asset.pack.reset();
+        asset.entry = nullptr;
+        asset.memory.reset();
+        asset.diskPath.clear();
+
+        std::error_code ec;
+        for (auto it = s_mounts.rbegin(); it != s_mounts.rend() && !asset.location.found; ++it) {
+            const Mount& mount = **it;
+            if (asset.normalized.compare(0, mount.point.size(), mount.point) != 0) continue;
+            switch (mount.kind) {
+            case Vfs::MountKind::Pack: {
+                std::string_view rest = std::string_view(asset.normalized).substr(mount.point.size());
+                if (const PakFile::Entry* entry = mount.pack->FindHash(PakFile::HashName(rest))) {
+                    asset.pack = mount.pack;
+                    asset.entry = entry;
+                    asset.location.found = true;
+                }
+                break;
+            }
+            case Vfs::MountKind::Memory: {
+                auto file = mount.files.find(id);
+                if (file != mount.files.end()) {
+                    asset.memory = file->second;
+                    asset.location.found = true;
+                }
+                break;
+            }
+            case Vfs::MountKind::Directory: {
+                // same characters as `normalized` past the prefix, original case
+                std::string_view rest = std::string_view(asset.name).substr(PakFile::NameStart(asset.name) + mount.point.size());
+                fs::path path = mount.root / fs::path(rest);
+                if (fs::is_regular_file(path, ec)) {
+                    asset.diskPath = path.make_preferred().string();
+                    asset.location.found = true;
+                }
+                break;
+            }
+            }
+            if (asset.location.found) {
+                asset.location.mount = mount.id;
+                asset.location.kind = mount.kind;
+            }
+        }
+        if (!asset.location.found && fs::is_regular_file(fs::path(asset.name), ec)) {
+            asset.diskPath = asset.name;
+            asset.location.found = true;
+        }
+        // misses are cached too, a file written later needs an Invalidate
+        asset.generation = s_generation;
+        return asset;
+    }
+
+    // What a read needs, copied out so the file access runs without the lock. The pack and
+    // memory buffer are shared, so an Unmount meanwhile can't free them under the read.
+    struct ReadSource {
+        bool found = false;
+        std::shared_ptr<const PakArchive> pack;
+        const PakFile::Entry* entry = nullptr;
+        MemoryFile memory;
+        std::string diskPath;
+    };
+
+    ReadSource GetSource(Vfs::AssetId id) {
+        ReadSource source;
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (id == Vfs::kInvalidAsset || id > s_assets.size()) return source;
+        const Asset& asset = ResolveLocked(id);
+        source.found = asset.location.found;
+        source.pack = asset.pack;
+        source.entry = asset.entry;
+        source.memory = asset.memory;
+        source.diskPath = asset.diskPath;
+        return source;
+    }
+}
+
+Vfs::MountId Vfs::MountDirectory(const std::string& directory, std::string_view mountPoint) {
+    std::error_code ec;
+    if (!fs::is_directory(directory, ec)) {
+        LOG_ERROR("Vfs: no such folder " << directory);
+        return kInvalidMount;
+    }
+    std::lock_guard<std::mutex> lock(s_mutex);
+    Mount& mount = AddMountLocked(MountKind::Directory, mountPoint);
+    mount.root = fs::path(directory);
+    LOG_INFO("Vfs: mounted folder " << directory << " at '" << mount.point << "'");
+    return mount.id;
+}
+
+Vfs::MountId Vfs::MountPack(const std::string& pakPath, std::string_view mountPoint) {
+    auto mount = std::make_unique<Mount>();
+    mount->pack = std::make_shared<PakArchive>();
+    if (!mount->pack->Open(pakPath)) return kInvalidMount;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    mount->id = s_nextMount++;
+    mount->kind = MountKind::Pack;
+    mount->point = NormalizeMountPoint(mountPoint);
+    s_mounts.push_back(std::move(mount));
+    ++s_generation;
+    return s_mounts.back()->id;
+}
+
+Vfs::MountId Vfs::MountMemory(std::string_view mountPoint) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return AddMountLocked(MountKind::Memory, mountPoint).id;
+}
+
+bool Vfs::AddMemoryFile(MountId id, std::string_view path, std::vector<uint8_t> bytes) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    Mount* mount = FindMountLocked(id);
+    if (!mount || mount->kind != MountKind::Memory) {
+        LOG_ERROR("Vfs: " << id << " is not a memory mount");
+        return false;
+    }
+    std::string full = mount->point;
+    full.append(path.substr(PakFile::NameStart(path)));
+    mount->files[InternLocked(full)] = std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+    ++s_generation;
+    return true;
+}
+
+bool Vfs::Unmount(MountId id) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (auto it = s_mounts.begin(); it != s_mounts.end(); ++it) {
+        if ((*it)->id != id) continue;
+        s_mounts.erase(it);
+        ForgetMountLocked(id);
+        ++s_generation;
+        return true;
+    }
+    return false;
+}
+
+void Vfs::UnmountAll() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_mounts.clear();
+    ForgetMountLocked(kInvalidMount);
+    s_defaultMounted = false;
+    ++s_generation;
+}
+
+const PakArchive* Vfs::GetPack(MountId id) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    Mount* mount = FindMountLocked(id);
+    return (mount && mount->kind == MountKind::Pack) ? mount->pack.get() : nullptr;
+}
+
+std::vector<Vfs::DirectoryMount> Vfs::DirectoryMounts() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    EnsureDefaultMountLocked();
+    std::vector<DirectoryMount> mounts;
+    for (const auto& mount : s_mounts) {
+        if (mount->kind == MountKind::Directory) mounts.push_back({ mount->id, mount->root.string(), mount->point });
+    }
+    return mounts;
+}
+
+Vfs::AssetId Vfs::Intern(std::string_view path) {
+    if (path.empty()) return kInvalidAsset;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return InternLocked(path);
+}
+
+Vfs::AssetId Vfs::Find(std::string_view path) {
+    const uint64_t hash = PakFile::HashName(path);
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return FindLocked(path, hash);
+}
+
+const std::string& Vfs::Name(AssetId id) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (id == kInvalidAsset || id > s_assets.size()) return s_noName;
+    return s_assets[id - 1].name;
+}
+
+Vfs::Location Vfs::Resolve(AssetId id) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (id == kInvalidAsset || id > s_assets.size()) return Location();
+    return ResolveLocked(id).location;
+}
+
+bool Vfs::Exists(AssetId id) {
+    return Resolve(id).found;
+}
+
+std::string Vfs::DiskPath(AssetId id) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (id == kInvalidAsset || id > s_assets.size()) return std::string();
+    return ResolveLocked(id).diskPath;
+}
+
+bool Vfs::Read(AssetId id, std::vector<uint8_t>& out) {
+    ReadSource source = GetSource(id);
+    if (!source.found) return false;
+    if (source.entry) return source.pack->Read(*source.entry, out);
+    if (source.memory) {
+        out = *source.memory;
+        return true;
+    }
+    std::ifstream in(source.diskPath, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    std::streamsize size = in.tellg();
+    in.seekg(0);
+    out.resize(static_cast<size_t>(size));
+    return size == 0 || static_cast<bool>(in.read(reinterpret_cast<char*>(out.data()), size));
+}
+
+bool Vfs::Open(AssetId id, MappedFile& file) {
+    ReadSource source = GetSource(id);
+    if (!source.found) return false;
+    if (source.entry) {
+        if (const uint8_t* view = source.pack->View(*source.entry)) return file.OpenView(view, static_cast<size_t>(source.entry->size), source.pack);
+        std::vector<uint8_t> bytes;
+        if (!source.pack->Read(*source.entry, bytes)) return false;
+        return file.OpenBuffer(std::move(bytes));
+    }
+    if (source.memory) return file.OpenView(source.memory->data(), source.memory->size(), source.memory);
+    return file.Open(source.diskPath);
+}
+
+void Vfs::Invalidate() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    ++s_generation;
+}
+
+void Vfs::Invalidate(AssetId id) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (id == kInvalidAsset || id > s_assets.size()) return;
+    s_assets[id - 1].generation = 0;
+}
+
+Vfs::Stats Vfs::GetStats() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    Stats stats;
+    stats.assets = s_assets.size();
+    stats.mounts = s_mounts.size();
+    stats.resolves = s_resolves;
+    stats.cacheHits = s_cacheHits;
+    return stats;
+}
@@ -3,16 +3,18 @@
 #include <Windows.h>
 #include <memory>
 #include <vector>
-#include <commdlg.h>
+#include <cstring>
 #include "imgui\imgui.h"
 #include <imgui\imgui_impl_glfw.h>
 #include <imgui\imgui_impl_opengl3.h>
 #include <imgui\ImGuiAF.h>
 
 #include "stb/stb_image.h"
-#include "../include/asset_path.h" // for GetAssetPath
+#include "../include/asset_path.h" // for ReadAssetFile
 #include "../include/globalVar.h"
 #include "../include/entity.h"
+#include "../include/file_dialog.h"
+#include "../include/font_cache.h"
 #include "log.h"
 #include <iostream>
 #include <minwindef.h>
@@ -74,19 +76,96 @@ SpxWindow::SpxWindow(const WindowConfig& config)
     SetVSync(m_config.vsync);
 }
 
-void SpxWindow::SetIcon(GLFWwindow* window)
+namespace {
+    // Fonts are read through the asset reader (loose file or pack); the atlas owns the copy
+    bool AddAssetFont(ImFontAtlas* atlas, const std::string& path, float size,
+        const ImFontConfig* config = nullptr, const ImWchar* ranges = nullptr)
+    {
+        std::vector<unsigned char> bytes;
+        if (!ReadAssetFile(path, bytes) || bytes.empty()) {
+            LOG_ERROR("Failed to read font " << path);
+            return false;
+        }
+        void* data = IM_ALLOC(bytes.size());
+        std::memcpy(data, bytes.data(), bytes.size());
+        return atlas->AddFontFromMemoryTTF(data, static_cast<int>(bytes.size()), size, config, ranges) != nullptr;
+    }
+
+    // Main text font with the Font Awesome icons merged in
+    bool AddEditorFonts(ImFontAtlas* atlas) {
+        ImFontConfig fontconfig;
+        fontconfig.MergeMode = true;
+        fontconfig.PixelSnapH = true;
+        static const ImWchar ranges[] = { ICON_MIN_FA, ICON_MAX_FA, 0 };
+
+        fontconfig.GlyphOffset = ImVec2(0.0f, 1.0f);
+        bool ok = AddAssetFont(atlas, FONT_PATH_MAIN_REL, FONT_SIZE);
+        ok = AddAssetFont(atlas, FA_SOLID_PATH, FONT_SIZE, &fontconfig, ranges) && ok;
+        return ok;
+    }
+}
+
+bool SpxWindow::DecodeIcon(std::vector<unsigned char>& rgba, int& width, int& height)
+{
+    std::vector<unsigned char> bytes;
+    if (!ReadAssetFile(ICON_PATH, bytes)) return false;
+    stbi_set_flip_vertically_on_load_thread(0); // workers may have flipping on from texture loads
+    unsigned char* pixels = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, 0, 4); // rgba = png
+    if (!pixels) return false;
+    rgba.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+    return true;
+}
+
+void SpxWindow::SetIcon(GLFWwindow* window, const std::vector<unsigned char>& rgba, int width, int height)
 {
-    std::string iconPath = GetAssetPath(ICON_PATH);
+    if (rgba.empty()) return;
     GLFWimage images[1];
-    images[0].pixels = stbi_load(iconPath.c_str(), &images[0].width, &images[0].height, 0, 4); // rgba = png
+    images[0].width = width;
+    images[0].height = height;
+    images[0].pixels = const_cast<unsigned char*>(rgba.data()); // GLFW copies the pixels
     glfwSetWindowIcon(window, 1, images);
-    stbi_image_free(images[0].pixels);
+}
+
+void SpxWindow::SetIcon(GLFWwindow* window)
+{
+    std::vector<unsigned char> rgba;
+    int width = 0, height = 0;
+    if (DecodeIcon(rgba, width, height)) SetIcon(window, rgba, width, height);
+}
+
+ImFontAtlas* SpxWindow::BuildFontAtlas()
+{
+    ImFontAtlas* atlas = IM_NEW(ImFontAtlas)();
+    if (!AddEditorFonts(atlas)) {
+        IM_DELETE(atlas);
+        return nullptr;
+    }
+    // a warm start restores the baked atlas instead of rasterizing the fonts again
+    const uint64_t key = FontCache::Key(atlas);
+    if (FontCache::Load(atlas, key)) {
+        LOG_INFO("Font atlas restored from the cache");
+    }
+    else {
+        if (!atlas->Build()) {
+            IM_DELETE(atlas);
+            return nullptr;
+        }
+        FontCache::Store(atlas, key);
+    }
+    // the OpenGL backend asks for RGBA32 when it creates the font texture; convert here as well
+    unsigned char* pixels = nullptr;
+    int width = 0, height = 0;
+    atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+    return atlas;
 }
 // ############################################# ImGui Set up #############################################
-void SpxWindow::SetUpImGui(GLFWwindow* window) {
+void SpxWindow::SetUpImGui(GLFWwindow* window, ImFontAtlas* fonts) {
     // ImGui set up
     IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
+    ImGui::CreateContext(fonts);
+    // a prebuilt atlas is handed over: the context frees it like its own
+    if (fonts) ImGui::GetCurrentContext()->FontAtlasOwnedByContext = true;
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
     // enable viewports/docking depending on flag
@@ -103,19 +182,7 @@ void SpxWindow::SetUpImGui(GLFWwindow* window) {
     ImGui_ImplOpenGL3_Init(glsl_version);
 
     // Fonts
-    ImFontConfig fontconfig;
-    fontconfig.MergeMode = true;
-    fontconfig.PixelSnapH = true;
-    static const ImWchar ranges[] = { ICON_MIN_FA, ICON_MAX_FA, 0 };
-
-    
-
-    fontconfig.GlyphOffset = ImVec2(0.0f, 1.0f);
-    std::string fontPath = GetAssetPath(FONT_PATH_MAIN_REL);
-    io.Fonts->AddFontFromFileTTF(fontPath.c_str(), FONT_SIZE);
-
-	std::string AFfontPath  = GetAssetPath(FA_SOLID_PATH).c_str();
-    io.Fonts->AddFontFromFileTTF(AFfontPath.c_str(), FONT_SIZE, &fontconfig, ranges);
+    if (!fonts) AddEditorFonts(io.Fonts);
 }
 
 void SpxWindow::NewImguiFrame(GLFWwindow* window)
@@ -258,6 +325,12 @@ void SpxWindow::MainSceneWindow(GLFWwindow* window)
                 // Request engine to add a plane via action callback
                 if (m_actionCallback) m_actionCallback("AddPlane");
                                 
+            }
+            if (ImGui::MenuItem("Model...", nullptr, false, !FileDialog::IsOpen())) {
+
+                // Request engine to pick a model file and add it
+                if (m_actionCallback) m_actionCallback("AddModel");
+
             }
             // other menu items...
             ImGui::EndMenu();
@@ -300,22 +373,36 @@ void SpxWindow::MainSceneWindow(GLFWwindow* window)
     ImGui::BeginMainMenuBar();
     if (ImGui::BeginMenu("File"))
     {
+        // the engine owns the scene, it handles these through the action callback
         if (ImGui::MenuItem("New scene"))
         {
-
+            if (m_actionCallback) m_actionCallback("NewScene");
         }
-        if (ImGui::MenuItem("Open scene"))
+        if (ImGui::MenuItem("Open scene", nullptr, false, !FileDialog::IsOpen()))
         {
-
+            if (m_actionCallback) m_actionCallback("OpenScene");
         }
         ImGui::Separator();
-        if (ImGui::MenuItem(ICON_FA_SAVE" Save scene"))
+        if (ImGui::MenuItem(ICON_FA_SAVE" Save scene", nullptr, false, !FileDialog::IsOpen()))
         {
-
+            if (m_actionCallback) m_actionCallback("SaveScene");
         }
-        if (ImGui::MenuItem("Save As scene"))
+        if (ImGui::MenuItem("Save As scene", nullptr, false, !FileDialog::IsOpen()))
         {
-
+            if (m_actionCallback) m_actionCallback("SaveSceneAs");
+        }
+        ImGui::Separator();
+        if (ImGui::MenuItem("Open world", nullptr, false, !FileDialog::IsOpen()))
+        {
+            if (m_actionCallback) m_actionCallback("OpenWorld");
+        }
+        if (ImGui::MenuItem("Export scene as world", nullptr, false, !FileDialog::IsOpen()))
+        {
+            if (m_actionCallback) m_actionCallback("ExportWorld");
+        }
+        if (ImGui::MenuItem("Close world"))
+        {
+            if (m_actionCallback) m_actionCallback("CloseWorld");
         }
         ImGui::Separator();
         if (ImGui::MenuItem(ICON_FA_SIGN_OUT_ALT" Exit"))
@@ -560,57 +647,11 @@ void* SpxWindow::GetNativeWindow() const {
     return reinterpret_cast<void*>(window);
 }
 
-//New Openfile dialog and return the selected file path as a string. Uses Windows API.
+// Blocking open-file dialog for images, returns the selected UTF-8 path or "".
+// The editor uses FileDialog::OpenAsync so the frame loop keeps running.
 std::string SpxWindow::openFileDialog()
 {
-    OPENFILENAMEW ofn;
-    // Wide buffer for file path
-    std::vector<wchar_t> filename(MAX_PATH, L'\0');
-
-    ZeroMemory(&ofn, sizeof(ofn));
-    ofn.lStructSize = sizeof(ofn);
-
-    // If you have a native HWND for the window, put it here; otherwise NULL is fine.
-    ofn.hwndOwner = NULL;
-
-    ofn.lpstrFile = filename.data();
-    ofn.nMaxFile = static_cast<DWORD>(filename.size());
-
-    // Double-null terminated wide-string filter (last \0 terminates the filter list)
-    static const wchar_t filter[] =
-        L"Image Files\0*.jpg;*.jpeg;*.png;*.bmp\0"
-        L"All Files\0*.*\0\0";
-    ofn.lpstrFilter = filter;
-    ofn.nFilterIndex = 1;
-
-    ofn.lpstrFileTitle = NULL;
-    ofn.nMaxFileTitle = 0;
-    ofn.lpstrInitialDir = NULL;
-
-    // Flags: require existing path/file, Explorer-style dialog
-    ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST | OFN_EXPLORER;
-
-    if (GetOpenFileNameW(&ofn)) {
-        // Convert selected wide string to UTF-8
-        int required = WideCharToMultiByte(CP_UTF8, 0, ofn.lpstrFile, -1, nullptr, 0, nullptr, nullptr);
-        if (required > 0) {
-            std::vector<char> utf8(required, 0);
-            WideCharToMultiByte(CP_UTF8, 0, ofn.lpstrFile, -1, utf8.data(), required, nullptr, nullptr);
-            return std::string(utf8.data());
-        }
-        else {
-            LOG_WARNING("openFileDialog: WideCharToMultiByte failed converting path.");
-            return std::string();
-        }
-    }
-    else {
-        // If user cancelled, CommDlgExtendedError returns 0. Otherwise log the error code.
-        DWORD err = CommDlgExtendedError();
-        if (err != 0) {
-            LOG_WARNING("openFileDialog: GetOpenFileNameW failed, CommDlgExtendedError=" << err);
-        }
-        return std::string();
-    }
+    return FileDialog::Open(FileDialog::Filter::Images);
 }
  
 
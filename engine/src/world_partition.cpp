@@ -0,0 +1,305 @@
+#include "../include/world_partition.h"
+#include "../include/jobs.h"
+#include "../include/log.h"
+#include "../include/mapped_file.h"
+#include "../include/text_parse.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace fs = std::filesystem;
+using namespace SceneFile;
+
+struct WorldPartition::Inbox {
+    std::mutex mutex;
+    std::vector<std::pair<uint64_t, std::unique_ptr<Columns>>> done;   // nullptr = failed
+};
+
+namespace {
+    // Append row i of src to dst, re-interning its strings into dst's table
+    void CopyRow(const Columns& src, size_t i, Columns& dst) {
+        const size_t row = dst.AddEntity(src.ids[i]);
+        dst.types[row] = src.types[i];
+        dst.objectIndices[row] = src.objectIndices[i];
+        dst.positions[row] = src.positions[i];
+        dst.rotations[row] = src.rotations[i];
+        dst.scales[row] = src.scales[i];
+        dst.flags[row] = src.flags[i];
+        dst.points[row] = src.points[i];
+        dst.healthPoints[row] = src.healthPoints[i];
+        if (src.names[i] != kNoString) dst.names[row] = dst.Intern(src.String(src.names[i]));
+        if (src.textures[i] != kNoString) dst.textures[row] = dst.Intern(src.String(src.textures[i]));
+        if (src.meshes[i] != kNoString) dst.meshes[row] = dst.Intern(src.String(src.meshes[i]));
+    }
+
+    std::string CellDirectory(const std::string& manifestPath) {
+        const fs::path manifest(manifestPath);
+        return (manifest.parent_path() / (manifest.stem().string() + "_cells")).generic_string();
+    }
+
+    std::string CellFile(const std::string& cellDir, int32_t x, int32_t z) {
+        return cellDir + "/cell_" + std::to_string(x) + "_" + std::to_string(z) + SceneFile::kExtension;
+    }
+
+    int32_t CellCoord(double v, double cellSize) {
+        return static_cast<int32_t>(std::floor(v / cellSize));
+    }
+}
+
+std::string WorldPartition::CellPath(int32_t x, int32_t z) const {
+    return CellFile(m_cellDir, x, z);
+}
+
+double WorldPartition::DistanceToCell(const glm::dvec3& p, int32_t x, int32_t z) const {
+    // distance on the XZ plane to the cell's square, 0 inside it
+    const double size = m_cellSize;
+    const double minX = x * size, minZ = z * size;
+    const double dx = std::max({ minX - p.x, 0.0, p.x - (minX + size) });
+    const double dz = std::max({ minZ - p.z, 0.0, p.z - (minZ + size) });
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+bool WorldPartition::Export(const Columns& scene, const std::string& manifestPath, float cellSize) {
+    if (!(cellSize > 0.0f)) {
+        LOG_ERROR("WorldPartition: cell size must be positive");
+        return false;
+    }
+    // sorted, so the manifest lists the cells in a stable order
+    std::map<std::pair<int32_t, int32_t>, Columns> cells;
+    for (size_t i = 0; i < scene.Size(); ++i) {
+        const glm::vec3& p = scene.positions[i];
+        CopyRow(scene, i, cells[{ CellCoord(p.x, cellSize), CellCoord(p.z, cellSize) }]);
+    }
+
+    const std::string cellDir = CellDirectory(manifestPath);
+    std::error_code ec;
+    fs::create_directories(cellDir, ec);
+    std::string manifest = "# Spx world: cell size and the non-empty cells (x z entities)\nspx world ";
+    manifest += std::to_string(kVersion);
+    manifest += "\ncellsize ";
+    char number[32];
+    manifest.append(number, std::to_chars(number, number + sizeof(number), cellSize).ptr);
+    manifest += '\n';
+    for (const auto& [coord, columns] : cells) {
+        if (!SceneFile::Write(CellFile(cellDir, coord.first, coord.second), columns)) return false;
+        manifest += "cell " + std::to_string(coord.first) + " " + std::to_string(coord.second) + " " + std::to_string(columns.Size()) + "\n";
+    }
+
+    // the manifest goes last, so a failed export never points at missing cells
+    std::string tmp = manifestPath + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.write(manifest.data(), static_cast<std::streamsize>(manifest.size()))) {
+            LOG_ERROR("WorldPartition: failed to write " << tmp);
+            return false;
+        }
+    }
+    fs::rename(tmp, manifestPath, ec);
+    if (ec) {
+        LOG_ERROR("WorldPartition: failed to replace " << manifestPath << ": " << ec.message());
+        fs::remove(tmp, ec);
+        return false;
+    }
+    LOG_INFO("WorldPartition: exported " << scene.Size() << " entities into " << cells.size() << " cells of "
+        << cellSize << " units (" << manifestPath << ")");
+    return true;
+}
+
+bool WorldPartition::Open(const std::string& manifestPath, const Settings& settings) {
+    Close();
+    MappedFile file;
+    if (!file.Open(manifestPath)) {
+        LOG_ERROR("WorldPartition: cannot open " << manifestPath);
+        return false;
+    }
+
+    using namespace TextParse;
+    const char* p = file.Data();
+    const char* end = p + file.Size();
+    int line = 0;
+    bool header = false;
+    float cellSize = 0.0f;
+    std::unordered_set<uint64_t> available;
+    while (p < end) {
+        ++line;
+        const char* next = NextLine(p, end);
+        const char* s = SkipSpaces(p, next);
+        const char* e = LineEnd(s, next);
+        p = next;
+        if (s == e || *s == '#') continue;
+
+        if (!header) {
+            int32_t version = 0;
+            const char* v = StartsWithWord(s, e, "spx world") ? SkipSpaces(s + 9, e) : s;
+            if (v == s || ParseInt(v, e, version) == v || version < 1 || version > kVersion) {
+                LOG_ERROR("WorldPartition: " << manifestPath << ":" << line << ": not a version " << kVersion << " world manifest");
+                return false;
+            }
+            header = true;
+        }
+        else if (StartsWithWord(s, e, "cellsize")) {
+            const char* v = SkipSpaces(s + 8, e);
+            if (ParseFloatExact(v, e, cellSize) == v || !(cellSize > 0.0f)) {
+                LOG_ERROR("WorldPartition: " << manifestPath << ":" << line << ": bad cell size");
+                return false;
+            }
+        }
+        else if (StartsWithWord(s, e, "cell")) {
+            int32_t x = 0, z = 0;
+            const char* v = SkipSpaces(s + 4, e);
+            const char* after = ParseInt(v, e, x);
+            const char* zs = SkipSpaces(after, e);
+            if (after == v || ParseInt(zs, e, z) == zs) {
+                LOG_ERROR("WorldPartition: " << manifestPath << ":" << line << ": bad cell");
+                return false;
+            }
+            available.insert(Key(x, z));
+        }
+        else {
+            LOG_WARNING("WorldPartition: " << manifestPath << ":" << line << ": unknown line ignored");
+        }
+    }
+    if (!header || cellSize <= 0.0f) {
+        LOG_ERROR("WorldPartition: " << manifestPath << " has no header or cell size");
+        return false;
+    }
+
+    m_settings = settings;
+    m_settings.unloadRadius = std::max(settings.unloadRadius, settings.loadRadius);
+    m_settings.maxLoadsInFlight = std::max(1, settings.maxLoadsInFlight);
+    m_cellSize = cellSize;
+    m_manifestPath = manifestPath;
+    m_cellDir = CellDirectory(manifestPath);
+    m_available = std::move(available);
+    m_inbox = std::make_shared<Inbox>();
+    LOG_INFO("WorldPartition: opened " << manifestPath << " (" << m_available.size() << " cells of " << m_cellSize << " units)");
+    return true;
+}
+
+void WorldPartition::Close() {
+    m_cellSize = 0.0f;
+    m_manifestPath.clear();
+    m_cellDir.clear();
+    m_available.clear();
+    m_cells.clear();
+    m_inbox.reset();
+    m_inFlight = 0;
+    m_unloaded.clear();
+}
+
+void WorldPartition::Update(const glm::dvec3& camera) {
+    if (!IsOpen()) return;
+    m_camera = camera;
+
+    // finished loads; a cell dropped meanwhile is no longer in m_cells
+    std::vector<std::pair<uint64_t, std::unique_ptr<Columns>>> done;
+    {
+        std::lock_guard<std::mutex> lock(m_inbox->mutex);
+        done.swap(m_inbox->done);
+    }
+    for (auto& [key, columns] : done) {
+        --m_inFlight;
+        auto it = m_cells.find(key);
+        if (it == m_cells.end() || it->second.state != CellState::Loading) continue;
+        // a cell that failed to load stays resident and empty, no retry every frame
+        it->second.state = columns ? CellState::Ready : CellState::Resident;
+        it->second.columns = std::move(columns);
+    }
+
+    // drop far cells
+    for (auto it = m_cells.begin(); it != m_cells.end();) {
+        const int32_t x = static_cast<int32_t>(it->first >> 32);
+        const int32_t z = static_cast<int32_t>(it->first & 0xFFFFFFFFu);
+        if (DistanceToCell(camera, x, z) <= m_settings.unloadRadius) {
+            ++it;
+            continue;
+        }
+        m_unloaded.insert(m_unloaded.end(), it->second.entityIds.begin(), it->second.entityIds.end());
+        it = m_cells.erase(it);
+    }
+
+    // start loads around the camera, nearest first
+    if (m_inFlight >= m_settings.maxLoadsInFlight) return;
+    std::vector<std::pair<double, uint64_t>> wanted;
+    const double r = m_settings.loadRadius;
+    const int32_t x0 = CellCoord(camera.x - r, m_cellSize), x1 = CellCoord(camera.x + r, m_cellSize);
+    const int32_t z0 = CellCoord(camera.z - r, m_cellSize), z1 = CellCoord(camera.z + r, m_cellSize);
+    for (int32_t z = z0; z <= z1; ++z) {
+        for (int32_t x = x0; x <= x1; ++x) {
+            const uint64_t key = Key(x, z);
+            if (!m_available.count(key) || m_cells.count(key)) continue;
+            const double d = DistanceToCell(camera, x, z);
+            if (d <= r) wanted.emplace_back(d, key);
+        }
+    }
+    std::sort(wanted.begin(), wanted.end());
+    for (const auto& [distance, key] : wanted) {
+        if (m_inFlight >= m_settings.maxLoadsInFlight) break;
+        m_cells[key].state = CellState::Loading;
+        ++m_inFlight;
+        std::string path = CellPath(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFFu));
+        std::shared_ptr<Inbox> inbox = m_inbox;
+        Jobs::Submit([inbox, key, path = std::move(path)]() {
+            auto columns = std::make_unique<Columns>();
+            if (!SceneFile::Read(path, *columns)) {
+                LOG_WARNING("WorldPartition: cell " << path << " failed to load");
+                columns.reset();
+            }
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->done.emplace_back(key, std::move(columns));
+        });
+    }
+}
+
+void WorldPartition::Spawn(const std::function<int(const Columns&, size_t)>& spawn) {
+    if (!IsOpen()) return;
+    std::vector<std::pair<double, Cell*>> ready;
+    for (auto& [key, cell] : m_cells) {
+        if (cell.state != CellState::Ready) continue;
+        ready.emplace_back(DistanceToCell(m_camera, static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFFu)), &cell);
+    }
+    if (ready.empty()) return;
+    std::sort(ready.begin(), ready.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // at least one entity per frame, so a tiny budget still makes progress
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point deadline = Clock::now()
+        + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(m_settings.spawnBudgetMs));
+    bool first = true;
+    for (const auto& [distance, cell] : ready) {
+        const Columns& columns = *cell->columns;
+        while (cell->spawned < columns.Size()) {
+            if (!first && Clock::now() >= deadline) return;
+            first = false;
+            const int id = spawn(columns, cell->spawned++);
+            if (id >= 0) cell->entityIds.push_back(id);
+        }
+        cell->state = CellState::Resident;
+        cell->columns.reset();
+    }
+}
+
+std::vector<int> WorldPartition::TakeUnloaded() {
+    std::vector<int> ids;
+    ids.swap(m_unloaded);
+    return ids;
+}
+
+WorldPartition::Stats WorldPartition::GetStats() const {
+    Stats stats;
+    stats.cells = m_available.size();
+    for (const auto& [key, cell] : m_cells) {
+        if (cell.state == CellState::Resident) ++stats.resident;
+        else ++stats.pending;
+        stats.entities += cell.entityIds.size();
+    }
+    return stats;
+}